@@ -229,6 +229,48 @@ void DebugCounterVariable::dump(char *buffer) {
     strcatUInt32(buffer, m_totalCounter);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+DebugProfilerZoneVariable::DebugProfilerZoneVariable(const char *name, profiler::Zone zone, uint32_t refreshRateMs)
+    : DebugVariable(name, refreshRateMs), m_zone(zone), m_lastCount(0), m_lastTotalDuration(0), m_count(0), m_avgDuration(0), m_load(0)
+{
+}
+
+void DebugProfilerZoneVariable::tick1secPeriod() {
+    profiler::ZoneStatistics statistics;
+    profiler::getZoneStatistics(m_zone, statistics);
+
+    if (statistics.count < m_lastCount) {
+        // profiler was reset
+        m_lastCount = 0;
+        m_lastTotalDuration = 0;
+    }
+
+    m_count = statistics.count - m_lastCount;
+    uint32_t totalDuration = (uint32_t)(statistics.totalDuration - m_lastTotalDuration);
+    m_avgDuration = m_count > 0 ? totalDuration / m_count : 0;
+    m_load = totalDuration / 10000.0f;
+
+    m_lastCount = statistics.count;
+    m_lastTotalDuration = statistics.totalDuration;
+}
+
+void DebugProfilerZoneVariable::tick10secPeriod() {
+}
+
+void DebugProfilerZoneVariable::dump(char *buffer) {
+    profiler::ZoneStatistics statistics;
+    profiler::getZoneStatistics(m_zone, statistics);
+
+    strcatUInt32(buffer, m_count);
+    strcat(buffer, " ");
+    strcatUInt32(buffer, m_avgDuration);
+    strcat(buffer, " ");
+    strcatFloat(buffer, m_load, 1);
+    strcat(buffer, "% / ");
+    strcatUInt32(buffer, statistics.maxDuration);
+}
+
 } // namespace debug
 } // namespace eez
 
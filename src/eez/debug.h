@@ -40,6 +40,8 @@ void Trace(const char *format, ...);
 
 #ifdef DEBUG
 
+#include <eez/profiler.h>
+
 namespace eez {
 namespace debug {
 
@@ -151,6 +153,27 @@ private:
     uint32_t m_totalCounter;
 };
 
+// Shows executions, average duration (us) and load (%) of the profiler zone
+// in the last second and the max duration (us) since the profiler reset.
+class DebugProfilerZoneVariable : public DebugVariable {
+public:
+    DebugProfilerZoneVariable(const char *name, profiler::Zone zone, uint32_t refreshRateMs = 1000);
+
+    void tick1secPeriod();
+    void tick10secPeriod();
+    void dump(char *buffer);
+
+private:
+    profiler::Zone m_zone;
+
+    uint32_t m_lastCount;
+    uint64_t m_lastTotalDuration;
+
+    uint32_t m_count;
+    uint32_t m_avgDuration;
+    float m_load;
+};
+
 } // namespace debug
 } // namespace eez
 
@@ -17,6 +17,7 @@
 */
 
 #include <eez/file_type.h>
+#include <eez/mp.h>
 #include <eez/util.h>
 
 #include <eez/modules/psu/psu.h>
@@ -85,6 +86,11 @@ static const char *rootDirectoryIcons[] = {
 };
 
 FileType getFileTypeFromExtension(const char *filePath) {
+    // compiled MicroPython script cache, not a script
+    if (endsWithNoCase(filePath, MP_CACHE_EXT)) {
+        return FILE_TYPE_OTHER;
+    }
+
     for (int fileType = 0; fileType < FILE_TYPE_OTHER; fileType++) {
         if (fileTypeExtension[fileType] && endsWithNoCase(filePath, fileTypeExtension[fileType])) {
             return (FileType)fileType;
@@ -288,15 +288,15 @@ bool test() {
     }
 }
 
-bool reset() {
+bool reset(bool resetScpiContexts) {
     using namespace psu;
 
     if (!isPsuThread()) {
-        sendMessageToPsu(PSU_MESSAGE_RESET);
+        sendMessageToPsu(PSU_MESSAGE_RESET, resetScpiContexts ? 1 : 0);
         return true;
     }
 
-    return psuReset();
+    return psuReset(resetScpiContexts);
 }
 
 void standBy() {
@@ -356,6 +356,10 @@ void shutdown() {
         }
     }
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    mcu::eeprom::flush();
+#endif
+
     if (g_restart) {
         delay(800);
 
@@ -37,7 +37,8 @@ extern bool g_shutdown;
 void boot();
 bool test();
 bool testMaster();
-bool reset();
+// resetScpiContexts is false for SCPI *RST, which resets only the context of the client which sent it
+bool reset(bool resetScpiContexts = true);
 void standBy();
 void restart();
 void shutdown();
@@ -28,44 +28,128 @@
 #include <eez/libs/lz4/lz4.h>
 
 #include <eez/gui/gui.h>
+#include <eez/gui/text_run_cache.h>
 #include <eez/gui/widget.h>
 
 #include <eez/libs/sd_fat/sd_fat.h>
 
 #include <scpi/scpi.h>
 
+/* Sectioned Assets Format
+
+Main assets can be stored as a single LZ4 block, which is decompressed at boot,
+or in the sectioned format, where only the tables are decompressed at boot
+and every font and bitmap is decompressed on the first use into the assets cache.
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x43455341L
+4         U32     4        VERSION = 0x0001L
+8         U32     4        Tables decompressed size
+12        U32     4        Tables compressed size
+16        U32     4        Fonts section offset
+20        U32     4        Bitmaps section offset
+24                         Tables, LZ4 block. Same layout as the single block format,
+                           but without the fonts and bitmaps data.
+
+Fonts and bitmaps sections (offsets are aligned to 4 bytes):
+
+0         U32     4        Number of items (N)
+4                          N items:
+          U32     4        LZ4 block offset from the section start
+          U32     4        LZ4 block size
+          U32     4        Decompressed size
+4 + N*12                   LZ4 blocks
+
+In the single block format first U32 is decompressed size, which is never equal to MAGIC.
+*/
+
 namespace eez {
 namespace gui {
 
+static const uint32_t SECTIONED_ASSETS_MAGIC = 0x43455341;
+static const uint32_t SECTIONED_ASSETS_VERSION = 1;
+
+struct SectionedAssetsHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tablesDecompressedSize;
+    uint32_t tablesCompressedSize;
+    uint32_t fontsSectionOffset;
+    uint32_t bitmapsSectionOffset;
+};
+
+struct CompressedItem {
+    uint32_t offset;
+    uint32_t compressedSize;
+    uint32_t decompressedSize;
+};
+
+struct CompressedSection {
+    uint32_t count;
+    CompressedItem items[1];
+};
+
+// Cache entries are not evicted in the GUI iteration in which they are used,
+// so the pointer returned by getFontData or getBitmap is valid at least until
+// the next tickAssetsCache. Items are allocated at 8 bytes boundary.
+// Cache is not locked, it is used only from the GUI thread.
+// Block as big as the largest font is reserved at the end of the cache region.
+// When the cache is full of the entries used in the current iteration, font
+// is loaded there, so at least one font can always be loaded. Bitmap that can't
+// be loaded is not drawn.
+static const int MAX_CACHE_ENTRIES = 128;
+static const uint32_t CACHE_ALIGNMENT = 8;
+
+struct CacheEntry {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t lastUsed;
+};
+
 bool g_assetsLoaded;
 static Assets g_mainAssets;
 
+static const CompressedSection *g_fontsSection;
+static const CompressedSection *g_bitmapsSection;
+
+static CacheEntry g_cacheEntries[MAX_CACHE_ENTRIES];
+static uint8_t *g_cacheStart;
+static uint8_t *g_cacheEnd;
+static uint32_t g_cacheIteration = 1;
+
+static uint8_t *g_reservedBlock;
+static int g_reservedEntryIndex = -1;
+static uint32_t g_reservedLastUsed;
+
+static AssetsStatistics g_assetsStatistics;
+
 static Assets g_externalAssets;
 
 static Assets *g_fixPointersAssets;
 
 void StyleList_fixPointers() {
-    g_fixPointersAssets->styles->first = (Style *)((uint8_t *)g_fixPointersAssets->styles + (uint32_t)g_fixPointersAssets->styles->first);
+    g_fixPointersAssets->styles->first.fixPointer(g_fixPointersAssets->styles);
 }
 
 void WidgetList_fixPointers(WidgetList &widgetList) {
-    widgetList.first = (Widget *)((uint8_t *)g_fixPointersAssets->document + (uint32_t)widgetList.first);
+    widgetList.first.fixPointer(g_fixPointersAssets->document);
     for (uint32_t i = 0; i < widgetList.count; ++i) {
         Widget_fixPointers((Widget *)widgetList.first + i);
     }
 }
 
 void ColorList_fixPointers(ColorList &colorList) {
-    colorList.first = (uint16_t *)((uint8_t *)g_fixPointersAssets->colorsData + (uint32_t)colorList.first);
+    colorList.first.fixPointer(g_fixPointersAssets->colorsData);
 }
 
 void Theme_fixPointers(Theme *theme) {
-    theme->name = (const char *)((uint8_t *)g_fixPointersAssets->colorsData + (uint32_t)theme->name);
+    theme->name.fixPointer(g_fixPointersAssets->colorsData);
     ColorList_fixPointers(theme->colors);
 }
 
 void ThemeList_fixPointers(ThemeList &themeList) {
-    themeList.first = (Theme *)((uint8_t *)g_fixPointersAssets->colorsData + (uint32_t)themeList.first);
+    themeList.first.fixPointer(g_fixPointersAssets->colorsData);
     for (uint32_t i = 0; i < themeList.count; ++i) {
         Theme_fixPointers((Theme *)themeList.first + i);
     }
@@ -78,9 +162,9 @@ void ColorsData_fixPointers() {
 
 void NameList_fixPointers(NameList *nameList) {
     if (nameList) {
-        nameList->first = (const char **)((uint8_t *)nameList + (uint32_t)nameList->first);
+        nameList->first.fixPointer(nameList);
         for (uint32_t i = 0; i < nameList->count; i++) {
-            nameList->first[i] = (const char *)((uint8_t *)nameList + (uint32_t)nameList->first[i]);
+            nameList->first[i].fixPointer(nameList);
         }
     }
 }
@@ -130,7 +214,7 @@ static FixPointersFunctionType *g_fixWidgetPointersFunctions[] = {
 // };
 
 void Widget_fixPointers(Widget *widget) {
-    widget->specific = (void *)((uint8_t *)g_fixPointersAssets->document + (uint32_t)widget->specific);
+    widget->specific.fixPointer(g_fixPointersAssets->document);
     if (*g_fixWidgetPointersFunctions[widget->type]) {
         (*g_fixWidgetPointersFunctions[widget->type])(widget, g_fixPointersAssets);
     }
@@ -152,25 +236,213 @@ void initAssets(Assets &assets, bool external, uint8_t *decompressedAssets) {
 }
 
 void decompressAssets() {
-    uint8_t *decompressedAssets;
+    uint32_t startTime = micros();
 
-    int compressedSize = sizeof(assets) - 4;
+    uint8_t *decompressedAssets = DECOMPRESSED_ASSETS_START_ADDRESS;
+    uint32_t decompressedSize;
 
-    // first 4 bytes (uint32_t) are decompressed size
-    uint32_t decompressedSize = ((uint32_t *)assets)[0];
-    assert(decompressedSize <= DECOMPRESSED_ASSETS_SIZE);
-    decompressedAssets = DECOMPRESSED_ASSETS_START_ADDRESS;
+    auto header = (const SectionedAssetsHeader *)assets;
+    if (header->magic == SECTIONED_ASSETS_MAGIC) {
+        assert(header->version == SECTIONED_ASSETS_VERSION);
+
+        decompressedSize = header->tablesDecompressedSize;
+        assert(decompressedSize <= DECOMPRESSED_ASSETS_SIZE);
 
-    int result = LZ4_decompress_safe((const char *)assets + 4, (char *)decompressedAssets, compressedSize, (int)decompressedSize);
-    assert(result == (int)decompressedSize);
+        int result = LZ4_decompress_safe((const char *)(header + 1), (char *)decompressedAssets, (int)header->tablesCompressedSize, (int)decompressedSize);
+        assert(result == (int)decompressedSize);
+
+        g_fontsSection = (const CompressedSection *)(assets + header->fontsSectionOffset);
+        g_bitmapsSection = (const CompressedSection *)(assets + header->bitmapsSectionOffset);
+        assert(g_fontsSection->count + g_bitmapsSection->count <= MAX_CACHE_ENTRIES);
+
+        uint32_t maxFontSize = 0;
+        for (uint32_t i = 0; i < g_fontsSection->count; i++) {
+            if (g_fontsSection->items[i].decompressedSize > maxFontSize) {
+                maxFontSize = g_fontsSection->items[i].decompressedSize;
+            }
+        }
+        maxFontSize = (maxFontSize + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+
+        // rest of the region is used for the cache, with the reserved block at the end
+        g_cacheStart = decompressedAssets + (decompressedSize + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+        g_reservedBlock = decompressedAssets + (DECOMPRESSED_ASSETS_SIZE - maxFontSize) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+        g_cacheEnd = g_reservedBlock;
+        assert(g_cacheStart <= g_cacheEnd);
+
+        g_assetsStatistics.sectioned = true;
+        g_assetsStatistics.numItems = g_fontsSection->count + g_bitmapsSection->count;
+        g_assetsStatistics.cacheSize = g_cacheEnd - g_cacheStart;
+    } else {
+        int compressedSize = sizeof(assets) - 4;
+
+        // first 4 bytes (uint32_t) are decompressed size
+        decompressedSize = ((uint32_t *)assets)[0];
+        assert(decompressedSize <= DECOMPRESSED_ASSETS_SIZE);
+
+        int result = LZ4_decompress_safe((const char *)assets + 4, (char *)decompressedAssets, compressedSize, (int)decompressedSize);
+        assert(result == (int)decompressedSize);
+    }
 
     initAssets(g_mainAssets, false, decompressedAssets);
 
     fixPointers(g_mainAssets);
 
+    g_assetsStatistics.bootTime = micros() - startTime;
+    g_assetsStatistics.compressedSize = sizeof(assets);
+    g_assetsStatistics.bootDecompressedSize = decompressedSize;
+
     g_assetsLoaded = true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns the free block of the given size, or nullptr if there is no free block that big.
+static uint8_t *allocateCacheBlock(uint32_t size) {
+    // free blocks are between the loaded entries sorted by address
+    int sortedEntries[MAX_CACHE_ENTRIES];
+    int numSortedEntries = 0;
+
+    for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
+        if (g_cacheEntries[i].data) {
+            int j = numSortedEntries++;
+            for (; j > 0 && g_cacheEntries[sortedEntries[j - 1]].data > g_cacheEntries[i].data; j--) {
+                sortedEntries[j] = sortedEntries[j - 1];
+            }
+            sortedEntries[j] = i;
+        }
+    }
+
+    uint8_t *freeBlock = g_cacheStart;
+    for (int i = 0; i < numSortedEntries; i++) {
+        CacheEntry &entry = g_cacheEntries[sortedEntries[i]];
+        if ((uint32_t)(entry.data - freeBlock) >= size) {
+            return freeBlock;
+        }
+        freeBlock = entry.data + entry.size;
+    }
+
+    if ((uint32_t)(g_cacheEnd - freeBlock) >= size) {
+        return freeBlock;
+    }
+
+    return nullptr;
+}
+
+// Evicts the least recently used entry, entries used in the current iteration
+// are never evicted. Returns false if there is no entry to evict.
+static bool evictCacheEntry() {
+    CacheEntry *lruEntry = nullptr;
+    for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
+        CacheEntry &entry = g_cacheEntries[i];
+        if (entry.data && entry.lastUsed != g_cacheIteration && (!lruEntry || entry.lastUsed < lruEntry->lastUsed)) {
+            lruEntry = &entry;
+        }
+    }
+
+    if (!lruEntry) {
+        return false;
+    }
+
+    lruEntry->data = nullptr;
+
+    g_assetsStatistics.cacheUsed -= lruEntry->size;
+    g_assetsStatistics.numEvictions++;
+
+    return true;
+}
+
+static bool decompressItem(const CompressedSection *section, int itemIndex, uint8_t *data) {
+    const CompressedItem &item = section->items[itemIndex];
+    int result = LZ4_decompress_safe((const char *)section + item.offset, (char *)data, (int)item.compressedSize, (int)item.decompressedSize);
+    return result == (int)item.decompressedSize;
+}
+
+// Font is loaded into the reserved block if it isn't used in this iteration by another font.
+static const uint8_t *getReservedItem(int entryIndex, const CompressedSection *section, int itemIndex) {
+    if (section != g_fontsSection || g_reservedLastUsed == g_cacheIteration) {
+        return nullptr;
+    }
+
+    g_reservedEntryIndex = -1;
+    if (!decompressItem(section, itemIndex, g_reservedBlock)) {
+        return nullptr;
+    }
+
+    g_reservedEntryIndex = entryIndex;
+    g_reservedLastUsed = g_cacheIteration;
+    g_assetsStatistics.numReservedLoads++;
+
+    return g_reservedBlock;
+}
+
+static const uint8_t *getCachedItem(int entryIndex, const CompressedSection *section, int itemIndex) {
+    CacheEntry &entry = g_cacheEntries[entryIndex];
+
+    entry.lastUsed = g_cacheIteration;
+
+    if (entry.data) {
+        g_assetsStatistics.numHits++;
+        return entry.data;
+    }
+
+    if (entryIndex == g_reservedEntryIndex) {
+        g_reservedLastUsed = g_cacheIteration;
+        g_assetsStatistics.numHits++;
+        return g_reservedBlock;
+    }
+
+    uint32_t startTime = micros();
+
+    const CompressedItem &item = section->items[itemIndex];
+    uint32_t size = (item.decompressedSize + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+
+    uint8_t *data;
+    while (!(data = allocateCacheBlock(size))) {
+        if (!evictCacheEntry()) {
+            // everything in the cache is used in this iteration
+            const uint8_t *reservedData = getReservedItem(entryIndex, section, itemIndex);
+            if (!reservedData) {
+                // item is not drawn until some entry can be evicted
+                g_assetsStatistics.numFailedLoads++;
+            }
+            return reservedData;
+        }
+    }
+
+    // Block is owned by the entry only after the successful decompression,
+    // until then it is still free for allocateCacheBlock, so nothing to release on failure.
+    if (!decompressItem(section, itemIndex, data)) {
+        g_assetsStatistics.numFailedLoads++;
+        return nullptr;
+    }
+
+    entry.data = data;
+    entry.size = size;
+
+    g_assetsStatistics.numLoads++;
+    g_assetsStatistics.cacheUsed += size;
+    if (g_assetsStatistics.cacheUsed > g_assetsStatistics.cacheHighWaterMark) {
+        g_assetsStatistics.cacheHighWaterMark = g_assetsStatistics.cacheUsed;
+    }
+    uint32_t loadTime = micros() - startTime;
+    g_assetsStatistics.loadTime += loadTime;
+    if (loadTime > g_assetsStatistics.maxLoadTime) {
+        g_assetsStatistics.maxLoadTime = loadTime;
+    }
+
+    return data;
+}
+
+void tickAssetsCache() {
+    g_cacheIteration++;
+}
+
+void getAssetsStatistics(AssetsStatistics &statistics) {
+    memcpy(&statistics, &g_assetsStatistics, sizeof(AssetsStatistics));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 const Style *getStyle(int styleID) {
     return g_mainAssets.styles->first + styleID - 1;
 }
@@ -188,11 +460,28 @@ const uint8_t *getFontData(int fontID) {
     if (fontID == 0) {
         return 0;
     }
+    if (g_fontsSection) {
+        return getCachedItem(fontID - 1, g_fontsSection, fontID - 1);
+    }
     return g_mainAssets.fontsData + ((uint32_t *)g_mainAssets.fontsData)[fontID - 1];
 }
 
+bool isFontData(const uint8_t *fontData, int fontID) {
+    if (g_fontsSection) {
+        // font which is not in the cache can't be the given one
+        if (!fontData) {
+            return false;
+        }
+        return g_cacheEntries[fontID - 1].data == fontData || (g_reservedEntryIndex == fontID - 1 && g_reservedBlock == fontData);
+    }
+    return fontData == getFontData(fontID);
+}
+
 const Bitmap *getBitmap(int bitmapID) {
     if (bitmapID > 0) {
+        if (g_bitmapsSection) {
+            return (const Bitmap *)getCachedItem(g_fontsSection->count + bitmapID - 1, g_bitmapsSection, bitmapID - 1);
+        }
         return (const Bitmap *)(g_mainAssets.bitmapsData + ((uint32_t *)g_mainAssets.bitmapsData)[bitmapID - 1]);
     } else if (bitmapID < 0) {
         return (const Bitmap *)(g_externalAssets.bitmapsData + ((uint32_t *)g_externalAssets.bitmapsData)[-bitmapID - 1]);
@@ -310,6 +599,8 @@ bool loadExternalAssets(const char *filePath, int *err) {
 
     fixPointers(g_externalAssets);
 
+    text_run_cache::invalidate();
+
     return true;
 }
 
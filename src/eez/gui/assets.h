@@ -27,9 +27,37 @@ void decompressAssets();
 
 extern bool g_assetsLoaded;
 
+// Called once per GUI iteration, after the display is synced.
+// Fonts and bitmaps used since the previous call are not evicted from the cache.
+void tickAssetsCache();
+
+struct AssetsStatistics {
+    bool sectioned;
+    uint32_t compressedSize;
+    uint32_t bootDecompressedSize;
+    uint32_t bootTime; // us
+    uint32_t numItems;
+    uint32_t cacheSize;
+    uint32_t cacheUsed;
+    uint32_t cacheHighWaterMark;
+    uint32_t numHits;
+    uint32_t numLoads;
+    uint32_t numEvictions;
+    uint32_t numFailedLoads; // cache was full of the items used in the same iteration
+    uint32_t numReservedLoads; // fonts loaded into the reserved block
+    uint32_t loadTime; // us
+    uint32_t maxLoadTime; // us
+};
+
+void getAssetsStatistics(AssetsStatistics &statistics);
+
 const Style *getStyle(int styleID);
 const Widget *getPageWidget(int pageId);
+// With the sectioned assets fonts and bitmaps are loaded into the cache owned by the GUI thread,
+// so these are called only from the GUI thread. Returns nullptr if the item can't be loaded.
 const uint8_t *getFontData(int fontID);
+// Checks if fontData is the data of the given font without loading the font.
+bool isFontData(const uint8_t *fontData, int fontID);
 const Bitmap *getBitmap(int bitmapID);
 int getThemesCount();
 const char *getThemeName(int i);
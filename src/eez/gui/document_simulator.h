@@ -1934,4 +1934,4 @@ enum PagesEnum {
     PAGE_ID_FRONT_PANEL_NUMERIC_KEYPAD = 182
 };
 
-extern const uint8_t assets[519372];
+extern const uint8_t assets[410880];
@@ -1875,4 +1875,4 @@ enum PagesEnum {
     PAGE_ID_DIB_DCM220_CH_SETTINGS_SPECIFIC = 172
 };
 
-extern const uint8_t assets[311297];
+extern const uint8_t assets[255260];
@@ -24,6 +24,7 @@
 #include <eez/util.h>
 
 #include <eez/gui/gui.h>
+#include <eez/gui/text_run_cache.h>
 
 using namespace eez::mcu;
 
@@ -57,19 +58,19 @@ font::Font styleGetFont(const Style *style) {
 }
 
 bool styleGetSmallerFont(font::Font &font) {
-    if (font.fontData == getFontData(FONT_ID_OSWALD48)) {
+    if (isFontData(font.fontData, FONT_ID_OSWALD48)) {
         font.fontData = getFontData(FONT_ID_OSWALD38);
-    } else if (font.fontData == getFontData(FONT_ID_OSWALD38)) {
+    } else if (isFontData(font.fontData, FONT_ID_OSWALD38)) {
         font.fontData = getFontData(FONT_ID_OSWALD24);
-    } else if (font.fontData == getFontData(FONT_ID_OSWALD24)) {
+    } else if (isFontData(font.fontData, FONT_ID_OSWALD24)) {
         font.fontData = getFontData(FONT_ID_OSWALD20);
-    } else if (font.fontData == getFontData(FONT_ID_OSWALD20)) {
+    } else if (isFontData(font.fontData, FONT_ID_OSWALD20)) {
         font.fontData = getFontData(FONT_ID_OSWALD17);
-    } else if (font.fontData == getFontData(FONT_ID_OSWALD17)) {
+    } else if (isFontData(font.fontData, FONT_ID_OSWALD17)) {
         font.fontData = getFontData(FONT_ID_OSWALD14);
-    } else if (font.fontData == getFontData(FONT_ID_OSWALD14)) {
+    } else if (isFontData(font.fontData, FONT_ID_OSWALD14)) {
         font.fontData = getFontData(FONT_ID_OSWALD12);
-    } else if (font.fontData == getFontData(FONT_ID_OSWALD12)) {
+    } else if (isFontData(font.fontData, FONT_ID_OSWALD12)) {
         font.fontData = getFontData(FONT_ID_ROBOTO_CONDENSED_REGULAR);
     } else {
         return false;
@@ -108,7 +109,27 @@ void drawText(const char *text, int textLength, int x, int y, int w, int h, cons
         y2 -= style->border_size_bottom;
     }
 
+    uint16_t backgroundColor;
+    uint16_t color;
+    if (active || blink) {
+        backgroundColor = overrideActiveBackgroundColor ? *overrideActiveBackgroundColor : style->active_background_color;
+        color = overrideActiveColor ? *overrideActiveColor : style->active_color;
+    } else {
+        backgroundColor = overrideBackgroundColor ? *overrideBackgroundColor : style->background_color;
+        color = overrideColor ? *overrideColor : style->color;
+    }
+
+    text_run_cache::Key key;
+    bool isCacheable = text_run_cache::initKey(key, text, textLength, x1, y1, x2, y2, borderRadius, style, color, backgroundColor, ignoreLuminocity, useSmallerFontIfDoesNotFit);
+    if (isCacheable && text_run_cache::draw(key, x1, y1)) {
+        return;
+    }
+
     font::Font font = styleGetFont(style);
+    if (!font.fontData) {
+        // font is not loaded, don't cache the text run drawn without the text
+        isCacheable = false;
+    }
 
     int width = display::measureStr(text, textLength, font, 0);
     while (useSmallerFontIfDoesNotFit && width > x2 - x1 + 1 && styleGetSmallerFont(font)) {
@@ -138,41 +159,25 @@ void drawText(const char *text, int textLength, int x, int y, int w, int h, cons
     } else {
         y_offset = y1 + ((y2 - y1 + 1) - height) / 2;
     }
+    if (y_offset < y1) {
+        // text position relative to the inner rectangle would depend on y1
+        isCacheable = false;
+    }
     if (y_offset < 0) {
         y_offset = y1;
     }
 
     // fill background
-    if (active || blink) {
-        if (overrideActiveBackgroundColor) {
-            display::setColor(*overrideActiveBackgroundColor, ignoreLuminocity);
-        } else {
-            display::setColor(style->active_background_color, ignoreLuminocity);
-        }
-    } else {
-        if (overrideBackgroundColor) {
-            display::setColor(*overrideBackgroundColor, ignoreLuminocity);
-        } else {
-            display::setColor(style->background_color, ignoreLuminocity);
-        }
-    }
+    display::setColor(backgroundColor, ignoreLuminocity);
     display::fillRect(x1, y1, x2, y2, borderRadius);
 
     // draw text
-    if (active || blink) {
-        if (overrideActiveColor) {
-            display::setColor(*overrideActiveColor, ignoreLuminocity);
-        } else {
-            display::setColor(style->active_color, ignoreLuminocity);
-        }
-    }  else {
-        if (overrideColor) {
-            display::setColor(*overrideColor, ignoreLuminocity);
-        } else {
-            display::setColor(style->color, ignoreLuminocity);
-        }
-    }
+    display::setColor(color, ignoreLuminocity);
     display::drawStr(text, textLength, x_offset, y_offset, x1, y1, x2, y2, font);
+
+    if (isCacheable) {
+        text_run_cache::store(key, x1, y1);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -460,6 +465,31 @@ void drawBitmap(Image *image, int x, int y, int w, int h, const Style *style, bo
     if (y_offset < 0)
         y_offset = y1;
 
+    // image bigger than the widget, e.g. screenshot taken in the simulator, is clipped
+    Image clippedImage = *image;
+    uint32_t bytesPerPixel = image->bpp / 8;
+    if (x_offset < x1) {
+        clippedImage.pixels += (x1 - x_offset) * bytesPerPixel;
+        width -= x1 - x_offset;
+        x_offset = x1;
+    }
+    if (x_offset + width - 1 > x2) {
+        width = x2 - x_offset + 1;
+    }
+    if (y_offset < y1) {
+        clippedImage.pixels += (y1 - y_offset) * (image->width + image->lineOffset) * bytesPerPixel;
+        height -= y1 - y_offset;
+        y_offset = y1;
+    }
+    if (y_offset + height - 1 > y2) {
+        height = y2 - y_offset + 1;
+    }
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    clippedImage.width = width;
+    clippedImage.height = height;
+    clippedImage.lineOffset = image->lineOffset + image->width - width;
 
     // draw bitmap
     uint8_t savedOpacity = display::getOpacity();
@@ -474,7 +504,7 @@ void drawBitmap(Image *image, int x, int y, int w, int h, const Style *style, bo
         display::setOpacity(style->opacity);
     }
 
-    display::drawBitmap(image, x_offset, y_offset);
+    display::drawBitmap(&clippedImage, x_offset, y_offset);
 
     display::setOpacity(savedOpacity);
 }
@@ -30,6 +30,7 @@
 #define CONF_GUI_KEYPAD_NEXT_AUTO_REPEAT_DELAY     50000L // 50ms
 #define CONF_GUI_EXTRA_LONG_TOUCH_TIMEOUT       15000000L // 15s
 #define CONF_GUI_MOUSE_TIMEOUT                  10000000L // 10s
+#define CONF_GUI_VELOCITY_WINDOW                  100000L // 100ms
 
 namespace eez {
 namespace gui {
@@ -44,6 +45,19 @@ static uint32_t m_lastAutoRepeatEventTime;
 static bool m_longTouchGenerated;
 static bool m_extraLongTouchGenerated;
 
+// Velocity is estimated from the positions in the last CONF_GUI_VELOCITY_WINDOW,
+// so the touch which stopped before it was released doesn't fling.
+static const uint32_t NUM_VELOCITY_SAMPLES = 16;
+struct VelocitySample {
+    uint32_t time;
+    int x;
+    int y;
+};
+static VelocitySample m_velocitySamples[NUM_VELOCITY_SAMPLES];
+static uint32_t m_numVelocitySamples;
+static int m_vx;
+static int m_vy;
+
 bool g_mouseCursorVisible;
 int g_mouseCursorX;
 int g_mouseCursorY;
@@ -54,7 +68,8 @@ bool g_mouseWasDown;
 int g_mouseWasCursorX;
 int g_mouseWasCursorY;
 
-static void processTouchEvent(EventType type, int x, int y);
+static void processEvent(EventType type, int x, int y, uint32_t time);
+static void processTouchEvent(EventType type, int x, int y, uint32_t time);
 static void onPageTouch(const WidgetCursor &foundWidget, Event &touchEvent);
 static void onWidgetDefaultTouch(const WidgetCursor &widgetCursor, Event &touchEvent);
 
@@ -87,48 +102,87 @@ void eventHandling() {
     g_mouseWasCursorY = g_mouseCursorY;
 
 
-    auto eventType = touch::getEventType();
-    
-    int eventX;
-    int eventY;
-    if (eventType == EVENT_TYPE_TOUCH_NONE && g_mouseCursorVisible) {
-        eventType = mouseEventType;
-        eventX = g_mouseCursorX;
-        eventY = g_mouseCursorY;
-    } else {
-        eventX = touch::getX();
-        eventY = touch::getY();
+    // all the touch events read since the last iteration are processed, every one with its own position and time
+    bool isTouchEvent = false;
+    while (touch::nextEvent()) {
+        isTouchEvent = true;
+        processEvent(touch::getEventType(), touch::getX(), touch::getY(), touch::getEventTime());
     }
 
-    if (eventType != EVENT_TYPE_TOUCH_NONE) {
-        eez::hmi::noteActivity();
-
-        if (eventType == EVENT_TYPE_TOUCH_DOWN) {
-            m_touchDownTime = tickCount;
-            m_lastAutoRepeatEventTime = tickCount;
-            m_longTouchGenerated = false;
-            m_extraLongTouchGenerated = false;
-            processTouchEvent(EVENT_TYPE_TOUCH_DOWN, eventX, eventY);
-        } else if (eventType == EVENT_TYPE_TOUCH_MOVE) {
-            processTouchEvent(EVENT_TYPE_TOUCH_MOVE, eventX, eventY);
-
-            if (!m_longTouchGenerated && int32_t(tickCount - m_touchDownTime) >= CONF_GUI_LONG_TOUCH_TIMEOUT) {
-                m_longTouchGenerated = true;
-                processTouchEvent(EVENT_TYPE_LONG_TOUCH, eventX, eventY);
-            }
+    if (!isTouchEvent && g_mouseCursorVisible && mouseEventType != EVENT_TYPE_TOUCH_NONE) {
+        processEvent(mouseEventType, g_mouseCursorX, g_mouseCursorY, tickCount);
+    }
+}
 
-            if (m_longTouchGenerated && !m_extraLongTouchGenerated && int32_t(tickCount - m_touchDownTime) >= CONF_GUI_EXTRA_LONG_TOUCH_TIMEOUT) {
-                m_extraLongTouchGenerated = true;
-                processTouchEvent(EVENT_TYPE_EXTRA_LONG_TOUCH, eventX, eventY);
-            }
+static void processEvent(EventType eventType, int eventX, int eventY, uint32_t time) {
+    eez::hmi::noteActivity();
+
+    if (eventType == EVENT_TYPE_TOUCH_DOWN) {
+        m_touchDownTime = time;
+        m_lastAutoRepeatEventTime = time;
+        m_longTouchGenerated = false;
+        m_extraLongTouchGenerated = false;
+        processTouchEvent(EVENT_TYPE_TOUCH_DOWN, eventX, eventY, time);
+    } else if (eventType == EVENT_TYPE_TOUCH_MOVE) {
+        processTouchEvent(EVENT_TYPE_TOUCH_MOVE, eventX, eventY, time);
+
+        if (!m_longTouchGenerated && int32_t(time - m_touchDownTime) >= CONF_GUI_LONG_TOUCH_TIMEOUT) {
+            m_longTouchGenerated = true;
+            processTouchEvent(EVENT_TYPE_LONG_TOUCH, eventX, eventY, time);
+        }
+
+        if (m_longTouchGenerated && !m_extraLongTouchGenerated && int32_t(time - m_touchDownTime) >= CONF_GUI_EXTRA_LONG_TOUCH_TIMEOUT) {
+            m_extraLongTouchGenerated = true;
+            processTouchEvent(EVENT_TYPE_EXTRA_LONG_TOUCH, eventX, eventY, time);
+        }
+
+        if (int32_t(time - m_lastAutoRepeatEventTime) >= (m_lastAutoRepeatEventTime == m_touchDownTime ? CONF_GUI_KEYPAD_FIRST_AUTO_REPEAT_DELAY : CONF_GUI_KEYPAD_NEXT_AUTO_REPEAT_DELAY)) {
+            processTouchEvent(EVENT_TYPE_AUTO_REPEAT, eventX, eventY, time);
+            m_lastAutoRepeatEventTime = time;
+        }
+    } else if (eventType == EVENT_TYPE_TOUCH_UP) {
+        processTouchEvent(EVENT_TYPE_TOUCH_UP, eventX, eventY, time);
+    }
+}
 
-            if (int32_t(tickCount - m_lastAutoRepeatEventTime) >= (m_lastAutoRepeatEventTime == m_touchDownTime ? CONF_GUI_KEYPAD_FIRST_AUTO_REPEAT_DELAY : CONF_GUI_KEYPAD_NEXT_AUTO_REPEAT_DELAY)) {
-                processTouchEvent(EVENT_TYPE_AUTO_REPEAT, eventX, eventY);
-                m_lastAutoRepeatEventTime = tickCount;
+static void updateVelocity(EventType type, int x, int y, uint32_t time) {
+    if (type == EVENT_TYPE_TOUCH_DOWN) {
+        m_numVelocitySamples = 0;
+    } else if (type == EVENT_TYPE_TOUCH_UP) {
+        // touch is released at the last position, fling velocity is the velocity at that position
+        if (m_numVelocitySamples > 0) {
+            const VelocitySample &lastSample = m_velocitySamples[(m_numVelocitySamples - 1) % NUM_VELOCITY_SAMPLES];
+            if (lastSample.x == x && lastSample.y == y) {
+                return;
             }
-        } else if (eventType == EVENT_TYPE_TOUCH_UP) {
-            processTouchEvent(EVENT_TYPE_TOUCH_UP, eventX, eventY);
         }
+    } else if (type != EVENT_TYPE_TOUCH_MOVE) {
+        return;
+    }
+
+    VelocitySample &sample = m_velocitySamples[m_numVelocitySamples % NUM_VELOCITY_SAMPLES];
+    sample.time = time;
+    sample.x = x;
+    sample.y = y;
+    m_numVelocitySamples++;
+
+    const VelocitySample *oldestSample = &sample;
+    for (uint32_t i = 1; i < MIN(m_numVelocitySamples, NUM_VELOCITY_SAMPLES); i++) {
+        const VelocitySample &previousSample = m_velocitySamples[(m_numVelocitySamples - 1 - i) % NUM_VELOCITY_SAMPLES];
+        // at least one previous sample is used, even if the samples are sparse
+        if (i > 1 && int32_t(time - previousSample.time) > CONF_GUI_VELOCITY_WINDOW) {
+            break;
+        }
+        oldestSample = &previousSample;
+    }
+
+    int32_t dt = time - oldestSample->time;
+    if (dt > 0) {
+        m_vx = (int)((int64_t)(x - oldestSample->x) * 1000000 / dt);
+        m_vy = (int)((int64_t)(y - oldestSample->y) * 1000000 / dt);
+    } else {
+        m_vx = 0;
+        m_vy = 0;
     }
 }
 
@@ -170,7 +224,9 @@ void onMouseDisconnected() {
     g_mouseDown = false;
 }
 
-static void processTouchEvent(EventType type, int x, int y) {
+static void processTouchEvent(EventType type, int x, int y, uint32_t time) {
+    updateVelocity(type, x, y, time);
+
     if (type == EVENT_TYPE_TOUCH_DOWN) {
         m_foundWidgetAtDown = findWidget(&getRootAppContext(), x, y);
         m_onTouchFunction = getWidgetTouchFunction(m_foundWidgetAtDown);
@@ -186,6 +242,9 @@ static void processTouchEvent(EventType type, int x, int y) {
         event.type = type;
         event.x = x;
         event.y = y;
+        event.time = time;
+        event.vx = m_vx;
+        event.vy = m_vy;
 
         m_onTouchFunction(m_foundWidgetAtDown, event);
     }
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 namespace eez {
 namespace gui {
 
@@ -35,6 +37,10 @@ struct Event {
     EventType type;
     int x;
     int y;
+    uint32_t time; // us
+    // estimated velocity in pixels per second, at EVENT_TYPE_TOUCH_UP it is the fling velocity
+    int vx;
+    int vy;
 };
 
 void eventHandling();
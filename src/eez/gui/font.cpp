@@ -43,12 +43,15 @@ Font::Font() : fontData(0) {
 Font::Font(const uint8_t *data) : fontData(data) {
 }
 
+// fontData is nullptr if the font couldn't be loaded into the assets cache,
+// such font has no glyphs and zero height
+
 uint8_t Font::getAscent() {
-    return fontData[0];
+    return fontData ? fontData[0] : 0;
 }
 
 uint8_t Font::getDescent() {
-    return fontData[1];
+    return fontData ? fontData[1] : 0;
 }
 
 uint8_t Font::getEncodingStart() {
@@ -64,6 +67,10 @@ uint8_t Font::getHeight() {
 }
 
 const uint8_t *Font::findGlyphData(uint8_t encoding) {
+    if (!fontData) {
+        return nullptr;
+    }
+
     uint8_t start = getEncodingStart();
     uint8_t end = getEncodingEnd();
 
@@ -109,6 +116,12 @@ void Font::getGlyph(uint8_t requested_encoding, Glyph &glyph) {
     glyph.data = findGlyphData(requested_encoding);
     if (glyph.data) {
         fillGlyphParameters(glyph);
+    } else {
+        glyph.dx = 0;
+        glyph.width = 0;
+        glyph.height = 0;
+        glyph.x = 0;
+        glyph.y = 0;
     }
 }
 
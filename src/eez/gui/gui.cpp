@@ -27,8 +27,14 @@
 
 #include <eez/sound.h>
 #include <eez/util.h>
+#include <eez/profiler.h>
 
 #include <eez/gui/gui.h>
+#include <eez/gui/input.h>
+
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+#include <eez/platform/simulator/headless.h>
+#endif
 
 #define CONF_GUI_BLINK_TIME 400 // 400ms
 
@@ -122,6 +128,10 @@ void oneIter() {
     //     lastTime = 1;
     // }
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    uint32_t queueDepth = 0;
+#endif
+
     while (true) {
         osEvent event = osMessageGet(g_guiMessageQueueId, timeout);
 
@@ -135,17 +145,34 @@ void oneIter() {
         uint8_t type = GUI_QUEUE_MESSAGE_TYPE(message);
         int16_t param = GUI_QUEUE_MESSAGE_PARAM(message);
         onGuiQueueMessage(type, param);
+
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+        queueDepth++;
+#endif
     }
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    platform::simulator::headless::ThreadIterationScope iterationScope(platform::simulator::headless::THREAD_GUI, queueDepth);
+#endif
+    PROFILER_ZONE(GUI_ITER);
+
     WATCHDOG_RESET();
 
     mcu::display::sync();
+    input::onFrameShown();
+
+    tickAssetsCache();
 
     g_wasBlinkTime = g_isBlinkTime;
     g_isBlinkTime = (millis() % (2 * CONF_GUI_BLINK_TIME)) > CONF_GUI_BLINK_TIME;
 
     touch::tick();
 
+    input::InputEvent keyboardEvent;
+    while (input::pop(input::SOURCE_KEYBOARD, keyboardEvent)) {
+        onGuiQueueMessageHook(GUI_QUEUE_MESSAGE_KEY_DOWN, (keyboardEvent.y << 8) | keyboardEvent.x);
+    }
+
     AppContext *appContext = &getRootAppContext();
 
     appContext->rect.x = 0;
@@ -165,6 +192,9 @@ void oneIter() {
         if (!wasOn) {
             mcu::display::beginBuffersDrawing();
         }
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+        platform::simulator::headless::FrameRenderScope frameRenderScope;
+#endif
         updateScreen();
     }
 
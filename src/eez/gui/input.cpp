@@ -0,0 +1,136 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if OPTION_DISPLAY
+
+#include <string.h>
+#include <atomic>
+
+#include <eez/system.h>
+
+#include <eez/gui/input.h>
+
+namespace eez {
+namespace gui {
+namespace input {
+
+static const uint32_t RING_SIZE = 64;
+
+// Head is moved only by the producer and tail only by the consumer.
+// Both are free running, the slot index is the counter modulo RING_SIZE.
+struct Ring {
+    InputEvent events[RING_SIZE];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> numFullRingPushes;
+};
+
+static Ring g_rings[NUM_SOURCES];
+
+static Statistics g_statistics;
+
+// time of the oldest event popped since the last frame was shown
+static bool g_isEventPending;
+static uint32_t g_pendingEventTime;
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool push(Source source, uint8_t type, int16_t x, int16_t y) {
+    Ring &ring = g_rings[source];
+
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == RING_SIZE) {
+        ring.numFullRingPushes++;
+        return false;
+    }
+
+    InputEvent &event = ring.events[head % RING_SIZE];
+    event.time = micros();
+    event.type = type;
+    event.x = x;
+    event.y = y;
+
+    ring.head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool pop(Source source, InputEvent &event) {
+    Ring &ring = g_rings[source];
+
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t numQueuedEvents = ring.head.load(std::memory_order_acquire) - tail;
+    if (numQueuedEvents == 0) {
+        return false;
+    }
+
+    event = ring.events[tail % RING_SIZE];
+
+    ring.tail.store(tail + 1, std::memory_order_release);
+
+    g_statistics.numEvents[source]++;
+    if (numQueuedEvents > g_statistics.maxQueuedEvents[source]) {
+        g_statistics.maxQueuedEvents[source] = numQueuedEvents;
+    }
+
+    if (!g_isEventPending) {
+        g_isEventPending = true;
+        g_pendingEventTime = event.time;
+    }
+
+    return true;
+}
+
+void onFrameShown() {
+    if (!g_isEventPending) {
+        return;
+    }
+
+    g_isEventPending = false;
+
+    uint32_t latency = micros() - g_pendingEventTime;
+
+    g_statistics.numFrames++;
+    g_statistics.lastLatency = latency;
+    if (latency > g_statistics.maxLatency) {
+        g_statistics.maxLatency = latency;
+    }
+    g_statistics.totalLatency += latency;
+}
+
+void getStatistics(Statistics &statistics) {
+    memcpy(&statistics, &g_statistics, sizeof(Statistics));
+
+    for (int i = 0; i < NUM_SOURCES; i++) {
+        statistics.numFullRingPushes[i] = g_rings[i].numFullRingPushes;
+    }
+}
+
+void resetStatistics() {
+    memset(&g_statistics, 0, sizeof(Statistics));
+
+    for (int i = 0; i < NUM_SOURCES; i++) {
+        g_rings[i].numFullRingPushes = 0;
+    }
+}
+
+} // namespace input
+} // namespace gui
+} // namespace eez
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+namespace input {
+
+// Input events are passed from the thread or the interrupt where they are read to the GUI thread
+// through the lock-free rings, one ring for every source. Every ring has a single producer
+// and a single consumer (GUI thread), so no mutex is needed and no event is lost
+// because the GUI thread was busy drawing.
+
+enum Source {
+    SOURCE_TOUCH,    // type is EventType, x and y is the position
+    SOURCE_ENCODER,  // x is the counter
+    SOURCE_KEYBOARD, // x is the key code, y are the key modifiers
+    NUM_SOURCES
+};
+
+struct InputEvent {
+    uint32_t time; // us
+    uint8_t type;
+    int16_t x;
+    int16_t y;
+};
+
+// Called only from the producer of the source, returns false if the ring is full.
+bool push(Source source, uint8_t type, int16_t x, int16_t y);
+
+// Called only from the GUI thread.
+bool pop(Source source, InputEvent &event);
+
+// Called from the GUI thread when the display is synced, i.e. the frame drawn
+// after the last popped events were handled is shown.
+void onFrameShown();
+
+struct Statistics {
+    uint32_t numEvents[NUM_SOURCES];
+    // Touch and encoder push the change again with the next read,
+    // so the moves are coalesced and the counter is added to the next one.
+    uint32_t numFullRingPushes[NUM_SOURCES];
+    uint32_t maxQueuedEvents[NUM_SOURCES];
+    uint32_t numFrames; // frames shown after the events
+    uint32_t lastLatency; // us, from the event to the frame shown
+    uint32_t maxLatency; // us
+    uint64_t totalLatency; // us
+};
+
+void getStatistics(Statistics &statistics);
+void resetStatistics();
+
+} // namespace input
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,304 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if OPTION_DISPLAY
+
+#include <string.h>
+
+#include <eez/memory.h>
+#include <eez/system.h>
+
+#include <eez/gui/gui.h>
+#include <eez/gui/text_run_cache.h>
+
+using namespace eez::mcu;
+
+namespace eez {
+namespace gui {
+namespace text_run_cache {
+
+// Pixels of the text runs are allocated one after another in the circular buffer,
+// the oldest text runs are evicted when the buffer wraps around.
+
+static const int NUM_ENTRIES = 64;
+
+// big text runs would evict too many small ones
+static const uint32_t MAX_PIXELS_SIZE = TEXT_RUN_CACHE_MEMORY_SIZE / 8;
+
+struct Entry {
+    Key key;
+    bool isUsed;
+    uint32_t pixelsOffset;
+    uint32_t pixelsSize;
+};
+
+static bool g_isEnabled = true;
+
+static Entry g_entries[NUM_ENTRIES];
+static int g_nextEntryIndex;
+static uint32_t g_nextPixelsOffset;
+
+static Statistics g_statistics;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static Entry *findEntry(const Key &key) {
+    for (int i = 0; i < NUM_ENTRIES; i++) {
+        Entry &entry = g_entries[i];
+        if (
+            entry.isUsed &&
+            entry.key.hash == key.hash &&
+            entry.key.style == key.style &&
+            entry.key.color == key.color &&
+            entry.key.backgroundColor == key.backgroundColor &&
+            entry.key.ignoreLuminocity == key.ignoreLuminocity &&
+            entry.key.width == key.width &&
+            entry.key.height == key.height &&
+            entry.key.textLength == key.textLength &&
+            entry.key.useSmallerFontIfDoesNotFit == key.useSmallerFontIfDoesNotFit &&
+            memcmp(entry.key.text, key.text, key.textLength) == 0
+        ) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+static void evictEntry(Entry &entry) {
+    entry.isUsed = false;
+    g_statistics.numEvictions++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool initKey(Key &key, const char *text, int textLength, int x1, int y1, int x2, int y2, int borderRadius,
+             const Style *style, uint16_t color, uint16_t backgroundColor, bool ignoreLuminocity, bool useSmallerFontIfDoesNotFit) {
+    if (!g_isEnabled || borderRadius != 0 || display::getOpacity() != 255) {
+        return false;
+    }
+
+    if (x1 < 0 || y1 < 0 || x2 >= display::getDisplayWidth() || y2 >= display::getDisplayHeight() || x1 > x2 || y1 > y2) {
+        return false;
+    }
+
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    int length;
+    for (length = 0; (textLength == -1 || length < textLength) && text[length]; length++) {
+        if (length == MAX_TEXT_LENGTH) {
+            return false;
+        }
+        key.text[length] = text[length];
+        hash = (hash ^ (uint8_t)text[length]) * 16777619u;
+    }
+
+    key.hash = hash;
+    key.style = style;
+
+    // colors are compared after the transformation done by the display,
+    // the same as drawText does it
+    uint16_t savedColor = display::getColor();
+    display::setColor(color, ignoreLuminocity);
+    key.color = display::getColor();
+    display::setColor(backgroundColor, ignoreLuminocity);
+    key.backgroundColor = display::getColor();
+    display::setColor16(savedColor);
+    key.ignoreLuminocity = ignoreLuminocity;
+
+    key.width = x2 - x1 + 1;
+    key.height = y2 - y1 + 1;
+    key.textLength = length;
+    key.useSmallerFontIfDoesNotFit = useSmallerFontIfDoesNotFit;
+
+    return true;
+}
+
+bool draw(const Key &key, int x, int y) {
+    Entry *entry = findEntry(key);
+    if (!entry) {
+        g_statistics.numMisses++;
+        return false;
+    }
+
+    display::writePixels(TEXT_RUN_CACHE_MEMORY + entry->pixelsOffset, x, y, key.width, key.height);
+
+    g_statistics.numHits++;
+    return true;
+}
+
+void store(const Key &key, int x, int y) {
+    uint32_t pixelsSize = (display::getPixelsSize(key.width, key.height) + 3) & ~3;
+    if (pixelsSize > MAX_PIXELS_SIZE) {
+        return;
+    }
+
+    if (g_nextPixelsOffset + pixelsSize > TEXT_RUN_CACHE_MEMORY_SIZE) {
+        g_nextPixelsOffset = 0;
+    }
+
+    for (int i = 0; i < NUM_ENTRIES; i++) {
+        Entry &entry = g_entries[i];
+        if (entry.isUsed && entry.pixelsOffset < g_nextPixelsOffset + pixelsSize && g_nextPixelsOffset < entry.pixelsOffset + entry.pixelsSize) {
+            evictEntry(entry);
+        }
+    }
+
+    Entry &entry = g_entries[g_nextEntryIndex];
+    g_nextEntryIndex = (g_nextEntryIndex + 1) % NUM_ENTRIES;
+    if (entry.isUsed) {
+        evictEntry(entry);
+    }
+
+    entry.key.hash = key.hash;
+    entry.key.style = key.style;
+    entry.key.color = key.color;
+    entry.key.backgroundColor = key.backgroundColor;
+    entry.key.ignoreLuminocity = key.ignoreLuminocity;
+    entry.key.width = key.width;
+    entry.key.height = key.height;
+    entry.key.textLength = key.textLength;
+    entry.key.useSmallerFontIfDoesNotFit = key.useSmallerFontIfDoesNotFit;
+    memcpy(entry.key.text, key.text, key.textLength);
+
+    entry.pixelsOffset = g_nextPixelsOffset;
+    entry.pixelsSize = pixelsSize;
+    g_nextPixelsOffset += pixelsSize;
+
+    display::readPixels(x, y, key.width, key.height, TEXT_RUN_CACHE_MEMORY + entry.pixelsOffset);
+
+    entry.isUsed = true;
+
+    g_statistics.numStores++;
+}
+
+void invalidate() {
+    for (int i = 0; i < NUM_ENTRIES; i++) {
+        g_entries[i].isUsed = false;
+    }
+    g_nextEntryIndex = 0;
+    g_nextPixelsOffset = 0;
+}
+
+void setEnabled(bool enabled) {
+    g_isEnabled = enabled;
+}
+
+bool isEnabled() {
+    return g_isEnabled;
+}
+
+void getStatistics(Statistics &statistics) {
+    memcpy(&statistics, &g_statistics, sizeof(Statistics));
+
+    statistics.numEntries = 0;
+    statistics.pixelsMemoryUsed = 0;
+    for (int i = 0; i < NUM_ENTRIES; i++) {
+        if (g_entries[i].isUsed) {
+            statistics.numEntries++;
+            statistics.pixelsMemoryUsed += g_entries[i].pixelsSize;
+        }
+    }
+}
+
+void resetStatistics() {
+    memset(&g_statistics, 0, sizeof(Statistics));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void drawBenchmarkText(const BenchmarkText &text) {
+    drawText(text.text, -1, 0, 0, text.width, text.height, getStyle(text.styleId), false, false, false, nullptr, nullptr, nullptr, nullptr);
+}
+
+void benchmark(const BenchmarkText *texts, int numTexts, int numIterations, BenchmarkResult &result) {
+    bool wasEnabled = g_isEnabled;
+    uint8_t savedOpacity = display::setOpacity(255);
+
+    result.numDraws = numTexts * numIterations;
+
+    g_isEnabled = false;
+    uint32_t startTime = micros();
+    for (int iteration = 0; iteration < numIterations; iteration++) {
+        for (int i = 0; i < numTexts; i++) {
+            drawBenchmarkText(texts[i]);
+        }
+    }
+    result.uncachedTime = micros() - startTime;
+
+    g_isEnabled = true;
+    invalidate();
+    for (int i = 0; i < numTexts; i++) {
+        drawBenchmarkText(texts[i]);
+    }
+    startTime = micros();
+    for (int iteration = 0; iteration < numIterations; iteration++) {
+        for (int i = 0; i < numTexts; i++) {
+            drawBenchmarkText(texts[i]);
+        }
+    }
+    result.cachedTime = micros() - startTime;
+
+    // screenshot buffer is borrowed for the check, it is big enough for two text runs
+    uint8_t *drawnPixels = SCREENSHOOT_BUFFER_START_ADDRESS;
+    uint8_t *cachedPixels = SCREENSHOOT_BUFFER_START_ADDRESS + SCREENSHOOT_BUFFER_SIZE / 2;
+
+    result.numCachedTexts = 0;
+    result.isPixelIdentical = true;
+
+    for (int i = 0; i < numTexts; i++) {
+        const BenchmarkText &text = texts[i];
+
+        uint32_t pixelsSize = display::getPixelsSize(text.width, text.height);
+        if (pixelsSize > SCREENSHOOT_BUFFER_SIZE / 2) {
+            continue;
+        }
+
+        g_isEnabled = false;
+        drawBenchmarkText(text);
+        display::readPixels(0, 0, text.width, text.height, drawnPixels);
+
+        g_isEnabled = true;
+        drawBenchmarkText(text);
+
+        // clear the text run, so it is certain that the cached pixels are drawn
+        display::setColor(0, 0, 0);
+        display::fillRect(0, 0, text.width - 1, text.height - 1);
+
+        uint32_t numHits = g_statistics.numHits;
+        drawBenchmarkText(text);
+        if (g_statistics.numHits == numHits) {
+            continue;
+        }
+
+        result.numCachedTexts++;
+
+        display::readPixels(0, 0, text.width, text.height, cachedPixels);
+        if (memcmp(drawnPixels, cachedPixels, pixelsSize) != 0) {
+            result.isPixelIdentical = false;
+        }
+    }
+
+    g_isEnabled = wasEnabled;
+    display::setOpacity(savedOpacity);
+}
+
+} // namespace text_run_cache
+} // namespace gui
+} // namespace eez
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+
+struct Style;
+
+namespace text_run_cache {
+
+// Text run is the inner rectangle of the text widget: background filled with the solid color
+// and the text drawn over it. Such rectangle depends only on the text, style, colors and size,
+// so it is drawn once and later copied from the cache, pixel by pixel the same.
+
+static const int MAX_TEXT_LENGTH = 32;
+
+struct Key {
+    uint32_t hash;
+    const Style *style;
+    uint16_t color;
+    uint16_t backgroundColor;
+    bool ignoreLuminocity;
+    int16_t width;
+    int16_t height;
+    uint8_t textLength;
+    bool useSmallerFontIfDoesNotFit;
+    char text[MAX_TEXT_LENGTH];
+};
+
+// Returns false if the text run can't be cached, colors are indexes as given to display::setColor.
+bool initKey(Key &key, const char *text, int textLength, int x1, int y1, int x2, int y2, int borderRadius,
+             const Style *style, uint16_t color, uint16_t backgroundColor, bool ignoreLuminocity, bool useSmallerFontIfDoesNotFit);
+
+// Draws the cached text run at the given position, returns false if it is not in the cache.
+bool draw(const Key &key, int x, int y);
+
+// Copies the text run just drawn at the given position to the cache.
+void store(const Key &key, int x, int y);
+
+// Must be called when the fonts or the styles are changed.
+void invalidate();
+
+void setEnabled(bool enabled);
+bool isEnabled();
+
+struct Statistics {
+    uint32_t numHits;
+    uint32_t numMisses;
+    uint32_t numStores;
+    uint32_t numEvictions;
+    uint32_t numEntries;
+    uint32_t pixelsMemoryUsed;
+};
+
+void getStatistics(Statistics &statistics);
+void resetStatistics();
+
+struct BenchmarkText {
+    int styleId;
+    int width;
+    int height;
+    const char *text;
+};
+
+struct BenchmarkResult {
+    uint32_t numDraws;
+    uint32_t numCachedTexts;
+    uint32_t uncachedTime; // us
+    uint32_t cachedTime; // us
+    bool isPixelIdentical;
+};
+
+// Draws every text the given number of times at the top left corner of the display,
+// first with the cache disabled and then with the cache enabled, and checks that
+// the cached text runs are the same as the drawn ones. Must be called from the GUI thread,
+// caller should refresh the screen after.
+void benchmark(const BenchmarkText *texts, int numTexts, int numIterations, BenchmarkResult &result);
+
+} // namespace text_run_cache
+} // namespace gui
+} // namespace eez
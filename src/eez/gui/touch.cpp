@@ -16,8 +16,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <eez/system.h>
+
 #include <eez/gui/gui.h>
 #include <eez/gui/touch_filter.h>
+#include <eez/gui/input.h>
 
 #include <eez/modules/mcu/touch.h>
 
@@ -27,8 +30,6 @@ namespace eez {
 namespace gui {
 namespace touch {
 
-static EventType g_lastEventType = EVENT_TYPE_TOUCH_NONE;
-
 static int g_x = -1;
 static int g_y = -1;
 static bool g_pressed = false;
@@ -43,27 +44,23 @@ static bool g_filteredPressed = false;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// touch state as it was last pushed to the input ring, i.e. as it is seen by the GUI thread
+static bool g_pushedPressed = false;
+static int g_pushedX = -1;
+static int g_pushedY = -1;
+
+////////////////////////////////////////////////////////////////////////////////
+
 static EventType g_eventType = EVENT_TYPE_TOUCH_NONE;
 static int g_eventX = -1;
 static int g_eventY = -1;
+static uint32_t g_eventTime;
+static bool g_isEventInIteration;
 
 ////////////////////////////////////////////////////////////////////////////////
 
 #if defined(EEZ_PLATFORM_STM32)
 
-static const int EVENT_QUEUE_MAX_SIZE = 50;
-struct Event {
-    EventType type;
-    int x;
-    int y;
-};
-static Event g_eventQueue[EVENT_QUEUE_MAX_SIZE];
-static uint8_t g_eventQueueHead = 0;
-static uint8_t g_eventQueueTail = 0;
-static bool g_eventQueueFull;
-osMutexId(g_eventQueueMutexId);
-osMutexDef(g_eventQueueMutex);
-
 void mainLoop(const void *);
 
 #if defined(EEZ_PLATFORM_STM32)
@@ -117,93 +114,74 @@ void oneIter() {
     g_pressed = pressed;
 #endif
 
+    // Only the changes of the touch state are pushed. If the ring is full, the change is pushed
+    // in some of the next iterations, so the moves are coalesced, but the GUI thread never
+    // sees the move without the down or the down without the up.
     if (g_pressed) {
-        if (g_lastEventType == EVENT_TYPE_TOUCH_NONE || g_lastEventType == EVENT_TYPE_TOUCH_UP) {
-            g_lastEventType = EVENT_TYPE_TOUCH_DOWN;
-        } else {
-            if (g_lastEventType == EVENT_TYPE_TOUCH_DOWN) {
-                g_lastEventType = EVENT_TYPE_TOUCH_MOVE;
+        if (!g_pushedPressed) {
+            if (input::push(input::SOURCE_TOUCH, EVENT_TYPE_TOUCH_DOWN, g_x, g_y)) {
+                g_pushedPressed = true;
+                g_pushedX = g_x;
+                g_pushedY = g_y;
+            }
+        } else if (g_x != g_pushedX || g_y != g_pushedY) {
+            if (input::push(input::SOURCE_TOUCH, EVENT_TYPE_TOUCH_MOVE, g_x, g_y)) {
+                g_pushedX = g_x;
+                g_pushedY = g_y;
             }
         }
     } else {
-        if (g_lastEventType == EVENT_TYPE_TOUCH_DOWN || g_lastEventType == EVENT_TYPE_TOUCH_MOVE) {
-            g_lastEventType = EVENT_TYPE_TOUCH_UP;
-        } else if (g_lastEventType == EVENT_TYPE_TOUCH_UP) {
-            g_lastEventType = EVENT_TYPE_TOUCH_NONE;
-        }
-    }
-
-#if defined(EEZ_PLATFORM_STM32)
-    if (g_lastEventType != EVENT_TYPE_TOUCH_NONE) {
-        if (osMutexWait(g_eventQueueMutexId, 5) == osOK) {
-		    if (g_eventQueueFull || g_eventQueueTail != g_eventQueueHead) {
-			    uint32_t previousEventQueueHead = g_eventQueueHead == 0 ? EVENT_QUEUE_MAX_SIZE - 1 : g_eventQueueHead - 1;
-                Event &event = g_eventQueue[previousEventQueueHead];
-                if (event.type == g_lastEventType) {
-                	g_eventQueueHead = previousEventQueueHead;
-                }
+        if (g_pushedPressed) {
+            if (input::push(input::SOURCE_TOUCH, EVENT_TYPE_TOUCH_UP, g_pushedX, g_pushedY)) {
+                g_pushedPressed = false;
             }
-
-			Event &event = g_eventQueue[g_eventQueueHead];
-
-			event.type = g_lastEventType;
-			event.x = g_x;
-			event.y = g_y;
-
-			if (g_eventQueueFull) {
-				g_eventQueueTail = (g_eventQueueTail + 1) % EVENT_QUEUE_MAX_SIZE;
-			}
-
-			g_eventQueueHead = (g_eventQueueHead + 1) % EVENT_QUEUE_MAX_SIZE;
-
-			if (g_eventQueueHead == g_eventQueueTail) {
-				g_eventQueueFull = true;
-			}
-
-            osMutexRelease(g_eventQueueMutexId);
         }
     }
-#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void init() {
 #if defined(EEZ_PLATFORM_STM32)
-    g_eventQueueMutexId = osMutexCreate(osMutex(g_eventQueueMutex));
     osThreadCreate(osThread(g_touchTask), nullptr);
 #endif
 }
 
 void tick() {
-#if defined(EEZ_PLATFORM_STM32)
-    if (osMutexWait(g_eventQueueMutexId, 5) == osOK) {
-		if (g_eventQueueFull || g_eventQueueTail != g_eventQueueHead) {
-			Event &event = g_eventQueue[g_eventQueueTail];
-
-            g_eventType = event.type;
-            g_eventX = event.x;
-            g_eventY = event.y;
-
-			g_eventQueueTail = (g_eventQueueTail + 1) % EVENT_QUEUE_MAX_SIZE;
-			g_eventQueueFull = false;
-		} else {
-            g_eventType = EVENT_TYPE_TOUCH_NONE;
-            g_eventX = -1;
-            g_eventY = -1;
-        }
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    oneIter();
+#endif
+
+    g_isEventInIteration = false;
+}
 
-        osMutexRelease(g_eventQueueMutexId);
+bool nextEvent() {
+    input::InputEvent event;
+    if (input::pop(input::SOURCE_TOUCH, event)) {
+        g_eventType = (EventType)event.type;
+        g_eventX = event.x;
+        g_eventY = event.y;
+        g_eventTime = event.time;
+        g_isEventInIteration = true;
+        return true;
     }
-#endif
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-    oneIter();
+    if (!g_isEventInIteration) {
+        g_isEventInIteration = true;
 
-    g_eventType = g_lastEventType;
-    g_eventX = g_x;
-    g_eventY = g_y;
-#endif
+        if (g_eventType == EVENT_TYPE_TOUCH_DOWN || g_eventType == EVENT_TYPE_TOUCH_MOVE) {
+            // touch is not moved, but it is still pressed
+            g_eventType = EVENT_TYPE_TOUCH_MOVE;
+            g_eventTime = micros();
+            return true;
+        }
+
+        g_eventType = EVENT_TYPE_TOUCH_NONE;
+        g_eventX = -1;
+        g_eventY = -1;
+    }
+
+    return false;
 }
 
 EventType getEventType() {
@@ -218,6 +196,10 @@ int getY() {
     return g_eventY;
 }
 
+uint32_t getEventTime() {
+    return g_eventTime;
+}
+
 } // namespace touch
 
 void data_touch_calibrated_x(DataOperationEnum operation, Cursor cursor, Value &value) {
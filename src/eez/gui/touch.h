@@ -27,9 +27,15 @@ namespace touch {
 void init();
 void tick();
 
+// Moves to the next touch event read since the last GUI iteration. While the touch is pressed
+// there is at least one event in every iteration, if there are no new events the last
+// position is repeated as EVENT_TYPE_TOUCH_MOVE. Returns false if there are no more events.
+bool nextEvent();
+
 EventType getEventType();
 int getX();
 int getY();
+uint32_t getEventTime(); // us
 
 } // namespace touch
 } // namespace gui
@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <assert.h>
+#include <stdint.h>
+
 #include <eez/gui/geometry.h>
 
 namespace eez {
@@ -66,6 +69,85 @@ typedef void (*OnTouchFunctionType)(const WidgetCursor &widgetCursor, Event &tou
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Pointer inside the assets. EEZ Studio generates the assets with the 32-bit pointers,
+// stored as the offsets which are converted to the pointers by fixPointer after the assets are
+// decompressed. On the 64-bit hosts (simulator) the pointer doesn't fit, so the offset
+// relative to the AssetsPtr itself is kept instead and the layout of the assets is unchanged.
+template <typename T>
+struct AssetsPtr {
+#if UINTPTR_MAX == 0xFFFFFFFF
+    AssetsPtr() : m_ptr(nullptr) {}
+    AssetsPtr(T *ptr) : m_ptr(ptr) {}
+
+    T *get() const {
+        return m_ptr;
+    }
+
+    AssetsPtr &operator=(T *ptr) {
+        m_ptr = ptr;
+        return *this;
+    }
+
+    void fixPointer(const void *base) {
+        m_ptr = (T *)((const uint8_t *)base + (uint32_t)m_ptr);
+    }
+#else
+    AssetsPtr() : m_offset(0) {}
+    AssetsPtr(T *ptr) {
+        *this = ptr;
+    }
+    AssetsPtr(const AssetsPtr &other) {
+        *this = other.get();
+    }
+
+    T *get() const {
+        return m_offset ? (T *)((const uint8_t *)this + m_offset) : nullptr;
+    }
+
+    AssetsPtr &operator=(const AssetsPtr &other) {
+        return *this = other.get();
+    }
+
+    AssetsPtr &operator=(T *ptr) {
+        if (ptr) {
+            int64_t offset = (const uint8_t *)ptr - (const uint8_t *)this;
+            assert(offset != 0 && offset >= INT32_MIN && offset <= INT32_MAX);
+            m_offset = (int32_t)offset;
+        } else {
+            m_offset = 0;
+        }
+        return *this;
+    }
+
+    void fixPointer(const void *base) {
+        *this = (T *)((const uint8_t *)base + (uint32_t)m_offset);
+    }
+#endif
+
+    operator T *() const {
+        return get();
+    }
+
+    T *operator->() const {
+        return get();
+    }
+
+    // for the casts of the widget specific data
+    template <typename U>
+    explicit operator U *() const {
+        return (U *)get();
+    }
+
+private:
+#if UINTPTR_MAX == 0xFFFFFFFF
+    T *m_ptr;
+#else
+    int32_t m_offset;
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct Bitmap {
     int16_t w;
     int16_t h;
@@ -117,7 +199,7 @@ struct Style {
 
 struct StyleList {
     uint32_t count;
-    const Style *first;
+    AssetsPtr<const Style> first;
 };
 
 void StyleList_fixPointers(StyleList &styleList);
@@ -133,14 +215,16 @@ struct Widget {
     int16_t w;
     int16_t h;
     uint16_t style;
-    const void *specific;
+    AssetsPtr<const void> specific;
 };
 
+static_assert(sizeof(Widget) == 20, "Widget layout must match the assets");
+
 void Widget_fixPointers(Widget *widget);
 
 struct WidgetList {
     uint32_t count;
-    const Widget *first;
+    AssetsPtr<const Widget> first;
 };
 
 void WidgetList_fixPointers(WidgetList &widgetList);
@@ -164,13 +248,13 @@ struct Document {
 
 struct ColorList {
     uint32_t count;
-    const uint16_t *first;
+    AssetsPtr<const uint16_t> first;
 };
 
 void ColorList_fixPointers(ColorList &colorList);
 
 struct Theme {
-    const char *name;
+    AssetsPtr<const char> name;
     ColorList colors;
 };
 
@@ -178,7 +262,7 @@ void Theme_fixPointers(Theme *theme);
 
 struct ThemeList {
     uint32_t count;
-    const Theme *first;
+    AssetsPtr<const Theme> first;
 };
 
 void ThemeList_fixPointers(ThemeList &themeList);
@@ -192,7 +276,7 @@ struct Colors {
 
 struct NameList {
     uint32_t count;
-    const char **first;
+    AssetsPtr<AssetsPtr<const char>> first;
 };
 
 struct Assets {
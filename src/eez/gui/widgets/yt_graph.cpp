@@ -70,6 +70,9 @@ struct YTGraphDrawHelper {
     int yPrev[2];
     int y[2];
 
+    // top of the min/max envelope, INT_MIN if value at the position is a single value
+    int yMax[2];
+
     Value::YtDataGetValueFunctionPointer ytDataGetValue;
 
     YTGraphDrawHelper(const WidgetCursor &widgetCursor_) : widgetCursor(widgetCursor_), widget(widgetCursor.widget) {
@@ -87,23 +90,39 @@ struct YTGraphDrawHelper {
         ytDataGetValue = ytDataGetGetValueFunc(widgetCursor.cursor, widget->data);
     }
 
-    int getYValue(int valueIndex, uint32_t position) {
+    int getY(int valueIndex, float value) {
+        return (int)round((widget->h - 1) * (value - min[valueIndex]) / (max[valueIndex] - min[valueIndex]));
+    }
+
+    int getYValue(int valueIndex, uint32_t position, int *yMaxValue = nullptr) {
+        if (yMaxValue) {
+            *yMaxValue = INT_MIN;
+        }
+
         if (position >= numPositions) {
             return INT_MIN;
         }
 
-        float value = ytDataGetValue(position, valueIndex, nullptr);
+        float fMax = NAN;
+        float value = ytDataGetValue(position, valueIndex, yMaxValue ? &fMax : nullptr);
 
         if (isNaN(value)) {
             return INT_MIN;
         }
 
-        int y = (int)round((widget->h - 1) * (value - min[valueIndex]) / (max[valueIndex] - min[valueIndex]));
+        int y = getY(valueIndex, value);
 
         if (y < 0 || y >= widget->h) {
             return INT_MIN;
         }
 
+        if (yMaxValue && !isNaN(fMax) && fMax > value) {
+            int yTop = getY(valueIndex, fMax);
+            if (yTop > y) {
+                *yMaxValue = widget->h - 1 - (yTop < widget->h ? yTop : widget->h - 1);
+            }
+        }
+
         return widget->h - 1 - y;
     }
 
@@ -123,10 +142,15 @@ struct YTGraphDrawHelper {
                 display::drawVLine(x, widgetCursor.y + y[valueIndex], yPrev[valueIndex] - y[valueIndex] - 1);
             }
         }
+
+        if (yMax[valueIndex] != INT_MIN) {
+            display::drawVLine(x, widgetCursor.y + yMax[valueIndex], y[valueIndex] - yMax[valueIndex]);
+        }
     }
 
     void drawStep() {
-        if (y[0] != INT_MIN && y[1] != INT_MIN && abs(yPrev[0] - y[0]) <= 1 && abs(yPrev[1] - y[1]) <= 1 && y[0] == y[1]) {
+        if (y[0] != INT_MIN && y[1] != INT_MIN && abs(yPrev[0] - y[0]) <= 1 && abs(yPrev[1] - y[1]) <= 1 && y[0] == y[1] &&
+            yMax[0] == INT_MIN && yMax[1] == INT_MIN) {
             display::setColor16(position % 2 ? dataColor16[1] : dataColor16[0]);
             display::drawPixel(x, widgetCursor.y + y[0]);
         } else {
@@ -151,10 +175,10 @@ struct YTGraphDrawHelper {
         for (position = startPosition; position < endPosition; ++position) {
             x = widgetCursor.x + position % graphWidth;
 
-            y[0] = getYValue(0, position);
+            y[0] = getYValue(0, position, &yMax[0]);
             yPrev[0] = getYValue(0, position == 0 ? position : position - 1);
 
-            y[1] = getYValue(1, position);
+            y[1] = getYValue(1, position, &yMax[1]);
             yPrev[1] = getYValue(1, position == 0 ? position : position - 1);
 
             drawStep();
@@ -191,8 +215,8 @@ struct YTGraphDrawHelper {
         display::fillRect(startX, widgetCursor.y, endX - 1, widgetCursor.y + widget->h - 1);
 
         for (x = startX; x < endX; x++, position++) {
-            y[0] = getYValue(0, position);
-            y[1] = getYValue(1, position);
+            y[0] = getYValue(0, position, &yMax[0]);
+            y[1] = getYValue(1, position, &yMax[1]);
 
             drawStep();
 
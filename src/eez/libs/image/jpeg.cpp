@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <memory.h>
 #include <assert.h>
+#include <math.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <jpeg.h>
@@ -31,8 +32,6 @@ extern "C" {
 }
 #endif
 
-#include "toojpeg.h"
-
 #include <eez/system.h>
 #include <eez/debug.h>
 #include <eez/memory.h>
@@ -40,18 +39,21 @@ extern "C" {
 #include <eez/libs/sd_fat/sd_fat.h>
 #include <eez/libs/image/jpeg.h>
 
-static size_t g_imageDataSize;
-
-void WRITE_ONE_BYTE(unsigned char byte) {
-	VRAM_SCREENSHOOT_JPEG_OUT_BUFFER[g_imageDataSize++] = byte;
+static bool writeToOutBuffer(void *context, const uint8_t *data, size_t size) {
+    size_t &imageDataSize = *(size_t *)context;
+    if (imageDataSize + size > VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE) {
+        return false;
+    }
+    memcpy(VRAM_SCREENSHOOT_JPEG_OUT_BUFFER + imageDataSize, data, size);
+    imageDataSize += size;
+    return true;
 }
 
-int jpegEncode(const uint8_t *screenshotPixels, unsigned char **imageData, size_t *imageDataSize) {
-	g_imageDataSize = 0;
-	TooJpeg::writeJpeg(WRITE_ONE_BYTE, screenshotPixels, 480, 272);
+int jpegEncode(const uint8_t *pixels, uint16_t width, uint16_t height, uint32_t stride, const JpegEncodeParams &params, unsigned char **imageData, size_t *imageDataSize) {
+    *imageDataSize = 0;
+    int err = jpegEncode(pixels, width, height, stride, params, writeToOutBuffer, imageDataSize);
     *imageData = VRAM_SCREENSHOOT_JPEG_OUT_BUFFER;
-    *imageDataSize = g_imageDataSize;
-    return 0;
+    return err;
 }
 
 uint8_t *g_fileData;
@@ -62,7 +64,10 @@ static bool g_jpegInitialized;
 
 #else
 
-extern "C" void * const g_jpegDecodeContext = (void *)FILE_VIEW_BUFFER;
+// jpegBenchmark uses its own context, so the image opened in the file viewer is not overwritten
+extern "C" {
+thread_local void *g_jpegDecodeContext = (void *)FILE_VIEW_BUFFER;
+}
 
 #define NJ_USE_LIBC 0
 #define NJ_USE_WIN32 0
@@ -74,7 +79,14 @@ static uint8_t *g_decodeBuffer = FILE_VIEW_BUFFER + sizeof(nj_context_t);
 
 uint8_t *g_decodeDynamicMemory;
 
+// jpegBenchmark decodes outside of FILE_VIEW_BUFFER, so it uses the host heap
+static thread_local bool g_decodeToHeap;
+
 extern "C" void* njAllocMem(int size) {
+    if (g_decodeToHeap) {
+        return malloc(size);
+    }
+
     if (g_decodeDynamicMemory + size > g_fileData) {
         return nullptr;
     }
@@ -87,6 +99,9 @@ extern "C" void* njAllocMem(int size) {
 }
 
 extern "C" void njFreeMem(void* block) {
+    if (g_decodeToHeap) {
+        free(block);
+    }
     // DebugTrace("free %p\n", block);
 }
 
@@ -142,7 +157,7 @@ bool jpegDecode(const char *filePath, Image *image) {
 
     uint32_t width = jpegInfo.ImageWidth;
     uint32_t height = jpegInfo.ImageHeight;
-    if (width > 480 || height > 272) {
+    if (width > DISPLAY_WIDTH || height > DISPLAY_HEIGHT) {
         return false;
     }
 
@@ -197,7 +212,8 @@ bool jpegDecode(const char *filePath, Image *image) {
         return false;
     }
 
-    if (njGetWidth() > 480 || njGetHeight() > 272 || !njIsColor() || njGetImageSize() > 480 * 272 * 3) {
+    // screenshots taken in the simulator are of the whole simulator display
+    if (njGetWidth() > (int)DISPLAY_WIDTH || njGetHeight() > (int)DISPLAY_HEIGHT || !njIsColor() || njGetImageSize() > (int)(DISPLAY_WIDTH * DISPLAY_HEIGHT * 3)) {
         return false;
     }
 
@@ -211,3 +227,127 @@ bool jpegDecode(const char *filePath, Image *image) {
 
 #endif
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct OutputHash {
+    uint32_t hash;
+    uint32_t size;
+};
+
+#if !defined(EEZ_PLATFORM_STM32)
+struct OutputBuffer {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+};
+
+static bool writeToHeap(void *context, const uint8_t *data, size_t size) {
+    OutputBuffer &outputBuffer = *(OutputBuffer *)context;
+    if (outputBuffer.size + size > outputBuffer.capacity) {
+        size_t capacity = 2 * (outputBuffer.size + size);
+        uint8_t *temp = (uint8_t *)realloc(outputBuffer.data, capacity);
+        if (!temp) {
+            return false;
+        }
+        outputBuffer.data = temp;
+        outputBuffer.capacity = capacity;
+    }
+    memcpy(outputBuffer.data + outputBuffer.size, data, size);
+    outputBuffer.size += size;
+    return true;
+}
+#endif
+
+static bool writeToHash(void *context, const uint8_t *data, size_t size) {
+    OutputHash &outputHash = *(OutputHash *)context;
+    for (size_t i = 0; i < size; i++) {
+        // FNV-1a
+        outputHash.hash = (outputHash.hash ^ data[i]) * 16777619u;
+    }
+    outputHash.size += size;
+    return true;
+}
+
+bool jpegBenchmark(const uint8_t *pixels, uint16_t width, uint16_t height, uint32_t stride, const JpegEncodeParams &params, JpegBenchmarkResult &result) {
+    static const int NUM_ITERATIONS = 5;
+
+    JpegEncodeParams singleThreadParams = params;
+    singleThreadParams.numThreads = 1;
+
+    OutputHash singleThreadHash;
+    OutputHash hash;
+
+    uint32_t startTime = eez::micros();
+    for (int i = 0; i < NUM_ITERATIONS; i++) {
+        singleThreadHash.hash = 2166136261u;
+        singleThreadHash.size = 0;
+        if (jpegEncode(pixels, width, height, stride, singleThreadParams, writeToHash, &singleThreadHash)) {
+            return false;
+        }
+    }
+    result.encodeTime = (eez::micros() - startTime) / NUM_ITERATIONS;
+
+    startTime = eez::micros();
+    for (int i = 0; i < NUM_ITERATIONS; i++) {
+        hash.hash = 2166136261u;
+        hash.size = 0;
+        if (jpegEncode(pixels, width, height, stride, params, writeToHash, &hash)) {
+            return false;
+        }
+    }
+    result.parallelEncodeTime = (eez::micros() - startTime) / NUM_ITERATIONS;
+
+    result.imageSize = hash.size;
+    result.isParallelOutputSame = hash.hash == singleThreadHash.hash && hash.size == singleThreadHash.size;
+    result.psnr = 0;
+
+#if !defined(EEZ_PLATFORM_STM32)
+    // decode back and compare with the source pixels,
+    // VRAM_SCREENSHOOT_JPEG_OUT_BUFFER and FILE_VIEW_BUFFER are not used, they belong to the other threads
+    OutputBuffer outputBuffer = { nullptr, 0, 0 };
+    if (jpegEncode(pixels, width, height, stride, params, writeToHeap, &outputBuffer)) {
+        free(outputBuffer.data);
+        return false;
+    }
+
+    void *savedDecodeContext = g_jpegDecodeContext;
+    g_jpegDecodeContext = malloc(sizeof(nj_context_t));
+    if (!g_jpegDecodeContext) {
+        g_jpegDecodeContext = savedDecodeContext;
+        free(outputBuffer.data);
+        return false;
+    }
+    g_decodeToHeap = true;
+    njInit();
+
+    bool decoded = njDecode(outputBuffer.data, outputBuffer.size) == NJ_OK && njGetWidth() == width && njGetHeight() == height && njIsColor();
+    if (decoded) {
+        const uint8_t *decodedPixels = njGetImage();
+        double sumSquaredError = 0;
+        for (int y = 0; y < height; y++) {
+            const uint8_t *row = pixels + y * stride;
+            const uint8_t *decodedRow = decodedPixels + y * width * 3;
+            for (int x = 0; x < width * 3; x++) {
+                int diff = row[x] - decodedRow[x];
+                sumSquaredError += diff * diff;
+            }
+        }
+
+        double meanSquaredError = sumSquaredError / (width * height * 3);
+        result.psnr = meanSquaredError > 0 ? (float)(10 * log10(255.0 * 255.0 / meanSquaredError)) : 99.0f;
+    }
+
+    njDone();
+    g_decodeToHeap = false;
+    free(g_jpegDecodeContext);
+    g_jpegDecodeContext = savedDecodeContext;
+    free(outputBuffer.data);
+
+    if (!decoded) {
+        return false;
+    }
+#endif
+
+    return true;
+}
@@ -20,6 +20,51 @@
 
 #include <eez/libs/image/image.h>
 
-int jpegEncode(const uint8_t *screenshotPixels, unsigned char **imageData, size_t *imageDataSize);
+#include <stddef.h>
+
+// Row parallel encoding is supported only in the desktop simulator
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#define JPEG_ENCODE_THREADS 1
+#else
+#define JPEG_ENCODE_THREADS 0
+#endif
+
+enum JpegSubsampling {
+    JPEG_SUBSAMPLING_444,
+    JPEG_SUBSAMPLING_422,
+    JPEG_SUBSAMPLING_420
+};
+
+struct JpegEncodeParams {
+    JpegEncodeParams() : quality(90), subsampling(JPEG_SUBSAMPLING_444), numThreads(JPEG_ENCODE_THREADS ? 4 : 1) {}
+
+    uint8_t quality; // 1 ... 100
+    JpegSubsampling subsampling;
+    // Bands of MCU rows are encoded in parallel if greater than 1,
+    // ignored if JPEG_ENCODE_THREADS is 0. Output doesn't depend on it.
+    uint8_t numThreads;
+};
+
+// Receives encoded data in chunks, returns false to stop the encoding
+typedef bool (*JpegWriteFunc)(void *context, const uint8_t *data, size_t size);
+
+// Encodes RGB888 pixels, stride is the number of bytes between the starts of two rows.
+// Returns 0 on success.
+int jpegEncode(const uint8_t *pixels, uint16_t width, uint16_t height, uint32_t stride, const JpegEncodeParams &params, JpegWriteFunc writeFunc, void *context);
+
+// Encodes into VRAM_SCREENSHOOT_JPEG_OUT_BUFFER. Returns 0 on success.
+int jpegEncode(const uint8_t *pixels, uint16_t width, uint16_t height, uint32_t stride, const JpegEncodeParams &params, unsigned char **imageData, size_t *imageDataSize);
 
 bool jpegDecode(const char *filePath, Image *image);
+
+struct JpegBenchmarkResult {
+    uint32_t imageSize;          // bytes
+    uint32_t encodeTime;         // us, with a single thread
+    uint32_t parallelEncodeTime; // us, with params.numThreads
+    bool isParallelOutputSame;
+    float psnr;                  // dB, image decoded back with nanojpeg, 0 if decoder is not available
+};
+
+// Encodes the pixels with a single thread and with params.numThreads and compares the outputs.
+// Outside of STM32 the image is also decoded back and compared with the pixels.
+bool jpegBenchmark(const uint8_t *pixels, uint16_t width, uint16_t height, uint32_t stride, const JpegEncodeParams &params, JpegBenchmarkResult &result);
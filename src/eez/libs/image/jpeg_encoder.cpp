@@ -0,0 +1,572 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory.h>
+
+#include <eez/libs/image/jpeg.h>
+
+#if JPEG_ENCODE_THREADS
+#include <thread>
+#include <vector>
+#endif
+
+/* Baseline JPEG encoder
+
+Image is encoded MCU by MCU: pixels of the MCU are converted to YCbCr, chroma is
+downsampled if requested, then every 8x8 block goes through the float AAN forward DCT,
+quantization and Huffman coding with the standard tables (JPEG spec, Annex K).
+
+Restart marker is written after every MCU row, so every MCU row is encoded independently
+of the other rows. That allows encoding bands of rows in parallel and concatenating the
+results, the output is the same for any number of threads.
+*/
+
+namespace {
+
+static const uint8_t QUANT_LUMINANCE[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+
+static const uint8_t QUANT_CHROMINANCE[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// natural order index of the coefficient at the zigzag position
+static const uint8_t ZIGZAG[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10,
+    17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+static const uint8_t DC_LUMINANCE_BITS[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const uint8_t DC_CHROMINANCE_BITS[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const uint8_t DC_VALUES[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t AC_LUMINANCE_BITS[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 125 };
+static const uint8_t AC_LUMINANCE_VALUES[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+    0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA
+};
+
+static const uint8_t AC_CHROMINANCE_BITS[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 119 };
+static const uint8_t AC_CHROMINANCE_VALUES[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+    0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+    0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+    0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+    0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+    0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA
+};
+
+static const float AAN_SCALE_FACTORS[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+struct HuffmanTable {
+    uint16_t codes[256];
+    uint8_t lengths[256];
+};
+
+struct Encoder {
+    const uint8_t *pixels;
+    int width;
+    int height;
+    uint32_t stride;
+
+    // MCU size in 8x8 blocks, chroma is always one block per MCU
+    int mcuBlocksX;
+    int mcuBlocksY;
+    int mcusPerRow;
+    int numMcuRows;
+
+    uint8_t quantTables[2][64]; // zigzag order, as written to DQT
+    float divisors[2][64]; // natural order, includes AAN scaling
+
+    HuffmanTable dcTables[2];
+    HuffmanTable acTables[2];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class Output {
+public:
+    Output(JpegWriteFunc writeFunc, void *context) : m_writeFunc(writeFunc), m_context(context), m_size(0), m_ok(true), m_bits(0), m_numBits(0) {
+    }
+
+    bool isOk() {
+        return m_ok;
+    }
+
+    void writeByte(uint8_t byte) {
+        m_buffer[m_size++] = byte;
+        if (m_size == sizeof(m_buffer)) {
+            flush();
+        }
+    }
+
+    void writeWord(uint16_t word) {
+        writeByte(word >> 8);
+        writeByte(word & 0xFF);
+    }
+
+    void writeBytes(const uint8_t *bytes, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            writeByte(bytes[i]);
+        }
+    }
+
+    void writeBits(uint32_t code, int length) {
+        m_bits = (m_bits << length) | code;
+        m_numBits += length;
+        while (m_numBits >= 8) {
+            m_numBits -= 8;
+            uint8_t byte = (uint8_t)(m_bits >> m_numBits);
+            writeByte(byte);
+            if (byte == 0xFF) {
+                writeByte(0);
+            }
+        }
+        m_bits &= (1 << m_numBits) - 1;
+    }
+
+    // pads the last byte with 1s
+    void alignBits() {
+        if (m_numBits > 0) {
+            writeBits((1 << (8 - m_numBits)) - 1, 8 - m_numBits);
+        }
+    }
+
+    void flush() {
+        if (m_size > 0) {
+            if (m_ok && !m_writeFunc(m_context, m_buffer, m_size)) {
+                m_ok = false;
+            }
+            m_size = 0;
+        }
+    }
+
+private:
+    JpegWriteFunc m_writeFunc;
+    void *m_context;
+    uint8_t m_buffer[512];
+    size_t m_size;
+    bool m_ok;
+
+    uint32_t m_bits;
+    int m_numBits;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void buildHuffmanTable(HuffmanTable &table, const uint8_t *bits, const uint8_t *values) {
+    uint16_t code = 0;
+    int k = 0;
+    for (int length = 1; length <= 16; length++) {
+        for (int i = 0; i < bits[length - 1]; i++, k++) {
+            table.codes[values[k]] = code++;
+            table.lengths[values[k]] = length;
+        }
+        code <<= 1;
+    }
+}
+
+static void initQuantTable(Encoder &encoder, int index, const uint8_t *baseTable, int quality) {
+    // same quality scaling as the IJG libjpeg
+    int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+
+    for (int i = 0; i < 64; i++) {
+        int value = (baseTable[ZIGZAG[i]] * scale + 50) / 100;
+        encoder.quantTables[index][i] = value < 1 ? 1 : value > 255 ? 255 : value;
+    }
+
+    for (int i = 0; i < 64; i++) {
+        int natural = ZIGZAG[i];
+        encoder.divisors[index][natural] =
+            1.0f / (encoder.quantTables[index][i] * AAN_SCALE_FACTORS[natural / 8] * AAN_SCALE_FACTORS[natural % 8] * 8.0f);
+    }
+}
+
+static void writeHuffmanTable(Output &output, uint8_t classAndId, const uint8_t *bits, const uint8_t *values, int numValues) {
+    output.writeByte(classAndId);
+    output.writeBytes(bits, 16);
+    output.writeBytes(values, numValues);
+}
+
+static void writeHeaders(Output &output, const Encoder &encoder) {
+    // SOI
+    output.writeWord(0xFFD8);
+
+    // APP0 - JFIF 1.1, no density, no thumbnail
+    static const uint8_t JFIF[] = { 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 };
+    output.writeBytes(JFIF, sizeof(JFIF));
+
+    // DQT
+    output.writeWord(0xFFDB);
+    output.writeWord(2 + 2 * 65);
+    output.writeByte(0);
+    output.writeBytes(encoder.quantTables[0], 64);
+    output.writeByte(1);
+    output.writeBytes(encoder.quantTables[1], 64);
+
+    // SOF0
+    output.writeWord(0xFFC0);
+    output.writeWord(2 + 6 + 3 * 3);
+    output.writeByte(8);
+    output.writeWord(encoder.height);
+    output.writeWord(encoder.width);
+    output.writeByte(3);
+    output.writeByte(1);
+    output.writeByte((encoder.mcuBlocksX << 4) | encoder.mcuBlocksY);
+    output.writeByte(0);
+    output.writeByte(2);
+    output.writeByte(0x11);
+    output.writeByte(1);
+    output.writeByte(3);
+    output.writeByte(0x11);
+    output.writeByte(1);
+
+    // DHT
+    output.writeWord(0xFFC4);
+    output.writeWord(2 + 4 * 17 + 2 * 12 + 2 * 162);
+    writeHuffmanTable(output, 0x00, DC_LUMINANCE_BITS, DC_VALUES, 12);
+    writeHuffmanTable(output, 0x10, AC_LUMINANCE_BITS, AC_LUMINANCE_VALUES, 162);
+    writeHuffmanTable(output, 0x01, DC_CHROMINANCE_BITS, DC_VALUES, 12);
+    writeHuffmanTable(output, 0x11, AC_CHROMINANCE_BITS, AC_CHROMINANCE_VALUES, 162);
+
+    // DRI - restart after every MCU row
+    output.writeWord(0xFFDD);
+    output.writeWord(4);
+    output.writeWord(encoder.mcusPerRow);
+
+    // SOS
+    static const uint8_t SOS[] = { 0xFF, 0xDA, 0x00, 0x0C, 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0 };
+    output.writeBytes(SOS, sizeof(SOS));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void forwardDct(float *data) {
+    for (int pass = 0; pass < 2; pass++) {
+        // first pass transforms rows, second pass columns
+        int step = pass == 0 ? 1 : 8;
+        int next = pass == 0 ? 8 : 1;
+
+        for (int i = 0; i < 8; i++) {
+            float *d = data + i * next;
+
+            float tmp0 = d[0 * step] + d[7 * step];
+            float tmp7 = d[0 * step] - d[7 * step];
+            float tmp1 = d[1 * step] + d[6 * step];
+            float tmp6 = d[1 * step] - d[6 * step];
+            float tmp2 = d[2 * step] + d[5 * step];
+            float tmp5 = d[2 * step] - d[5 * step];
+            float tmp3 = d[3 * step] + d[4 * step];
+            float tmp4 = d[3 * step] - d[4 * step];
+
+            // even part
+            float tmp10 = tmp0 + tmp3;
+            float tmp13 = tmp0 - tmp3;
+            float tmp11 = tmp1 + tmp2;
+            float tmp12 = tmp1 - tmp2;
+
+            d[0 * step] = tmp10 + tmp11;
+            d[4 * step] = tmp10 - tmp11;
+
+            float z1 = (tmp12 + tmp13) * 0.707106781f;
+            d[2 * step] = tmp13 + z1;
+            d[6 * step] = tmp13 - z1;
+
+            // odd part
+            tmp10 = tmp4 + tmp5;
+            tmp11 = tmp5 + tmp6;
+            tmp12 = tmp6 + tmp7;
+
+            float z5 = (tmp10 - tmp12) * 0.382683433f;
+            float z2 = 0.541196100f * tmp10 + z5;
+            float z4 = 1.306562965f * tmp12 + z5;
+            float z3 = tmp11 * 0.707106781f;
+
+            float z11 = tmp7 + z3;
+            float z13 = tmp7 - z3;
+
+            d[5 * step] = z13 + z2;
+            d[3 * step] = z13 - z2;
+            d[1 * step] = z11 + z4;
+            d[7 * step] = z11 - z4;
+        }
+    }
+}
+
+static void encodeBlock(Output &output, const Encoder &encoder, float *block, int table, int &dcPredictor) {
+    forwardDct(block);
+
+    int coefficients[64];
+    const float *divisors = encoder.divisors[table];
+    for (int i = 0; i < 64; i++) {
+        float value = block[ZIGZAG[i]] * divisors[ZIGZAG[i]];
+        coefficients[i] = (int)(value < 0 ? value - 0.5f : value + 0.5f);
+    }
+
+    const HuffmanTable &dcTable = encoder.dcTables[table];
+    const HuffmanTable &acTable = encoder.acTables[table];
+
+    int diff = coefficients[0] - dcPredictor;
+    dcPredictor = coefficients[0];
+
+    int value = diff < 0 ? -diff : diff;
+    int numBits = 0;
+    while (value) {
+        numBits++;
+        value >>= 1;
+    }
+    output.writeBits(dcTable.codes[numBits], dcTable.lengths[numBits]);
+    if (numBits) {
+        output.writeBits((diff < 0 ? diff - 1 : diff) & ((1 << numBits) - 1), numBits);
+    }
+
+    int last = 63;
+    while (last > 0 && coefficients[last] == 0) {
+        last--;
+    }
+
+    int run = 0;
+    for (int i = 1; i <= last; i++) {
+        int coefficient = coefficients[i];
+        if (coefficient == 0) {
+            run++;
+            continue;
+        }
+
+        while (run > 15) {
+            output.writeBits(acTable.codes[0xF0], acTable.lengths[0xF0]);
+            run -= 16;
+        }
+
+        value = coefficient < 0 ? -coefficient : coefficient;
+        numBits = 0;
+        while (value) {
+            numBits++;
+            value >>= 1;
+        }
+
+        int symbol = (run << 4) | numBits;
+        output.writeBits(acTable.codes[symbol], acTable.lengths[symbol]);
+        output.writeBits((coefficient < 0 ? coefficient - 1 : coefficient) & ((1 << numBits) - 1), numBits);
+
+        run = 0;
+    }
+
+    if (last < 63) {
+        // EOB
+        output.writeBits(acTable.codes[0x00], acTable.lengths[0x00]);
+    }
+}
+
+static void encodeMcu(Output &output, const Encoder &encoder, int mcuX, int mcuY, int *dcPredictors) {
+    int mcuWidth = 8 * encoder.mcuBlocksX;
+    int mcuHeight = 8 * encoder.mcuBlocksY;
+
+    float y[16 * 16];
+    float cb[16 * 16];
+    float cr[16 * 16];
+
+    // convert to YCbCr, the pixels outside of the image repeat the last column/row
+    int x0 = mcuX * mcuWidth;
+    int y0 = mcuY * mcuHeight;
+    for (int j = 0; j < mcuHeight; j++) {
+        int py = y0 + j < encoder.height ? y0 + j : encoder.height - 1;
+        const uint8_t *row = encoder.pixels + py * encoder.stride;
+        for (int i = 0; i < mcuWidth; i++) {
+            int px = x0 + i < encoder.width ? x0 + i : encoder.width - 1;
+            const uint8_t *pixel = row + 3 * px;
+            float r = pixel[0];
+            float g = pixel[1];
+            float b = pixel[2];
+            int k = j * mcuWidth + i;
+            y[k] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+            cb[k] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+            cr[k] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+        }
+    }
+
+    float block[64];
+
+    for (int by = 0; by < encoder.mcuBlocksY; by++) {
+        for (int bx = 0; bx < encoder.mcuBlocksX; bx++) {
+            for (int j = 0; j < 8; j++) {
+                memcpy(block + 8 * j, y + (8 * by + j) * mcuWidth + 8 * bx, 8 * sizeof(float));
+            }
+            encodeBlock(output, encoder, block, 0, dcPredictors[0]);
+        }
+    }
+
+    for (int component = 1; component < 3; component++) {
+        const float *c = component == 1 ? cb : cr;
+        if (encoder.mcuBlocksX == 1 && encoder.mcuBlocksY == 1) {
+            memcpy(block, c, 64 * sizeof(float));
+        } else {
+            // average of the pixels covered by the chroma sample
+            float scale = 1.0f / (encoder.mcuBlocksX * encoder.mcuBlocksY);
+            for (int j = 0; j < 8; j++) {
+                for (int i = 0; i < 8; i++) {
+                    float sum = 0;
+                    for (int v = 0; v < encoder.mcuBlocksY; v++) {
+                        for (int u = 0; u < encoder.mcuBlocksX; u++) {
+                            sum += c[(j * encoder.mcuBlocksY + v) * mcuWidth + i * encoder.mcuBlocksX + u];
+                        }
+                    }
+                    block[8 * j + i] = sum * scale;
+                }
+            }
+        }
+        encodeBlock(output, encoder, block, 1, dcPredictors[component]);
+    }
+}
+
+static void encodeMcuRows(Output &output, const Encoder &encoder, int fromMcuRow, int toMcuRow) {
+    for (int mcuY = fromMcuRow; mcuY < toMcuRow; mcuY++) {
+        int dcPredictors[3] = { 0, 0, 0 };
+
+        for (int mcuX = 0; mcuX < encoder.mcusPerRow; mcuX++) {
+            encodeMcu(output, encoder, mcuX, mcuY, dcPredictors);
+        }
+
+        output.alignBits();
+
+        if (mcuY < encoder.numMcuRows - 1) {
+            // RSTn
+            output.writeByte(0xFF);
+            output.writeByte(0xD0 + (mcuY & 7));
+        }
+    }
+}
+
+#if JPEG_ENCODE_THREADS
+
+static bool appendToVector(void *context, const uint8_t *data, size_t size) {
+    std::vector<uint8_t> &buffer = *(std::vector<uint8_t> *)context;
+    buffer.insert(buffer.end(), data, data + size);
+    return true;
+}
+
+#endif
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+int jpegEncode(const uint8_t *pixels, uint16_t width, uint16_t height, uint32_t stride, const JpegEncodeParams &params, JpegWriteFunc writeFunc, void *context) {
+    if (width == 0 || height == 0 || stride < 3u * width) {
+        return 1;
+    }
+
+    // Huffman and quantization tables are about 3KB, don't keep them on the stack
+    static Encoder encoder;
+
+    encoder.pixels = pixels;
+    encoder.width = width;
+    encoder.height = height;
+    encoder.stride = stride;
+
+    encoder.mcuBlocksX = params.subsampling == JPEG_SUBSAMPLING_444 ? 1 : 2;
+    encoder.mcuBlocksY = params.subsampling == JPEG_SUBSAMPLING_420 ? 2 : 1;
+    encoder.mcusPerRow = (width + 8 * encoder.mcuBlocksX - 1) / (8 * encoder.mcuBlocksX);
+    encoder.numMcuRows = (height + 8 * encoder.mcuBlocksY - 1) / (8 * encoder.mcuBlocksY);
+
+    int quality = params.quality < 1 ? 1 : params.quality > 100 ? 100 : params.quality;
+    initQuantTable(encoder, 0, QUANT_LUMINANCE, quality);
+    initQuantTable(encoder, 1, QUANT_CHROMINANCE, quality);
+
+    buildHuffmanTable(encoder.dcTables[0], DC_LUMINANCE_BITS, DC_VALUES);
+    buildHuffmanTable(encoder.acTables[0], AC_LUMINANCE_BITS, AC_LUMINANCE_VALUES);
+    buildHuffmanTable(encoder.dcTables[1], DC_CHROMINANCE_BITS, DC_VALUES);
+    buildHuffmanTable(encoder.acTables[1], AC_CHROMINANCE_BITS, AC_CHROMINANCE_VALUES);
+
+    Output output(writeFunc, context);
+
+    writeHeaders(output, encoder);
+
+#if JPEG_ENCODE_THREADS
+    int numThreads = params.numThreads < encoder.numMcuRows ? params.numThreads : encoder.numMcuRows;
+    if (numThreads > 1) {
+        std::vector<std::vector<uint8_t>> bands(numThreads);
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < numThreads; i++) {
+            int fromMcuRow = encoder.numMcuRows * i / numThreads;
+            int toMcuRow = encoder.numMcuRows * (i + 1) / numThreads;
+            std::vector<uint8_t> *band = &bands[i];
+            threads.push_back(std::thread([band, fromMcuRow, toMcuRow]() {
+                Output bandOutput(appendToVector, band);
+                encodeMcuRows(bandOutput, encoder, fromMcuRow, toMcuRow);
+                bandOutput.flush();
+            }));
+        }
+
+        for (int i = 0; i < numThreads; i++) {
+            threads[i].join();
+            output.writeBytes(bands[i].data(), bands[i].size());
+        }
+    } else
+#endif
+    {
+        encodeMcuRows(output, encoder, 0, encoder.numMcuRows);
+    }
+
+    // EOI
+    output.writeWord(0xFFD9);
+
+    output.flush();
+
+    return output.isOk() ? 0 : 1;
+}
@@ -73,6 +73,11 @@ enum SdFatResult {
 
 struct FileInfo {
     FileInfo();
+#if !defined(EEZ_PLATFORM_STM32) && !defined(EEZ_PLATFORM_SIMULATOR_WIN32)
+    // m_dirent can point to m_fstatDirent, so it is rebound on copy
+    FileInfo(const FileInfo &fileInfo);
+    FileInfo &operator=(const FileInfo &fileInfo);
+#endif
 
     SdFatResult fstat(const char *filePath);
 
@@ -96,6 +101,7 @@ struct FileInfo {
 #else
     std::string m_parentPath;
     struct dirent *m_dirent;
+    struct dirent m_fstatDirent;
 #endif
 };
 
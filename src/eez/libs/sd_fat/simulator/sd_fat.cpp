@@ -55,11 +55,19 @@ FileInfo::FileInfo() {
 #endif
 }
 
-SdFatResult FileInfo::fstat(const char *filePath) {
-    Directory dir;
-    return dir.findFirst(filePath, *this);
+#if !defined(EEZ_PLATFORM_SIMULATOR_WIN32)
+FileInfo::FileInfo(const FileInfo &fileInfo) {
+    *this = fileInfo;
 }
 
+FileInfo &FileInfo::operator=(const FileInfo &fileInfo) {
+    m_parentPath = fileInfo.m_parentPath;
+    m_fstatDirent = fileInfo.m_fstatDirent;
+    m_dirent = fileInfo.m_dirent == &fileInfo.m_fstatDirent ? &m_fstatDirent : fileInfo.m_dirent;
+    return *this;
+}
+#endif
+
 std::string getRealPath(const char *path) {
     std::string realPath;
 
@@ -81,6 +89,29 @@ std::string getRealPath(const char *path) {
     return getConfFilePath(realPath.c_str());
 }
 
+SdFatResult FileInfo::fstat(const char *filePath) {
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    Directory dir;
+    return dir.findFirst(filePath, *this);
+#else
+    // entry returned by readdir is not valid after the directory is closed,
+    // so entry for the given path is kept in FileInfo
+    std::string realPath = getRealPath(filePath);
+    struct stat stbuf;
+    if (stat(realPath.c_str(), &stbuf) != 0) {
+        return SD_FAT_RESULT_NO_FILE;
+    }
+
+    size_t i = realPath.rfind('/');
+    m_parentPath = realPath.substr(0, i);
+    strncpy(m_fstatDirent.d_name, realPath.c_str() + i + 1, sizeof(m_fstatDirent.d_name) - 1);
+    m_fstatDirent.d_name[sizeof(m_fstatDirent.d_name) - 1] = 0;
+    m_dirent = &m_fstatDirent;
+
+    return SD_FAT_RESULT_OK;
+#endif
+}
+
 bool pathExists(const char *path) {
     std::string realPath = getRealPath(path);
     struct stat path_stat;
@@ -288,17 +319,33 @@ bool File::open(const char *path, uint8_t mode) {
 
     if (mode == (FILE_OPEN_EXISTING | FILE_READ)) {
         fmode = "rb";
+    } else if (mode == (FILE_OPEN_EXISTING | FILE_READ | FILE_WRITE)) {
+        fmode = "r+b";
     } else if (mode == (FILE_OPEN_ALWAYS | FILE_WRITE)) {
         fmode = "r+b";
         m_fp = fopen(getRealPath(path).c_str(), fmode);
         if (m_fp) {
+            m_isOpen = true;
             return true;
         }
         fmode = "wb";
     } else if (mode == (FILE_OPEN_APPEND | FILE_WRITE)) {
-        fmode = "ab";
+        // same as FatFs FA_OPEN_APPEND: position is at the end of the file, but it can be moved with seek,
+        // which is not possible with "ab" mode
+        m_fp = fopen(getRealPath(path).c_str(), "r+b");
+        if (!m_fp) {
+            m_fp = fopen(getRealPath(path).c_str(), "w+b");
+        }
+        if (m_fp && fseek(m_fp, 0, SEEK_END) != 0) {
+            fclose(m_fp);
+            m_fp = nullptr;
+        }
+        m_isOpen = m_fp != nullptr;
+        return m_isOpen;
     } else if (mode == (FILE_CREATE_ALWAYS | FILE_WRITE)) {
         fmode = "wb";
+    } else if (mode == (FILE_CREATE_ALWAYS | FILE_READ | FILE_WRITE)) {
+        fmode = "w+b";
     }
 
     m_fp = fopen(getRealPath(path).c_str(), fmode);
@@ -18,6 +18,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <main.h>
@@ -51,6 +52,10 @@
 #include <eez/modules/psu/serial_psu.h>
 #include <eez/modules/psu/sd_card.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+#include <eez/platform/simulator/headless.h>
+#endif
+
  ////////////////////////////////////////////////////////////////////////////////
 
 #if !defined(__EMSCRIPTEN__)
@@ -93,6 +98,12 @@ int main(int argc, char **argv) {
     startEmscripten();
 #else
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    if (!eez::platform::simulator::headless::init(argc, argv)) {
+        return 1;
+    }
+#endif
+
 #if defined(EEZ_PLATFORM_STM32)
 	if (RCC->CSR & RCC_CSR_IWDGRSTF) {	
 		/* Reset by IWDG */
@@ -149,6 +160,16 @@ int main(int argc, char **argv) {
         osDelay(100);
     }
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    eez::platform::simulator::headless::writeReport();
+
+    // other threads are still running and waiting on the static mutexes and condition variables,
+    // so the static destructors are not called
+    fflush(stdout);
+    fflush(stderr);
+    _Exit(0);
+#endif
+
 #endif
 
     return 0;
@@ -167,9 +188,20 @@ osThreadId g_consoleInputTaskHandle;
 #if !defined(__EMSCRIPTEN__)
 
 void mainTask(const void *) {
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    // script is started before the boot, with the virtual time it advances the time during the boot
+    if (eez::platform::simulator::headless::hasScript()) {
+        eez::platform::simulator::headless::startScript();
+    }
+#endif
+
     eez::boot();
 
-#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    if (!eez::platform::simulator::headless::hasScript()) {
+        g_consoleInputTaskHandle = osThreadCreate(osThread(g_consoleInputTask), nullptr);
+    }
+#elif defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
     g_consoleInputTaskHandle = osThreadCreate(osThread(g_consoleInputTask), nullptr);
 #endif
 
@@ -47,23 +47,47 @@ static uint8_t * const FILE_VIEW_BUFFER = DLOG_RECORD_BUFFER + DLOG_RECORD_BUFFE
 static const uint32_t FILE_VIEW_BUFFER_SIZE = 1024 * 1024;
 #endif
 #if defined(EEZ_PLATFORM_SIMULATOR)
-static const uint32_t FILE_VIEW_BUFFER_SIZE = 3 * 512 * 1024;
+// big enough to decode the screenshot of the whole simulator display
+static const uint32_t FILE_VIEW_BUFFER_SIZE = 8 * 1024 * 1024;
 #endif
 
 static uint8_t * const MP_BUFFER = FILE_VIEW_BUFFER + FILE_VIEW_BUFFER_SIZE;
 static const uint32_t MP_BUFFER_SIZE = 512 * 1024;
 
 static uint8_t * const SOUND_TUNES_MEMORY = MP_BUFFER + MP_BUFFER_SIZE;
-static const uint32_t SOUND_TUNES_MEMORY_SIZE = 32 * 1024;
+#if defined(EEZ_PLATFORM_STM32)
+static const uint32_t SOUND_TUNES_MEMORY_SIZE = 64 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t SOUND_TUNES_MEMORY_SIZE = 512 * 1024;
+#endif
 
 static uint8_t * const FILE_MANAGER_MEMORY = SOUND_TUNES_MEMORY + SOUND_TUNES_MEMORY_SIZE;
 static const uint32_t FILE_MANAGER_MEMORY_SIZE = 512 * 1024;
 
-static uint8_t * const VRAM_SCREENSHOOT_JPEG_OUT_BUFFER = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+static uint8_t * const LIST_STREAM_MEMORY = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+static const uint32_t LIST_STREAM_MEMORY_SIZE = 96 * 1024;
+
+static uint8_t * const CHANNEL_HISTORY_MEMORY = LIST_STREAM_MEMORY + LIST_STREAM_MEMORY_SIZE;
+static const uint32_t CHANNEL_HISTORY_MEMORY_SIZE = 192 * 1024;
+
+static uint8_t * const TEXT_RUN_CACHE_MEMORY = CHANNEL_HISTORY_MEMORY + CHANNEL_HISTORY_MEMORY_SIZE;
+#if defined(EEZ_PLATFORM_STM32)
+static const uint32_t TEXT_RUN_CACHE_MEMORY_SIZE = 128 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t TEXT_RUN_CACHE_MEMORY_SIZE = 1024 * 1024;
+#endif
+
+static uint8_t * const VRAM_SCREENSHOOT_JPEG_OUT_BUFFER = TEXT_RUN_CACHE_MEMORY + TEXT_RUN_CACHE_MEMORY_SIZE;
+#if defined(EEZ_PLATFORM_STM32)
 static const uint32_t VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE = 256 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE = 1024 * 1024;
+#endif
 
 static uint8_t * const SCREENSHOOT_BUFFER_START_ADDRESS = VRAM_SCREENSHOOT_JPEG_OUT_BUFFER + VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE;
-static const uint32_t SCREENSHOOT_BUFFER_SIZE = 480 * 272 * 3;
 
 #if defined(EEZ_PLATFORM_STM32)
 static const uint32_t DISPLAY_WIDTH = 480;
@@ -77,6 +101,9 @@ static const uint32_t DISPLAY_HEIGHT = 563;
 static const uint32_t VRAM_BUFFER_SIZE = DISPLAY_WIDTH * DISPLAY_HEIGHT * 4; // RGBA8888
 #endif
 
+// screenshot of the whole display, RGB888
+static const uint32_t SCREENSHOOT_BUFFER_SIZE = DISPLAY_WIDTH * DISPLAY_HEIGHT * 3;
+
 static uint8_t * const VRAM_BUFFER1_START_ADDRESS = SCREENSHOOT_BUFFER_START_ADDRESS + SCREENSHOOT_BUFFER_SIZE;
 static uint8_t * const VRAM_BUFFER2_START_ADDRESS = VRAM_BUFFER1_START_ADDRESS + VRAM_BUFFER_SIZE;
 
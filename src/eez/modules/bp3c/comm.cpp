@@ -24,9 +24,12 @@
 #include <stdlib.h>
 #endif
 
+#include <string.h>
+
 #include <eez/debug.h>
 #include <eez/index.h>
 #include <eez/system.h>
+#include <eez/tasks.h>
 
 #include <eez/modules/bp3c/comm.h>
 
@@ -36,10 +39,157 @@
 #define CONF_MASTER_SYNC_TIMEOUT_MS 500
 #define CONF_MASTER_SYNC_IRQ_TIMEOUT_MS 50
 
+#define CONF_TRANSFER_TIMEOUT_US 10000
+
 namespace eez {
 namespace bp3c {
 namespace comm {
 
+enum TransferState {
+    TRANSFER_STATE_IDLE,
+    TRANSFER_STATE_QUEUED,
+    TRANSFER_STATE_IN_PROGRESS,
+    TRANSFER_STATE_FINISHED // by the DMA interrupt, module is not notified yet
+};
+
+struct Transfer {
+    uint8_t *output;
+    uint8_t *input;
+    uint16_t bufferSize;
+    uint8_t maxRetries;
+    uint8_t numRetries;
+    volatile uint8_t state;
+    volatile uint8_t result;
+    uint32_t queueTime;
+    uint32_t startTime;
+};
+
+static Transfer g_transfers[NUM_SLOTS];
+
+static Statistics g_statistics;
+
+// transfer is started only when no other transfer is in progress, used by the benchmark
+static bool g_serialTransfers;
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static BusTiming g_busTiming = { 6750000, 10, 0 };
+static uint32_t g_busTime;
+static uint32_t g_random = 1;
+static uint32_t g_finishTimes[NUM_SLOTS];
+static bool g_isBenchmarkRunning;
+static BusTiming g_benchmarkBusTiming;
+static uint32_t g_benchmarkNumTicks;
+// owned by comm, so a late PSU thread never writes to the caller's stack frame
+static BenchmarkResult g_benchmarkResult;
+static volatile bool g_benchmarkInProgress;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t getTime() {
+#if defined(EEZ_PLATFORM_STM32)
+    return micros();
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    return g_isBenchmarkRunning ? g_busTime : micros();
+#endif
+}
+
+static void startTransfer(int slotIndex) {
+    Transfer &transfer = g_transfers[slotIndex];
+
+    transfer.startTime = getTime();
+
+    // DMA interrupt can finish the transfer before transferDMA returns
+    transfer.state = TRANSFER_STATE_IN_PROGRESS;
+
+#if defined(EEZ_PLATFORM_STM32)
+    spi::handle[slotIndex]->ErrorCode = 0;
+
+    spi::select(slotIndex, spi::CHIP_SLAVE_MCU);
+    auto result = spi::transferDMA(slotIndex, transfer.output, transfer.input, transfer.bufferSize);
+    if (result != HAL_OK) {
+        spi::deselect(slotIndex);
+        transfer.result = result;
+        transfer.state = TRANSFER_STATE_FINISHED;
+    }
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    g_finishTimes[slotIndex] = transfer.startTime + g_busTiming.transferOverhead +
+        (uint32_t)(8ULL * transfer.bufferSize * 1000000 / g_busTiming.bitRate);
+#endif
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static void simulateBus() {
+    for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
+        Transfer &transfer = g_transfers[slotIndex];
+        if (transfer.state == TRANSFER_STATE_IN_PROGRESS && int32_t(g_busTime - g_finishTimes[slotIndex]) >= 0) {
+            g_random = g_random * 1103515245 + 12345;
+            bool isCrcError = (g_random >> 16) % 1000 < g_busTiming.crcErrorRate;
+            transfer.result = isCrcError ? TRANSFER_STATUS_CRC_ERROR : TRANSFER_STATUS_OK;
+            transfer.state = TRANSFER_STATE_FINISHED;
+        }
+    }
+}
+#endif
+
+static void finishTransfer(int slotIndex) {
+    Transfer &transfer = g_transfers[slotIndex];
+    SlotStatistics &statistics = g_statistics.slots[slotIndex];
+
+    TransferResult result = (TransferResult)transfer.result;
+
+#if defined(EEZ_PLATFORM_STM32)
+    if (result == TRANSFER_STATUS_OK && !g_slots[slotIndex]->moduleInfo->spiCrcCalculationEnable) {
+        uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)transfer.input, transfer.bufferSize - 4);
+        if (crc != *((uint32_t *)(transfer.input + transfer.bufferSize - 4))) {
+            result = TRANSFER_STATUS_CRC_ERROR;
+        }
+    }
+#endif
+
+    if (result == TRANSFER_STATUS_CRC_ERROR) {
+        statistics.numCrcErrors++;
+        if (transfer.numRetries < transfer.maxRetries) {
+            transfer.numRetries++;
+            statistics.numRetries++;
+            transfer.state = TRANSFER_STATE_QUEUED;
+            return;
+        }
+    } else if (result != TRANSFER_STATUS_OK) {
+        statistics.numErrors++;
+    }
+
+    uint32_t latency = getTime() - transfer.queueTime;
+    statistics.numTransfers++;
+    statistics.lastLatency = latency;
+    if (latency > statistics.maxLatency) {
+        statistics.maxLatency = latency;
+    }
+    statistics.totalLatency += latency;
+
+    transfer.state = TRANSFER_STATE_IDLE;
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    if (g_isBenchmarkRunning) {
+        return;
+    }
+#endif
+
+    g_slots[slotIndex]->onSpiDmaTransferCompleted(result);
+}
+
+static void waitForTransfer(int slotIndex) {
+    while (g_transfers[slotIndex].state != TRANSFER_STATE_IDLE) {
+        tick();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool masterSynchro(int slotIndex) {
     auto &slot = *g_slots[slotIndex];
 
@@ -104,6 +254,8 @@ bool masterSynchro(int slotIndex) {
 }
 
 TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize) {
+    waitForTransfer(slotIndex);
+
 #if defined(EEZ_PLATFORM_STM32)
     spi::handle[slotIndex]->ErrorCode = 0;
 
@@ -132,20 +284,179 @@ TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t
 #endif
 }
 
-TransferResult transferDMA(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize) {
-#if defined(EEZ_PLATFORM_STM32)
-    spi::handle[slotIndex]->ErrorCode = 0;
+bool queueTransfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize, int maxRetries) {
+    Transfer &transfer = g_transfers[slotIndex];
+    if (transfer.state != TRANSFER_STATE_IDLE) {
+        return false;
+    }
 
-    spi::select(slotIndex, spi::CHIP_SLAVE_MCU);
-    auto result = spi::transferDMA(slotIndex, output, input, bufferSize);
-    return (TransferResult)result;
-#endif
+    transfer.output = output;
+    transfer.input = input;
+    transfer.bufferSize = bufferSize;
+    transfer.maxRetries = maxRetries;
+    transfer.numRetries = 0;
+    transfer.queueTime = getTime();
+    transfer.state = TRANSFER_STATE_QUEUED;
 
+    return true;
+}
+
+bool isTransferIdle(int slotIndex) {
+    return g_transfers[slotIndex].state == TRANSFER_STATE_IDLE;
+}
+
+void tick() {
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    return TRANSFER_STATUS_OK;
+    simulateBus();
 #endif
+
+    bool isInProgress = false;
+
+    for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
+        Transfer &transfer = g_transfers[slotIndex];
+
+        if (transfer.state == TRANSFER_STATE_IN_PROGRESS && int32_t(getTime() - transfer.startTime) > CONF_TRANSFER_TIMEOUT_US) {
+#if defined(EEZ_PLATFORM_STM32)
+            HAL_SPI_Abort(spi::handle[slotIndex]);
+            spi::deselect(slotIndex);
+#endif
+            transfer.result = TRANSFER_STATUS_TIMEOUT;
+            transfer.state = TRANSFER_STATE_FINISHED;
+        }
+
+        if (transfer.state == TRANSFER_STATE_FINISHED) {
+            finishTransfer(slotIndex);
+        }
+
+        if (transfer.state == TRANSFER_STATE_IN_PROGRESS) {
+            isInProgress = true;
+        }
+    }
+
+    for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
+        if (g_transfers[slotIndex].state == TRANSFER_STATE_QUEUED) {
+            if (g_serialTransfers && isInProgress) {
+                break;
+            }
+            startTransfer(slotIndex);
+            isInProgress = true;
+        }
+    }
+}
+
+void onDmaTransferCompleted(int slotIndex, TransferResult result) {
+    Transfer &transfer = g_transfers[slotIndex];
+    if (transfer.state == TRANSFER_STATE_IN_PROGRESS) {
+        transfer.result = result;
+        transfer.state = TRANSFER_STATE_FINISHED;
+    }
+}
+
+void getStatistics(Statistics &statistics) {
+    memcpy(&statistics, &g_statistics, sizeof(Statistics));
+}
+
+void resetStatistics() {
+    memset(&g_statistics, 0, sizeof(Statistics));
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+bool benchmark(const BusTiming &busTiming, uint32_t numTicks, BenchmarkResult &result) {
+    if (g_benchmarkInProgress || numTicks > MAX_BENCHMARK_TICKS) {
+        // previous benchmark timed out and is still running in the PSU thread
+        return false;
+    }
+
+    g_benchmarkBusTiming = busTiming;
+    g_benchmarkNumTicks = numTicks;
+
+    g_benchmarkInProgress = true;
+    sendMessageToPsu(PSU_MESSAGE_BP3C_COMM_BENCHMARK, 0, 0);
+
+    for (int i = 0; i < 1000 && g_benchmarkInProgress; ++i) {
+        osDelay(10);
+    }
+
+    if (g_benchmarkInProgress) {
+        return false;
+    }
+
+    memcpy(&result, &g_benchmarkResult, sizeof(BenchmarkResult));
+    return true;
+}
+
+static uint32_t benchmarkTicks(bool serialTransfers) {
+    // buffer sizes of the DCM220, SMX46 and MIO168 transfers
+    static const uint16_t BUFFER_SIZES[NUM_SLOTS] = { 20, 16, 1024 };
+    static uint8_t g_buffers[NUM_SLOTS][2][1024];
+
+    g_serialTransfers = serialTransfers;
+
+    uint32_t startTime = g_busTime;
+
+    for (uint32_t i = 0; i < g_benchmarkNumTicks; i++) {
+        for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
+            queueTransfer(slotIndex, g_buffers[slotIndex][0], g_buffers[slotIndex][1], BUFFER_SIZES[slotIndex], 2);
+        }
+
+        // bus clock is moved to the next transfer finish until all the transfers of the tick are done
+        while (true) {
+            tick();
+
+            uint32_t nextFinishTime = 0;
+            bool isInProgress = false;
+            for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
+                if (g_transfers[slotIndex].state == TRANSFER_STATE_IN_PROGRESS) {
+                    if (!isInProgress || int32_t(g_finishTimes[slotIndex] - nextFinishTime) < 0) {
+                        nextFinishTime = g_finishTimes[slotIndex];
+                    }
+                    isInProgress = true;
+                }
+            }
+
+            if (!isInProgress) {
+                break;
+            }
+
+            g_busTime = nextFinishTime;
+        }
+    }
+
+    g_serialTransfers = false;
+
+    return g_benchmarkNumTicks > 0 ? (g_busTime - startTime) / g_benchmarkNumTicks : 0;
 }
 
+void doBenchmark() {
+    BenchmarkResult &result = g_benchmarkResult;
+
+    BusTiming savedBusTiming = g_busTiming;
+    Statistics savedStatistics;
+    getStatistics(savedStatistics);
+
+    g_busTiming = g_benchmarkBusTiming;
+    g_isBenchmarkRunning = true;
+
+    result.numTicks = g_benchmarkNumTicks;
+
+    g_random = 1;
+    result.serialTickPeriod = benchmarkTicks(true);
+
+    g_random = 1;
+    resetStatistics();
+    result.overlappedTickPeriod = benchmarkTicks(false);
+    getStatistics(result.statistics);
+
+    g_isBenchmarkRunning = false;
+    g_busTiming = savedBusTiming;
+    memcpy(&g_statistics, &savedStatistics, sizeof(Statistics));
+
+    g_benchmarkInProgress = false;
+}
+
+#endif
+
 } // namespace comm
 } // namespace bp3c
 } // namespace eez
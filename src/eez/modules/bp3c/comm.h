@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <eez/index.h>
+
 namespace eez {
 namespace bp3c {
 namespace comm {
@@ -34,8 +36,68 @@ enum TransferResult {
     TRANSFER_STATUS_CRC_ERROR
 };
 
+// Blocking transfer, waits for the scheduled transfer on the same slot to finish first.
 TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize);
-TransferResult transferDMA(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize);
+
+// Transfers are queued by the modules during the PSU thread tick and started together at the end
+// of the tick, so DMA transfers on the SPI buses of different slots overlap. Module is notified
+// through Module::onSpiDmaTransferCompleted, in the PSU thread, at the beginning of the next tick
+// (or later if the transfer is not finished by then). Transfer with the CRC error is repeated up to maxRetries times before the module
+// is notified. Buffers must be valid until the module is notified.
+// Returns false if the previous transfer of the slot is not finished yet.
+bool queueTransfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize, int maxRetries = 0);
+
+bool isTransferIdle(int slotIndex);
+
+// Called from the PSU thread at the beginning and at the end of every tick, notifies the modules
+// about the finished transfers and starts the queued ones.
+void tick();
+
+// Called from the SPI DMA interrupt.
+void onDmaTransferCompleted(int slotIndex, TransferResult result);
+
+struct SlotStatistics {
+    uint32_t numTransfers;
+    uint32_t numRetries;
+    uint32_t numCrcErrors; // including the retried transfers
+    uint32_t numErrors;
+    uint32_t lastLatency; // us, from the queue to the module notification
+    uint32_t maxLatency; // us
+    uint64_t totalLatency; // us
+};
+
+struct Statistics {
+    SlotStatistics slots[NUM_SLOTS];
+};
+
+void getStatistics(Statistics &statistics);
+void resetStatistics();
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+// Simulator transfers take the time of the configured bus timing, measured with the virtual bus clock.
+struct BusTiming {
+    uint32_t bitRate; // bits per second
+    uint32_t transferOverhead; // us, chip select, DMA start and completion
+    uint32_t crcErrorRate; // CRC errors per 1000 transfers
+};
+
+struct BenchmarkResult {
+    uint32_t numTicks;
+    uint32_t serialTickPeriod; // us, average, transfers of all the slots done one after another
+    uint32_t overlappedTickPeriod; // us, average, transfers of all the slots started together
+    Statistics statistics; // of the overlapped transfers
+};
+
+static const uint32_t MAX_BENCHMARK_TICKS = 100000;
+
+// Simulates, in the PSU thread, the given number of ticks with the DCM220, SMX46 and MIO168 transfers
+// in the slots 1, 2 and 3. Returns false if the PSU thread didn't finish it in time
+// or the previous benchmark is still running.
+bool benchmark(const BusTiming &busTiming, uint32_t numTicks, BenchmarkResult &result);
+void doBenchmark();
+
+#endif
 
 } // namespace comm
 } // namespace bp3c
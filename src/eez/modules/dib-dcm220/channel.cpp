@@ -58,6 +58,8 @@ static const uint16_t ADC_MAX = 65535;
 
 #define BUFFER_SIZE 20
 
+#define MAX_TRANSFER_RETRIES 2
+
 static const float PTOT = 155.0f;
 
 static const float I_MON_RESOLUTION = 0.02f;
@@ -419,6 +421,10 @@ public:
 #if defined(EEZ_PLATFORM_STM32)
     void transfer() {
         auto status = bp3c::comm::transfer(slotIndex, output, input, BUFFER_SIZE);
+        updateNumCrcErrors(status);
+    }
+
+    void updateNumCrcErrors(int status) {
         if (status == bp3c::comm::TRANSFER_STATUS_OK) {
             numCrcErrors = 0;
         } else {
@@ -462,6 +468,11 @@ public:
     }
 
     void tick(uint8_t slotIndex) {
+        if (!bp3c::comm::isTransferIdle(slotIndex)) {
+            // output buffer is still used by the previous transfer
+            return;
+        }
+
         DcmChannel &channel1 = (DcmChannel &)*Channel::getBySlotIndex(slotIndex, 0);
         DcmChannel &channel2 = (DcmChannel &)*Channel::getBySlotIndex(slotIndex, 1);
 
@@ -482,9 +493,13 @@ public:
         psu::debug::g_iDac[channel2.channelIndex].set(channel2.iSet);
 #endif
 
-        transfer();
+        bp3c::comm::queueTransfer(slotIndex, output, input, BUFFER_SIZE, MAX_TRANSFER_RETRIES);
+    }
 
-        if (numCrcErrors == 0) {
+    void onSpiDmaTransferCompleted(int status) override {
+        updateNumCrcErrors(status);
+
+        if (status == bp3c::comm::TRANSFER_STATUS_OK) {
             uint16_t *inputSetValues = (uint16_t *)(input + 2);
 
             for (int subchannelIndex = 0; subchannelIndex < 2; subchannelIndex++) {
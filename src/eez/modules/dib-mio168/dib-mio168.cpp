@@ -123,8 +123,11 @@ public:
 
 #if defined(EEZ_PLATFORM_STM32)
         if (spiReady) {
+            // cleared before the transfer is started, restored if it wasn't queued
             spiReady = false;
-            transfer();
+            if (!transfer()) {
+                spiReady = true;
+            }
         }
 #endif
     }
@@ -135,15 +138,15 @@ public:
     }
 #endif
 
-    void transfer() {
+    bool transfer() {
+        if (!bp3c::comm::isTransferIdle(slotIndex)) {
+            return false;
+        }
+
         output[0] = inputPinStates;
         output[1] = outputPinStates;
 
-        auto status = bp3c::comm::transferDMA(slotIndex, output, input, BUFFER_SIZE);
-        if (status != bp3c::comm::TRANSFER_STATUS_OK) {
-        	auto &slot = *g_slots[slotIndex];
-        	slot.onSpiDmaTransferCompleted(status);
-        }
+        return bp3c::comm::queueTransfer(slotIndex, output, input, BUFFER_SIZE);
     }
 
     void onSpiDmaTransferCompleted(int status) override {
@@ -114,8 +114,11 @@ public:
 
 #if defined(EEZ_PLATFORM_STM32)
         if (spiReady) {
+            // cleared before the transfer is started, restored if it wasn't queued
             spiReady = false;
-            transfer();
+            if (!transfer()) {
+                spiReady = true;
+            }
         }
 #endif
     }
@@ -126,8 +129,11 @@ public:
     }
 #endif
 
-    void transfer() {
-        auto status = bp3c::comm::transfer(slotIndex, output, input, BUFFER_SIZE);
+    bool transfer() {
+        return bp3c::comm::queueTransfer(slotIndex, output, input, BUFFER_SIZE);
+    }
+
+    void onSpiDmaTransferCompleted(int status) override {
         if (status == bp3c::comm::TRANSFER_STATUS_OK) {
             numCrcErrors = 0;
         } else {
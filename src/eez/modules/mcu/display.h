@@ -102,6 +102,13 @@ void bitBlt(void *src, int x1, int y1, int x2, int y2);
 void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2);
 void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy, uint8_t opacity);
 void drawBitmap(Image *image, int x, int y);
+
+// Copies the rectangle of the current buffer to/from the memory in the native pixel format,
+// getPixelsSize returns the number of bytes needed for the rectangle.
+uint32_t getPixelsSize(int width, int height);
+void readPixels(int x, int y, int width, int height, void *pixels);
+void writePixels(const void *pixels, int x, int y, int width, int height);
+
 void drawStr(const char *text, int textLength, int x, int y, int clip_x1, int clip_y1, int clip_x2,
              int clip_y2, gui::font::Font &font);
 int8_t measureGlyph(uint8_t encoding, gui::font::Font &font);
@@ -22,10 +22,6 @@
 #include <i2c.h>
 #endif
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-#include <stdio.h>
-#endif
-
 #include <eez/system.h>
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/mcu/eeprom.h>
@@ -49,13 +45,13 @@ TestResult g_testResult = TEST_FAILED;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// simulator implementation of read and write is in simulator/eeprom.cpp
 #if defined(EEZ_PLATFORM_STM32)
+
 const int MAX_READ_CHUNK_SIZE = 16;
-#endif
 
 bool read(uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
 
-#if defined(EEZ_PLATFORM_STM32)
     for (uint16_t i = 0; i < bufferSize; i += MAX_READ_CHUNK_SIZE) {
         uint16_t chunkAddress = address + i;
 
@@ -82,38 +78,12 @@ bool read(uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
     }
 
     return true;
-#endif
-
-#if defined(EEZ_PLATFORM_SIMULATOR)
-    char *file_path = getConfFilePath("EEPROM.state");
-    FILE *fp = fopen(file_path, "r+b");
-    if (fp == NULL) {
-        fp = fopen(file_path, "w+b");
-    }
-    if (fp == NULL) {
-        return false;
-    }
-
-    fseek(fp, address, SEEK_SET);
-    size_t readBytes = fread(buffer, 1, bufferSize, fp);
-    fclose(fp);
-
-    if (readBytes < bufferSize) {
-        memset(buffer + readBytes, 0xFF, bufferSize - readBytes);
-    }
-
-    return true;
-#endif
-
 }
 
-#if defined(EEZ_PLATFORM_STM32)
 const int MAX_WRITE_CHUNK_SIZE = 16;
-#endif
 
 bool write(const uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
 
-#if defined(EEZ_PLATFORM_STM32)
     for (uint16_t i = 0; i < bufferSize; i += MAX_WRITE_CHUNK_SIZE) {
         uint16_t chunkAddress = address + i;
 
@@ -159,27 +129,10 @@ bool write(const uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
     }
 
     return true;
-#endif
-
-#if defined(EEZ_PLATFORM_SIMULATOR)
-    char *file_path = getConfFilePath("EEPROM.state");
-    FILE *fp = fopen(file_path, "r+b");
-    if (fp == NULL) {
-        fp = fopen(file_path, "w+b");
-    }
-    if (fp == NULL) {
-        return false;
-    }
-
-    fseek(fp, address, SEEK_SET);
-    fwrite(buffer, 1, bufferSize, fp);
-    fclose(fp);
-
-    return true;
-#endif
-
 }
 
+#endif // EEZ_PLATFORM_STM32
+
 void init() {
 }
 
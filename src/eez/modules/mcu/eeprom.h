@@ -124,6 +124,36 @@ bool write(const uint8_t *buffer, uint16_t buffer_size, uint16_t address);
 
 void resetAllExceptOnTimeCounters();
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+// Simulator keeps EEPROM content in the memory mapped EEPROM.state file.
+// Pages changed by write are flushed to the disk together, in tick when there were no writes
+// for some time, or at the latest one second after the first unflushed write.
+static const uint16_t EEPROM_PAGE_SIZE = 64;
+static const uint16_t EEPROM_NUM_PAGES = EEPROM_SIZE / EEPROM_PAGE_SIZE;
+
+void tick();
+void flush();
+
+struct Statistics {
+    uint32_t numReads;
+    uint32_t numWrites;
+    uint32_t numBytesWritten;  // bytes passed to write
+    uint32_t numBytesChanged;  // written bytes which were different from the EEPROM content
+    uint32_t numPageWrites;    // page write cycles, EEPROM is written in 16 bytes chunks as on the STM32
+    uint32_t maxPageWrites;    // page write cycles of the most written page
+    uint32_t numFlushes;
+    uint32_t numFlushedBytes;
+    uint32_t writeTime;        // us spent in write
+};
+
+void getStatistics(Statistics &statistics);
+// page write cycles for each of EEPROM_NUM_PAGES pages
+const uint32_t *getPageWrites();
+void resetStatistics();
+
+#endif
+
 } // namespace eeprom
 } // namespace mcu
 } // namespace eez
@@ -26,6 +26,8 @@
 
 #include <eez/modules/mcu/encoder.h>
 
+#include <eez/gui/input.h>
+
 #if defined(EEZ_PLATFORM_STM32)	
 #include <eez/modules/mcu/button.h>
 #endif
@@ -49,6 +51,7 @@ static Button g_encoderSwitch(ENC_SW_GPIO_Port, ENC_SW_Pin, true, false);
 #endif	
 
 static uint16_t g_totalCounter;
+// counter not pushed to the input ring because it was full, it is pushed with the next rotation
 static int16_t g_diffCounter;
 #if defined(EEZ_PLATFORM_SIMULATOR)
 bool g_simulatorClicked;
@@ -126,6 +129,15 @@ void init() {
     g_calcAutoModeStepLevel.reset();
 }
 
+static void pushCounter(int16_t counter) {
+    counter += g_diffCounter;
+    if (gui::input::push(gui::input::SOURCE_ENCODER, 0, counter, 0)) {
+        g_diffCounter = 0;
+    } else {
+        g_diffCounter = counter;
+    }
+}
+
 #if defined(EEZ_PLATFORM_STM32)
 
 void onPinInterrupt() {
@@ -150,14 +162,17 @@ void onPinInterrupt() {
     }
 
     if (offset) {
-        g_diffCounter += offset;
+        pushCounter(offset);
     }
 }
 #endif
 
 int getCounter() {
-    int16_t diffCounter = g_diffCounter;
-    g_diffCounter -= diffCounter;
+    int16_t diffCounter = 0;
+    gui::input::InputEvent event;
+    while (gui::input::pop(gui::input::SOURCE_ENCODER, event)) {
+        diffCounter += event.x;
+    }
 
     g_totalCounter += diffCounter;
     psu::debug::g_encoderCounter.set(g_totalCounter);
@@ -198,7 +213,9 @@ void read(int &counter, bool &clicked) {
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
 void write(int counter, bool clicked) {
-	g_diffCounter = counter;
+    if (counter != 0) {
+        pushCounter(counter);
+    }
 	g_simulatorClicked = clicked;
 }
 #endif
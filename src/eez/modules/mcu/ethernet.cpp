@@ -53,11 +53,18 @@ extern ip4_addr_t gw;
 #include <fcntl.h>
 #include <memory.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 #endif
 
 #include <eez/firmware.h>
@@ -133,13 +140,16 @@ struct netconn *g_tcpClientConnection;
 static netbuf *g_inbuf;
 static bool g_checkLinkWhileIdle = false;
 
+// only one client is served (MAX_NUM_CLIENTS is 1), it uses the first SCPI context
+static const int CLIENT_INDEX = 0;
+
 static void netconnCallback(struct netconn *conn, enum netconn_evt evt, u16_t len) {
 	switch (evt) {
 	case NETCONN_EVT_RCVPLUS:
 		if (conn == g_tcpListenConnection) {
 			osMessagePut(g_ethernetMessageQueueId, QUEUE_MESSAGE_ACCEPT_CLIENT, osWaitForever);
 		} else if (conn == g_tcpClientConnection) {
-			sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE);
+			sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE, CLIENT_INDEX);
 		}
 		break;
 
@@ -260,7 +270,7 @@ static void onEvent(uint8_t eventType) {
 				} else {
 					// connection with the client established
 					g_tcpClientConnection = newConnection;
-					sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED);
+					sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED, CLIENT_INDEX);
 				}
 			}
 		}
@@ -294,44 +304,85 @@ void onIdle() {
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-#define INPUT_BUFFER_SIZE 1024
+#define INPUT_BUFFER_SIZE 4096
+
+// client which doesn't read the output for this long is disconnected
+#define CONF_WRITE_TIMEOUT_MS 250
+
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+typedef SOCKET Socket;
+#define INVALID_SOCKET_VALUE INVALID_SOCKET
+#else
+typedef int Socket;
+#define INVALID_SOCKET_VALUE -1
+#endif
+
+enum ClientState {
+    CLIENT_STATE_FREE,
+    CLIENT_STATE_CONNECTED,
+    CLIENT_STATE_CLOSED // socket is closed, waiting for the low priority thread to release the client
+};
+
+struct Client {
+    std::atomic<int> state;
+    Socket socket;
+    std::mutex socketMutex;
+
+    // Receive ring buffer. Head is moved only by the ethernet thread (when data is received),
+    // and tail only by the low priority thread (when data is parsed).
+    char inputBuffer[INPUT_BUFFER_SIZE];
+    std::atomic<uint32_t> inputHead;
+    std::atomic<uint32_t> inputTail;
+    uint32_t inputViewLength;
+    std::atomic<bool> isInputAvailableMessageSent;
+};
 
 static uint16_t g_port;
-static char g_inputBuffer[INPUT_BUFFER_SIZE];
-static uint32_t g_inputBufferLength;
+static Socket g_listenSocket = INVALID_SOCKET_VALUE;
+static Client g_clients[MAX_NUM_CLIENTS];
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool bind(int port);
-bool client_available();
-bool connected();
-int available();
-int read(char *buffer, int buffer_size);
-int write(const char *buffer, int buffer_size);
-void stop();
+static void closeSocket(Socket socket) {
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
 
+static bool isWouldBlockError() {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-static SOCKET listen_socket = INVALID_SOCKET;
-static SOCKET client_socket = INVALID_SOCKET;
+    return WSAGetLastError() == WSAEWOULDBLOCK;
 #else
-static int listen_socket = -1;
-static int client_socket = -1;
+    return errno == EWOULDBLOCK || errno == EAGAIN;
+#endif
+}
 
-bool enable_non_blocking(int fd) {
-    int flags = fcntl(fd, F_GETFL, 0);
+static bool enableNonBlocking(Socket socket) {
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    u_long iMode = 1;
+    return ioctlsocket(socket, FIONBIO, &iMode) == NO_ERROR;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
     if (flags < 0) {
         return false;
     }
     flags = flags | O_NONBLOCK;
-    if (fcntl(fd, F_SETFL, flags) < 0) {
+    if (fcntl(socket, F_SETFL, flags) < 0) {
         return false;
     }
     return true;
+#endif
 }
 
-#endif
+static void disableNagle(Socket socket) {
+    // responses are already batched, so send them immediately
+    int flag = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&flag, sizeof(flag));
+}
 
-bool bind(int port) {
+static bool bind(int port) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     WSADATA wsaData;
     int iResult;
@@ -366,74 +417,75 @@ bool bind(int port) {
     }
 
     // Create a SOCKET for connecting to server
-    listen_socket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-    if (listen_socket == INVALID_SOCKET) {
+    g_listenSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (g_listenSocket == INVALID_SOCKET) {
         DebugTrace("EHTERNET: socket failed with error %d\n", WSAGetLastError());
         freeaddrinfo(result);
         return false;
     }
 
-    u_long iMode = 1;
-    iResult = ioctlsocket(listen_socket, FIONBIO, &iMode);
-    if (iResult != NO_ERROR) {
-        DebugTrace("EHTERNET: ioctlsocket failed with error %d\n", iResult);
+    if (!enableNonBlocking(g_listenSocket)) {
+        DebugTrace("EHTERNET: ioctlsocket failed with error %d\n", WSAGetLastError());
         freeaddrinfo(result);
-        closesocket(listen_socket);
-        listen_socket = INVALID_SOCKET;
+        closesocket(g_listenSocket);
+        g_listenSocket = INVALID_SOCKET;
         return false;
     }
 
     // Setup the TCP listening socket
-    iResult = ::bind(listen_socket, result->ai_addr, (int)result->ai_addrlen);
+    iResult = ::bind(g_listenSocket, result->ai_addr, (int)result->ai_addrlen);
     if (iResult == SOCKET_ERROR) {
         DebugTrace("EHTERNET: bind failed with error %d\n", WSAGetLastError());
         freeaddrinfo(result);
-        closesocket(listen_socket);
-        listen_socket = INVALID_SOCKET;
+        closesocket(g_listenSocket);
+        g_listenSocket = INVALID_SOCKET;
         return false;
     }
 
     freeaddrinfo(result);
 
-    iResult = listen(listen_socket, SOMAXCONN);
+    iResult = listen(g_listenSocket, SOMAXCONN);
     if (iResult == SOCKET_ERROR) {
         DebugTrace("EHTERNET listen failed with error %d\n", WSAGetLastError());
-        closesocket(listen_socket);
-        listen_socket = INVALID_SOCKET;
+        closesocket(g_listenSocket);
+        g_listenSocket = INVALID_SOCKET;
         return false;
     }
 
     return true;
 #else
     sockaddr_in serv_addr;
-    listen_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_socket < 0) {
+    g_listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (g_listenSocket < 0) {
         DebugTrace("EHTERNET: socket failed with error %d", errno);
         return false;
     }
 
-    if (!enable_non_blocking(listen_socket)) {
+    if (!enableNonBlocking(g_listenSocket)) {
         DebugTrace("EHTERNET: ioctl on listen socket failed with error %d", errno);
-        close(listen_socket);
-        listen_socket = -1;
+        close(g_listenSocket);
+        g_listenSocket = -1;
         return false;
     }
 
+    int reuseAddr = 1;
+    setsockopt(g_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
     bzero((char *)&serv_addr, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
     serv_addr.sin_addr.s_addr = INADDR_ANY;
     serv_addr.sin_port = htons(port);
-    if (::bind(listen_socket, (sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+    if (::bind(g_listenSocket, (sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
         DebugTrace("EHTERNET: bind failed with error %d", errno);
-        close(listen_socket);
-        listen_socket = -1;
+        close(g_listenSocket);
+        g_listenSocket = -1;
         return false;
     }
 
-    if (listen(listen_socket, 5) < 0) {
+    if (listen(g_listenSocket, 5) < 0) {
         DebugTrace("EHTERNET: listen failed with error %d", errno);
-        close(listen_socket);
-        listen_socket = -1;
+        close(g_listenSocket);
+        g_listenSocket = -1;
         return false;
     }
 
@@ -441,238 +493,308 @@ bool bind(int port) {
 #endif    
 }
 
-bool client_available() {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (connected())
-        return true;
+static void acceptClient() {
+    Socket socket = accept(g_listenSocket, NULL, NULL);
+    if (socket == INVALID_SOCKET_VALUE) {
+        if (isWouldBlockError()) {
+            return;
+        }
 
-    if (listen_socket == INVALID_SOCKET) {
-        return false;
+        DebugTrace("EHTERNET: accept failed\n");
+        closeSocket(g_listenSocket);
+        g_listenSocket = INVALID_SOCKET_VALUE;
+        return;
     }
 
-    // Accept a client socket
-    client_socket = accept(listen_socket, NULL, NULL);
-    if (client_socket == INVALID_SOCKET) {
-        if (WSAGetLastError() == WSAEWOULDBLOCK) {
-            return false;
-        }
+    for (int clientIndex = 0; clientIndex < MAX_NUM_CLIENTS; clientIndex++) {
+        Client &client = g_clients[clientIndex];
+        if (client.state == CLIENT_STATE_FREE) {
+            if (!enableNonBlocking(socket)) {
+                DebugTrace("EHTERNET: ioctl on client socket failed\n");
+                closeSocket(socket);
+                return;
+            }
 
-        DebugTrace("EHTERNET accept failed with error %d\n", WSAGetLastError());
-        closesocket(listen_socket);
-        listen_socket = INVALID_SOCKET;
-        return false;
-    }
+            disableNagle(socket);
 
-    return true;
-#else
-    if (connected())
-        return true;
+            client.socket = socket;
+            client.inputHead = 0;
+            client.inputTail = 0;
+            client.inputViewLength = 0;
+            client.isInputAvailableMessageSent = false;
+            client.state = CLIENT_STATE_CONNECTED;
 
-    if (listen_socket == -1) {
-        return 0;
+            sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED, clientIndex);
+            return;
+        }
     }
 
-    sockaddr_in cli_addr;
-    socklen_t clilen = sizeof(cli_addr);
-    client_socket = accept(listen_socket, (sockaddr *)&cli_addr, &clilen);
-    if (client_socket < 0) {
-        if (errno == EWOULDBLOCK) {
-            return false;
-        }
+    // all the clients are already connected, close this connection
+    closeSocket(socket);
+}
 
-        DebugTrace("EHTERNET: accept failed with error %d", errno);
-        close(listen_socket);
-        listen_socket = -1;
-        return false;
-    }
+static void closeClient(int clientIndex) {
+    Client &client = g_clients[clientIndex];
 
-    if (!enable_non_blocking(client_socket)) {
-        DebugTrace("EHTERNET: ioctl on client socket failed with error %d", errno);
-        close(client_socket);
-        listen_socket = -1;
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(client.socketMutex);
+        closeSocket(client.socket);
+        client.socket = INVALID_SOCKET_VALUE;
+        client.state = CLIENT_STATE_CLOSED;
     }
 
-    return true;
-#endif    
+    sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, clientIndex);
 }
 
-bool connected() {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    return client_socket != INVALID_SOCKET;
-#else
-    return client_socket != -1;
-#endif    
+static uint32_t getInputBufferFreeSpace(const Client &client) {
+    return INPUT_BUFFER_SIZE - (client.inputHead - client.inputTail);
 }
 
-int available() {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (client_socket == INVALID_SOCKET)
-        return 0;
+static void receive(int clientIndex) {
+    Client &client = g_clients[clientIndex];
+
+    // receive directly into the ring buffer, into the free space till the end of buffer
+    uint32_t head = client.inputHead;
+    uint32_t position = head % INPUT_BUFFER_SIZE;
+    uint32_t size = MIN(getInputBufferFreeSpace(client), INPUT_BUFFER_SIZE - position);
 
-    int iResult = ::recv(client_socket, g_inputBuffer, INPUT_BUFFER_SIZE, MSG_PEEK);
-    if (iResult > 0) {
-        return iResult;
+    int n = ::recv(client.socket, client.inputBuffer + position, size, 0);
+    if (n > 0) {
+        client.inputHead = head + n;
+    } else if (n == 0 || !isWouldBlockError()) {
+        closeClient(clientIndex);
     }
+}
 
-    if (iResult < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
-        return 0;
+static void notifyInputAvailable() {
+    for (int clientIndex = 0; clientIndex < MAX_NUM_CLIENTS; clientIndex++) {
+        Client &client = g_clients[clientIndex];
+        if (
+            client.state == CLIENT_STATE_CONNECTED &&
+            client.inputHead != client.inputTail &&
+            !client.isInputAvailableMessageSent.exchange(true)
+        ) {
+            sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE, clientIndex);
+        }
     }
+}
 
-    stop();
+void onEvent(uint8_t eventType) {
+    switch (eventType) {
+    case QUEUE_MESSAGE_CONNECT:
+        sendMessageToLowPriorityThread(ETHERNET_CONNECTED, 1);
+        break;
 
-    return 0;
-#else
-    if (client_socket == -1)
-        return 0;
+    case QUEUE_MESSAGE_CREATE_TCP_SERVER:
+        bind(g_port);
+        break;
 
-    char buffer[1000];
-    int iResult = ::recv(client_socket, buffer, 1000, MSG_PEEK);
-    if (iResult > 0) {
-        return iResult;
+    case QUEUE_MESSAGE_DESTROY_TCP_SERVER:
+        if (g_listenSocket != INVALID_SOCKET_VALUE) {
+            closeSocket(g_listenSocket);
+            g_listenSocket = INVALID_SOCKET_VALUE;
+        }
+        break;
     }
+}
 
-    if (iResult < 0 && errno == EWOULDBLOCK) {
-        return 0;
+void onIdle() {
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    Socket maxSocket = 0;
+    bool hasPendingInput = false;
+
+    if (g_listenSocket != INVALID_SOCKET_VALUE) {
+        FD_SET(g_listenSocket, &readSet);
+        maxSocket = g_listenSocket;
     }
 
-    stop();
-
-    return 0;
-#endif        
-}
+    for (int clientIndex = 0; clientIndex < MAX_NUM_CLIENTS; clientIndex++) {
+        Client &client = g_clients[clientIndex];
+        if (client.state == CLIENT_STATE_CONNECTED) {
+            if (client.inputHead != client.inputTail) {
+                hasPendingInput = true;
+            }
+            // when ring buffer is full, wait for the low priority thread to parse the input
+            if (getInputBufferFreeSpace(client) > 0) {
+                FD_SET(client.socket, &readSet);
+                if (client.socket > maxSocket) {
+                    maxSocket = client.socket;
+                }
+            }
+        }
+    }
 
-int read(char *buffer, int buffer_size) {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    int iResult = ::recv(client_socket, buffer, buffer_size, 0);
-    if (iResult > 0) {
-        return iResult;
+    if (g_listenSocket == INVALID_SOCKET_VALUE && !hasPendingInput) {
+        osDelay(10);
+        return;
     }
 
-    if (iResult < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
-        return 0;
+    // wait for input, while there is unparsed input check more often if the
+    // low priority thread needs another ETHERNET_INPUT_AVAILABLE message
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = hasPendingInput ? 1000 : 10000;
+    if (osVirtualTimeIsEnabled()) {
+        // don't block in the host, virtual time is not advanced until this thread waits in osDelay
+        timeout.tv_usec = 0;
     }
+    int result = select((int)maxSocket + 1, &readSet, nullptr, nullptr, &timeout);
 
-    stop();
+    if (result > 0) {
+        if (g_listenSocket != INVALID_SOCKET_VALUE && FD_ISSET(g_listenSocket, &readSet)) {
+            acceptClient();
+        }
 
-    return 0;
-#else
-    int n = ::read(client_socket, buffer, buffer_size);
-    if (n > 0) {
-        return n;
+        for (int clientIndex = 0; clientIndex < MAX_NUM_CLIENTS; clientIndex++) {
+            Client &client = g_clients[clientIndex];
+            if (client.state == CLIENT_STATE_CONNECTED && FD_ISSET(client.socket, &readSet)) {
+                receive(clientIndex);
+            }
+        }
+    } else if (result < 0 || osVirtualTimeIsEnabled()) {
+        osDelay(1);
     }
 
-    if (n < 0 && errno == EWOULDBLOCK) {
-        return 0;
-    }
+    notifyInputAvailable();
+}
 
-    stop();
+////////////////////////////////////////////////////////////////////////////////
 
-    return 0;
-#endif    
-}
+static std::mutex g_loadTestMutex;
+static LoadTestResult g_loadTestResult;
+static int g_numLoadTestClientsRunning;
+static std::chrono::steady_clock::time_point g_loadTestStartTime;
+static char g_loadTestRequest[128];
 
-int write(const char *buffer, int buffer_size) {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    int iSendResult;
-
-    if (client_socket != INVALID_SOCKET) {
-        // Echo the buffer back to the sender
-        iSendResult = ::send(client_socket, buffer, buffer_size, 0);
-        if (iSendResult == SOCKET_ERROR) {
-            DebugTrace("send failed with error: %d\n", WSAGetLastError());
-            closesocket(client_socket);
-            client_socket = INVALID_SOCKET;
-            return 0;
+static bool sendAll(Socket socket, const char *buffer, size_t length) {
+    while (length > 0) {
+        int n = ::send(socket, buffer, (int)length, 0);
+        if (n <= 0) {
+            return false;
         }
-        return iSendResult;
+        buffer += n;
+        length -= n;
     }
+    return true;
+}
 
-    return 0;
-#else
-    if (client_socket != -1) {
-        int n = ::write(client_socket, buffer, buffer_size);
-        if (n < 0) {
-            close(client_socket);
-            client_socket = -1;
-            return 0;
-        }
-        return n;
-    }
+static void loadTestClient(int clientIndex) {
+    using namespace std::chrono;
 
-    return 0;
-#endif    
-}
+    int numRequests = g_loadTestResult.numRequests;
+    int numErrors = 0;
+    uint64_t totalLatency = 0;
+    uint32_t maxLatency = 0;
+    int numResponses = 0;
 
-void stop() {
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (client_socket != INVALID_SOCKET) {
-        int iResult = ::shutdown(client_socket, SD_SEND);
-        if (iResult == SOCKET_ERROR) {
-            DebugTrace("EHTERNET shutdown failed with error %d\n", WSAGetLastError());
+    Socket socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(g_port);
+
+    if (socket == INVALID_SOCKET_VALUE || connect(socket, (sockaddr *)&address, sizeof(address)) != 0) {
+        numErrors = numRequests;
+    } else {
+        disableNagle(socket);
+
+        size_t requestLength = strlen(g_loadTestRequest);
+        char buffer[1024];
+
+        for (int i = 0; i < numRequests; i++) {
+            auto startTime = steady_clock::now();
+
+            if (!sendAll(socket, g_loadTestRequest, requestLength)) {
+                numErrors += numRequests - i;
+                break;
+            }
+
+            // wait for the end of the response line
+            bool isResponseReceived = false;
+            while (!isResponseReceived) {
+                int n = ::recv(socket, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    break;
+                }
+                isResponseReceived = memchr(buffer, '\n', n) != nullptr;
+            }
+
+            if (!isResponseReceived) {
+                numErrors += numRequests - i;
+                break;
+            }
+
+            uint32_t latency = (uint32_t)duration_cast<microseconds>(steady_clock::now() - startTime).count();
+            totalLatency += latency;
+            if (latency > maxLatency) {
+                maxLatency = latency;
+            }
+            numResponses++;
         }
-        closesocket(client_socket);
-        client_socket = INVALID_SOCKET;
     }
-#else
-    int result = ::shutdown(client_socket, SHUT_WR);
-    if (result < 0) {
-        DebugTrace("ETHERNET shutdown failed with error %d\n", errno);
+
+    if (socket != INVALID_SOCKET_VALUE) {
+        closeSocket(socket);
     }
-    close(client_socket);
-    client_socket = -1;
-#endif    
-}
 
-void onEvent(uint8_t eventType) {
-    switch (eventType) {
-    case QUEUE_MESSAGE_CONNECT:
-        sendMessageToLowPriorityThread(ETHERNET_CONNECTED, 1);
-        break;
+    std::lock_guard<std::mutex> lock(g_loadTestMutex);
 
-    case QUEUE_MESSAGE_CREATE_TCP_SERVER:
-        bind(g_port);
-        break;
+    g_loadTestResult.numErrors += numErrors;
+    g_loadTestResult.avgLatency[clientIndex] = numResponses > 0 ? 1.0f * totalLatency / numResponses : 0;
+    g_loadTestResult.maxLatency[clientIndex] = maxLatency;
 
-    case QUEUE_MESSAGE_DESTROY_TCP_SERVER:
-#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-        if (listen_socket != INVALID_SOCKET) {
-            closesocket(listen_socket);
-            listen_socket = INVALID_SOCKET;
-        }
-#else
-        close(listen_socket);
-        listen_socket = -1;
-#endif    
-        break;
+    if (--g_numLoadTestClientsRunning == 0) {
+        g_loadTestResult.duration = (uint32_t)duration_cast<milliseconds>(steady_clock::now() - g_loadTestStartTime).count();
+        g_loadTestResult.isFinished = true;
     }
 }
 
-void onIdle() {
-    static bool wasConnected = false;
+bool startLoadTest(int numClients, int numRequests, const char *command) {
+    std::lock_guard<std::mutex> lock(g_loadTestMutex);
 
-    if (wasConnected) {
-        if (connected()) {
-            if (!g_inputBufferLength && available()) {
-                g_inputBufferLength = read(g_inputBuffer, INPUT_BUFFER_SIZE);
-                sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE);
-            }
-        } else {
-            sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
-            wasConnected = false;
-        }
-    } else {
-        if (client_available()) {
-            wasConnected = true;
-            sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED);
-        }
+    if (g_numLoadTestClientsRunning > 0 || g_listenSocket == INVALID_SOCKET_VALUE) {
+        return false;
+    }
+
+    if (numClients < 1 || numClients > MAX_NUM_CLIENTS || numRequests < 1 || strlen(command) + 2 > sizeof(g_loadTestRequest)) {
+        return false;
+    }
+
+    strcpy(g_loadTestRequest, command);
+    strcat(g_loadTestRequest, "\n");
+
+    memset(&g_loadTestResult, 0, sizeof(g_loadTestResult));
+    g_loadTestResult.numClients = numClients;
+    g_loadTestResult.numRequests = numRequests;
+
+    g_numLoadTestClientsRunning = numClients;
+    g_loadTestStartTime = std::chrono::steady_clock::now();
+
+    for (int clientIndex = 0; clientIndex < numClients; clientIndex++) {
+        std::thread(loadTestClient, clientIndex).detach();
     }
+
+    return true;
 }
+
+void getLoadTestResult(LoadTestResult &result) {
+    std::lock_guard<std::mutex> lock(g_loadTestMutex);
+    result = g_loadTestResult;
+}
+
 #endif
 
 void mainLoop(const void *) {
     while (1) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+        // in simulator onIdle is waiting for the socket input
+        osEvent event = osMessageGet(g_ethernetMessageQueueId, 0);
+#else
         osEvent event = osMessageGet(g_ethernetMessageQueueId, 10);
+#endif
         if (event.status == osEventMessage) {
             uint8_t eventType = event.value.v & 0xFF;
             if (eventType == QUEUE_MESSAGE_PUSH_EVENT) {
@@ -748,7 +870,7 @@ void endServer() {
     osMessagePut(g_ethernetMessageQueueId, QUEUE_MESSAGE_DESTROY_TCP_SERVER, osWaitForever);
 }
 
-void getInputBuffer(int bufferPosition, char **buffer, uint32_t *length) {
+void getInputBuffer(int client, char **buffer, uint32_t *length) {
 #if defined(EEZ_PLATFORM_STM32)
 	if (!g_tcpClientConnection) {
 		return;
@@ -786,52 +908,124 @@ fail1:
 	netconn_close(g_tcpClientConnection);
 	netconn_delete(g_tcpClientConnection);
 	g_tcpClientConnection = nullptr;
-	sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
+	sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, CLIENT_INDEX);
 
 	*buffer = nullptr;
 	length = 0;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    *buffer = g_inputBuffer;
-    *length = g_inputBufferLength;
+    Client &clientData = g_clients[client];
+
+    // new ETHERNET_INPUT_AVAILABLE message will be sent if more data arrives after this point
+    clientData.isInputAvailableMessageSent = false;
+
+    if (clientData.state != CLIENT_STATE_CONNECTED) {
+        clientData.inputViewLength = 0;
+    } else {
+        // view of the contiguous received data, it ends at the end of ring buffer
+        uint32_t tail = clientData.inputTail;
+        uint32_t position = tail % INPUT_BUFFER_SIZE;
+        clientData.inputViewLength = MIN(clientData.inputHead - tail, INPUT_BUFFER_SIZE - position);
+        *buffer = clientData.inputBuffer + position;
+    }
+
+    if (clientData.inputViewLength == 0) {
+        *buffer = nullptr;
+    }
+    *length = clientData.inputViewLength;
 #endif
 }
 
-void releaseInputBuffer() {
+void releaseInputBuffer(int client) {
 #if defined(EEZ_PLATFORM_STM32)
 	netbuf_delete(g_inbuf);
 	g_inbuf = nullptr;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    g_inputBufferLength = 0;
+    Client &clientData = g_clients[client];
+    clientData.inputTail += clientData.inputViewLength;
+    clientData.inputViewLength = 0;
 #endif
 }
 
-int writeBuffer(const char *buffer, uint32_t length) {
+int writeBuffer(int client, const char *buffer, uint32_t length) {
 #if defined(EEZ_PLATFORM_STM32)
 	netconn_write(g_tcpClientConnection, (void *)buffer, (uint16_t)length, NETCONN_COPY);
     return length;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    int numWritten = write(buffer, length);
-    osDelay(1);
+    Client &clientData = g_clients[client];
+
+    uint32_t numWritten = 0;
+    uint32_t lastProgressTime = millis();
+
+    while (numWritten < length) {
+        {
+            // socket mutex is held only while sending, so the ethernet thread
+            // is not blocked while this client doesn't read the output
+            std::lock_guard<std::mutex> lock(clientData.socketMutex);
+
+            if (clientData.state != CLIENT_STATE_CONNECTED) {
+                return numWritten;
+            }
+
+            int n = ::send(clientData.socket, buffer + numWritten, length - numWritten, 0);
+            if (n > 0) {
+                numWritten += n;
+                lastProgressTime = millis();
+                continue;
+            }
+
+            if (!(n < 0 && isWouldBlockError()) || millis() - lastProgressTime >= CONF_WRITE_TIMEOUT_MS) {
+                // ethernet thread will close the socket and notify low priority thread
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+                ::shutdown(clientData.socket, SD_BOTH);
+#else
+                ::shutdown(clientData.socket, SHUT_RDWR);
+#endif
+                return numWritten;
+            }
+        }
+
+        // socket send buffer is full, wait until client reads some data
+        osDelay(1);
+    }
+
     return numWritten;
 #endif
 }
 
-void disconnectClient() {
+void disconnectClient(int client) {
 #if defined(EEZ_PLATFORM_STM32)
-	netconn_close(g_tcpClientConnection);
-	netconn_delete(g_tcpClientConnection);
-	g_tcpClientConnection = nullptr;
+    if (g_tcpClientConnection) {
+        netconn_close(g_tcpClientConnection);
+        netconn_delete(g_tcpClientConnection);
+        g_tcpClientConnection = nullptr;
+    }
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    stop();
-#endif    
+    Client &clientData = g_clients[client];
+
+    std::lock_guard<std::mutex> lock(clientData.socketMutex);
+
+    if (clientData.state == CLIENT_STATE_CONNECTED) {
+        // ethernet thread will close the socket and notify low priority thread
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+        ::shutdown(clientData.socket, SD_BOTH);
+#else
+        ::shutdown(clientData.socket, SHUT_RDWR);
+#endif
+    } else if (clientData.state == CLIENT_STATE_CLOSED) {
+        // client can be reused for the new connection
+        clientData.inputTail = clientData.inputHead.load();
+        clientData.inputViewLength = 0;
+        clientData.state = CLIENT_STATE_FREE;
+    }
+#endif
 }
 
 void pushEvent(int16_t eventId) {
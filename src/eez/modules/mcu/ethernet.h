@@ -26,6 +26,12 @@ namespace eez {
 namespace mcu {
 namespace ethernet {
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const int MAX_NUM_CLIENTS = 4;
+#else
+static const int MAX_NUM_CLIENTS = 1;
+#endif
+
 void initMessageQueue();
 void startThread();
 
@@ -58,16 +64,37 @@ IPAddress dnsServerIP();
 void beginServer(uint16_t port);
 void endServer();
 
-void getInputBuffer(int bufferPosition, char **buffer, uint32_t *length);
-void releaseInputBuffer();
+// Client index is passed as a parameter of ETHERNET_CLIENT_CONNECTED,
+// ETHERNET_CLIENT_DISCONNECTED and ETHERNET_INPUT_AVAILABLE messages.
+// Input buffer is a view into the receive buffer of the client and it is valid
+// until releaseInputBuffer is called.
+void getInputBuffer(int client, char **buffer, uint32_t *length);
+void releaseInputBuffer(int client);
 
-int writeBuffer(const char *buffer, uint32_t length);
-void disconnectClient();
+int writeBuffer(int client, const char *buffer, uint32_t length);
+void disconnectClient(int client);
 
 void pushEvent(int16_t eventId);
 
 void ntpStateTransition(int transition);
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+struct LoadTestResult {
+    bool isFinished;
+    int numClients;
+    int numRequests;
+    int numErrors;
+    uint32_t duration; // in ms
+    float avgLatency[MAX_NUM_CLIENTS]; // in us
+    uint32_t maxLatency[MAX_NUM_CLIENTS]; // in us
+};
+
+// Connects numClients clients to the SCPI server over the loopback interface,
+// each client sends numRequests queries and waits for the response.
+bool startLoadTest(int numClients, int numRequests, const char *command);
+void getLoadTestResult(LoadTestResult &result);
+#endif
+
 }
 }
 } // namespace eez::mcu::ethernet
@@ -25,12 +25,15 @@
 #include <utility>
 #include <string>
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
 #include <SDL_image.h>
+#endif
 
 #include <cmsis_os.h>
 
 #include <eez/modules/mcu/display.h>
+#include <eez/modules/mcu/simulator/pixel_kernels.h>
 
 #include <eez/modules/psu/gui/psu.h>
 #include <eez/debug.h>
@@ -49,13 +52,15 @@ namespace display {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static bool g_isOn;
+
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 static const char *TITLE = "EEZ Modular Firmware Simulator";
 static const char *ICON = "eez.png";
 
-static bool g_isOn;
-
 static SDL_Window *g_mainWindow;
 static SDL_Renderer *g_renderer;
+#endif
 
 static uint32_t *g_buffer;
 static uint32_t *g_lastBuffer;
@@ -65,6 +70,16 @@ static int g_screenshotY;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+
+// headless simulator renders only into VRAM buffers
+bool init() {
+    kernels::init();
+    return true;
+}
+
+#else
+
 // heuristics to find resource file
 std::string getFullPath(std::string category, std::string path) {
     std::string fullPath = category + "/" + path;
@@ -97,6 +112,8 @@ int getDesktopResolution(int *w, int *h) {
 }
 
 bool init() {
+    kernels::init();
+
     // Set texture filtering to linear
     if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1")) {
         printf("Warning: Linear texture filtering not enabled!");
@@ -142,6 +159,8 @@ bool init() {
     return true;
 }
 
+#endif
+
 void *getBufferPointer() {
     return g_buffer;
 }
@@ -200,6 +219,7 @@ void updateScreen(uint32_t *buffer) {
         return;
     }
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     SDL_Surface *rgbSurface = SDL_CreateRGBSurfaceFrom(
         buffer, DISPLAY_WIDTH, DISPLAY_HEIGHT, 32, 4 * DISPLAY_WIDTH, 0, 0, 0, 0);
     if (rgbSurface != NULL) {
@@ -219,6 +239,7 @@ void updateScreen(uint32_t *buffer) {
         printf("Unable to render text surface! SDL Error: %s\n", SDL_GetError());
     }
     SDL_RenderPresent(g_renderer);
+#endif
 }
 
 void animate() {
@@ -243,23 +264,18 @@ void animate() {
 }
 
 void doTakeScreenshot() {
-    uint8_t *src = (uint8_t *)(g_lastBuffer + g_psuAppContext.rect.y * DISPLAY_WIDTH + g_psuAppContext.rect.x);
+    uint8_t *src = (uint8_t *)g_lastBuffer;
     uint8_t *dst = SCREENSHOOT_BUFFER_START_ADDRESS;
 
-    int srcAdvance = (DISPLAY_WIDTH - 480) * 4;
-
-    for (int y = 0; y < 272; y++) {
-        for (int x = 0; x < 480; x++) {
-            uint8_t b = *src++;
-            uint8_t g = *src++;
-            uint8_t r = *src++;
-            src++;
+    for (uint32_t i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        uint8_t b = *src++;
+        uint8_t g = *src++;
+        uint8_t r = *src++;
+        src++;
 
-            *dst++ = r;
-            *dst++ = g;
-            *dst++ = b;
-        }
-        src += srcAdvance;
+        *dst++ = r;
+        *dst++ = g;
+        *dst++ = b;
     }
 
     g_takeScreenshot = false;
@@ -267,6 +283,8 @@ void doTakeScreenshot() {
 }
 
 void sync() {
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    // headless simulator is running at full speed
     static uint32_t g_lastTickCount;
     uint32_t tickCount = millis();
     int32_t diff = 1000 / 60 - (tickCount - g_lastTickCount);
@@ -274,14 +292,17 @@ void sync() {
     if (diff > 0 && diff < 1000 / 60) {
         SDL_Delay(diff);
     }
+#endif
 
     if (!isOn()) {
         return;
     }
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     if (g_mainWindow == nullptr) {
         init();
     }
+#endif
 
     if (g_animationState.enabled) {
         animate();
@@ -354,23 +375,13 @@ const uint8_t *takeScreenshot() {
 ////////////////////////////////////////////////////////////////////////////////
 
 static void doDrawGlyph(const gui::font::Glyph &glyph, int x_glyph, int y_glyph, int width, int height, int offset, int iStartByte) {
-    uint32_t pixel;
-    ((uint8_t *)&pixel)[0] = COLOR_TO_B(g_fc);
-    ((uint8_t *)&pixel)[1] = COLOR_TO_G(g_fc);
-    ((uint8_t *)&pixel)[2] = COLOR_TO_R(g_fc);
-    uint8_t *pixelAlpha = ((uint8_t *)&pixel) + 3;
+    uint32_t color = color16to32(g_fc, 0);
 
     const uint8_t *src = glyph.data + offset + iStartByte;
-    int nlSrc = glyph.width - width;
-
     uint32_t *dst = g_buffer + y_glyph * DISPLAY_WIDTH + x_glyph;
-    int nlDst = DISPLAY_WIDTH - width;
 
-    for (const uint8_t *srcEnd = src + height * glyph.width; src != srcEnd; src += nlSrc, dst += nlDst) {
-        for (uint32_t *dstEnd = dst + width; dst != dstEnd; src++, dst++) {
-            *pixelAlpha = *src;
-            *dst = blendColor(pixel, *dst);
-        }
+    for (const uint8_t *srcEnd = src + height * glyph.width; src != srcEnd; src += glyph.width, dst += DISPLAY_WIDTH) {
+        kernels::g_kernels->blendMask(dst, src, width, color);
     }
 }
 
@@ -463,19 +474,9 @@ void fillRect(int x1, int y1, int x2, int y2, int r) {
         uint32_t *dst = g_buffer + y1 * DISPLAY_WIDTH + x1;
         int width = x2 - x1 + 1;
         int height = y2 - y1 + 1;
-        int nl = DISPLAY_WIDTH - width;
-        if (g_opacity == 255) {
-            for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += nl) {
-                for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++) {
-                    *dst = color32;
-                }
-            }
-        } else {
-            for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += nl) {
-                for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++) {
-                    *dst = blendColor(color32, *dst);
-                }
-            }
+        auto fill = g_opacity == 255 ? kernels::g_kernels->fill : kernels::g_kernels->fillBlend;
+        for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += DISPLAY_WIDTH) {
+            fill(dst, width, color32);
         }
     } else {
         // draw rounded rect
@@ -499,12 +500,9 @@ void fillRect(int x1, int y1, int x2, int y2, int r) {
 void fillRect(void *dstBuffer, int x1, int y1, int x2, int y2) {
     uint32_t color32 = color16to32(g_fc);
     uint32_t *dst = (uint32_t *)dstBuffer + y1 * DISPLAY_WIDTH + x1;
-    int nl = DISPLAY_WIDTH - (x2 - x1 + 1);
-    for (int y = y1; y <= y2; y++) {
-        for (int x = x1; x <= x2; x++) {
-            *dst++ = color32;
-        }
-        dst += nl;
+    int width = x2 - x1 + 1;
+    for (int y = y1; y <= y2; y++, dst += DISPLAY_WIDTH) {
+        kernels::g_kernels->fill(dst, width, color32);
     }
 
     markDirty(x1, y1, x2, y2);
@@ -513,10 +511,8 @@ void fillRect(void *dstBuffer, int x1, int y1, int x2, int y2) {
 void drawHLine(int x, int y, int l) {
     uint32_t color32 = color16to32(g_fc);
 
-    uint32_t *dst = g_buffer + y * DISPLAY_WIDTH + x;
-    uint32_t *dstEnd = dst + l + 1;
-    while (dst < dstEnd) {
-        *dst++ = color32;
+    if (l >= 0) {
+        kernels::g_kernels->fill(g_buffer + y * DISPLAY_WIDTH + x, l + 1, color32);
     }
 
     markDirty(x, y, x + l, y);
@@ -542,13 +538,9 @@ void bitBlt(int x1, int y1, int x2, int y2, int dstx, int dsty) {
 
     uint32_t *src = g_buffer + y1 * DISPLAY_WIDTH + x1;
     uint32_t *dst = g_buffer + dsty * DISPLAY_WIDTH + dstx;
-    int nl = DISPLAY_WIDTH - width;
 
-    for (int y = y1; y <= y2; y++, src += nl, dst += nl) {
-        for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++, src++) {
-            uint8_t *src8 = (uint8_t *)src;
-            *dst = color16to32(RGB_TO_COLOR(src8[2], src8[1], src8[0]));
-        }
+    for (int y = 0; y < height; y++, src += DISPLAY_WIDTH, dst += DISPLAY_WIDTH) {
+        kernels::g_kernels->copyRgb565(dst, src, width);
     }
 
     markDirty(dstx, dsty, dstx + x2 - x1, dsty + y2 - y1);
@@ -560,10 +552,11 @@ void bitBlt(void *src, int x1, int y1, int x2, int y2) {
 }
 
 void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2) {
-    for (int y = y1; y <= y2; ++y) {
-        for (int x = x1; x <= x2; ++x) {
-            int i = y * DISPLAY_WIDTH + x;
-            ((uint32_t *)dst)[i] = ((uint32_t *)src)[i];
+    int width = x2 - x1 + 1;
+    if (width > 0) {
+        for (int y = y1; y <= y2; ++y) {
+            int i = y * DISPLAY_WIDTH + x1;
+            memcpy((uint32_t *)dst + i, (uint32_t *)src + i, width * sizeof(uint32_t));
         }
     }
 
@@ -575,43 +568,56 @@ void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy
         dst = g_buffer;
     }
 
+    if (sw <= 0) {
+        return;
+    }
+
+    uint32_t *srcLine = (uint32_t *)src + sy * DISPLAY_WIDTH + sx;
+    uint32_t *dstLine = (uint32_t *)dst + dy * DISPLAY_WIDTH + dx;
+
     if (opacity == 255) {
-        for (int y = 0; y < sh; ++y) {
-            for (int x = 0; x < sw; ++x) {
-                ((uint32_t *)dst)[(dy + y) * DISPLAY_WIDTH + dx + x] = ((uint32_t *)src)[(sy + y) * DISPLAY_WIDTH + sx + x];
-            }
+        for (int y = 0; y < sh; ++y, srcLine += DISPLAY_WIDTH, dstLine += DISPLAY_WIDTH) {
+            memmove(dstLine, srcLine, sw * sizeof(uint32_t));
         }
     } else {
-        for (int y = 0; y < sh; ++y) {
-            for (int x = 0; x < sw; ++x) {
-                uint8_t *p = (uint8_t *)&((uint32_t *)src)[(sy + y) * DISPLAY_WIDTH + sx + x];
-                p[3] = opacity;
-                ((uint32_t *)dst)[(dy + y) * DISPLAY_WIDTH + dx + x] = blendColor(
-                    ((uint32_t *)src)[(sy + y) * DISPLAY_WIDTH + sx + x],
-                    ((uint32_t *)dst)[(dy + y) * DISPLAY_WIDTH + dx + x]
-                );
-            }
+        for (int y = 0; y < sh; ++y, srcLine += DISPLAY_WIDTH, dstLine += DISPLAY_WIDTH) {
+            kernels::g_kernels->blendOpacity(dstLine, srcLine, sw, opacity);
         }
     }
 }
 
+uint32_t getPixelsSize(int width, int height) {
+    return width * height * sizeof(uint32_t);
+}
+
+void readPixels(int x, int y, int width, int height, void *pixels) {
+    uint32_t *src = g_buffer + y * DISPLAY_WIDTH + x;
+    uint32_t *dst = (uint32_t *)pixels;
+    for (int i = 0; i < height; ++i, src += DISPLAY_WIDTH, dst += width) {
+        memcpy(dst, src, width * sizeof(uint32_t));
+    }
+}
+
+void writePixels(const void *pixels, int x, int y, int width, int height) {
+    const uint32_t *src = (const uint32_t *)pixels;
+    uint32_t *dst = g_buffer + y * DISPLAY_WIDTH + x;
+    for (int i = 0; i < height; ++i, src += width, dst += DISPLAY_WIDTH) {
+        memcpy(dst, src, width * sizeof(uint32_t));
+    }
+
+    markDirty(x, y, x + width - 1, y + height - 1);
+}
+
 void drawBitmap(Image *image, int x, int y) {
     uint32_t *dst = g_buffer + y * DISPLAY_WIDTH + x;
     int nlDst = DISPLAY_WIDTH - image->width;
 
     if (image->bpp == 32) {
         uint32_t *src = (uint32_t *)image->pixels;
-        int nlSrc = image->lineOffset;
+        int srcStride = image->width + image->lineOffset;
 
-        uint32_t pixel;
-        uint8_t *pixelAlpha = ((uint8_t *)&pixel) + 3;
-
-        for (uint32_t *srcEnd = src + (image->width + nlSrc) * image->height; src != srcEnd; src += nlSrc, dst += nlDst) {
-            for (uint32_t *lineEnd = dst + image->width; dst != lineEnd; src++, dst++) {
-                pixel = *src;
-                *pixelAlpha = *pixelAlpha * g_opacity / 255;
-                *dst = blendColor(pixel, *dst);
-            }
+        for (uint32_t *srcEnd = src + srcStride * image->height; src != srcEnd; src += srcStride, dst += DISPLAY_WIDTH) {
+            kernels::g_kernels->blendScaledAlpha(dst, src, image->width, g_opacity);
         }
     } else if (image->bpp == 24) {
         uint8_t *src = (uint8_t *)image->pixels;
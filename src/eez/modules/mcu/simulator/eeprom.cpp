@@ -0,0 +1,291 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory.h>
+
+#ifdef _WIN32
+#undef INPUT
+#undef OUTPUT
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <eez/system.h>
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/mcu/eeprom.h>
+
+namespace eez {
+namespace mcu {
+namespace eeprom {
+
+// EEPROM.state is mapped with the shared mapping, so every write is in the file as soon as
+// it is copied to the mapped memory, even if the simulator crashes before the flush.
+// Flush writes the changed pages from the OS cache to the disk.
+
+static const uint32_t FLUSH_DELAY_MS = 100;
+static const uint32_t FLUSH_MAX_DELAY_MS = 1000;
+
+// same as MAX_WRITE_CHUNK_SIZE of the STM32 implementation
+static const uint16_t WRITE_CHUNK_SIZE = 16;
+
+static uint8_t *g_memory;
+
+#ifdef _WIN32
+static HANDLE g_fileHandle = INVALID_HANDLE_VALUE;
+#endif
+
+static uint8_t g_dirtyPages[EEPROM_NUM_PAGES / 8];
+static bool g_isDirty;
+static uint32_t g_firstDirtyTime;
+static uint32_t g_lastWriteTime;
+
+static Statistics g_statistics;
+static uint32_t g_pageWrites[EEPROM_NUM_PAGES];
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void markDirty(uint32_t address, uint32_t size) {
+    if (!g_isDirty) {
+        g_isDirty = true;
+        g_firstDirtyTime = millis();
+    }
+    g_lastWriteTime = millis();
+
+    for (uint32_t page = address / EEPROM_PAGE_SIZE; page <= (address + size - 1) / EEPROM_PAGE_SIZE; page++) {
+        g_dirtyPages[page / 8] |= 1 << (page % 8);
+    }
+}
+
+static bool isPageDirty(uint32_t page) {
+    return (g_dirtyPages[page / 8] & (1 << (page % 8))) != 0;
+}
+
+static void flushRange(uint32_t address, uint32_t size) {
+#ifdef _WIN32
+    FlushViewOfFile(g_memory + address, size);
+#else
+    // msync requires address aligned to the OS page
+    uint32_t alignment = (uint32_t)sysconf(_SC_PAGESIZE);
+    uint32_t alignedAddress = address / alignment * alignment;
+    msync(g_memory + alignedAddress, address + size - alignedAddress, MS_SYNC);
+#endif
+}
+
+static bool open() {
+    if (g_memory) {
+        return true;
+    }
+
+    const char *filePath = getConfFilePath("EEPROM.state");
+
+    uint32_t fileSize;
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    fileSize = size.QuadPart < EEPROM_SIZE ? (uint32_t)size.QuadPart : EEPROM_SIZE;
+
+    // mapping extends the file to the EEPROM size
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE, 0, EEPROM_SIZE, NULL);
+    if (!mappingHandle) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    void *memory = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, EEPROM_SIZE);
+    if (!memory) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    // mapped view keeps the mapping open
+    CloseHandle(mappingHandle);
+
+    g_fileHandle = fileHandle;
+#else
+    int fd = ::open(filePath, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    fileSize = st.st_size < EEPROM_SIZE ? (uint32_t)st.st_size : EEPROM_SIZE;
+
+    if (fileSize < EEPROM_SIZE && ftruncate(fd, EEPROM_SIZE) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *memory = mmap(NULL, EEPROM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    // mapping stays valid after the file is closed
+    ::close(fd);
+#endif
+
+    g_memory = (uint8_t *)memory;
+
+    if (fileSize < EEPROM_SIZE) {
+        // file was created or extended, not written EEPROM bytes are 0xFF
+        memset(g_memory + fileSize, 0xFF, EEPROM_SIZE - fileSize);
+        markDirty(fileSize, EEPROM_SIZE - fileSize);
+        flush();
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool read(uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
+    if (!open() || address + bufferSize > EEPROM_SIZE) {
+        return false;
+    }
+
+    memcpy(buffer, g_memory + address, bufferSize);
+
+    g_statistics.numReads++;
+
+    return true;
+}
+
+bool write(const uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
+    if (!open() || address + bufferSize > EEPROM_SIZE) {
+        return false;
+    }
+
+    uint32_t startTime = micros();
+
+    // count page write cycles as they are done by the real EEPROM
+    for (uint32_t i = 0; i < bufferSize; i += WRITE_CHUNK_SIZE) {
+        uint32_t chunkAddress = address + i;
+        uint32_t chunkSize = MIN(WRITE_CHUNK_SIZE, bufferSize - i);
+        for (uint32_t page = chunkAddress / EEPROM_PAGE_SIZE; page <= (chunkAddress + chunkSize - 1) / EEPROM_PAGE_SIZE; page++) {
+            g_pageWrites[page]++;
+            g_statistics.numPageWrites++;
+            if (g_pageWrites[page] > g_statistics.maxPageWrites) {
+                g_statistics.maxPageWrites = g_pageWrites[page];
+            }
+        }
+    }
+
+    // only the pages with changed content are flushed
+    uint32_t numBytesChanged = 0;
+    uint32_t firstChanged = 0;
+    uint32_t lastChanged = 0;
+    for (uint32_t i = 0; i < bufferSize; i++) {
+        if (g_memory[address + i] != buffer[i]) {
+            g_memory[address + i] = buffer[i];
+            if (numBytesChanged++ == 0) {
+                firstChanged = i;
+            }
+            lastChanged = i;
+        }
+    }
+
+    if (numBytesChanged > 0) {
+        markDirty(address + firstChanged, lastChanged - firstChanged + 1);
+    }
+
+    g_statistics.numWrites++;
+    g_statistics.numBytesWritten += bufferSize;
+    g_statistics.numBytesChanged += numBytesChanged;
+    g_statistics.writeTime += micros() - startTime;
+
+    return true;
+}
+
+void tick() {
+    if (g_isDirty) {
+        uint32_t time = millis();
+        if (time - g_lastWriteTime >= FLUSH_DELAY_MS || time - g_firstDirtyTime >= FLUSH_MAX_DELAY_MS) {
+            flush();
+        }
+    }
+}
+
+void flush() {
+    if (!g_isDirty) {
+        return;
+    }
+
+    g_isDirty = false;
+
+    // consecutive dirty pages are flushed together
+    uint32_t page = 0;
+    while (page < EEPROM_NUM_PAGES) {
+        if (!isPageDirty(page)) {
+            page++;
+            continue;
+        }
+
+        uint32_t firstPage = page;
+        while (page < EEPROM_NUM_PAGES && isPageDirty(page)) {
+            g_dirtyPages[page / 8] &= ~(1 << (page % 8));
+            page++;
+        }
+
+        uint32_t address = firstPage * EEPROM_PAGE_SIZE;
+        uint32_t size = (page - firstPage) * EEPROM_PAGE_SIZE;
+        flushRange(address, size);
+        g_statistics.numFlushedBytes += size;
+    }
+
+#ifdef _WIN32
+    FlushFileBuffers(g_fileHandle);
+#endif
+
+    g_statistics.numFlushes++;
+}
+
+void getStatistics(Statistics &statistics) {
+    memcpy(&statistics, &g_statistics, sizeof(Statistics));
+}
+
+const uint32_t *getPageWrites() {
+    return g_pageWrites;
+}
+
+void resetStatistics() {
+    memset(&g_statistics, 0, sizeof(Statistics));
+    memset(g_pageWrites, 0, sizeof(g_pageWrites));
+}
+
+} // namespace eeprom
+} // namespace mcu
+} // namespace eez
@@ -0,0 +1,640 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include <eez/modules/mcu/display.h>
+#include <eez/modules/mcu/simulator/pixel_kernels.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(PIXEL_KERNELS_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define PIXEL_KERNELS_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace eez {
+namespace mcu {
+namespace display {
+namespace kernels {
+
+////////////////////////////////////////////////////////////////////////////////
+// scalar, reference implementation
+
+static void fillScalar(uint32_t *dst, int count, uint32_t color) {
+    for (uint32_t *dstEnd = dst + count; dst != dstEnd; dst++) {
+        *dst = color;
+    }
+}
+
+static void fillBlendScalar(uint32_t *dst, int count, uint32_t color) {
+    for (uint32_t *dstEnd = dst + count; dst != dstEnd; dst++) {
+        *dst = blendColor(color, *dst);
+    }
+}
+
+static void blendMaskScalar(uint32_t *dst, const uint8_t *mask, int count, uint32_t color) {
+    uint32_t pixel = color;
+    uint8_t *pixelAlpha = ((uint8_t *)&pixel) + 3;
+
+    for (uint32_t *dstEnd = dst + count; dst != dstEnd; dst++, mask++) {
+        *pixelAlpha = *mask;
+        *dst = blendColor(pixel, *dst);
+    }
+}
+
+static void blendOpacityScalar(uint32_t *dst, uint32_t *src, int count, uint8_t opacity) {
+    for (uint32_t *dstEnd = dst + count; dst != dstEnd; dst++, src++) {
+        ((uint8_t *)src)[3] = opacity;
+        *dst = blendColor(*src, *dst);
+    }
+}
+
+static void blendScaledAlphaScalar(uint32_t *dst, const uint32_t *src, int count, uint8_t opacity) {
+    uint32_t pixel;
+    uint8_t *pixelAlpha = ((uint8_t *)&pixel) + 3;
+
+    for (uint32_t *dstEnd = dst + count; dst != dstEnd; dst++, src++) {
+        pixel = *src;
+        *pixelAlpha = *pixelAlpha * opacity / 255;
+        *dst = blendColor(pixel, *dst);
+    }
+}
+
+static void copyRgb565Scalar(uint32_t *dst, const uint32_t *src, int count) {
+    for (uint32_t *dstEnd = dst + count; dst != dstEnd; dst++, src++) {
+        const uint8_t *src8 = (const uint8_t *)src;
+        *dst = color16to32(RGB_TO_COLOR(src8[2], src8[1], src8[0]));
+    }
+}
+
+static const PixelKernels g_scalarKernels = {
+    "scalar",
+    fillScalar,
+    fillBlendScalar,
+    blendMaskScalar,
+    blendOpacityScalar,
+    blendScaledAlphaScalar,
+    copyRgb565Scalar
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// SSE2, 4 pixels at once
+//
+// Blending follows blendColor operation by operation in single precision floats,
+// so the result is bit exact. Channel and alpha values are less then 256,
+// so 16-bit multiply is enough for the integer products.
+
+#if defined(PIXEL_KERNELS_SSE2)
+
+static inline __m128i blendChannelSse2(__m128i fgC, __m128i bgC, __m128i fgA, __m128i bgA, __m128 alphaMult, __m128 alphaOut) {
+    __m128i t = _mm_add_epi32(_mm_mullo_epi16(fgC, fgA), _mm_mullo_epi16(bgC, bgA));
+    __m128 c = _mm_div_ps(_mm_sub_ps(_mm_cvtepi32_ps(t), _mm_mul_ps(_mm_cvtepi32_ps(bgC), alphaMult)), alphaOut);
+    // max returns 0 for NaN (0 / 0), the same as float to uint8_t conversion in blendColor
+    c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    return _mm_cvttps_epi32(c);
+}
+
+static inline __m128i blendSse2(__m128i fg, __m128i bg) {
+    const __m128i mask = _mm_set1_epi32(0xFF);
+
+    __m128i fgA = _mm_srli_epi32(fg, 24);
+    __m128i bgA = _mm_srli_epi32(bg, 24);
+
+    __m128 alphaMult = _mm_div_ps(_mm_cvtepi32_ps(_mm_mullo_epi16(fgA, bgA)), _mm_set1_ps(255.0f));
+    __m128 alphaOut = _mm_sub_ps(_mm_cvtepi32_ps(_mm_add_epi32(fgA, bgA)), alphaMult);
+
+    __m128i b = blendChannelSse2(_mm_and_si128(fg, mask), _mm_and_si128(bg, mask), fgA, bgA, alphaMult, alphaOut);
+    __m128i g = blendChannelSse2(_mm_and_si128(_mm_srli_epi32(fg, 8), mask), _mm_and_si128(_mm_srli_epi32(bg, 8), mask), fgA, bgA, alphaMult, alphaOut);
+    __m128i r = blendChannelSse2(_mm_and_si128(_mm_srli_epi32(fg, 16), mask), _mm_and_si128(_mm_srli_epi32(bg, 16), mask), fgA, bgA, alphaMult, alphaOut);
+    __m128i a = _mm_cvttps_epi32(alphaOut);
+
+    return _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(a, 24)));
+}
+
+static void fillSse2(uint32_t *dst, int count, uint32_t color) {
+    __m128i c = _mm_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i *)(dst + i), c);
+    }
+    fillScalar(dst + i, count - i, color);
+}
+
+static void fillBlendSse2(uint32_t *dst, int count, uint32_t color) {
+    __m128i c = _mm_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), blendSse2(c, d));
+    }
+    fillBlendScalar(dst + i, count - i, color);
+}
+
+static void blendMaskSse2(uint32_t *dst, const uint8_t *mask, int count, uint32_t color) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i rgb = _mm_set1_epi32((int)(color & 0x00FFFFFF));
+    __m128i opaque = _mm_set1_epi32((int)(color | 0xFF000000));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t m;
+        memcpy(&m, mask + i, 4);
+
+        // full coverage gives exactly the glyph color
+        if (m == 0xFFFFFFFF) {
+            _mm_storeu_si128((__m128i *)(dst + i), opaque);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+        // no coverage leaves the pixel as it is, unless it is fully transparent
+        if (m == 0 && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(d, 24), zero)) == 0) {
+            continue;
+        }
+
+        __m128i a = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)m), zero), zero);
+        _mm_storeu_si128((__m128i *)(dst + i), blendSse2(_mm_or_si128(rgb, _mm_slli_epi32(a, 24)), d));
+    }
+    blendMaskScalar(dst + i, mask + i, count - i, color);
+}
+
+static void blendOpacitySse2(uint32_t *dst, uint32_t *src, int count, uint8_t opacity) {
+    __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    __m128i alpha = _mm_set1_epi32((int)((uint32_t)opacity << 24));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_or_si128(_mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), rgbMask), alpha);
+        _mm_storeu_si128((__m128i *)(src + i), s);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), blendSse2(s, d));
+    }
+    blendOpacityScalar(dst + i, src + i, count - i, opacity);
+}
+
+static void blendScaledAlphaSse2(uint32_t *dst, const uint32_t *src, int count, uint8_t opacity) {
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    __m128i op = _mm_set1_epi32(opacity);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        // a * opacity / 255, exact for the products up to 255 * 255
+        __m128i a = _mm_mullo_epi16(_mm_srli_epi32(s, 24), op);
+        a = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(a, one), _mm_srli_epi32(a, 8)), 8);
+        s = _mm_or_si128(_mm_and_si128(s, rgbMask), _mm_slli_epi32(a, 24));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), blendSse2(s, d));
+    }
+    blendScaledAlphaScalar(dst + i, src + i, count - i, opacity);
+}
+
+static void copyRgb565Sse2(uint32_t *dst, const uint32_t *src, int count) {
+    if (dst > src && dst < src + count) {
+        // overlapping copy forward must propagate already written pixels
+        copyRgb565Scalar(dst, src, count);
+        return;
+    }
+
+    __m128i rgbMask = _mm_set1_epi32(0x00F8FCF8);
+    __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(s, rgbMask), alpha));
+    }
+    copyRgb565Scalar(dst + i, src + i, count - i);
+}
+
+static const PixelKernels g_sse2Kernels = {
+    "sse2",
+    fillSse2,
+    fillBlendSse2,
+    blendMaskSse2,
+    blendOpacitySse2,
+    blendScaledAlphaSse2,
+    copyRgb565Sse2
+};
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX2, 8 pixels at once, the same algorithm as SSE2
+
+#if defined(PIXEL_KERNELS_AVX2)
+
+static inline AVX2_FUNCTION __m256i blendChannelAvx2(__m256i fgC, __m256i bgC, __m256i fgA, __m256i bgA, __m256 alphaMult, __m256 alphaOut) {
+    __m256i t = _mm256_add_epi32(_mm256_mullo_epi16(fgC, fgA), _mm256_mullo_epi16(bgC, bgA));
+    __m256 c = _mm256_div_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(t), _mm256_mul_ps(_mm256_cvtepi32_ps(bgC), alphaMult)), alphaOut);
+    c = _mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    return _mm256_cvttps_epi32(c);
+}
+
+static inline AVX2_FUNCTION __m256i blendAvx2(__m256i fg, __m256i bg) {
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+
+    __m256i fgA = _mm256_srli_epi32(fg, 24);
+    __m256i bgA = _mm256_srli_epi32(bg, 24);
+
+    __m256 alphaMult = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_mullo_epi16(fgA, bgA)), _mm256_set1_ps(255.0f));
+    __m256 alphaOut = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(fgA, bgA)), alphaMult);
+
+    __m256i b = blendChannelAvx2(_mm256_and_si256(fg, mask), _mm256_and_si256(bg, mask), fgA, bgA, alphaMult, alphaOut);
+    __m256i g = blendChannelAvx2(_mm256_and_si256(_mm256_srli_epi32(fg, 8), mask), _mm256_and_si256(_mm256_srli_epi32(bg, 8), mask), fgA, bgA, alphaMult, alphaOut);
+    __m256i r = blendChannelAvx2(_mm256_and_si256(_mm256_srli_epi32(fg, 16), mask), _mm256_and_si256(_mm256_srli_epi32(bg, 16), mask), fgA, bgA, alphaMult, alphaOut);
+    __m256i a = _mm256_cvttps_epi32(alphaOut);
+
+    return _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), _mm256_slli_epi32(a, 24)));
+}
+
+static AVX2_FUNCTION void fillAvx2(uint32_t *dst, int count, uint32_t color) {
+    __m256i c = _mm256_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i *)(dst + i), c);
+    }
+    fillScalar(dst + i, count - i, color);
+}
+
+static AVX2_FUNCTION void fillBlendAvx2(uint32_t *dst, int count, uint32_t color) {
+    __m256i c = _mm256_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), blendAvx2(c, d));
+    }
+    fillBlendScalar(dst + i, count - i, color);
+}
+
+static AVX2_FUNCTION void blendMaskAvx2(uint32_t *dst, const uint8_t *mask, int count, uint32_t color) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i rgb = _mm256_set1_epi32((int)(color & 0x00FFFFFF));
+    __m256i opaque = _mm256_set1_epi32((int)(color | 0xFF000000));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t m;
+        memcpy(&m, mask + i, 8);
+
+        if (m == 0xFFFFFFFFFFFFFFFFULL) {
+            _mm256_storeu_si256((__m256i *)(dst + i), opaque);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+
+        if (m == 0 && _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_srli_epi32(d, 24), zero)) == 0) {
+            continue;
+        }
+
+        __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(mask + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), blendAvx2(_mm256_or_si256(rgb, _mm256_slli_epi32(a, 24)), d));
+    }
+    blendMaskScalar(dst + i, mask + i, count - i, color);
+}
+
+static AVX2_FUNCTION void blendOpacityAvx2(uint32_t *dst, uint32_t *src, int count, uint8_t opacity) {
+    __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    __m256i alpha = _mm256_set1_epi32((int)((uint32_t)opacity << 24));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_or_si256(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i)), rgbMask), alpha);
+        _mm256_storeu_si256((__m256i *)(src + i), s);
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), blendAvx2(s, d));
+    }
+    blendOpacityScalar(dst + i, src + i, count - i, opacity);
+}
+
+static AVX2_FUNCTION void blendScaledAlphaAvx2(uint32_t *dst, const uint32_t *src, int count, uint8_t opacity) {
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    __m256i op = _mm256_set1_epi32(opacity);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i a = _mm256_mullo_epi16(_mm256_srli_epi32(s, 24), op);
+        a = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(a, one), _mm256_srli_epi32(a, 8)), 8);
+        s = _mm256_or_si256(_mm256_and_si256(s, rgbMask), _mm256_slli_epi32(a, 24));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), blendAvx2(s, d));
+    }
+    blendScaledAlphaScalar(dst + i, src + i, count - i, opacity);
+}
+
+static AVX2_FUNCTION void copyRgb565Avx2(uint32_t *dst, const uint32_t *src, int count) {
+    if (dst > src && dst < src + count) {
+        copyRgb565Scalar(dst, src, count);
+        return;
+    }
+
+    __m256i rgbMask = _mm256_set1_epi32(0x00F8FCF8);
+    __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(_mm256_and_si256(s, rgbMask), alpha));
+    }
+    copyRgb565Scalar(dst + i, src + i, count - i);
+}
+
+static const PixelKernels g_avx2Kernels = {
+    "avx2",
+    fillAvx2,
+    fillBlendAvx2,
+    blendMaskAvx2,
+    blendOpacityAvx2,
+    blendScaledAlphaAvx2,
+    copyRgb565Avx2
+};
+
+static bool isAvx2Supported() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // OS saves YMM registers
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+const PixelKernels *g_kernels = &g_scalarKernels;
+
+static const PixelKernels *g_kernelSets[3];
+static int g_numKernelSets;
+
+void init() {
+    g_numKernelSets = 0;
+    g_kernelSets[g_numKernelSets++] = &g_scalarKernels;
+#if defined(PIXEL_KERNELS_SSE2)
+    g_kernelSets[g_numKernelSets++] = &g_sse2Kernels;
+#endif
+#if defined(PIXEL_KERNELS_AVX2)
+    if (isAvx2Supported()) {
+        g_kernelSets[g_numKernelSets++] = &g_avx2Kernels;
+    }
+#endif
+
+    g_kernels = g_kernelSets[g_numKernelSets - 1];
+
+    const char *name = getenv("EEZ_PIXEL_KERNELS");
+    if (name) {
+        const PixelKernels *kernels = getKernelSet(name);
+        if (kernels) {
+            g_kernels = kernels;
+        }
+    }
+}
+
+int getNumKernelSets() {
+    return g_numKernelSets;
+}
+
+const PixelKernels *getKernelSet(int index) {
+    return index >= 0 && index < g_numKernelSets ? g_kernelSets[index] : nullptr;
+}
+
+const PixelKernels *getKernelSet(const char *name) {
+    for (int i = 0; i < g_numKernelSets; i++) {
+        if (strcmp(g_kernelSets[i]->name, name) == 0) {
+            return g_kernelSets[i];
+        }
+    }
+    return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const int TEST_BUFFER_SIZE = 1024;
+static const int TEST_MAX_COUNT = 300;
+static const int NUM_VERIFY_ITERATIONS = 2000;
+
+static uint32_t g_randomState;
+
+static uint32_t nextRandom() {
+    // xorshift32
+    g_randomState ^= g_randomState << 13;
+    g_randomState ^= g_randomState >> 17;
+    g_randomState ^= g_randomState << 5;
+    return g_randomState;
+}
+
+// 0 and 255 are the most common values of the alpha channel and the glyph mask
+static uint8_t randomAlpha() {
+    uint32_t r = nextRandom();
+    switch (r % 4) {
+    case 0:
+        return 0;
+    case 1:
+        return 255;
+    default:
+        return (uint8_t)(r >> 8);
+    }
+}
+
+static uint32_t randomPixel() {
+    return (nextRandom() & 0x00FFFFFF) | ((uint32_t)randomAlpha() << 24);
+}
+
+static void randomPixels(uint32_t *buffer, int count) {
+    // runs of the same alpha, like in the real images
+    uint8_t alpha = randomAlpha();
+    for (int i = 0; i < count; i++) {
+        if (nextRandom() % 8 == 0) {
+            alpha = randomAlpha();
+        }
+        buffer[i] = (nextRandom() & 0x00FFFFFF) | ((uint32_t)alpha << 24);
+    }
+}
+
+static void randomMask(uint8_t *buffer, int count) {
+    uint8_t value = randomAlpha();
+    for (int i = 0; i < count; i++) {
+        if (nextRandom() % 8 == 0) {
+            value = randomAlpha();
+        }
+        buffer[i] = value;
+    }
+}
+
+static uint32_t compare(const uint32_t *a, const uint32_t *b, int count) {
+    uint32_t numDifferences = 0;
+    for (int i = 0; i < count; i++) {
+        if (a[i] != b[i]) {
+            numDifferences++;
+        }
+    }
+    return numDifferences;
+}
+
+// [0] is the original data, [1] is processed by the scalar kernels and [2] by the tested kernels
+static uint32_t g_srcBuffer[3][TEST_BUFFER_SIZE];
+static uint32_t g_dstBuffer[3][TEST_BUFFER_SIZE];
+static uint8_t g_maskBuffer[TEST_BUFFER_SIZE];
+
+uint32_t verify(const PixelKernels &kernels) {
+    const PixelKernels *sets[2] = { &g_scalarKernels, &kernels };
+
+    uint32_t numDifferences = 0;
+
+    g_randomState = 0x12345678;
+
+    for (int iteration = 0; iteration < NUM_VERIFY_ITERATIONS; iteration++) {
+        int count = nextRandom() % TEST_MAX_COUNT;
+        int srcOffset = nextRandom() % 8;
+        int dstOffset = nextRandom() % 8;
+        uint32_t color = randomPixel();
+        uint8_t opacity = randomAlpha();
+
+        randomPixels(g_srcBuffer[0], TEST_BUFFER_SIZE);
+        randomPixels(g_dstBuffer[0], TEST_BUFFER_SIZE);
+        randomMask(g_maskBuffer, TEST_BUFFER_SIZE);
+
+        for (int kernel = 0; kernel < 7; kernel++) {
+            for (int set = 0; set < 2; set++) {
+                const PixelKernels &k = *sets[set];
+
+                memcpy(g_srcBuffer[1 + set], g_srcBuffer[0], sizeof(g_srcBuffer[0]));
+                memcpy(g_dstBuffer[1 + set], g_dstBuffer[0], sizeof(g_dstBuffer[0]));
+
+                uint32_t *src = g_srcBuffer[1 + set] + srcOffset;
+                uint32_t *dst = g_dstBuffer[1 + set] + dstOffset;
+
+                switch (kernel) {
+                case 0:
+                    k.fill(dst, count, color);
+                    break;
+                case 1:
+                    k.fillBlend(dst, count, color);
+                    break;
+                case 2:
+                    k.blendMask(dst, g_maskBuffer + srcOffset, count, color);
+                    break;
+                case 3:
+                    k.blendOpacity(dst, src, count, opacity);
+                    break;
+                case 4:
+                    k.blendScaledAlpha(dst, src, count, opacity);
+                    break;
+                case 5:
+                    k.copyRgb565(dst, src, count);
+                    break;
+                case 6:
+                    // overlapping copy, like bitBlt inside the same buffer
+                    k.copyRgb565(dst, g_dstBuffer[1 + set] + srcOffset, count);
+                    break;
+                }
+            }
+
+            numDifferences += compare(g_srcBuffer[1], g_srcBuffer[2], TEST_BUFFER_SIZE);
+            numDifferences += compare(g_dstBuffer[1], g_dstBuffer[2], TEST_BUFFER_SIZE);
+        }
+    }
+
+    return numDifferences;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const int BENCHMARK_ROW_LENGTH = 1024;
+static const int NUM_BENCHMARK_ROWS = 1000;
+
+static float benchmarkKernel(const PixelKernels &kernels, int kernel) {
+    g_randomState = 0x12345678;
+    randomPixels(g_srcBuffer[0], BENCHMARK_ROW_LENGTH);
+    randomPixels(g_dstBuffer[0], BENCHMARK_ROW_LENGTH);
+    randomMask(g_maskBuffer, BENCHMARK_ROW_LENGTH);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int row = 0; row < NUM_BENCHMARK_ROWS; row++) {
+        // restore destination, so that every row blends the same data
+        memcpy(g_dstBuffer[1], g_dstBuffer[0], BENCHMARK_ROW_LENGTH * sizeof(uint32_t));
+
+        switch (kernel) {
+        case 0:
+            kernels.fill(g_dstBuffer[1], BENCHMARK_ROW_LENGTH, 0xFF204060);
+            break;
+        case 1:
+            kernels.fillBlend(g_dstBuffer[1], BENCHMARK_ROW_LENGTH, 0x80204060);
+            break;
+        case 2:
+            kernels.blendMask(g_dstBuffer[1], g_maskBuffer, BENCHMARK_ROW_LENGTH, 0x00FFFFFF);
+            break;
+        case 3:
+            kernels.blendOpacity(g_dstBuffer[1], g_srcBuffer[0], BENCHMARK_ROW_LENGTH, 128);
+            break;
+        case 4:
+            kernels.blendScaledAlpha(g_dstBuffer[1], g_srcBuffer[0], BENCHMARK_ROW_LENGTH, 200);
+            break;
+        case 5:
+            kernels.copyRgb565(g_dstBuffer[1], g_srcBuffer[0], BENCHMARK_ROW_LENGTH);
+            break;
+        }
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+    return duration > 0 ? 1.0f * BENCHMARK_ROW_LENGTH * NUM_BENCHMARK_ROWS / duration : 0.0f;
+}
+
+void benchmark(const PixelKernels &kernels, BenchmarkResult &result) {
+    result.fill = benchmarkKernel(kernels, 0);
+    result.fillBlend = benchmarkKernel(kernels, 1);
+    result.blendMask = benchmarkKernel(kernels, 2);
+    result.blendOpacity = benchmarkKernel(kernels, 3);
+    result.blendScaledAlpha = benchmarkKernel(kernels, 4);
+    result.copyRgb565 = benchmarkKernel(kernels, 5);
+}
+
+} // namespace kernels
+} // namespace display
+} // namespace mcu
+} // namespace eez
@@ -0,0 +1,97 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Pixel kernels
+
+Row operations used by the simulator display driver on 32-bit BGRA pixels.
+All kernel sets produce exactly the same pixels as the scalar set,
+which calls blendColor for every blended pixel.
+
+Kernel sets, in order of preference:
+
+    avx2      8 pixels per iteration, selected at runtime if CPU supports it
+    sse2      4 pixels per iteration, x86 and x64
+    scalar    reference implementation
+
+New set (e.g. NEON) is added by implementing the PixelKernels functions
+and adding it to the table in pixel_kernels.cpp.
+*/
+
+namespace eez {
+namespace mcu {
+namespace display {
+namespace kernels {
+
+struct PixelKernels {
+    const char *name;
+
+    // dst[i] = color
+    void (*fill)(uint32_t *dst, int count, uint32_t color);
+
+    // dst[i] = blendColor(color, dst[i])
+    void (*fillBlend)(uint32_t *dst, int count, uint32_t color);
+
+    // dst[i] = blendColor(color with alpha set to mask[i], dst[i])
+    void (*blendMask)(uint32_t *dst, const uint8_t *mask, int count, uint32_t color);
+
+    // src[i] alpha is set to opacity, then dst[i] = blendColor(src[i], dst[i])
+    void (*blendOpacity)(uint32_t *dst, uint32_t *src, int count, uint8_t opacity);
+
+    // dst[i] = blendColor(src[i] with alpha multiplied by opacity / 255, dst[i])
+    void (*blendScaledAlpha)(uint32_t *dst, const uint32_t *src, int count, uint8_t opacity);
+
+    // dst[i] = src[i] reduced to RGB565 precision and alpha set to 255,
+    // processed from the first to the last pixel, so src and dst can overlap
+    void (*copyRgb565)(uint32_t *dst, const uint32_t *src, int count);
+};
+
+// Selects the fastest kernel set supported by the CPU.
+// EEZ_PIXEL_KERNELS environment variable can be used to select the set by name.
+void init();
+
+extern const PixelKernels *g_kernels;
+
+int getNumKernelSets();
+const PixelKernels *getKernelSet(int index);
+const PixelKernels *getKernelSet(const char *name);
+
+// Compares all kernels of the given set against the scalar set on random data
+// with random lengths and alignments, returns the number of different pixels.
+uint32_t verify(const PixelKernels &kernels);
+
+struct BenchmarkResult {
+    // megapixels per second
+    float fill;
+    float fillBlend;
+    float blendMask;
+    float blendOpacity;
+    float blendScaledAlpha;
+    float copyRgb565;
+};
+
+// Runs every kernel on display sized rows.
+void benchmark(const PixelKernels &kernels, BenchmarkResult &result);
+
+} // namespace kernels
+} // namespace display
+} // namespace mcu
+} // namespace eez
@@ -677,6 +677,35 @@ void drawBitmap(Image *image, int x, int y) {
     markDirty(x, y, x + image->width - 1, y + image->height - 1);
 }
 
+uint32_t getPixelsSize(int width, int height) {
+    return width * height * sizeof(uint16_t);
+}
+
+void readPixels(int x, int y, int width, int height, void *pixels) {
+    hdma2d.Init.Mode = DMA2D_M2M;
+    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
+    hdma2d.Init.OutputOffset = 0;
+
+    hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - width;
+    hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
+    hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
+    hdma2d.LayerCfg[1].InputAlpha = 0;
+
+    DMA2D_WAIT;
+
+    HAL_DMA2D_Init(&hdma2d);
+    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
+    HAL_DMA2D_Start(&hdma2d, vramOffset(g_buffer, x, y), (uint32_t)pixels, width, height);
+
+    // pixels could be read by the CPU as soon as this function returns
+    DMA2D_WAIT;
+}
+
+void writePixels(const void *pixels, int x, int y, int width, int height) {
+    bitBlt((void *)pixels, 16, 0, g_buffer, x, y, width, height);
+    markDirty(x, y, x + width - 1, y + height - 1);
+}
+
 void drawStr(const char *text, int textLength, int x, int y, int clip_x1, int clip_y1, int clip_x2, int clip_y2, gui::font::Font &font) {
     g_font = font;
 
@@ -429,6 +429,8 @@ bool save() {
         memcpy(&g_channel->cal_conf.i[1], &g_currents[1].configuration, sizeof(Channel::CalibrationValueConfiguration));
     }
 
+    g_channel->updateCalibrationTables();
+
     // TODO move this to scpi thread
     return persist_conf::saveChannelCalibration(*g_channel);
 }
@@ -439,6 +441,205 @@ bool clear(Channel *channel) {
     return persist_conf::saveChannelCalibration(*channel);
 }
 
+#if defined(DEBUG)
+
+// remapping as it was done before Channel::CalibrationTable
+static float linearSearchRemap(float value, const Channel::CalibrationValueConfiguration &cal, bool adc) {
+    unsigned i;
+    unsigned j;
+
+    if (cal.numPoints == 2) {
+        i = 0;
+        j = 1;
+    } else {
+        for (j = 1; j < cal.numPoints - 1 && value > (adc ? cal.points[j].adc : cal.points[j].value); j++) {
+        }
+        i = j - 1;
+    }
+
+    if (adc) {
+        if (cal.points[i].adc == cal.points[j].adc) {
+            return value;
+        }
+        return remap(value, cal.points[i].adc, cal.points[i].value, cal.points[j].adc, cal.points[j].value);
+    } else {
+        if (cal.points[i].value == cal.points[j].value) {
+            return value;
+        }
+        return remap(value, cal.points[i].value, cal.points[i].dac, cal.points[j].value, cal.points[j].dac);
+    }
+}
+
+enum BenchmarkConfigurationType {
+    BENCHMARK_CONFIGURATION_SORTED,
+    BENCHMARK_CONFIGURATION_UNIFORM,
+    BENCHMARK_CONFIGURATION_NEARLY_UNIFORM,
+    BENCHMARK_CONFIGURATION_UNSORTED,
+    BENCHMARK_CONFIGURATION_REPEATED,
+    BENCHMARK_CONFIGURATION_DESCENDING,
+    BENCHMARK_CONFIGURATION_NAN,
+    NUM_BENCHMARK_CONFIGURATION_TYPES
+};
+
+static uint32_t g_benchmarkSeed;
+
+static float benchmarkRandom(float min, float max) {
+    g_benchmarkSeed = g_benchmarkSeed * 1103515245 + 12345;
+    return min + (max - min) * ((g_benchmarkSeed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+static void generatePoints(int type, unsigned numPoints, float *x) {
+    float step = benchmarkRandom(0.1f, 5.0f);
+    float x0 = benchmarkRandom(-1.0f, 1.0f);
+
+    for (unsigned i = 0; i < numPoints; i++) {
+        if (type == BENCHMARK_CONFIGURATION_UNIFORM) {
+            x[i] = x0 + i * step;
+        } else if (type == BENCHMARK_CONFIGURATION_NEARLY_UNIFORM) {
+            x[i] = x0 + i * step + benchmarkRandom(-step / 1000, step / 1000);
+        } else if (type == BENCHMARK_CONFIGURATION_UNSORTED) {
+            x[i] = benchmarkRandom(x0, x0 + numPoints * step);
+        } else if (type == BENCHMARK_CONFIGURATION_DESCENDING) {
+            x[i] = x0 - i * benchmarkRandom(0, step);
+        } else {
+            x[i] = (i > 0 ? x[i - 1] : x0) + benchmarkRandom(0, step);
+        }
+    }
+
+    if (type == BENCHMARK_CONFIGURATION_REPEATED && numPoints > 2) {
+        for (int i = 0; i < 3; i++) {
+            unsigned j = 1 + (g_benchmarkSeed >> 8) % (numPoints - 1);
+            x[j] = x[j - 1];
+            benchmarkRandom(0, 1);
+        }
+    }
+
+    if (type == BENCHMARK_CONFIGURATION_NAN && numPoints > 2) {
+        x[1 + (g_benchmarkSeed >> 8) % (numPoints - 2)] = NAN;
+    }
+}
+
+static void generateConfiguration(int type, unsigned numPoints, Channel::CalibrationValueConfiguration &cal) {
+    float x[MAX_CALIBRATION_POINTS];
+
+    cal.numPoints = numPoints;
+
+    generatePoints(type, numPoints, x);
+    for (unsigned i = 0; i < numPoints; i++) {
+        cal.points[i].adc = x[i];
+    }
+
+    generatePoints(type, numPoints, x);
+    for (unsigned i = 0; i < numPoints; i++) {
+        cal.points[i].value = x[i];
+        cal.points[i].dac = x[i] * benchmarkRandom(0.95f, 1.05f);
+    }
+}
+
+static bool isSameResult(float a, float b) {
+    return (isNaN(a) && isNaN(b)) || memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// Samples are every point, its neighbouring floats, middle points between the points
+// and values outside of the range.
+static int generateSamples(const Channel::CalibrationValueConfiguration &cal, bool adc, float *samples) {
+    int numSamples = 0;
+
+    for (unsigned i = 0; i < cal.numPoints; i++) {
+        float x = adc ? cal.points[i].adc : cal.points[i].value;
+        samples[numSamples++] = x;
+        samples[numSamples++] = nextafterf(x, INFINITY);
+        samples[numSamples++] = nextafterf(x, -INFINITY);
+        if (i > 0) {
+            float prevX = adc ? cal.points[i - 1].adc : cal.points[i - 1].value;
+            samples[numSamples++] = (prevX + x) / 2;
+        }
+    }
+
+    samples[numSamples++] = -1000.0f;
+    samples[numSamples++] = 1000.0f;
+    samples[numSamples++] = 0;
+    samples[numSamples++] = INFINITY;
+    samples[numSamples++] = -INFINITY;
+    samples[numSamples++] = NAN;
+
+    for (int i = 0; i < 20; i++) {
+        samples[numSamples++] = benchmarkRandom(-10.0f, 100.0f);
+    }
+
+    return numSamples;
+}
+
+static const int MAX_BENCHMARK_SAMPLES = 4 * MAX_CALIBRATION_POINTS + 26;
+
+void benchmark(BenchmarkResult &result) {
+    memset(&result, 0, sizeof(result));
+
+    g_benchmarkSeed = 1;
+
+    Channel::CalibrationValueConfiguration cal;
+    Channel::CalibrationTable table;
+    float samples[MAX_BENCHMARK_SAMPLES];
+
+    for (int type = 0; type < NUM_BENCHMARK_CONFIGURATION_TYPES; type++) {
+        for (unsigned numPoints = 2; numPoints <= MAX_CALIBRATION_POINTS; numPoints++) {
+            for (int i = 0; i < 10; i++) {
+                generateConfiguration(type, numPoints, cal);
+
+                for (int direction = 0; direction < 2; direction++) {
+                    bool adc = direction == 0;
+
+                    table.build(cal, adc);
+
+                    int numSamples = generateSamples(cal, adc, samples);
+                    for (int j = 0; j < numSamples; j++) {
+                        if (!isSameResult(table.remap(samples[j]), linearSearchRemap(samples[j], cal, adc))) {
+                            result.numDifferences++;
+                        }
+                    }
+
+                    result.numConfigurations++;
+                    result.numSamples += numSamples;
+                }
+            }
+        }
+    }
+
+    static const unsigned BENCHMARK_SIZES[NUM_BENCHMARK_SIZES] = { 2, 3, 5, 10, MAX_CALIBRATION_POINTS };
+    static const int NUM_ITERATIONS = 100;
+
+    volatile float sum = 0;
+
+    for (int i = 0; i < NUM_BENCHMARK_SIZES; i++) {
+        generateConfiguration(BENCHMARK_CONFIGURATION_SORTED, BENCHMARK_SIZES[i], cal);
+        table.build(cal, true);
+
+        float min = cal.points[0].adc;
+        float max = cal.points[cal.numPoints - 1].adc;
+        for (int j = 0; j < MAX_BENCHMARK_SAMPLES; j++) {
+            samples[j] = benchmarkRandom(min, max);
+        }
+
+        uint32_t startTime = micros();
+        for (int k = 0; k < NUM_ITERATIONS; k++) {
+            for (int j = 0; j < MAX_BENCHMARK_SAMPLES; j++) {
+                sum += linearSearchRemap(samples[j], cal, true);
+            }
+        }
+        result.linearSearchTime[i] = (micros() - startTime) * 1000 / (NUM_ITERATIONS * MAX_BENCHMARK_SAMPLES);
+
+        startTime = micros();
+        for (int k = 0; k < NUM_ITERATIONS; k++) {
+            for (int j = 0; j < MAX_BENCHMARK_SAMPLES; j++) {
+                sum += table.remap(samples[j]);
+            }
+        }
+        result.tableTime[i] = (micros() - startTime) * 1000 / (NUM_ITERATIONS * MAX_BENCHMARK_SAMPLES);
+    }
+}
+
+#endif
+
 } // namespace calibration
 } // namespace psu
 } // namespace eez
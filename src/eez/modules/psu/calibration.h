@@ -89,6 +89,26 @@ bool save();
 /// /param channel Selected channel
 bool clear(Channel *channel);
 
+#if defined(DEBUG)
+
+static const int NUM_BENCHMARK_SIZES = 5;
+
+struct BenchmarkResult {
+    uint32_t numConfigurations;
+    uint32_t numSamples;
+    uint32_t numDifferences;
+    /// ns per sample for 2, 3, 5, 10 and MAX_CALIBRATION_POINTS points
+    uint32_t linearSearchTime[NUM_BENCHMARK_SIZES];
+    uint32_t tableTime[NUM_BENCHMARK_SIZES];
+};
+
+/// Compares Channel::CalibrationTable with the linear search over the calibration points
+/// in both directions for the generated configurations with 2 .. MAX_CALIBRATION_POINTS points
+/// (sorted, uniform, unsorted, with repeated and NaN points) and measures the cost per sample.
+void benchmark(BenchmarkResult &result);
+
+#endif
+
 } // namespace calibration
 } // namespace psu
 } // namespace eez
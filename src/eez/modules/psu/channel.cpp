@@ -24,6 +24,8 @@
 
 #include <eez/firmware.h>
 #include <eez/system.h>
+#include <eez/memory.h>
+#include <eez/profiler.h>
 #include <eez/modules/psu/board.h>
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/channel_dispatcher.h>
@@ -192,164 +194,42 @@ void Channel::restoreOE() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-float Channel::getChannel0HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
-    Channel &channel = *g_channels[0];
+static_assert(CH_MAX * sizeof(ChannelHistory) <= CHANNEL_HISTORY_MEMORY_SIZE, "CHANNEL_HISTORY_MEMORY is too small");
 
-    uint32_t position = rowIndex % CHANNEL_HISTORY_SIZE;
-    
-    if (columnIndex == 0) {
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    } else {
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    }
-
-    return channel.uHistory[position] * channel.iHistory[position];
+ChannelHistory &Channel::getHistory() {
+    return ((ChannelHistory *)CHANNEL_HISTORY_MEMORY)[channelIndex];
 }
 
-float Channel::getChannel1HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
-    Channel &channel = *g_channels[1];
-
-    uint32_t position = rowIndex % CHANNEL_HISTORY_SIZE;
-
-    if (columnIndex == 0) {
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    } else {
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    }
-
-    return channel.uHistory[position] * channel.iHistory[position];
-}
+template <int CHANNEL_INDEX>
+float Channel::getHistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
+    Channel &channel = *g_channels[CHANNEL_INDEX];
 
-float Channel::getChannel2HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
-    Channel &channel = *g_channels[2];
+    uint8_t displayValue = columnIndex == 0 ? channel.flags.displayValue1 : channel.flags.displayValue2;
+    int signal = displayValue == DISPLAY_VALUE_VOLTAGE ? HISTORY_SIGNAL_U :
+        displayValue == DISPLAY_VALUE_CURRENT ? HISTORY_SIGNAL_I : HISTORY_SIGNAL_P;
 
-    uint32_t position = rowIndex % CHANNEL_HISTORY_SIZE;
+    ChannelHistory &history = channel.getHistory();
 
-    if (columnIndex == 0) {
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    } else {
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
+    if (max) {
+        *max = history.getMax(channel.historyTier, signal, rowIndex);
     }
 
-    return channel.uHistory[position] * channel.iHistory[position];
+    return history.getMin(channel.historyTier, signal, rowIndex);
 }
 
-float Channel::getChannel3HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
-    Channel &channel = *g_channels[3];
-
-    uint32_t position = rowIndex % CHANNEL_HISTORY_SIZE;
-
-    if (columnIndex == 0) {
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    } else {
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    }
-
-    return channel.uHistory[position] * channel.iHistory[position];
-}
-
-float Channel::getChannel4HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
-    Channel &channel = *g_channels[4];
-
-    uint32_t position = rowIndex % CHANNEL_HISTORY_SIZE;
-
-    if (columnIndex == 0) {
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    } else {
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    }
-
-    return channel.uHistory[position] * channel.iHistory[position];
-}
-
-float Channel::getChannel5HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
-    Channel &channel = *g_channels[5];
-
-    uint32_t position = rowIndex % CHANNEL_HISTORY_SIZE;
-
-    if (columnIndex == 0) {
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-        if (channel.flags.displayValue1 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-    } else {
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_CURRENT) {
-            return channel.iHistory[position];
-        }
-        if (channel.flags.displayValue2 == DISPLAY_VALUE_VOLTAGE) {
-            return channel.uHistory[position];
-        }
-    }
+Channel::YtDataGetValueFunctionPointer Channel::getChannelHistoryValueFuncs(int channelIndex) {
+    static const YtDataGetValueFunctionPointer g_historyValueFuncs[] = {
+        getHistoryValue<0>,
+        getHistoryValue<1>,
+        getHistoryValue<2>,
+        getHistoryValue<3>,
+        getHistoryValue<4>,
+        getHistoryValue<5>,
+    };
 
-    return channel.uHistory[position] * channel.iHistory[position];
-}
+    static_assert(sizeof(g_historyValueFuncs) / sizeof(g_historyValueFuncs[0]) == CH_MAX, "history value function is missing");
 
-Channel::YtDataGetValueFunctionPointer Channel::getChannelHistoryValueFuncs(int channelIndex) {
-    if (channelIndex == 0) {
-        return Channel::getChannel0HistoryValue;
-    } else if (channelIndex == 1) {
-        return Channel::getChannel1HistoryValue;
-    } else if (channelIndex == 2) {
-        return Channel::getChannel2HistoryValue;
-    } else if (channelIndex == 3) {
-        return Channel::getChannel3HistoryValue;
-    } else if (channelIndex == 4) {
-        return Channel::getChannel4HistoryValue;
-    } else {
-        return Channel::getChannel5HistoryValue;
-    }
+    return g_historyValueFuncs[channelIndex >= 0 && channelIndex < CH_MAX ? channelIndex : CH_MAX - 1];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -622,7 +502,7 @@ void Channel::reset() {
 }
 
 uint32_t Channel::getCurrentHistoryValuePosition() {
-	return historyPosition;
+    return flags.historyStarted ? getHistory().getPosition(historyTier) : 1;
 }
 
 void Channel::resetHistoryForAllChannels() {
@@ -632,12 +512,24 @@ void Channel::resetHistoryForAllChannels() {
 }
 
 void Channel::resetHistory() {
-    for (int i = 0; i < CHANNEL_HISTORY_SIZE; ++i) {
-        uHistory[i] = 0;
-        iHistory[i] = 0;
-    }
+    // history is cleared by startHistory in the next tick
     flags.historyStarted = 0;
-    historyPosition = 1;
+}
+
+void Channel::startHistory() {
+    // Show the highest tier which entry period is ytViewRate while the tier 0 sample period
+    // is not shorter than GUI_YT_VIEW_RATE_MIN, so every shown point is min/max of as many
+    // samples as the PSU thread can take.
+    float samplePeriod = ytViewRate;
+    historyTier = 0;
+    while (historyTier < CHANNEL_HISTORY_NUM_TIERS - 1 && samplePeriod / CHANNEL_HISTORY_DECIMATION >= GUI_YT_VIEW_RATE_MIN) {
+        samplePeriod /= CHANNEL_HISTORY_DECIMATION;
+        historyTier++;
+    }
+    historySamplePeriod = (uint32_t)round(samplePeriod * 1000000L);
+
+    getHistory().reset();
+    flags.historyStarted = 1;
 }
 
 void Channel::clearCalibrationConf() {
@@ -647,6 +539,8 @@ void Channel::clearCalibrationConf() {
     
     cal_conf.calibrationDate = 0;
     strcpy(cal_conf.calibrationRemark, CALIBRATION_REMARK_INIT);
+
+    updateCalibrationTables();
 }
 
 void Channel::clearProtectionConf() {
@@ -691,6 +585,8 @@ void Channel::tick(uint32_t tick_usec) {
         return;
     }
 
+    PROFILER_ZONE(CHANNEL_TICK);
+
     tickSpecific(tick_usec);
 
     if (params.features & CH_FEATURE_RPOL) {
@@ -717,18 +613,19 @@ void Channel::tick(uint32_t tick_usec) {
 
     // update history values
     if (!flags.historyStarted) {
-        flags.historyStarted = 1;
+        startHistory();
         historyLastTick = tick_usec;
-        historyPosition = 1;
-    } else {
-        uint32_t ytViewRateMicroseconds = (int)round(ytViewRate * 1000000L);
-        while (tick_usec - historyLastTick >= ytViewRateMicroseconds) {
-            uint32_t historyIndex = historyPosition % CHANNEL_HISTORY_SIZE;
-            uHistory[historyIndex] = channel_dispatcher::getUMonLast(*this);
-            iHistory[historyIndex] = channel_dispatcher::getIMonLast(*this);
-            historyPosition++;
-            historyLastTick += ytViewRateMicroseconds;
-        }
+    } else if (tick_usec - historyLastTick >= historySamplePeriod) {
+        float values[NUM_HISTORY_SIGNALS];
+        values[HISTORY_SIGNAL_U] = channel_dispatcher::getUMonLast(*this);
+        values[HISTORY_SIGNAL_I] = channel_dispatcher::getIMonLast(*this);
+        values[HISTORY_SIGNAL_P] = values[HISTORY_SIGNAL_U] * values[HISTORY_SIGNAL_I];
+
+        ChannelHistory &history = getHistory();
+        do {
+            history.push(values);
+            historyLastTick += historySamplePeriod;
+        } while (tick_usec - historyLastTick >= historySamplePeriod);
     }
 
     doAutoSelectCurrentRange(tick_usec);
@@ -781,64 +678,125 @@ float Channel::roundChannelValue(Unit unit, float value) const {
     return roundPrec(value, getValuePrecision(unit, value));
 }
 
-float remapAdcValue(float value, Channel::CalibrationValueConfiguration &cal) {
-    unsigned i;
-    unsigned j;
-
-    if (cal.numPoints == 2) {
-        i = 0;
-        j = 1;
-    } else {
-        for (j = 1; j < cal.numPoints - 1 && value > cal.points[j].adc; j++) {
-        }
-        i = j - 1;
+void Channel::CalibrationTable::build(const CalibrationValueConfiguration &cal, bool adc) {
+    if (cal.numPoints < 2 || cal.numPoints > MAX_CALIBRATION_POINTS) {
+        numSegments = 0;
+        return;
     }
 
-    if (cal.points[i].adc == cal.points[j].adc) {
-    	return value;
+    numSegments = cal.numPoints - 1;
+
+    for (int k = 0; k < numSegments; k++) {
+        const CalibrationValuePointConfiguration &p1 = cal.points[k];
+        const CalibrationValuePointConfiguration &p2 = cal.points[k + 1];
+
+        CalibrationSegment &segment = segments[k];
+        segment.x1 = adc ? p1.adc : p1.value;
+        segment.y1 = adc ? p1.value : p1.dac;
+        float x2 = adc ? p2.adc : p2.value;
+        float y2 = adc ? p2.value : p2.dac;
+        segment.dx = segment.x1 == x2 ? 0 : x2 - segment.x1;
+        segment.dy = y2 - segment.y1;
     }
 
-    return remap(value,
-        cal.points[i].adc,
-        cal.points[i].value,
-        cal.points[j].adc,
-        cal.points[j].value);
+    // linear search takes the first point 1 .. numPoints - 2 with x not less than the value,
+    // which is the same point as the first one with the running maximum not less than the value,
+    // so breakpoints are sorted even if the points are not.
+    // Linear search never goes past NaN, so all the breakpoints after NaN are NaN.
+    int numBreakpoints = numSegments - 1;
+    for (int k = 0; k < numBreakpoints; k++) {
+        float x = adc ? cal.points[k + 1].adc : cal.points[k + 1].value;
+        if (k > 0 && (isNaN(breakpoints[k - 1]) || breakpoints[k - 1] > x)) {
+            x = breakpoints[k - 1];
+        }
+        breakpoints[k] = x;
+    }
+
+    // direct index is only a guess, findSegment corrects it, so it is enough if the breakpoints
+    // are approximately uniform
+    isUniform = false;
+    if (numBreakpoints >= 3) {
+        float step = (breakpoints[numBreakpoints - 1] - breakpoints[0]) / (numBreakpoints - 1);
+        if (step > 0) {
+            isUniform = true;
+            for (int k = 1; k < numBreakpoints; k++) {
+                if (fabs(breakpoints[k] - breakpoints[k - 1] - step) > step / 100) {
+                    isUniform = false;
+                    break;
+                }
+            }
+            invStep = 1 / step;
+        }
+    }
 }
 
-float remapValue(float value, Channel::CalibrationValueConfiguration &cal) {
-    unsigned i;
-    unsigned j;
+int Channel::CalibrationTable::findSegment(float x) const {
+    int numBreakpoints = numSegments - 1;
 
-    if (cal.numPoints == 2) {
-        i = 0;
-        j = 1;
-    } else {
-        for (j = 1; j < cal.numPoints - 1 && value > cal.points[j].value; j++) {
+    // x is compared with "x > breakpoint", as in the linear search, so NaN goes to the first segment
+    if (numBreakpoints == 0 || !(x > breakpoints[0])) {
+        return 0;
+    }
+
+    if (isUniform) {
+        float t = (x - breakpoints[0]) * invStep;
+        int k = t >= numBreakpoints ? numBreakpoints : (int)t + 1;
+        while (k > 1 && !(x > breakpoints[k - 1])) {
+            k--;
+        }
+        while (k < numBreakpoints && x > breakpoints[k]) {
+            k++;
         }
-        i = j - 1;
+        return k;
     }
 
-    if (cal.points[i].value == cal.points[j].value) {
-    	return value;
+    int low = 1;
+    int high = numBreakpoints;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (x > breakpoints[mid]) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+float Channel::CalibrationTable::remap(float x) const {
+    if (numSegments == 0) {
+        return x;
     }
 
-    return remap(value,
-        cal.points[i].value,
-        cal.points[i].dac,
-        cal.points[j].value,
-        cal.points[j].dac);
+    const CalibrationSegment &segment = segments[findSegment(x)];
+
+    if (segment.dx == 0) {
+        return x;
+    }
+
+    // same as eez::remap
+    return segment.y1 + (x - segment.x1) * segment.dy / segment.dx;
+}
+
+void Channel::updateCalibrationTables() {
+    calAdcTables[0].build(cal_conf.u, true);
+    calDacTables[0].build(cal_conf.u, false);
+    for (int i = 0; i < 2; i++) {
+        calAdcTables[1 + i].build(cal_conf.i[i], true);
+        calDacTables[1 + i].build(cal_conf.i[i], false);
+    }
 }
 
 void Channel::addUMonAdcValue(float value) {
     if (isVoltageCalibrationEnabled()) {
-        value = remapAdcValue(value, cal_conf.u);
+        value = calAdcTables[0].remap(value);
     }
     u.addMonValue(value, getVoltageResolution());
 }
 
 void Channel::addIMonAdcValue(float value) {
     if (isCurrentCalibrationEnabled()) {
-        value = remapAdcValue(value, cal_conf.i[flags.currentCurrentRange]);
+        value = calAdcTables[1 + flags.currentCurrentRange].remap(value);
     }
 
     i.addMonValue(value, getCurrentResolution());
@@ -1185,7 +1143,7 @@ bool Channel::isRemoteProgrammingEnabled() {
 
 float Channel::getCalibratedVoltage(float value) {
     if (isVoltageCalibrationEnabled()) {
-        value = remapValue(value, cal_conf.u);
+        value = calDacTables[0].remap(value);
     }
 
 #if !defined(EEZ_PLATFORM_SIMULATOR)
@@ -1233,7 +1191,7 @@ void Channel::doSetCurrent(float value) {
     i.mon_dac = 0;
 
     if (isCurrentCalibrationEnabled()) {
-        value = remapValue(value, cal_conf.i[flags.currentCurrentRange]);
+        value = calDacTables[1 + flags.currentCurrentRange].remap(value);
     }
 
     value += getDualRangeGndOffset();
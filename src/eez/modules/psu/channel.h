@@ -22,6 +22,7 @@
 
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/temp_sensor.h>
+#include <eez/modules/psu/channel_history.h>
 
 #define IS_OVP_VALUE(channel, cpv) (&cpv == &channel->ovp)
 #define IS_OCP_VALUE(channel, cpv) (&cpv == &channel->ocp)
@@ -47,6 +48,10 @@ struct Value;
 
 enum DisplayValue { DISPLAY_VALUE_VOLTAGE, DISPLAY_VALUE_CURRENT, DISPLAY_VALUE_POWER };
 
+enum HistorySignal { HISTORY_SIGNAL_U, HISTORY_SIGNAL_I, HISTORY_SIGNAL_P, NUM_HISTORY_SIGNALS };
+
+typedef DecimatedHistory<NUM_HISTORY_SIGNALS, CHANNEL_HISTORY_SIZE, CHANNEL_HISTORY_NUM_TIERS, CHANNEL_HISTORY_DECIMATION> ChannelHistory;
+
 enum TriggerMode { TRIGGER_MODE_FIXED, TRIGGER_MODE_LIST, TRIGGER_MODE_STEP };
 
 enum TriggerOnListStop {
@@ -250,6 +255,35 @@ public:
         char calibrationRemark[CALIBRATION_REMARK_MAX_LENGTH + 1];
     };
 
+    /// Line between the two consecutive calibration points.
+    /// dx is 0 if both points have the same x, then the value is not remapped.
+    struct CalibrationSegment {
+        float x1;
+        float y1;
+        float dx;
+        float dy;
+    };
+
+    /// Calibration value configuration compiled for remapping in one direction,
+    /// ADC to value or value to DAC.
+    /// Segment is found with binary search, or directly if the breakpoints are uniform,
+    /// and remapped with the same expression as remap(), so the result is exactly the same
+    /// as with the linear search over the calibration points.
+    struct CalibrationTable {
+        /// 0 if there is no calibration
+        uint8_t numSegments;
+        bool isUniform;
+        float invStep;
+        /// Breakpoint k is the greatest x of the calibration points 1 .. k + 1,
+        /// x greater than the breakpoint k is remapped with the segment k + 1 or higher.
+        float breakpoints[MAX_CALIBRATION_POINTS - 2];
+        CalibrationSegment segments[MAX_CALIBRATION_POINTS - 1];
+
+        void build(const CalibrationValueConfiguration &cal, bool adc);
+        int findSegment(float x) const;
+        float remap(float x) const;
+    };
+
     /// Binary flags for the channel protection configuration
     struct ProtectionConfigurationFlags {
         /// Is OVP enabled?
@@ -433,6 +467,9 @@ public:
     /// Clear channel calibration configuration.
     void clearCalibrationConf();
 
+    /// Compiles calibration tables, must be called every time cal_conf is changed.
+    void updateCalibrationTables();
+
     /// Is channel power ok (state of PWRGOOD bit in IO Expander)?
     bool isPowerOk();
 
@@ -705,19 +742,24 @@ private:
     
     MaxCurrentLimitCause maxCurrentLimitCause;
 
-    float uHistory[CHANNEL_HISTORY_SIZE];
-    float iHistory[CHANNEL_HISTORY_SIZE];
-    uint32_t historyPosition;
+    // history tier shown in YT view and the period of the tier 0 entries,
+    // both are selected from ytViewRate when history is started
+    uint8_t historyTier;
+    uint32_t historySamplePeriod;
     uint32_t historyLastTick;
 
+    /// cal_conf.u, cal_conf.i[0] and cal_conf.i[1] compiled for remapping
+    /// ADC to value (calAdcTables) and value to DAC (calDacTables)
+    CalibrationTable calAdcTables[3];
+    CalibrationTable calDacTables[3];
+
     int reg_get_ques_isum_bit_mask_for_channel_protection_value(ProtectionValue &cpv);
 
-    static float getChannel0HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
-    static float getChannel1HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
-    static float getChannel2HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
-    static float getChannel3HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
-    static float getChannel4HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
-    static float getChannel5HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
+    ChannelHistory &getHistory();
+    void startHistory();
+
+    template <int CHANNEL_INDEX>
+    static float getHistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
 
     void clearProtectionConf();
     void protectionCheck(ProtectionValue &cpv);
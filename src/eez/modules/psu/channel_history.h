@@ -0,0 +1,126 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Channel history
+
+Monitored values are stored in the tier 0 ring. Every DECIMATION consecutive entries of
+a tier are reduced to one min/max entry of the next tier, so tier t covers DECIMATION^t
+times longer time span with the same number of entries. Reduction is accumulated entry
+by entry, so push is O(1) and no tier is ever rescanned.
+
+Position is the number of entries added to the tier plus one (position 0 is never written),
+the entry at the position is stored in the ring at position % SIZE.
+*/
+
+namespace eez {
+namespace psu {
+
+template <int NUM_SIGNALS, uint32_t SIZE, int NUM_TIERS, uint32_t DECIMATION>
+class DecimatedHistory {
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be power of 2");
+    static_assert(NUM_TIERS >= 1, "at least one tier is required");
+
+public:
+    void reset() {
+        for (int tier = 0; tier < NUM_TIERS; tier++) {
+            m_position[tier] = 1;
+            m_numAccumulated[tier] = 0;
+        }
+
+        for (int signal = 0; signal < NUM_SIGNALS; signal++) {
+            for (uint32_t i = 0; i < SIZE; i++) {
+                m_values[signal][i] = 0;
+            }
+            for (int tier = 0; tier < NUM_TIERS - 1; tier++) {
+                for (uint32_t i = 0; i < SIZE; i++) {
+                    m_min[tier][signal][i] = 0;
+                    m_max[tier][signal][i] = 0;
+                }
+            }
+        }
+    }
+
+    void push(const float *values) {
+        add(0, values, values);
+    }
+
+    uint32_t getPosition(int tier) const {
+        return m_position[tier];
+    }
+
+    float getMin(int tier, int signal, uint32_t position) const {
+        return tier == 0 ? m_values[signal][position % SIZE] : m_min[tier - 1][signal][position % SIZE];
+    }
+
+    float getMax(int tier, int signal, uint32_t position) const {
+        return tier == 0 ? m_values[signal][position % SIZE] : m_max[tier - 1][signal][position % SIZE];
+    }
+
+private:
+    // tier 0 entries are single values, min/max is stored only for the upper tiers
+    float m_values[NUM_SIGNALS][SIZE];
+    float m_min[NUM_TIERS > 1 ? NUM_TIERS - 1 : 1][NUM_SIGNALS][SIZE];
+    float m_max[NUM_TIERS > 1 ? NUM_TIERS - 1 : 1][NUM_SIGNALS][SIZE];
+
+    uint32_t m_position[NUM_TIERS];
+
+    // min/max of the entries added to the tier since the last entry of the next tier
+    uint32_t m_numAccumulated[NUM_TIERS];
+    float m_accumulatedMin[NUM_TIERS][NUM_SIGNALS];
+    float m_accumulatedMax[NUM_TIERS][NUM_SIGNALS];
+
+    void add(int tier, const float *min, const float *max) {
+        uint32_t index = m_position[tier] % SIZE;
+        for (int signal = 0; signal < NUM_SIGNALS; signal++) {
+            if (tier == 0) {
+                m_values[signal][index] = min[signal];
+            } else {
+                m_min[tier - 1][signal][index] = min[signal];
+                m_max[tier - 1][signal][index] = max[signal];
+            }
+        }
+        m_position[tier]++;
+
+        if (tier + 1 == NUM_TIERS) {
+            return;
+        }
+
+        float *accumulatedMin = m_accumulatedMin[tier];
+        float *accumulatedMax = m_accumulatedMax[tier];
+        for (int signal = 0; signal < NUM_SIGNALS; signal++) {
+            if (m_numAccumulated[tier] == 0 || min[signal] < accumulatedMin[signal]) {
+                accumulatedMin[signal] = min[signal];
+            }
+            if (m_numAccumulated[tier] == 0 || max[signal] > accumulatedMax[signal]) {
+                accumulatedMax[signal] = max[signal];
+            }
+        }
+
+        if (++m_numAccumulated[tier] == DECIMATION) {
+            m_numAccumulated[tier] = 0;
+            add(tier + 1, accumulatedMin, accumulatedMax);
+        }
+    }
+};
+
+} // namespace psu
+} // namespace eez
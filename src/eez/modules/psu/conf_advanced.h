@@ -199,6 +199,11 @@
 /// greater then width of YT widget.
 #define CHANNEL_HISTORY_SIZE 512
 
+/// Number of history tiers. Every next tier keeps min/max of CHANNEL_HISTORY_DECIMATION
+/// entries of the previous tier, so YT view shows the min/max envelope at the slow view rates.
+#define CHANNEL_HISTORY_NUM_TIERS 3
+#define CHANNEL_HISTORY_DECIMATION 10
+
 #define GUI_YT_VIEW_RATE_DEFAULT 0.1f
 #define GUI_YT_VIEW_RATE_MIN 0.005f
 #define GUI_YT_VIEW_RATE_MAX 300.0f
@@ -30,6 +30,8 @@ namespace debug {
 
 DebugCounterVariable g_adcCounter("ADC_COUNTER");
 DebugValueVariable g_encoderCounter("ENC_COUNTER", 100);
+DebugDurationVariable g_dlogWriteDuration("DLOG_WRITE");
+DebugCounterVariable g_dlogOverrunCounter("DLOG_OVERRUN");
 DebugValueVariable g_uDac[CH_MAX] = { DebugValueVariable("CH1 U_DAC"), DebugValueVariable("CH2 U_DAC"), DebugValueVariable("CH3 U_DAC"), DebugValueVariable("CH4 U_DAC"), DebugValueVariable("CH5 U_DAC"), DebugValueVariable("CH6 U_DAC") };
 DebugValueVariable g_uMon[CH_MAX] = { DebugValueVariable("CH1 U_MON"), DebugValueVariable("CH2 U_MON"), DebugValueVariable("CH3 U_MON"), DebugValueVariable("CH4 U_MON"), DebugValueVariable("CH5 U_MON"), DebugValueVariable("CH6 U_MON") };
 DebugValueVariable g_uMonDac[CH_MAX] = { DebugValueVariable("CH1 U_MON_DAC"), DebugValueVariable("CH2 U_MON_DAC"), DebugValueVariable("CH3 U_MON_DAC"), DebugValueVariable("CH4 U_MON_DAC"), DebugValueVariable("CH5 U_MON_DAC"), DebugValueVariable("CH6 U_MON_DAC") };
@@ -37,9 +39,20 @@ DebugValueVariable g_iDac[CH_MAX] = { DebugValueVariable("CH1 I_DAC"), DebugValu
 DebugValueVariable g_iMon[CH_MAX] = { DebugValueVariable("CH1 I_MON"), DebugValueVariable("CH2 I_MON"), DebugValueVariable("CH3 I_MON"), DebugValueVariable("CH4 I_MON"), DebugValueVariable("CH5 I_MON"), DebugValueVariable("CH6 I_MON") };
 DebugValueVariable g_iMonDac[CH_MAX] = { DebugValueVariable("CH1 I_MON_DAC"), DebugValueVariable("CH2 I_MON_DAC"), DebugValueVariable("CH3 I_MON_DAC"), DebugValueVariable("CH4 I_MON_DAC"), DebugValueVariable("CH5 I_MON_DAC"), DebugValueVariable("CH6 I_MON_DAC") };
 
+#define PROFILER_ZONE_VARIABLE(id, thread, name) DebugProfilerZoneVariable("PROF " name, profiler::ZONE_##id),
+DebugProfilerZoneVariable g_profilerZones[profiler::NUM_ZONES] = {
+    PROFILER_ZONES(PROFILER_ZONE_VARIABLE)
+};
+#undef PROFILER_ZONE_VARIABLE
+
 DebugVariable *g_variables[] = { 
     &g_adcCounter,
     &g_encoderCounter,
+    &g_dlogWriteDuration,
+    &g_dlogOverrunCounter,
+#define PROFILER_ZONE_VARIABLE_POINTER(id, thread, name) &g_profilerZones[profiler::ZONE_##id],
+    PROFILER_ZONES(PROFILER_ZONE_VARIABLE_POINTER)
+#undef PROFILER_ZONE_VARIABLE_POINTER
     &g_uDac[0], &g_uMon[0], &g_uMonDac[0], &g_iDac[0], &g_iMon[0], &g_iMonDac[0],
     &g_uDac[1], &g_uMon[1], &g_uMonDac[1], &g_iDac[1], &g_iMon[1], &g_iMonDac[1],
     &g_uDac[2], &g_uMon[2], &g_uMonDac[2], &g_iDac[2], &g_iMon[2], &g_iMonDac[2],
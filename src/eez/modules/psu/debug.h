@@ -24,6 +24,7 @@
 
 using eez::debug::DebugCounterVariable;
 using eez::debug::DebugDurationVariable;
+using eez::debug::DebugProfilerZoneVariable;
 using eez::debug::DebugValueVariable;
 using eez::debug::DebugVariable;
 
@@ -37,6 +38,9 @@ void tick(uint32_t tickCount);
 extern DebugCounterVariable g_adcCounter;
 extern DebugValueVariable g_encoderCounter;
 
+extern DebugDurationVariable g_dlogWriteDuration;
+extern DebugCounterVariable g_dlogOverrunCounter;
+
 extern DebugValueVariable g_uDac[CH_MAX];
 extern DebugValueVariable g_uMon[CH_MAX];
 extern DebugValueVariable g_uMonDac[CH_MAX];
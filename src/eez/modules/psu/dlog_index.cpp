@@ -0,0 +1,509 @@
+/*
+* EEZ PSU Firmware
+* Copyright (C) 2020-present, Envox d.o.o.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/dlog_index.h>
+#include <eez/modules/psu/dlog_view.h>
+#include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/sd_card.h>
+
+#include <eez/modules/psu/scpi/psu.h>
+
+namespace eez {
+
+using namespace scpi;
+
+namespace psu {
+namespace dlog_index {
+
+static Entry g_readBuffer[NUM_BUFFER_ENTRIES];
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline void initEntry(Entry &entry) {
+    entry.min = NAN;
+    entry.max = NAN;
+}
+
+static inline void addValue(Entry &entry, float value) {
+    if (isNaN(value)) {
+        return;
+    }
+
+    if (isNaN(entry.min)) {
+        entry.min = value;
+        entry.max = value;
+    } else if (value < entry.min) {
+        entry.min = value;
+    } else if (value > entry.max) {
+        entry.max = value;
+    }
+}
+
+static inline void mergeEntry(Entry &entry, const Entry &other) {
+    if (isNaN(other.min)) {
+        return;
+    }
+
+    if (isNaN(entry.min)) {
+        entry = other;
+    } else {
+        if (other.min < entry.min) {
+            entry.min = other.min;
+        }
+        if (other.max > entry.max) {
+            entry.max = other.max;
+        }
+    }
+}
+
+void getIndexFilePath(const char *dlogFilePath, char *indexFilePath) {
+    strncpy(indexFilePath, dlogFilePath, MAX_PATH_LENGTH - 4);
+    indexFilePath[MAX_PATH_LENGTH - 4] = 0;
+    strcat(indexFilePath, DLOG_INDEX_EXT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Builder::begin(const char *dlogFilePath, uint32_t dataOffset, uint16_t numYAxes) {
+    m_error = true;
+
+    if (numYAxes == 0 || numYAxes > MAX_NUM_Y_AXES) {
+        return false;
+    }
+
+    char indexFilePath[MAX_PATH_LENGTH + 1];
+    getIndexFilePath(dlogFilePath, indexFilePath);
+
+    if (!m_file.open(indexFilePath, FILE_CREATE_ALWAYS | FILE_READ | FILE_WRITE)) {
+        return false;
+    }
+
+    memset(&m_header, 0, sizeof(m_header));
+    m_header.numYAxes = numYAxes;
+    m_header.dataOffset = dataOffset;
+    m_header.numLevels = 1;
+    m_header.levelOffsets[0] = sizeof(Header);
+
+    // magic is written at the end, so index file is not valid until finished
+    if (m_file.write(&m_header, sizeof(Header)) != sizeof(Header)) {
+        m_file.close();
+        return false;
+    }
+
+    m_header.magic = MAGIC;
+    m_header.version = VERSION;
+
+    m_rowSize = numYAxes * sizeof(float);
+    m_rowBytes = 0;
+    m_entrySamples = 0;
+    m_numBufferedRows = 0;
+    m_error = false;
+
+    return true;
+}
+
+void Builder::addData(uint32_t filePosition, const uint8_t *data, uint32_t size) {
+    if (m_error) {
+        return;
+    }
+
+    // skip dlog file header and data already added (e.g. when write is repeated after an error)
+    uint32_t expectedFilePosition = m_header.dataOffset + m_header.numSamples * m_rowSize + m_rowBytes;
+    if (filePosition < expectedFilePosition) {
+        uint32_t skip = expectedFilePosition - filePosition;
+        if (skip >= size) {
+            return;
+        }
+        data += skip;
+        size -= skip;
+    } else if (filePosition > expectedFilePosition) {
+        // some data is missing
+        abort();
+        return;
+    }
+
+    while (size > 0) {
+        uint32_t n = MIN(m_rowSize - m_rowBytes, size);
+        memcpy(m_row + m_rowBytes, data, n);
+        m_rowBytes += n;
+        data += n;
+        size -= n;
+
+        if (m_rowBytes == m_rowSize) {
+            addRow();
+            m_rowBytes = 0;
+        }
+    }
+}
+
+void Builder::addRow() {
+    if (m_entrySamples == 0) {
+        for (uint32_t i = 0; i < m_header.numYAxes; i++) {
+            initEntry(m_entry[i]);
+        }
+    }
+
+    float *values = (float *)m_row;
+    for (uint32_t i = 0; i < m_header.numYAxes; i++) {
+        addValue(m_entry[i], values[i]);
+    }
+
+    m_header.numSamples++;
+
+    if (++m_entrySamples == LEVEL0_DECIMATION) {
+        writeEntry();
+    }
+}
+
+void Builder::writeEntry() {
+    memcpy(m_buffer + m_numBufferedRows * m_header.numYAxes, m_entry, m_header.numYAxes * sizeof(Entry));
+    m_header.levelSizes[0]++;
+    m_entrySamples = 0;
+
+    if (++m_numBufferedRows == NUM_BUFFER_ENTRIES / m_header.numYAxes) {
+        flushEntries();
+    }
+}
+
+void Builder::flushEntries() {
+    if (m_numBufferedRows > 0) {
+        uint32_t size = m_numBufferedRows * m_header.numYAxes * sizeof(Entry);
+        if (m_file.write(m_buffer, size) != size) {
+            m_error = true;
+        }
+        m_numBufferedRows = 0;
+    }
+}
+
+bool Builder::buildUpperLevels() {
+    uint32_t numYAxes = m_header.numYAxes;
+    uint32_t rowSize = numYAxes * sizeof(Entry);
+    uint32_t rowsPerBuffer = (NUM_BUFFER_ENTRIES / numYAxes) & ~1;
+
+    for (uint32_t level = 1; level < MAX_NUM_LEVELS && m_header.levelSizes[level - 1] > 1; level++) {
+        uint32_t srcOffset = m_header.levelOffsets[level - 1];
+        uint32_t srcSize = m_header.levelSizes[level - 1];
+        uint32_t dstOffset = srcOffset + srcSize * rowSize;
+        uint32_t dstSize = 0;
+
+        for (uint32_t i = 0; i < srcSize; i += rowsPerBuffer) {
+            uint32_t n = MIN(rowsPerBuffer, srcSize - i);
+
+            if (!m_file.seek(srcOffset + i * rowSize) || m_file.read(g_readBuffer, n * rowSize) != n * rowSize) {
+                return false;
+            }
+
+            for (uint32_t j = 0; j < n; j += 2) {
+                Entry *dst = m_buffer + (j / 2) * numYAxes;
+                Entry *src = g_readBuffer + j * numYAxes;
+                for (uint32_t k = 0; k < numYAxes; k++) {
+                    dst[k] = src[k];
+                    if (j + 1 < n) {
+                        mergeEntry(dst[k], src[numYAxes + k]);
+                    }
+                }
+            }
+
+            uint32_t m = (n + 1) / 2;
+            if (!m_file.seek(dstOffset + dstSize * rowSize) || m_file.write(m_buffer, m * rowSize) != m * rowSize) {
+                return false;
+            }
+            dstSize += m;
+        }
+
+        m_header.levelOffsets[level] = dstOffset;
+        m_header.levelSizes[level] = dstSize;
+        m_header.numLevels = level + 1;
+    }
+
+    return true;
+}
+
+bool Builder::finish() {
+    if (m_error) {
+        abort();
+        return false;
+    }
+
+    if (m_entrySamples > 0) {
+        writeEntry();
+    }
+    flushEntries();
+
+    bool result = !m_error && buildUpperLevels();
+
+    if (result) {
+        result = m_file.seek(0) && m_file.write(&m_header, sizeof(Header)) == sizeof(Header);
+    }
+
+    if (!m_file.close()) {
+        result = false;
+    }
+
+    m_error = true;
+
+    return result;
+}
+
+void Builder::abort() {
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_error = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool openIndex(const char *dlogFilePath, uint32_t dataOffset, uint16_t numYAxes, uint32_t numSamples, File &file, Header &header) {
+    char indexFilePath[MAX_PATH_LENGTH + 1];
+    getIndexFilePath(dlogFilePath, indexFilePath);
+
+    if (!file.open(indexFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    if (
+        file.read(&header, sizeof(Header)) != sizeof(Header) ||
+        header.magic != MAGIC ||
+        header.version != VERSION ||
+        header.numYAxes != numYAxes ||
+        header.dataOffset != dataOffset ||
+        header.numSamples != numSamples ||
+        header.numLevels == 0 ||
+        header.numLevels > MAX_NUM_LEVELS
+    ) {
+        file.close();
+        return false;
+    }
+
+    return true;
+}
+
+int findLevel(const Header &header, uint32_t numSamplesPerValue) {
+    int level = -1;
+    while (level + 1 < (int)header.numLevels && getLevelDecimation(level + 1) <= numSamplesPerValue) {
+        level++;
+    }
+    return level;
+}
+
+static bool mergeSamples(File &dlogFile, const Header &header, uint32_t start, uint32_t end, Entry *result) {
+    uint32_t numYAxes = header.numYAxes;
+    uint32_t rowSize = numYAxes * sizeof(float);
+
+    if (!dlogFile.seek(header.dataOffset + start * rowSize)) {
+        return false;
+    }
+
+    static const uint32_t NUM_ROWS = 4;
+    float rows[NUM_ROWS * MAX_NUM_Y_AXES];
+
+    for (uint32_t i = start; i < end; i += NUM_ROWS) {
+        uint32_t n = MIN(NUM_ROWS, end - i);
+        if (dlogFile.read(rows, n * rowSize) != n * rowSize) {
+            return false;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            for (uint32_t k = 0; k < numYAxes; k++) {
+                addValue(result[k], rows[j * numYAxes + k]);
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool mergeEntries(File &indexFile, const Header &header, int level, uint32_t first, uint32_t last, Entry *result) {
+    uint32_t numYAxes = header.numYAxes;
+    uint32_t rowSize = numYAxes * sizeof(Entry);
+
+    if (!indexFile.seek(header.levelOffsets[level] + first * rowSize)) {
+        return false;
+    }
+
+    static const uint32_t NUM_ROWS = 4;
+    Entry rows[NUM_ROWS * MAX_NUM_Y_AXES];
+
+    for (uint32_t i = first; i < last; i += NUM_ROWS) {
+        uint32_t n = MIN(NUM_ROWS, last - i);
+        if (indexFile.read(rows, n * rowSize) != n * rowSize) {
+            return false;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            for (uint32_t k = 0; k < numYAxes; k++) {
+                mergeEntry(result[k], rows[j * numYAxes + k]);
+            }
+        }
+    }
+
+    return true;
+}
+
+// Merges entries of the given level which are completely inside [start, end),
+// what is left on both sides is merged from the lower levels and finally from the raw samples.
+static bool mergeRange(File &indexFile, File &dlogFile, const Header &header, int level, uint32_t start, uint32_t end, Entry *result) {
+    if (start >= end) {
+        return true;
+    }
+
+    if (level < 0) {
+        return mergeSamples(dlogFile, header, start, end, result);
+    }
+
+    uint32_t shift = LEVEL0_DECIMATION_SHIFT + level;
+    uint32_t first = (start + getLevelDecimation(level) - 1) >> shift;
+    uint32_t last = end >> shift;
+    if (end == header.numSamples) {
+        // last entry can summarize less samples
+        last = header.levelSizes[level];
+    }
+
+    if (first >= last) {
+        return mergeRange(indexFile, dlogFile, header, level - 1, start, end, result);
+    }
+
+    return
+        mergeRange(indexFile, dlogFile, header, level - 1, start, first << shift, result) &&
+        mergeEntries(indexFile, header, level, first, last, result) &&
+        mergeRange(indexFile, dlogFile, header, level - 1, MIN(last << shift, end), end, result);
+}
+
+bool readMinMax(File &indexFile, File &dlogFile, const Header &header, int level, uint32_t startSample, uint32_t numSamples, Entry *result) {
+    for (uint32_t k = 0; k < header.numYAxes; k++) {
+        initEntry(result[k]);
+    }
+
+    if (startSample >= header.numSamples || numSamples == 0) {
+        return false;
+    }
+
+    uint32_t endSample = numSamples < header.numSamples - startSample ? startSample + numSamples : header.numSamples;
+
+    return mergeRange(indexFile, dlogFile, header, level, startSample, endSample, result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool readDlogHeader(File &file, uint32_t &dataOffset, uint16_t &numYAxes) {
+    uint8_t buffer[dlog_view::DLOG_VERSION1_HEADER_SIZE];
+    if (file.read(buffer, sizeof(buffer)) != sizeof(buffer)) {
+        return false;
+    }
+
+    uint32_t magic1 = buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | (buffer[3] << 24);
+    uint32_t magic2 = buffer[4] | (buffer[5] << 8) | (buffer[6] << 16) | (buffer[7] << 24);
+    uint16_t version = buffer[8] | (buffer[9] << 8);
+
+    if (magic1 != dlog_view::MAGIC1 || magic2 != dlog_view::MAGIC2) {
+        return false;
+    }
+
+    if (version == dlog_view::VERSION1) {
+        uint32_t columns = buffer[12] | (buffer[13] << 8) | (buffer[14] << 16) | (buffer[15] << 24);
+        numYAxes = 0;
+        for (int channelIndex = 0; channelIndex < CH_MAX; ++channelIndex) {
+            for (int i = 0; i < 3; i++) {
+                if (columns & ((1 << i) << (4 * channelIndex))) {
+                    numYAxes++;
+                }
+            }
+        }
+        dataOffset = dlog_view::DLOG_VERSION1_HEADER_SIZE;
+    } else if (version == dlog_view::VERSION2) {
+        numYAxes = buffer[10] | (buffer[11] << 8);
+        dataOffset = buffer[12] | (buffer[13] << 8) | (buffer[14] << 16) | (buffer[15] << 24);
+    } else {
+        return false;
+    }
+
+    return numYAxes > 0 && numYAxes <= MAX_NUM_Y_AXES;
+}
+
+bool rebuild(const char *dlogFilePath, int *err) {
+    static Builder g_builder;
+    static const uint32_t CHUNK_SIZE = 4096;
+    static uint8_t g_chunk[CHUNK_SIZE];
+
+    if (!sd_card::isMounted(err)) {
+        return false;
+    }
+
+    if (dlog_record::isExecuting() && strcmp(dlog_record::g_recording.parameters.filePath, dlogFilePath) == 0) {
+        if (err) {
+            *err = SCPI_ERROR_DLOG_FILE_IS_RECORDING;
+        }
+        return false;
+    }
+
+    File file;
+    if (!file.open(dlogFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (err) {
+            *err = SCPI_ERROR_FILE_NAME_NOT_FOUND;
+        }
+        return false;
+    }
+
+    uint32_t dataOffset;
+    uint16_t numYAxes;
+    if (!readDlogHeader(file, dataOffset, numYAxes) || !file.seek(dataOffset)) {
+        file.close();
+        if (err) {
+            *err = SCPI_ERROR_INVALID_DLOG_FILE;
+        }
+        return false;
+    }
+
+    if (!g_builder.begin(dlogFilePath, dataOffset, numYAxes)) {
+        file.close();
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    uint32_t filePosition = dataOffset;
+    while (true) {
+        uint32_t read = file.read(g_chunk, CHUNK_SIZE);
+        if (read > 0) {
+            g_builder.addData(filePosition, g_chunk, read);
+            filePosition += read;
+        }
+        if (read < CHUNK_SIZE) {
+            break;
+        }
+    }
+
+    file.close();
+
+    if (!g_builder.finish()) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace dlog_index
+} // namespace psu
+} // namespace eez
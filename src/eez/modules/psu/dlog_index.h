@@ -0,0 +1,134 @@
+/*
+* EEZ PSU Firmware
+* Copyright (C) 2020-present, Envox d.o.o.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <eez/libs/sd_fat/sd_fat.h>
+
+#define DLOG_INDEX_EXT ".idx"
+
+/* DLOG Index File Format
+
+Index file is stored next to the dlog file, with ".idx" appended to the dlog file name.
+It contains a pyramid of min/max summaries of dlog data at power of two decimation levels.
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x58444C44L
+
+4         U16     2        VERSION = 0x0001L
+
+6         U16     2        Number of Y axes (N)
+
+8         U32     4        Data offset in dlog file
+
+12        U32     4        Number of samples
+
+16        U32     4        Number of levels
+
+20        U32[24] 96       Level offsets in index file
+
+116       U32[24] 96       Number of entries in each level
+
+212                        Level data. Level L entry summarizes 2^(4 + L) samples
+                           and consists of N (min, max) float pairs.
+*/
+
+namespace eez {
+namespace psu {
+namespace dlog_index {
+
+static const uint32_t MAGIC = 0x58444C44;
+static const uint16_t VERSION = 1;
+
+static const uint32_t LEVEL0_DECIMATION_SHIFT = 4;
+static const uint32_t LEVEL0_DECIMATION = 1 << LEVEL0_DECIMATION_SHIFT;
+static const int MAX_NUM_LEVELS = 24;
+
+static const int MAX_NUM_Y_AXES = CH_MAX * 3;
+
+static const uint32_t NUM_BUFFER_ENTRIES = 256;
+
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numYAxes;
+    uint32_t dataOffset;
+    uint32_t numSamples;
+    uint32_t numLevels;
+    uint32_t levelOffsets[MAX_NUM_LEVELS];
+    uint32_t levelSizes[MAX_NUM_LEVELS];
+};
+
+struct Entry {
+    float min;
+    float max;
+};
+
+void getIndexFilePath(const char *dlogFilePath, char *indexFilePath);
+
+inline uint32_t getLevelDecimation(uint32_t level) {
+    return 1 << (LEVEL0_DECIMATION_SHIFT + level);
+}
+
+// Builds index incrementally from the dlog data as it is written to the file.
+class Builder {
+public:
+    bool begin(const char *dlogFilePath, uint32_t dataOffset, uint16_t numYAxes);
+    void addData(uint32_t filePosition, const uint8_t *data, uint32_t size);
+    bool finish();
+    void abort();
+
+private:
+    File m_file;
+    Header m_header;
+    uint8_t m_row[MAX_NUM_Y_AXES * sizeof(float)];
+    uint32_t m_rowSize;
+    uint32_t m_rowBytes;
+    Entry m_entry[MAX_NUM_Y_AXES];
+    uint32_t m_entrySamples;
+    Entry m_buffer[NUM_BUFFER_ENTRIES];
+    uint32_t m_numBufferedRows;
+    bool m_error;
+
+    void addRow();
+    void writeEntry();
+    void flushEntries();
+    bool buildUpperLevels();
+};
+
+// Opens index file and checks that it matches dlog file
+bool openIndex(const char *dlogFilePath, uint32_t dataOffset, uint16_t numYAxes, uint32_t numSamples, File &file, Header &header);
+
+// Reads dlog file header, file position must be at the start of the file
+bool readDlogHeader(File &file, uint32_t &dataOffset, uint16_t &numYAxes);
+
+// Rebuilds index for already existing dlog file (e.g. recorded by the older firmware)
+bool rebuild(const char *dlogFilePath, int *err);
+
+// Finds the level with the largest decimation which is not greater than numSamplesPerValue,
+// returns -1 if raw data should be used.
+int findLevel(const Header &header, uint32_t numSamplesPerValue);
+
+// Reads min/max of the samples [startSample, startSample + numSamples) for all Y axes, using the entries
+// of the given and lower levels and the raw samples from the dlog file for the ends not covered by any entry.
+bool readMinMax(File &indexFile, File &dlogFile, const Header &header, int level, uint32_t startSample, uint32_t numSamples, Entry *result);
+
+} // namespace dlog_index
+} // namespace psu
+} // namespace eez
@@ -20,6 +20,7 @@
 
 #include <eez/index.h>
 #include <eez/system.h>
+#include <eez/profiler.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel_dispatcher.h>
@@ -27,7 +28,9 @@
 #include <eez/modules/psu/sd_card.h>
 #include <eez/modules/psu/io_pins.h>
 #include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/dlog_index.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/debug.h>
 
 #include <eez/modules/psu/scpi/psu.h>
 
@@ -45,6 +48,8 @@ namespace psu {
 namespace dlog_record {
 
 #define CHUNK_SIZE 4096
+#define CONF_WRITE_BATCH_SIZE (8 * CHUNK_SIZE)
+#define INDEX_CHUNK_SIZE 512
 
 #define CONF_DLOG_SYNC_FILE_TIME_MS 10000
 
@@ -116,7 +121,11 @@ uint32_t g_fileLength;
 static unsigned int g_bufferIndex;
 
 static unsigned int g_lastSavedBufferIndex;
-static uint32_t g_lastSavedBufferTickCount;
+static uint32_t g_lastSyncTickCount;
+
+static File g_file;
+
+static dlog_index::Builder g_indexBuilder;
 
 osMutexId(g_mutexId);
 osMutexDef(g_mutex);
@@ -158,105 +167,226 @@ static int fileTruncate() {
     return SCPI_RES_OK;
 }
 
-void getNextWriteBuffer(const uint8_t *&buffer, uint32_t &bufferSize, bool flush) {
-    static uint8_t g_saveBuffer[CHUNK_SIZE];
+static bool fileOpen() {
+    if (g_file.isOpen()) {
+        return true;
+    }
+
+    if (!g_file.open(g_recording.parameters.filePath, FILE_OPEN_ALWAYS | FILE_WRITE)) {
+        return false;
+    }
+
+    if (!g_file.seek(g_lastSavedBufferIndex)) {
+        g_file.close();
+        return false;
+    }
+
+    return true;
+}
 
+static void fileClose() {
+    if (g_file.isOpen()) {
+        g_file.close();
+    }
+}
+
+static const float *getNaNBuffer() {
+    static float g_nanBuffer[CHUNK_SIZE / 4];
+    if (!isNaN(g_nanBuffer[0])) {
+        for (unsigned i = 0; i < CHUNK_SIZE / 4; i++) {
+            g_nanBuffer[i] = NAN;
+        }
+    }
+    return g_nanBuffer;
+}
+
+// Returns the next contiguous region that should be written to the file.
+// If recording is running ahead of the writer (ring buffer overrun) then
+// the lost samples are replaced with NaN's.
+static void getNextWriteBuffer(const uint8_t *&buffer, uint32_t &bufferSize, bool flush, bool &sync) {
     buffer = nullptr;
     bufferSize = 0;
+    sync = false;
 
     if (osMutexWait(g_mutexId, 5) == osOK) {
-        int32_t timeDiff = millis() - g_lastSavedBufferTickCount;
+        int32_t timeDiff = millis() - g_lastSyncTickCount;
         uint32_t alignedBufferIndex = (g_bufferIndex / 4) * 4;
         uint32_t indexDiff = alignedBufferIndex - g_lastSavedBufferIndex;
-        if (indexDiff > 0 && (flush || timeDiff >= CONF_DLOG_SYNC_FILE_TIME_MS || indexDiff >= CHUNK_SIZE)) {
-            bufferSize = MIN(indexDiff, CHUNK_SIZE);
-            buffer = g_saveBuffer;
 
-            int32_t i = g_bufferIndex - (g_lastSavedBufferIndex + DLOG_RECORD_BUFFER_SIZE);
+        sync = timeDiff >= CONF_DLOG_SYNC_FILE_TIME_MS;
+
+        if (indexDiff > 0 && (flush || sync || indexDiff >= CHUNK_SIZE)) {
+            int32_t lost = g_bufferIndex - (g_lastSavedBufferIndex + DLOG_RECORD_BUFFER_SIZE);
+            if (lost > 0) {
+                bufferSize = MIN((uint32_t)lost, CHUNK_SIZE);
+                bufferSize = ((bufferSize + 3) / 4) * 4;
+                buffer = (const uint8_t *)getNaNBuffer();
 
-            if (i <= 0) {
-                i = 0;
+#ifdef DEBUG
+                debug::g_dlogOverrunCounter.inc();
+#endif
             } else {
-                if ((uint32_t)i > bufferSize) {
-                    i = bufferSize;
-                }
-                
-                for (int j = 0; j < i / 4; j++) {
-                    ((float *)g_saveBuffer)[j] = NAN;
+                // write directly from the ring buffer, up to the end of the buffer
+                uint32_t tail = g_lastSavedBufferIndex % DLOG_RECORD_BUFFER_SIZE;
+                bufferSize = MIN(indexDiff, CONF_WRITE_BATCH_SIZE);
+                bufferSize = MIN(bufferSize, DLOG_RECORD_BUFFER_SIZE - tail);
+
+                // keep file writes aligned to the CHUNK_SIZE boundaries
+                uint32_t end = g_lastSavedBufferIndex + bufferSize;
+                if (end % CHUNK_SIZE != 0 && (end / CHUNK_SIZE) * CHUNK_SIZE > g_lastSavedBufferIndex) {
+                    bufferSize = (end / CHUNK_SIZE) * CHUNK_SIZE - g_lastSavedBufferIndex;
                 }
 
-                //DebugTrace("NaN's: %d\n", i);
+                buffer = DLOG_RECORD_BUFFER + tail;
             }
 
-            if ((uint32_t)i < bufferSize) {
-                uint32_t tail = (g_lastSavedBufferIndex + i) % DLOG_RECORD_BUFFER_SIZE;
-                uint32_t head = (g_lastSavedBufferIndex + bufferSize) % DLOG_RECORD_BUFFER_SIZE;
-                if (tail < head) {
-                    memcpy(g_saveBuffer + i, DLOG_RECORD_BUFFER + tail, head - tail);
-                } else {
-                    uint32_t n = DLOG_RECORD_BUFFER_SIZE - tail;
-                    memcpy(g_saveBuffer, DLOG_RECORD_BUFFER + tail, n);
-                    if (head > 0) {
-                        memcpy(g_saveBuffer + n, DLOG_RECORD_BUFFER, head);
-                        //DebugTrace("boundary: %d\n", n);
-                    }
-                }
-            } 
-            
-            // for (uint32_t i = 0; i < bufferSize; i++) {
-            //     g_saveBuffer[i] = g_lastSavedBufferIndex + i + DLOG_RECORD_BUFFER_SIZE >= g_bufferIndex ? DLOG_RECORD_BUFFER[(g_lastSavedBufferIndex + i) % DLOG_RECORD_BUFFER_SIZE] : 0;
-            // }
+            if (flush && bufferSize == indexDiff) {
+                sync = true;
+            }
         }
+
         osMutexRelease(g_mutexId);
     }
 }
 
-// returns true if there is more data to write
+// Checks if the recording overwrote ring buffer region [from, to) while it was written to the file.
+// Returns the number of bytes (from the start of the region) that are no longer valid.
+static uint32_t getNumOverwrittenBytes(uint32_t from, uint32_t to) {
+    uint32_t overwritten = 0;
+
+    if (osMutexWait(g_mutexId, 5) == osOK) {
+        int32_t diff = g_bufferIndex - (from + DLOG_RECORD_BUFFER_SIZE);
+        if (diff > 0) {
+            overwritten = MIN((uint32_t)diff, to - from);
+            overwritten = ((overwritten + 3) / 4) * 4;
+        }
+        osMutexRelease(g_mutexId);
+    }
+
+    return overwritten;
+}
+
+// Replaces already written region [position, position + size) with NaN's
+// and moves file position back to the endPosition.
+static int overwriteWithNaNs(uint32_t position, uint32_t size, uint32_t endPosition) {
+    if (!g_file.seek(position)) {
+        return event_queue::EVENT_ERROR_DLOG_SEEK_ERROR;
+    }
+
+    while (size > 0) {
+        uint32_t n = MIN(size, CHUNK_SIZE);
+        if (g_file.write(getNaNBuffer(), n) != n) {
+            return event_queue::EVENT_ERROR_DLOG_WRITE_ERROR;
+        }
+        g_indexBuilder.addData(position, (const uint8_t *)getNaNBuffer(), n);
+        position += n;
+        size -= n;
+    }
+
+    if (!g_file.seek(endPosition)) {
+        return event_queue::EVENT_ERROR_DLOG_SEEK_ERROR;
+    }
+
+    return 0;
+}
+
+// Adds [position, position + size) region of the ring buffer, which is already written to the file,
+// to the index. Region is copied in chunks and checked for the overrun after every copy, so the index
+// gets exactly the bytes which were written to the file. Returns the number of bytes at the start
+// of the region which were overwritten before they were added to the index, these are added as NaN's
+// and must be replaced with NaN's in the file too.
+static uint32_t addRingBufferDataToIndex(uint32_t position, const uint8_t *buffer, uint32_t size) {
+    static uint8_t g_indexChunk[INDEX_CHUNK_SIZE];
+
+    uint32_t lost = 0;
+
+    for (uint32_t offset = 0; offset < size; ) {
+        uint32_t n = MIN(size - offset, INDEX_CHUNK_SIZE);
+        memcpy(g_indexChunk, buffer + offset, n);
+
+        lost = MIN(getNumOverwrittenBytes(position, position + size), size);
+
+        uint32_t lostInChunk = 0;
+        if (lost > offset) {
+            lostInChunk = MIN(lost - offset, n);
+            g_indexBuilder.addData(position + offset, (const uint8_t *)getNaNBuffer(), lostInChunk);
+        }
+
+        g_indexBuilder.addData(position + offset + lostInChunk, g_indexChunk + lostInChunk, n - lostInChunk);
+
+        offset += n;
+    }
+
+    return lost;
+}
+
 void fileWrite(bool flush) {
     if (g_state != STATE_EXECUTING) {
         return;
     }
 
+    PROFILER_ZONE(DLOG_FILE_WRITE);
+
     uint32_t timeout = millis() + CONF_WRITE_TIMEOUT_MS;
     while (millis() < timeout) {
         const uint8_t *buffer = nullptr;
         uint32_t bufferSize = 0;
-        getNextWriteBuffer(buffer, bufferSize, flush);
+        bool sync;
+        getNextWriteBuffer(buffer, bufferSize, flush, sync);
         if (!buffer) {
             return;
         }
 
-        int err = 0;
+#ifdef DEBUG
+        debug::g_dlogWriteDuration.start();
+#endif
 
-        File file;
-        if (file.open(g_recording.parameters.filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
-            if (file.seek(g_lastSavedBufferIndex)) {
-                size_t written = file.write(buffer, bufferSize);
+        int err = 0;
 
-                if (written != bufferSize) {
-                    err = event_queue::EVENT_ERROR_DLOG_WRITE_ERROR;
+        if (fileOpen()) {
+            size_t written = g_file.write(buffer, bufferSize);
+            if (written == bufferSize) {
+                if (buffer >= DLOG_RECORD_BUFFER && buffer < DLOG_RECORD_BUFFER + DLOG_RECORD_BUFFER_SIZE) {
+                    uint32_t overwritten = addRingBufferDataToIndex(g_lastSavedBufferIndex, buffer, bufferSize);
+                    if (overwritten > 0) {
+                        // data was overwritten while it was written or added to the index,
+                        // replace it with NaN's, index already has NaN's there
+                        err = overwriteWithNaNs(g_lastSavedBufferIndex, overwritten, g_lastSavedBufferIndex + bufferSize);
+
+#ifdef DEBUG
+                        debug::g_dlogOverrunCounter.inc();
+#endif
+                    }
+                } else {
+                    g_indexBuilder.addData(g_lastSavedBufferIndex, buffer, bufferSize);
                 }
+            } else {
+                err = event_queue::EVENT_ERROR_DLOG_WRITE_ERROR;
+            }
 
-                if (!file.close()) {
+            if (!err && sync) {
+                if (g_file.sync()) {
+                    g_lastSyncTickCount = millis();
+                } else {
                     err = event_queue::EVENT_ERROR_DLOG_WRITE_ERROR;
                 }
-
-                if (!err) {
-                    g_lastSavedBufferIndex += bufferSize;
-                    g_lastSavedBufferTickCount = millis();
-                }
-            } else {
-                err = event_queue::EVENT_ERROR_DLOG_SEEK_ERROR;
             }
         } else {
             err = event_queue::EVENT_ERROR_DLOG_FILE_REOPEN_ERROR;
         }
 
+#ifdef DEBUG
+        debug::g_dlogWriteDuration.finish();
+#endif
+
         if (err) {
             //DebugTrace("write error\n");
+            fileClose();
             sd_card::reinitialize();
             return;
         }
+
+        g_lastSavedBufferIndex += bufferSize;
     }
 }
 
@@ -574,7 +704,9 @@ static int doStartImmediately() {
 
     writeFileHeaderAndMetaFields();
 
-    g_lastSavedBufferTickCount = millis();
+    g_indexBuilder.begin(g_recording.parameters.filePath, g_recording.dataOffset, g_recording.parameters.numYAxes);
+
+    g_lastSyncTickCount = millis();
 
     setState(STATE_EXECUTING);
 
@@ -617,7 +749,12 @@ static void resetParameters() {
 static void doFinish(bool afterError) {
     if (!afterError) {
         flushData();
+        fileClose();
+        g_indexBuilder.finish();
         onSdCardFileChangeHook(g_parameters.filePath);
+    } else {
+        fileClose();
+        g_indexBuilder.abort();
     }
     resetParameters();
     setState(STATE_IDLE);
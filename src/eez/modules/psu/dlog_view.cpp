@@ -27,6 +27,7 @@
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/dlog_view.h>
 #include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/dlog_index.h>
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/serial_psu.h>
 #include <eez/modules/psu/gui/psu.h>
@@ -77,6 +78,9 @@ static float g_loadScale;
 static bool g_refreshed;
 static bool g_wasExecuting;
 
+static bool g_hasIndex;
+static dlog_index::Header g_indexHeader;
+
 State getState() {
     if (g_showLatest) {
         if (g_wasExecuting) {
@@ -137,11 +141,67 @@ void invalidateAllBlocks() {
     }
 }
 
+static void loadBlockFromIndex(int level, unsigned numSamplesPerValue) {
+    File file;
+    if (dlog_index::openIndex(g_filePath, g_recording.dataOffset, g_recording.parameters.numYAxes, g_recording.numSamples, file, g_indexHeader)) {
+        // raw samples at both ends of the range not covered by the index entries are read from the dlog file
+        File dlogFile;
+        if (dlogFile.open(g_filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+            auto numElementsPerRow = getNumElementsPerRow();
+
+            BlockElement *blockElements = getCacheBlock(g_blockIndexToLoad);
+
+            dlog_index::Entry entries[dlog_index::MAX_NUM_Y_AXES];
+
+            uint32_t i = g_cacheBlocks[g_blockIndexToLoad].loadedValues;
+            while (i < NUM_ELEMENTS_PER_BLOCKS) {
+                if (g_interruptLoading) {
+                    break;
+                }
+
+                auto offset = (uint32_t)roundf((g_blockIndexToLoad * NUM_ELEMENTS_PER_BLOCKS + i) / numElementsPerRow * g_loadScale * g_recording.parameters.numYAxes);
+                uint32_t startSample = (offset + g_recording.parameters.numYAxes - 1) / g_recording.parameters.numYAxes;
+
+                if (!dlog_index::readMinMax(file, dlogFile, g_indexHeader, level, startSample, numSamplesPerValue, entries)) {
+                    break;
+                }
+
+                for (unsigned k = 0; k < numElementsPerRow; k++) {
+                    BlockElement *blockElement = blockElements + i++;
+                    blockElement->min = entries[k].min;
+                    blockElement->max = entries[k].max;
+                }
+            }
+
+            g_cacheBlocks[g_blockIndexToLoad].loadedValues = i < NUM_ELEMENTS_PER_BLOCKS && !g_interruptLoading ? NUM_ELEMENTS_PER_BLOCKS : i;
+            dlogFile.close();
+        }
+
+        file.close();
+    } else {
+        // index file is gone, fallback to raw data
+        g_hasIndex = false;
+    }
+
+    g_isLoading = false;
+    g_refreshed = true;
+}
+
 void loadBlock() {
     static const int NUM_VALUES_ROWS = 16;
     float values[18 * NUM_VALUES_ROWS];
 
     auto numSamplesPerValue = (unsigned)round(g_loadScale);
+
+    if (g_hasIndex && numSamplesPerValue > 0) {
+        // use min/max pyramid from the index file if there is a level that fits requested scale
+        int level = dlog_index::findLevel(g_indexHeader, numSamplesPerValue);
+        if (level >= 0) {
+            loadBlockFromIndex(level, numSamplesPerValue);
+            return;
+        }
+    }
+
     if (numSamplesPerValue > 0) {
         File file;
         if (file.open(g_filePath, FILE_OPEN_EXISTING | FILE_READ)) {
@@ -737,6 +797,12 @@ bool openFile(const char *filePath, int *err) {
                     g_recording.getValue = getValue;
                     g_isLoading = false;
 
+                    File indexFile;
+                    g_hasIndex = dlog_index::openIndex(filePath != nullptr ? filePath : g_filePath, g_recording.dataOffset, g_recording.parameters.numYAxes, g_recording.numSamples, indexFile, g_indexHeader);
+                    if (g_hasIndex) {
+                        indexFile.close();
+                    }
+
                     if (isMulipleValuesOverlayHeuristic(g_recording)) {
                         autoScale(g_recording);
                     }
@@ -798,8 +864,8 @@ void uploadFile() {
 #endif
 
 #if OPTION_ETHERNET
-    if (!context && psu::ethernet::isConnected()) {
-        context = &psu::ethernet::g_scpiContext;
+    if (!context) {
+        context = psu::ethernet::getConnectedScpiContext();
     }
 #endif
 
@@ -21,6 +21,7 @@
 #include <stdio.h>
 
 #include <eez/firmware.h>
+#include <eez/scpi/scpi.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/event_queue.h>
@@ -32,6 +33,8 @@
 
 #define CONF_CHECK_DHCP_LEASE_SEC 60
 
+#define OUTPUT_BUFFER_SIZE 1024
+
 namespace eez {
 
 using namespace scpi;
@@ -42,25 +45,56 @@ using namespace scpi;
 
 namespace ethernet {
 
+using eez::mcu::ethernet::MAX_NUM_CLIENTS;
+
 TestResult g_testResult = TEST_FAILED;
 
-static bool g_isConnected = false;
+static bool g_isConnected[MAX_NUM_CLIENTS];
+
+// While input from the client is parsed, responses are collected in the output buffer
+// and sent all at once when parsing is finished (or when the buffer is full).
+static int g_inputClient = -1;
+static char g_outputBuffer[OUTPUT_BUFFER_SIZE];
+static uint32_t g_outputBufferLength;
 
 ////////////////////////////////////////////////////////////////////////////////
 
-size_t ethernet_client_write(const char *data, size_t len) {
-    size_t size = eez::mcu::ethernet::writeBuffer(data, len);
-    return size;
+static int getClient(scpi_t *context) {
+    for (int client = 0; client < MAX_NUM_CLIENTS; client++) {
+        if (context == &g_scpiContexts[client]) {
+            return client;
+        }
+    }
+    return 0;
+}
+
+static void flushOutputBuffer() {
+    if (g_outputBufferLength > 0) {
+        eez::mcu::ethernet::writeBuffer(g_inputClient, g_outputBuffer, g_outputBufferLength);
+        g_outputBufferLength = 0;
+    }
 }
 
-size_t ethernet_client_write_str(const char *str) {
-    return ethernet_client_write(str, strlen(str));
+size_t ethernet_client_write(int client, const char *data, size_t len) {
+    if (client == g_inputClient && isLowPriorityThread()) {
+        if (g_outputBufferLength + len > OUTPUT_BUFFER_SIZE) {
+            flushOutputBuffer();
+        }
+
+        if (len <= OUTPUT_BUFFER_SIZE) {
+            memcpy(g_outputBuffer + g_outputBufferLength, data, len);
+            g_outputBufferLength += len;
+            return len;
+        }
+    }
+
+    return eez::mcu::ethernet::writeBuffer(client, data, len);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
-    return ethernet_client_write(data, len);
+    return ethernet_client_write(getClient(context), data, len);
 }
 
 scpi_result_t SCPI_Flush(scpi_t *context) {
@@ -72,7 +106,7 @@ int SCPI_Error(scpi_t *context, int_fast16_t err) {
         char errorOutputBuffer[256];
         sprintf(errorOutputBuffer, "**ERROR: %d,\"%s\"\r\n", (int16_t)err,
                 SCPI_ErrorTranslate(err));
-        ethernet_client_write(errorOutputBuffer, strlen(errorOutputBuffer));
+        ethernet_client_write(getClient(context), errorOutputBuffer, strlen(errorOutputBuffer));
 
         if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
             scpi::onBufferOverrun(*context);
@@ -90,7 +124,7 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
         sprintf(outputBuffer, "**CTRL %02x: 0x%X (%d)\r\n", ctrl, val, val);
     }
 
-    ethernet_client_write(outputBuffer, strlen(outputBuffer));
+    ethernet_client_write(getClient(context), outputBuffer, strlen(outputBuffer));
 
     return SCPI_RES_OK;
 }
@@ -98,29 +132,34 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
 scpi_result_t SCPI_Reset(scpi_t *context) {
     char errorOutputBuffer[256];
     strcpy(errorOutputBuffer, "**Reset\r\n");
-    ethernet_client_write(errorOutputBuffer, strlen(errorOutputBuffer));
+    ethernet_client_write(getClient(context), errorOutputBuffer, strlen(errorOutputBuffer));
+
+    eez::scpi::resetContext(context);
 
-    return reset() ? SCPI_RES_OK : SCPI_RES_ERR;
+    return reset(false) ? SCPI_RES_OK : SCPI_RES_ERR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
-static scpi_psu_t g_scpiPsuContext = { g_scpiPsuRegs };
+static scpi_reg_val_t g_scpiPsuRegs[MAX_NUM_CLIENTS][SCPI_PSU_REG_COUNT];
+static scpi_psu_t g_scpiPsuContexts[MAX_NUM_CLIENTS];
 
 static scpi_interface_t g_scpiInterface = {
     SCPI_Error, SCPI_Write, SCPI_Control, SCPI_Flush, SCPI_Reset,
 };
 
-static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
-static scpi_error_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+static char g_scpiInputBuffers[MAX_NUM_CLIENTS][SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static scpi_error_t g_errorQueueData[MAX_NUM_CLIENTS][SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
 
-scpi_t g_scpiContext;
+scpi_t g_scpiContexts[MAX_NUM_CLIENTS];
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void init() {
-    scpi::init(g_scpiContext, g_scpiPsuContext, &g_scpiInterface, g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    for (int client = 0; client < MAX_NUM_CLIENTS; client++) {
+        g_scpiPsuContexts[client].registers = g_scpiPsuRegs[client];
+        scpi::init(g_scpiContexts[client], g_scpiPsuContexts[client], &g_scpiInterface, g_scpiInputBuffers[client], SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData[client], SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    }
 
     if (!persist_conf::isEthernetEnabled()) {
         g_testResult = TEST_SKIPPED;
@@ -158,17 +197,26 @@ void onQueueMessage(uint32_t type, uint32_t param) {
         eez::mcu::ethernet::beginServer(persist_conf::devConf.ethernetScpiPort);
         //DebugTrace("Listening on port %d", (int)persist_conf::devConf.ethernetScpiPort);
     } else if (type == ETHERNET_CLIENT_CONNECTED) {
-        g_isConnected = true;
-        scpi::emptyBuffer(g_scpiContext);
+        int client = param;
+        g_isConnected[client] = true;
+        scpi::emptyBuffer(g_scpiContexts[client]);
     } else if (type == ETHERNET_CLIENT_DISCONNECTED) {
-        g_isConnected = false;
+        int client = param;
+        g_isConnected[client] = false;
+        eez::mcu::ethernet::disconnectClient(client);
     } else if (type == ETHERNET_INPUT_AVAILABLE) {
-        char *buffer;
-        uint32_t length;
-        eez::mcu::ethernet::getInputBuffer(param, &buffer, &length);
+        int client = param;
+        char *buffer = nullptr;
+        uint32_t length = 0;
+        eez::mcu::ethernet::getInputBuffer(client, &buffer, &length);
         if (buffer && length) {
-            input(g_scpiContext, (const char *)buffer, length);
-            eez::mcu::ethernet::releaseInputBuffer();
+            // parse directly from the receive buffer
+            g_inputClient = client;
+            inputInPlace(g_scpiContexts[client], buffer, length);
+            flushOutputBuffer();
+            g_inputClient = -1;
+
+            eez::mcu::ethernet::releaseInputBuffer(client);
         }
     }
 }
@@ -178,7 +226,21 @@ uint32_t getIpAddress() {
 }
 
 bool isConnected() {
-    return g_isConnected;
+    for (int client = 0; client < MAX_NUM_CLIENTS; client++) {
+        if (g_isConnected[client]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+scpi_t *getConnectedScpiContext() {
+    for (int client = 0; client < MAX_NUM_CLIENTS; client++) {
+        if (g_isConnected[client]) {
+            return &g_scpiContexts[client];
+        }
+    }
+    return nullptr;
 }
 
 void update() {
@@ -193,9 +255,11 @@ void update() {
             eez::mcu::ethernet::beginServer(persist_conf::devConf.ethernetScpiPort);
         }
     } else {
-        if (g_isConnected) {
-            eez::mcu::ethernet::disconnectClient();
-            g_isConnected = false;
+        for (int client = 0; client < MAX_NUM_CLIENTS; client++) {
+            if (g_isConnected[client]) {
+                eez::mcu::ethernet::disconnectClient(client);
+                g_isConnected[client] = false;
+            }
         }
 
         eez::mcu::ethernet::endServer();
@@ -20,12 +20,14 @@
 
 #include <eez/modules/psu/scpi/psu.h>
 
+#include <eez/modules/mcu/ethernet.h>
+
 namespace eez {
 namespace psu {
 namespace ethernet {
 
 extern TestResult g_testResult;
-extern scpi_t g_scpiContext;
+extern scpi_t g_scpiContexts[mcu::ethernet::MAX_NUM_CLIENTS];
 
 void init();
 bool test();
@@ -34,8 +36,12 @@ void onQueueMessage(uint32_t type, uint32_t param);
 
 uint32_t getIpAddress();
 
+// returns true if at least one client is connected
 bool isConnected();
 
+// returns SCPI context of the first connected client or nullptr
+scpi_t *getConnectedScpiContext();
+
 // this function is called when ethernet settings are changed,
 // and it should reconnect to the ethernet with these settings
 void update();
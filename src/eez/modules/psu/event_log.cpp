@@ -0,0 +1,817 @@
+/*
+* EEZ PSU Firmware
+* Copyright (C) 2020-present, Envox d.o.o.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <eez/system.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/datetime.h>
+#include <eez/modules/psu/event_log.h>
+#include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/sd_card.h>
+
+#include <eez/modules/psu/scpi/psu.h>
+
+namespace eez {
+namespace psu {
+namespace event_log {
+
+using namespace event_queue;
+
+static const char *RECORDS_FILE_NAME = "events.bin";
+static const char *MESSAGES_FILE_NAME = "messages.bin";
+static const char *INDEX_FILE_NAMES[] = { "events2.idx", "events3.idx", "events4.idx" };
+
+// files of the older firmware
+static const char *TEXT_LOG_FILE_NAME = "log.txt";
+static const char *TEXT_LOG_INDEX_FILE_NAMES[] = { "index1", "index2", "index3", "index4" };
+
+static const int EXPORT_CHUNK_NUM_RECORDS = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool readMessage(File &file, uint32_t messageOffset, char *message, size_t messageSize) {
+    uint16_t messageLength;
+    if (!file.seek(messageOffset) || file.read(&messageLength, sizeof(uint16_t)) != sizeof(uint16_t)) {
+        return false;
+    }
+
+    if (messageLength > messageSize - 1) {
+        messageLength = messageSize - 1;
+    }
+
+    if (file.read(message, messageLength) != messageLength) {
+        return false;
+    }
+
+    message[messageLength] = 0;
+    return true;
+}
+
+static bool getEventText(File &messagesFile, const Record &record, char *message, size_t messageSize) {
+    if (record.messageOffset != NO_MESSAGE) {
+        return readMessage(messagesFile, record.messageOffset, message, messageSize);
+    }
+
+    const char *eventMessage = event_queue::getEventMessage(record.eventId);
+    strncpy(message, eventMessage ? eventMessage : "", messageSize - 1);
+    message[messageSize - 1] = 0;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Store::open(const char *dirPath) {
+    close();
+
+    strncpy(m_dirPath, dirPath, MAX_PATH_LENGTH);
+    m_dirPath[MAX_PATH_LENGTH] = 0;
+
+    memset(m_numEvents, 0, sizeof(m_numEvents));
+    m_messagesSize = 0;
+    m_numBufferedRecords = 0;
+    memset(m_numBufferedIndexes, 0, sizeof(m_numBufferedIndexes));
+    m_bufferedMessagesSize = 0;
+    resetPageCache();
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    getFilePath(RECORDS_FILE_NAME, filePath);
+
+    if (!sd_card::exists(filePath, nullptr)) {
+        if (!create()) {
+            return false;
+        }
+
+        m_isOpen = true;
+
+        char textLogFilePath[MAX_PATH_LENGTH + 1];
+        getFilePath(TEXT_LOG_FILE_NAME, textLogFilePath);
+        if (sd_card::exists(textLogFilePath, nullptr)) {
+            migrate(textLogFilePath);
+        }
+
+        return true;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ | FILE_WRITE)) {
+        return false;
+    }
+
+    Header header;
+    bool isValid = file.read(&header, sizeof(Header)) == sizeof(Header) &&
+        header.magic == MAGIC && header.version == VERSION && header.recordSize == sizeof(Record);
+
+    uint32_t numRecords = 0;
+    if (isValid) {
+        uint32_t fileSize = file.size();
+        numRecords = (fileSize - sizeof(Header)) / sizeof(Record);
+
+        // drop the last record if it was not completely written
+        uint32_t recordsEnd = sizeof(Header) + numRecords * sizeof(Record);
+        if (recordsEnd != fileSize) {
+            file.truncate(recordsEnd);
+        }
+    }
+
+    file.close();
+
+    if (!isValid) {
+        if (!create()) {
+            return false;
+        }
+        m_isOpen = true;
+        return true;
+    }
+
+    m_numEvents[EVENT_TYPE_DEBUG] = numRecords;
+
+    for (int filter = EVENT_TYPE_INFO; filter <= EVENT_TYPE_ERROR; filter++) {
+        getIndexFilePath(filter, filePath);
+        m_numEvents[filter] = repairIndexFile(filePath, numRecords);
+    }
+
+    getFilePath(MESSAGES_FILE_NAME, filePath);
+    m_messagesSize = getFileSize(filePath);
+
+    m_isOpen = true;
+    return true;
+}
+
+void Store::close() {
+    if (m_isOpen) {
+        flush();
+        m_isOpen = false;
+    }
+}
+
+bool Store::append(uint32_t dateTime, int16_t eventId, int eventType, const char *message) {
+    if (!m_isOpen) {
+        return false;
+    }
+
+    if (eventType < EVENT_TYPE_DEBUG || eventType > EVENT_TYPE_ERROR) {
+        return false;
+    }
+
+    if (
+        m_numBufferedRecords == WRITE_BUFFER_NUM_RECORDS ||
+        (message && m_bufferedMessagesSize + sizeof(uint16_t) + MAX_MESSAGE_LENGTH > WRITE_BUFFER_MESSAGES_SIZE)
+    ) {
+        if (!flush()) {
+            return false;
+        }
+    }
+
+    Record &record = m_bufferedRecords[m_numBufferedRecords++];
+    record.dateTime = dateTime;
+    record.eventId = eventId;
+    record.eventType = (uint8_t)eventType;
+    record.channelIndex = getEventChannelIndex(eventId);
+
+    if (message) {
+        size_t messageLength = strlen(message);
+        if (messageLength > MAX_MESSAGE_LENGTH) {
+            messageLength = MAX_MESSAGE_LENGTH;
+        }
+
+        uint16_t length = (uint16_t)messageLength;
+        memcpy(m_bufferedMessages + m_bufferedMessagesSize, &length, sizeof(uint16_t));
+        memcpy(m_bufferedMessages + m_bufferedMessagesSize + sizeof(uint16_t), message, messageLength);
+        m_bufferedMessagesSize += sizeof(uint16_t) + messageLength;
+
+        record.messageOffset = m_messagesSize;
+        m_messagesSize += sizeof(uint16_t) + messageLength;
+    } else {
+        record.messageOffset = NO_MESSAGE;
+    }
+
+    uint32_t recordIndex = m_numEvents[EVENT_TYPE_DEBUG]++;
+
+    for (int filter = EVENT_TYPE_INFO; filter <= eventType; filter++) {
+        int i = filter - EVENT_TYPE_INFO;
+        m_bufferedIndexes[i][m_numBufferedIndexes[i]++] = recordIndex;
+        m_numEvents[filter]++;
+    }
+
+    return true;
+}
+
+bool Store::flush() {
+    if (!m_isOpen) {
+        return false;
+    }
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    bool result = true;
+
+    // messages are written first and indexes last,
+    // so interrupted flush never leaves a reference to unwritten data
+    if (m_bufferedMessagesSize > 0) {
+        getFilePath(MESSAGES_FILE_NAME, filePath);
+        result = appendToFile(filePath, m_bufferedMessages, m_bufferedMessagesSize);
+        m_bufferedMessagesSize = 0;
+    }
+
+    if (m_numBufferedRecords > 0) {
+        getFilePath(RECORDS_FILE_NAME, filePath);
+        result = result && appendToFile(filePath, m_bufferedRecords, m_numBufferedRecords * sizeof(Record));
+        m_numBufferedRecords = 0;
+    }
+
+    for (int filter = EVENT_TYPE_INFO; filter <= EVENT_TYPE_ERROR; filter++) {
+        int i = filter - EVENT_TYPE_INFO;
+        if (m_numBufferedIndexes[i] > 0) {
+            getIndexFilePath(filter, filePath);
+            result = result && appendToFile(filePath, m_bufferedIndexes[i], m_numBufferedIndexes[i] * sizeof(uint32_t));
+            m_numBufferedIndexes[i] = 0;
+        }
+    }
+
+    if (!result) {
+        // counters are not valid anymore, reload them from the files
+        char dirPath[MAX_PATH_LENGTH + 1];
+        strcpy(dirPath, m_dirPath);
+        m_isOpen = false;
+        open(dirPath);
+    }
+
+    return result;
+}
+
+uint32_t Store::getNumEvents(int filter) {
+    if (filter < EVENT_TYPE_DEBUG || filter > EVENT_TYPE_ERROR) {
+        filter = EVENT_TYPE_DEBUG;
+    }
+    return m_isOpen ? m_numEvents[filter] : 0;
+}
+
+int Store::readPage(int filter, uint32_t fromPosition, int count, Record *records, uint32_t *recordIndexes) {
+    if (!m_isOpen) {
+        return 0;
+    }
+
+    if (filter < EVENT_TYPE_DEBUG || filter > EVENT_TYPE_ERROR) {
+        filter = EVENT_TYPE_DEBUG;
+    }
+
+    if (m_numBufferedRecords > 0 && !flush()) {
+        return 0;
+    }
+
+    uint32_t numEvents = m_numEvents[filter];
+    if (fromPosition >= numEvents) {
+        return 0;
+    }
+
+    if (count > MAX_PAGE_SIZE) {
+        count = MAX_PAGE_SIZE;
+    }
+    if (fromPosition + count > numEvents) {
+        count = numEvents - fromPosition;
+    }
+
+    // position 0 is the newest event, while the files are ordered from the oldest event
+    uint32_t firstIndex = numEvents - fromPosition - count;
+
+    // events are only appended, so once read page stays valid until the store is removed
+    PageCacheEntry *page = nullptr;
+    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
+        PageCacheEntry &entry = m_pageCache[i];
+        if (entry.count == count && entry.filter == filter && entry.firstIndex == firstIndex) {
+            page = &entry;
+            break;
+        }
+    }
+
+    if (!page) {
+        page = &m_pageCache[0];
+        for (int i = 1; i < PAGE_CACHE_SIZE; i++) {
+            if (m_pageCache[i].lastUsed < page->lastUsed) {
+                page = &m_pageCache[i];
+            }
+        }
+
+        page->count = 0;
+
+        char filePath[MAX_PATH_LENGTH + 1];
+
+        if (filter == EVENT_TYPE_DEBUG) {
+            for (int i = 0; i < count; i++) {
+                page->recordIndexes[i] = firstIndex + i;
+            }
+        } else {
+            getIndexFilePath(filter, filePath);
+            File indexFile;
+            if (!indexFile.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+                return 0;
+            }
+            size_t size = count * sizeof(uint32_t);
+            bool result = indexFile.seek(firstIndex * sizeof(uint32_t)) && indexFile.read(page->recordIndexes, size) == size;
+            indexFile.close();
+            if (!result) {
+                return 0;
+            }
+        }
+
+        getFilePath(RECORDS_FILE_NAME, filePath);
+        File recordsFile;
+        if (!recordsFile.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+            return 0;
+        }
+
+        bool result = true;
+        if (filter == EVENT_TYPE_DEBUG) {
+            size_t size = count * sizeof(Record);
+            result = recordsFile.seek(sizeof(Header) + firstIndex * sizeof(Record)) && recordsFile.read(page->records, size) == size;
+        } else {
+            for (int i = 0; result && i < count; i++) {
+                result = recordsFile.seek(sizeof(Header) + page->recordIndexes[i] * sizeof(Record)) &&
+                    recordsFile.read(&page->records[i], sizeof(Record)) == sizeof(Record);
+            }
+        }
+
+        recordsFile.close();
+
+        if (!result) {
+            return 0;
+        }
+
+        page->filter = (uint8_t)filter;
+        page->count = (uint8_t)count;
+        page->firstIndex = firstIndex;
+    }
+
+    page->lastUsed = ++m_pageCacheCounter;
+
+    for (int i = 0; i < count; i++) {
+        records[i] = page->records[count - 1 - i];
+        recordIndexes[i] = page->recordIndexes[count - 1 - i];
+    }
+
+    return count;
+}
+
+bool Store::readMessage(const Record &record, char *message, size_t messageSize) {
+    if (!m_isOpen || record.messageOffset == NO_MESSAGE) {
+        return false;
+    }
+
+    if (m_bufferedMessagesSize > 0 && !flush()) {
+        return false;
+    }
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    getFilePath(MESSAGES_FILE_NAME, filePath);
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    bool result = event_log::readMessage(file, record.messageOffset, message, messageSize);
+
+    file.close();
+
+    return result;
+}
+
+bool Store::exportText(const char *filePath, int *err) {
+    if (!m_isOpen || !flush()) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    char storeFilePath[MAX_PATH_LENGTH + 1];
+
+    getFilePath(RECORDS_FILE_NAME, storeFilePath);
+    File recordsFile;
+    if (!recordsFile.open(storeFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    // messages file doesn't exist if there is no debug trace
+    getFilePath(MESSAGES_FILE_NAME, storeFilePath);
+    File messagesFile;
+    messagesFile.open(storeFilePath, FILE_OPEN_EXISTING | FILE_READ);
+
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        recordsFile.close();
+        messagesFile.close();
+        if (err) {
+            *err = SCPI_ERROR_FILE_NAME_NOT_FOUND;
+        }
+        return false;
+    }
+
+    sd_card::BufferedFileWrite bufferedFile(file);
+
+    bool result = recordsFile.seek(sizeof(Header));
+
+    uint32_t numRecords = m_numEvents[EVENT_TYPE_DEBUG];
+    for (uint32_t recordIndex = 0; result && recordIndex < numRecords; ) {
+        Record records[EXPORT_CHUNK_NUM_RECORDS];
+
+        uint32_t numChunkRecords = numRecords - recordIndex;
+        if (numChunkRecords > EXPORT_CHUNK_NUM_RECORDS) {
+            numChunkRecords = EXPORT_CHUNK_NUM_RECORDS;
+        }
+
+        size_t size = numChunkRecords * sizeof(Record);
+        if (recordsFile.read(records, size) != size) {
+            result = false;
+            break;
+        }
+
+        for (uint32_t i = 0; result && i < numChunkRecords; i++) {
+            const Record &record = records[i];
+
+            int year, month, day, hour, minute, second;
+            datetime::breakTime(record.dateTime, year, month, day, hour, minute, second);
+
+            char line[32 + MAX_MESSAGE_LENGTH + 2];
+            int n = sprintf(line, "%04d-%02d-%02d %02d:%02d:%02d %s ", year, month, day, hour, minute, second,
+                event_queue::getEventTypeNameByType(record.eventType));
+
+            if (!getEventText(messagesFile, record, line + n, MAX_MESSAGE_LENGTH + 1)) {
+                line[n] = 0;
+            }
+            strcat(line, "\n");
+
+            result = bufferedFile.write((const uint8_t *)line, strlen(line));
+        }
+
+        recordIndex += numChunkRecords;
+    }
+
+    if (result) {
+        result = bufferedFile.flush();
+    }
+
+    file.close();
+    messagesFile.close();
+    recordsFile.close();
+
+    if (!result) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    onSdCardFileChangeHook(filePath);
+
+    return true;
+}
+
+void Store::remove() {
+    m_isOpen = false;
+
+    char filePath[MAX_PATH_LENGTH + 1];
+
+    getFilePath(RECORDS_FILE_NAME, filePath);
+    sd_card::deleteFile(filePath, nullptr);
+
+    getFilePath(MESSAGES_FILE_NAME, filePath);
+    sd_card::deleteFile(filePath, nullptr);
+
+    for (int filter = EVENT_TYPE_INFO; filter <= EVENT_TYPE_ERROR; filter++) {
+        getIndexFilePath(filter, filePath);
+        sd_card::deleteFile(filePath, nullptr);
+    }
+
+    memset(m_numEvents, 0, sizeof(m_numEvents));
+    m_messagesSize = 0;
+    m_numBufferedRecords = 0;
+    memset(m_numBufferedIndexes, 0, sizeof(m_numBufferedIndexes));
+    m_bufferedMessagesSize = 0;
+    resetPageCache();
+}
+
+void Store::getFilePath(const char *fileName, char *filePath) {
+    strcpy(filePath, m_dirPath);
+    strcat(filePath, PATH_SEPARATOR);
+    strcat(filePath, fileName);
+}
+
+void Store::getIndexFilePath(int filter, char *filePath) {
+    getFilePath(INDEX_FILE_NAMES[filter - EVENT_TYPE_INFO], filePath);
+}
+
+bool Store::create() {
+    char filePath[MAX_PATH_LENGTH + 1];
+
+    getFilePath(RECORDS_FILE_NAME, filePath);
+
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return false;
+    }
+
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.recordSize = sizeof(Record);
+
+    bool result = file.write(&header, sizeof(Header)) == sizeof(Header);
+
+    file.close();
+
+    if (!result) {
+        return false;
+    }
+
+    // remove files left from the previous store
+    getFilePath(MESSAGES_FILE_NAME, filePath);
+    sd_card::deleteFile(filePath, nullptr);
+
+    for (int filter = EVENT_TYPE_INFO; filter <= EVENT_TYPE_ERROR; filter++) {
+        getIndexFilePath(filter, filePath);
+        sd_card::deleteFile(filePath, nullptr);
+    }
+
+    return true;
+}
+
+bool Store::migrate(const char *textLogFilePath) {
+    File file;
+    if (!file.open(textLogFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    using namespace sd_card;
+    BufferedFileRead bufferedFile(file);
+
+    while (bufferedFile.available()) {
+        unsigned int year, month, day, hour, minute, second;
+        if (
+            !match(bufferedFile, year) || !match(bufferedFile, '-') ||
+            !match(bufferedFile, month) || !match(bufferedFile, '-') ||
+            !match(bufferedFile, day) ||
+            !match(bufferedFile, hour) || !match(bufferedFile, ':') ||
+            !match(bufferedFile, minute) || !match(bufferedFile, ':') ||
+            !match(bufferedFile, second)
+        ) {
+            skipUntilEOL(bufferedFile);
+            continue;
+        }
+
+        matchZeroOrMoreSpaces(bufferedFile);
+
+        char eventTypeStr[9];
+        if (!matchUntil(bufferedFile, ' ', eventTypeStr, sizeof(eventTypeStr) - 1)) {
+            break;
+        }
+
+        int eventType = EVENT_TYPE_NONE;
+        for (int i = EVENT_TYPE_DEBUG; i <= EVENT_TYPE_ERROR; i++) {
+            if (strcmp(eventTypeStr, event_queue::getEventTypeNameByType(i)) == 0) {
+                eventType = i;
+                break;
+            }
+        }
+
+        char message[MAX_MESSAGE_LENGTH + 1];
+        if (!matchUntil(bufferedFile, '\n', message, sizeof(message) - 1)) {
+            break;
+        }
+
+        if (eventType == EVENT_TYPE_NONE) {
+            continue;
+        }
+
+        uint32_t dateTime = datetime::makeTime(year, month, day, hour, minute, second);
+
+        // message text is kept only for the debug traces and for the events not known to this firmware
+        int16_t eventId = eventType == EVENT_TYPE_DEBUG ? EVENT_DEBUG_TRACE : event_queue::findEventId(eventType, message);
+
+        if (!append(dateTime, eventId, eventType, eventId == EVENT_DEBUG_TRACE || eventId == 0 ? message : nullptr)) {
+            break;
+        }
+    }
+
+    file.close();
+
+    bool result = flush();
+
+    if (result) {
+        char filePath[MAX_PATH_LENGTH + 1];
+        for (unsigned i = 0; i < sizeof(TEXT_LOG_INDEX_FILE_NAMES) / sizeof(const char *); i++) {
+            getFilePath(TEXT_LOG_INDEX_FILE_NAMES[i], filePath);
+            sd_card::deleteFile(filePath, nullptr);
+        }
+    }
+
+    return result;
+}
+
+uint32_t Store::getFileSize(const char *filePath) {
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return 0;
+    }
+    uint32_t size = file.size();
+    file.close();
+    return size;
+}
+
+// Drops the partially written last index and the indexes of the records that were
+// not written (or were dropped when the records file was opened) from the index file,
+// so the next appendToFile continues after the last valid index. Returns the number of indexes.
+uint32_t Store::repairIndexFile(const char *filePath, uint32_t numRecords) {
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ | FILE_WRITE)) {
+        return 0;
+    }
+
+    uint32_t fileSize = file.size();
+    uint32_t numIndexes = fileSize / sizeof(uint32_t);
+    if (numIndexes > numRecords) {
+        numIndexes = numRecords;
+    }
+
+    // indexes are in the increasing order
+    while (numIndexes > 0) {
+        uint32_t recordIndex;
+        if (!file.seek((numIndexes - 1) * sizeof(uint32_t)) || file.read(&recordIndex, sizeof(uint32_t)) != sizeof(uint32_t)) {
+            numIndexes = 0;
+            break;
+        }
+        if (recordIndex < numRecords) {
+            break;
+        }
+        numIndexes--;
+    }
+
+    if (numIndexes * sizeof(uint32_t) != fileSize) {
+        file.truncate(numIndexes * sizeof(uint32_t));
+    }
+
+    file.close();
+
+    return numIndexes;
+}
+
+bool Store::appendToFile(const char *filePath, const void *buffer, size_t size) {
+    File file;
+    if (!file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
+        return false;
+    }
+    bool result = file.write(buffer, size) == size;
+    file.close();
+    return result;
+}
+
+void Store::resetPageCache() {
+    for (int i = 0; i < PAGE_CACHE_SIZE; i++) {
+        m_pageCache[i].count = 0;
+        m_pageCache[i].lastUsed = 0;
+    }
+    m_pageCacheCounter = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t getEventChannelIndex(int16_t eventId) {
+    if (eventId == 0 || eventId == EVENT_DEBUG_TRACE) {
+        return NO_CHANNEL;
+    }
+
+    const char *message = event_queue::getEventMessage(eventId);
+    if (!message) {
+        return NO_CHANNEL;
+    }
+
+    // channel is mentioned in the message as "Ch<N>" or "CH<N>"
+    for (const char *p = message; *p; p++) {
+        if ((p == message || p[-1] == ' ') && p[0] == 'C' && (p[1] == 'h' || p[1] == 'H') && p[2] >= '1' && p[2] <= '9' && (p[3] < '0' || p[3] > '9')) {
+            return p[2] - '1';
+        }
+    }
+
+    return NO_CHANNEL;
+}
+
+bool benchmark(const char *dirPath, uint32_t numEvents, BenchmarkResult &result, int *err) {
+    static Store store;
+
+    memset(&result, 0, sizeof(result));
+
+    if (!sd_card::exists(dirPath, nullptr) && !sd_card::makeDir(dirPath, err)) {
+        return false;
+    }
+
+    // start from the empty store
+    if (!store.open(dirPath)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+    store.remove();
+    if (!store.open(dirPath)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    uint32_t dateTime = datetime::now() - numEvents;
+
+    uint32_t startTime = millis();
+
+    bool appendResult = true;
+    for (uint32_t i = 0; appendResult && i < numEvents; i++) {
+        // 5% debug traces, 5% errors, 15% warnings and 75% info events
+        int k = i % 20;
+        if (k == 0) {
+            char message[32];
+            sprintf(message, "Benchmark trace %u", (unsigned)i);
+            appendResult = store.append(dateTime + i, EVENT_DEBUG_TRACE, EVENT_TYPE_DEBUG, message);
+        } else if (k == 1) {
+            appendResult = store.append(dateTime + i, event_queue::EVENT_ERROR_CH1_OVP_TRIPPED + i % 2, EVENT_TYPE_ERROR, nullptr);
+        } else if (k < 5) {
+            appendResult = store.append(dateTime + i, event_queue::EVENT_WARNING_CH1_CALIBRATION_DISABLED + i % 2, EVENT_TYPE_WARNING, nullptr);
+        } else {
+            appendResult = store.append(dateTime + i, event_queue::EVENT_INFO_CH1_OUTPUT_ENABLED + i % 2, EVENT_TYPE_INFO, nullptr);
+        }
+    }
+
+    appendResult = appendResult && store.flush();
+
+    result.appendTime = millis() - startTime;
+
+    if (appendResult) {
+        Record records[MAX_PAGE_SIZE];
+        uint32_t recordIndexes[MAX_PAGE_SIZE];
+
+        for (int filter = EVENT_TYPE_DEBUG; filter <= EVENT_TYPE_ERROR; filter++) {
+            uint32_t n = store.getNumEvents(filter);
+            result.numEvents[filter] = n;
+
+            uint32_t totalTime = 0;
+            for (uint32_t position = 0; position < n; position += MAX_PAGE_SIZE) {
+                uint32_t pageStartTime = micros();
+                if (!store.readPage(filter, position, MAX_PAGE_SIZE, records, recordIndexes)) {
+                    appendResult = false;
+                    break;
+                }
+                uint32_t pageReadTime = micros() - pageStartTime;
+
+                totalTime += pageReadTime;
+                if (pageReadTime > result.maxPageReadTime[filter]) {
+                    result.maxPageReadTime[filter] = pageReadTime;
+                }
+                result.numPages[filter]++;
+            }
+
+            if (result.numPages[filter] > 0) {
+                result.avgPageReadTime[filter] = totalTime / result.numPages[filter];
+            }
+        }
+
+        // the last page read is in the cache
+        uint32_t pageStartTime = micros();
+        store.readPage(EVENT_TYPE_ERROR, (result.numPages[EVENT_TYPE_ERROR] - 1) * MAX_PAGE_SIZE, MAX_PAGE_SIZE, records, recordIndexes);
+        result.cachedPageReadTime = micros() - pageStartTime;
+    }
+
+    store.remove();
+    sd_card::removeDir(dirPath, nullptr);
+
+    if (!appendResult) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace event_log
+} // namespace psu
+} // namespace eez
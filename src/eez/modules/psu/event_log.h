@@ -0,0 +1,172 @@
+/*
+* EEZ PSU Firmware
+* Copyright (C) 2020-present, Envox d.o.o.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <eez/libs/sd_fat/sd_fat.h>
+
+/* Event Log File Format
+
+Events are stored in the log directory as fixed size records, so the event at any position
+is found without parsing preceding events.
+
+events.bin - records file
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x474C5645L
+
+4         U16     2        VERSION = 0x0001L
+
+6         U16     2        Record size (R) = 12
+
+8                          Records, R bytes each:
+
+          U32     4        Date and time (datetime::now())
+          S16     2        Event ID, 0 if event is stored only as a message
+          U8      1        Event type (severity), EVENT_TYPE_DEBUG ... EVENT_TYPE_ERROR
+          U8      1        Channel index, 0xFF if event is not related to the channel
+          U32     4        Message offset in messages.bin, 0xFFFFFFFF if there is no message
+
+messages.bin - messages of the debug traces and of the migrated events with unknown ID,
+               U16 length followed by the message characters
+
+events2.idx, events3.idx, events4.idx - for the INFO, WARNING and ERROR filter,
+               U32 index of every record with the event type greater or equal to the filter.
+               DEBUG filter shows all the records, so it doesn't need the index.
+*/
+
+namespace eez {
+namespace psu {
+namespace event_log {
+
+static const uint32_t MAGIC = 0x474C5645;
+static const uint16_t VERSION = 1;
+
+static const uint8_t NO_CHANNEL = 0xFF;
+static const uint32_t NO_MESSAGE = 0xFFFFFFFF;
+
+static const int MAX_PAGE_SIZE = 8;
+static const size_t MAX_MESSAGE_LENGTH = 255;
+
+#pragma pack(push, 1)
+
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+};
+
+struct Record {
+    uint32_t dateTime;
+    int16_t eventId;
+    uint8_t eventType;
+    uint8_t channelIndex;
+    uint32_t messageOffset;
+};
+
+#pragma pack(pop)
+
+class Store {
+public:
+    // Opens store in the given directory, creates it if it doesn't exist.
+    // Text log left by the older firmware is converted on the first open.
+    bool open(const char *dirPath);
+    void close();
+    bool isOpen() { return m_isOpen; }
+
+    // Events are collected in the write buffer, which is written to the files
+    // when it is full or when flush is called.
+    bool append(uint32_t dateTime, int16_t eventId, int eventType, const char *message);
+    bool flush();
+
+    // Number of events shown with the given filter (EVENT_TYPE_DEBUG ... EVENT_TYPE_ERROR)
+    uint32_t getNumEvents(int filter);
+
+    // Reads up to MAX_PAGE_SIZE events starting from the position (0 is the newest event),
+    // recordIndexes receives unique and stable index of every event. Returns number of events read.
+    int readPage(int filter, uint32_t fromPosition, int count, Record *records, uint32_t *recordIndexes);
+
+    bool readMessage(const Record &record, char *message, size_t messageSize);
+
+    // Writes all events as text, one event per line, in the format of the older firmware log.txt
+    bool exportText(const char *filePath, int *err);
+
+    // Removes all the store files
+    void remove();
+
+private:
+    struct PageCacheEntry {
+        uint8_t filter;
+        uint8_t count;
+        uint32_t firstIndex;
+        uint32_t lastUsed;
+        Record records[MAX_PAGE_SIZE];
+        uint32_t recordIndexes[MAX_PAGE_SIZE];
+    };
+
+    static const int PAGE_CACHE_SIZE = 4;
+    static const int WRITE_BUFFER_NUM_RECORDS = 16;
+    static const size_t WRITE_BUFFER_MESSAGES_SIZE = 2 * (2 + MAX_MESSAGE_LENGTH);
+
+    bool m_isOpen;
+    char m_dirPath[MAX_PATH_LENGTH + 1];
+
+    // number of events, including the events in the write buffer
+    uint32_t m_numEvents[5];
+    uint32_t m_messagesSize;
+
+    PageCacheEntry m_pageCache[PAGE_CACHE_SIZE];
+    uint32_t m_pageCacheCounter;
+
+    Record m_bufferedRecords[WRITE_BUFFER_NUM_RECORDS];
+    int m_numBufferedRecords;
+    uint32_t m_bufferedIndexes[3][WRITE_BUFFER_NUM_RECORDS];
+    int m_numBufferedIndexes[3];
+    uint8_t m_bufferedMessages[WRITE_BUFFER_MESSAGES_SIZE];
+    size_t m_bufferedMessagesSize;
+
+    void getFilePath(const char *fileName, char *filePath);
+    void getIndexFilePath(int filter, char *filePath);
+
+    bool create();
+    bool migrate(const char *textLogFilePath);
+    uint32_t getFileSize(const char *filePath);
+    uint32_t repairIndexFile(const char *filePath, uint32_t numRecords);
+    bool appendToFile(const char *filePath, const void *buffer, size_t size);
+    void resetPageCache();
+};
+
+uint8_t getEventChannelIndex(int16_t eventId);
+
+struct BenchmarkResult {
+    uint32_t numEvents[5];
+    uint32_t appendTime;        // ms
+    uint32_t numPages[5];
+    uint32_t avgPageReadTime[5]; // us
+    uint32_t maxPageReadTime[5]; // us
+    uint32_t cachedPageReadTime; // us
+};
+
+// Creates the store with the given number of generated events in the given directory,
+// reads it page by page with every filter and removes it.
+bool benchmark(const char *dirPath, uint32_t numEvents, BenchmarkResult &result, int *err);
+
+} // namespace event_log
+} // namespace psu
+} // namespace eez
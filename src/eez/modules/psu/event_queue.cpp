@@ -27,6 +27,7 @@
 #include <eez/modules/mcu/eeprom.h>
 
 #include <eez/modules/psu/datetime.h>
+#include <eez/modules/psu/event_log.h>
 #include <eez/modules/psu/event_queue.h>
 #include <eez/modules/psu/sd_card.h>
 
@@ -47,6 +48,9 @@
 using namespace eez::psu::gui;
 
 namespace eez {
+
+extern char g_exportLogFilePath[MAX_PATH_LENGTH + 1];
+
 namespace psu {
 namespace event_queue {
 
@@ -54,13 +58,6 @@ static const int EVENTS_PER_PAGE = 8;
 
 static const int CONF_EVENT_LINE_WIDTH_PX = 448;
 
-static const char *LOG_FILE_NAME = "log.txt";
-
-static const char *LOG_DEBUG_INDEX_FILE_NAME   = "index1";
-static const char *LOG_INFO_INDEX_FILE_NAME    = "index2";
-static const char *LOG_WARNING_INDEX_FILE_NAME = "index3";
-static const char *LOG_ERROR_INDEX_FILE_NAME   = "index4";
-
 static const char *EVENT_TYPE_NAMES[] = {
     "NONE",
     "DEBUG",
@@ -89,6 +86,7 @@ osMutexDef(g_writeQueueMutex);
 ////////////////////////////////////////////////////////////////////////////////
 
 static bool g_isSdCardMounted = false;
+static event_log::Store g_store;
 static bool g_refreshEvents;
 
 static int g_filter = EVENT_TYPE_INFO;
@@ -104,8 +102,8 @@ struct Event {
     uint32_t dateTime;
     int eventType;
     char message[EVENT_MESSAGE_MAX_SIZE];
-    bool isLongMessageText;
-    uint32_t logOffset;
+    int8_t isLongMessageText; // -1 if not measured yet, it is measured in the GUI thread which owns the fonts
+    uint32_t recordIndex;
 };
 static Event g_events[EVENTS_PER_PAGE];
 
@@ -116,11 +114,6 @@ static int g_selectedEventIndex = -1;
 static void addEventToWriteQueue(int16_t eventId, char *message);
 static bool getEventFromWriteQueue(QueueEvent *queueEvent);
 
-static void getIndexFilePath(int indexType, char *filePath);
-static void getLogFilePath(char *filePath);
-
-static int getEventType(int16_t eventId);
-
 static void setDisplayFromPosition(uint32_t position);
 
 static void refreshEvents();
@@ -141,13 +134,25 @@ void tick() {
     bool isSdCardMounted = sd_card::isMounted(nullptr);
     if (isSdCardMounted != g_isSdCardMounted) {
         g_refreshEvents = true;
+        if (isSdCardMounted) {
+            g_store.open(LOGS_DIR);
+        } else {
+            g_store.close();
+        }
     }
     g_isSdCardMounted = isSdCardMounted;
 
-    if (g_isSdCardMounted) {
+    if (g_store.isOpen()) {
+        // all the queued events are written with a single flush
         QueueEvent queueEvent;
-        if (getEventFromWriteQueue(&queueEvent)) {
+        bool written = false;
+        while (getEventFromWriteQueue(&queueEvent)) {
             writeEvent(&queueEvent);
+            written = true;
+        }
+
+        if (written) {
+            g_store.flush();
             g_previousDisplayFromPosition = -1;
         }
     }
@@ -172,16 +177,38 @@ void shutdownSave() {
     while (getEventFromWriteQueue(&queueEvent)) {
         writeEvent(&queueEvent);
     }
+    g_store.flush();
 }
 
 int16_t getLastErrorEventId() {
     return g_lastErrorEventId;
 }
 
+int getEventType(int16_t eventId) {
+    if (eventId == EVENT_DEBUG_TRACE) {
+        return EVENT_TYPE_DEBUG;
+    } else if (eventId >= EVENT_INFO_START_ID) {
+        return EVENT_TYPE_INFO;
+    } else if (eventId >= EVENT_WARNING_START_ID) {
+        return EVENT_TYPE_WARNING;
+    } else if (eventId != EVENT_TYPE_NONE) {
+        return EVENT_TYPE_ERROR;
+    } else {
+        return EVENT_TYPE_NONE;
+    }
+}
+
 const char *getEventTypeName(int16_t eventId) {
     return EVENT_TYPE_NAMES[getEventType(eventId)];
 }
 
+const char *getEventTypeNameByType(int eventType) {
+    if (eventType < EVENT_TYPE_NONE || eventType > EVENT_TYPE_ERROR) {
+        eventType = EVENT_TYPE_NONE;
+    }
+    return EVENT_TYPE_NAMES[eventType];
+}
+
 const char *getEventMessage(int16_t eventId) {
     static char message[35];
 
@@ -250,6 +277,46 @@ const char *getEventMessage(int16_t eventId) {
     return 0;
 }
 
+int16_t findEventId(int eventType, const char *message) {
+    // messages in the text log are truncated by getEventMessage
+    static const size_t MAX_MESSAGE_LENGTH = 34;
+
+#define MATCH_EVENT(EVENT_ID, TEXT)                                                                \
+    if (strncmp(message, TEXT, MAX_MESSAGE_LENGTH) == 0 && getEventType(EVENT_ID) == eventType) { \
+        return EVENT_ID;                                                                           \
+    }
+#define EVENT_SCPI_ERROR(ID, TEXT) MATCH_EVENT(ID, TEXT)
+#define EVENT_ERROR(NAME, ID, TEXT) MATCH_EVENT(EVENT_ERROR_START_ID + ID, TEXT)
+#define EVENT_WARNING(NAME, ID, TEXT) MATCH_EVENT(EVENT_WARNING_START_ID + ID, TEXT)
+#define EVENT_INFO(NAME, ID, TEXT) MATCH_EVENT(EVENT_INFO_START_ID + ID, TEXT)
+    LIST_OF_EVENTS
+#undef EVENT_SCPI_ERROR
+#undef EVENT_INFO
+#undef EVENT_WARNING
+#undef EVENT_ERROR
+#undef MATCH_EVENT
+
+    return 0;
+}
+
+bool exportLog(const char *filePath, int *err) {
+    if (!g_store.isOpen()) {
+        if (err) {
+            *err = SCPI_ERROR_MISSING_MASS_MEDIA;
+        }
+        return false;
+    }
+
+    if (!isLowPriorityThread()) {
+        // store is written by tick in the low priority thread
+        strcpy(g_exportLogFilePath, filePath);
+        sendMessageToLowPriorityThread(THREAD_MESSAGE_EVENT_QUEUE_EXPORT_LOG);
+        return true;
+    }
+
+    return g_store.exportText(filePath, err);
+}
+
 void pushEvent(int16_t eventId) {
     addEventToWriteQueue(eventId, nullptr);
 
@@ -373,28 +440,6 @@ static void addEventToWriteQueue(int16_t eventId, char *message) {
     }
 }
 
-static void getIndexFilePath(int indexType, char *filePath) {
-    strcpy(filePath, LOGS_DIR);
-
-    strcat(filePath, PATH_SEPARATOR);
-
-    if (indexType == EVENT_TYPE_DEBUG) {
-        strcat(filePath, LOG_DEBUG_INDEX_FILE_NAME);
-    } else if (indexType == EVENT_TYPE_INFO) {
-        strcat(filePath, LOG_INFO_INDEX_FILE_NAME);
-    } else if (indexType == EVENT_TYPE_WARNING) {
-        strcat(filePath, LOG_WARNING_INDEX_FILE_NAME);
-    } else {
-        strcat(filePath, LOG_ERROR_INDEX_FILE_NAME);
-    }
-}
-
-static void getLogFilePath(char *filePath) {
-    strcpy(filePath, LOGS_DIR);
-    strcat(filePath, PATH_SEPARATOR);
-    strcat(filePath, LOG_FILE_NAME);
-}
-
 static int getFilter() {
     return g_filter;
 }
@@ -408,20 +453,6 @@ static uint32_t getEventDateTime(Event *e) {
     return e->dateTime;
 }
 
-static int getEventType(int16_t eventId) {
-    if (eventId == EVENT_DEBUG_TRACE) {
-        return EVENT_TYPE_DEBUG;
-    } else if (eventId >= EVENT_INFO_START_ID) {
-        return EVENT_TYPE_INFO;
-    } else if (eventId >= EVENT_WARNING_START_ID) {
-        return EVENT_TYPE_WARNING;
-    } else if (eventId != EVENT_TYPE_NONE) {
-        return EVENT_TYPE_ERROR;
-    } else {
-        return EVENT_TYPE_NONE;
-    }
-}
-
 static int getEventType(Event *e) {
     if (!e) {
         return EVENT_TYPE_NONE;
@@ -436,9 +467,14 @@ static const char *getEventMessage(Event *e) {
     return e->message;
 }
 
+static void updateIsLongMessageText(Event &event);
+
 static bool isLongMessageText(Event *e) {
     if (e) {
-        return e->isLongMessageText;
+        if (e->isLongMessageText == -1) {
+            updateIsLongMessageText(*e);
+        }
+        return e->isLongMessageText == 1;
     }
     return false;
 }
@@ -469,16 +505,8 @@ static void refreshEvents() {
     g_previousDisplayFromPosition = -1;
     g_selectedEventIndex = -1;
 
-    if (g_isSdCardMounted) {
-        char filePath[MAX_PATH_LENGTH];
-        getIndexFilePath(g_filter, filePath);
-
-        File file;
-        if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-            g_numEvents = file.size() / 4;
-            file.close();
-        }
-
+    if (g_store.isOpen()) {
+        g_numEvents = g_store.getNumEvents(g_filter);
         g_refreshEvents = false;
     } else {
         g_numEvents = 0;
@@ -505,91 +533,16 @@ static void refreshEvents() {
     }
 }
 
-static bool writeToLog(QueueEvent *event, uint32_t &logOffset, int &eventType) {
-    char filePath[MAX_PATH_LENGTH];
-    getLogFilePath(filePath);
-
-    File file;
-    if (!file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
-        return false;
-    }
-
-    logOffset = file.size();
-
-    using namespace sd_card;
-    BufferedFileWrite bufferedFile(file);
-
-    int year, month, day, hour, minute, second;
-    datetime::breakTime(event->dateTime, year, month, day, hour, minute, second);
-
-    eventType = getEventType(event->eventId);
-
-    char dateTimeAndEventTypeStr[32];
-    sprintf(dateTimeAndEventTypeStr, "%04d-%02d-%02d %02d:%02d:%02d %s ", year, month, day, hour, minute, second, EVENT_TYPE_NAMES[eventType]);
-    bool result = bufferedFile.write((const uint8_t *)dateTimeAndEventTypeStr, strlen(dateTimeAndEventTypeStr));
-
-    if (result) {
-        if (event->eventId == EVENT_DEBUG_TRACE) {
-            result = bufferedFile.write((const uint8_t *)event->message, strlen(event->message));
-        } else {
-            const char *message = getEventMessage(event->eventId);
-            result = bufferedFile.write((const uint8_t *)message, strlen(message));
-        }
-
-        if (result) {
-            result = bufferedFile.write((const uint8_t *)"\n", 1);
-            if (result) {
-                result = bufferedFile.flush();
-            }
-        }
-    }
-
-    file.close();
-
-    return result;
-}
-
-static void writeToIndex(int indexType, uint32_t logOffset) {
-    char filePath[MAX_PATH_LENGTH];
-    getIndexFilePath(indexType, filePath);
-
-    File file;
-    if (file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
-        file.write((const uint8_t *)&logOffset, sizeof(uint32_t));
-        file.close();
-    }
-}
-
 static void writeEvent(QueueEvent *event) {
-    uint32_t logOffset;
-    int eventType;
-    if (!writeToLog(event, logOffset, eventType)) {
+    int eventType = getEventType(event->eventId);
+
+    if (!g_store.append(event->dateTime, event->eventId, eventType, event->eventId == EVENT_DEBUG_TRACE ? event->message : nullptr)) {
         return;
     }
 
     if (eventType >= g_filter) {
         g_refreshEvents = true;
     }
-
-    writeToIndex(EVENT_TYPE_DEBUG, logOffset);
-
-    if (eventType == EVENT_TYPE_DEBUG) {
-        return;
-    }
-
-    writeToIndex(EVENT_TYPE_INFO, logOffset);
-
-    if (eventType == EVENT_TYPE_INFO) {
-        return;
-    }
-
-    writeToIndex(EVENT_TYPE_WARNING, logOffset);
-
-    if (eventType == EVENT_TYPE_WARNING) {
-        return;
-    }
-
-    writeToIndex(EVENT_TYPE_ERROR, logOffset);
 }
 
 static void getEventInfoText(Event *e, char *text, int count) {
@@ -622,113 +575,43 @@ static void updateIsLongMessageText(Event &event) {
     char text[256];
     getEventInfoText(&event, text, sizeof(text));
     eez::gui::font::Font font(getFontData(FONT_ID_OSWALD14));
-    event.isLongMessageText = mcu::display::measureStr(text, -1, font) > CONF_EVENT_LINE_WIDTH_PX;
-}
-
-static bool readEvent(File &indexFile, File &logFile, int eventIndex, Event &event) {
-    indexFile.seek(4 * (g_numEvents - 1 - eventIndex));
-    uint32_t logOffset;
-    if (indexFile.read(&logOffset, sizeof(uint32_t)) != sizeof(uint32_t)) {
-        return false;
-    }
-
-    logFile.seek(logOffset);
-    using namespace sd_card;
-    BufferedFileRead bufferedFile(logFile, 64);
-
-    unsigned int year;
-    if (!match(bufferedFile, year)) {
-        return false;
-    }
-    if (!match(bufferedFile, '-')) {
-        return false;
-    }
-    unsigned int month;
-    if (!match(bufferedFile, month)) {
-        return false;
-    }
-    if (!match(bufferedFile, '-')) {
-        return false;
-    }
-    unsigned int day;
-    if (!match(bufferedFile, day)) {
-        return false;
-    }
-
-    unsigned int hour;
-    if (!match(bufferedFile, hour)) {
-        return false;
-    }
-    if (!match(bufferedFile, ':')) {
-        return false;
-    }
-    unsigned int minute;
-    if (!match(bufferedFile, minute)) {
-        return false;
-    }
-    if (!match(bufferedFile, ':')) {
-        return false;
-    }
-    unsigned int second;
-    if (!match(bufferedFile, second)) {
-        return false;
-    }
-
-    matchZeroOrMoreSpaces(bufferedFile);
-
-    char eventTypeStr[9];
-    matchUntil(bufferedFile, ' ', eventTypeStr, sizeof(eventTypeStr) - 1);
-    eventTypeStr[sizeof(eventTypeStr) - 1] = 0;
-
-    int eventType = EVENT_TYPE_NONE;
-
-    for (int i = EVENT_TYPE_DEBUG; i <= EVENT_TYPE_ERROR; i++) {
-        if (strcmp(eventTypeStr, EVENT_TYPE_NAMES[i]) == 0) {
-            eventType = i;
-            break;
-        }
-    }
-
-    if (eventType == EVENT_TYPE_NONE) {
-        return false;
+    if (!font.fontData) {
+        // font is not loaded, measure again next time
+        event.isLongMessageText = -1;
+        return;
     }
+    event.isLongMessageText = mcu::display::measureStr(text, -1, font) > CONF_EVENT_LINE_WIDTH_PX ? 1 : 0;
+}
 
-    char message[EVENT_MESSAGE_MAX_SIZE];
-    matchUntil(bufferedFile, '\n', message, sizeof(message) - 1);
-    message[sizeof(message) - 1] = 0;
-
-    event.dateTime = datetime::makeTime(year, month, day, hour, minute, second);
-    event.eventType = eventType;
-    strcpy(event.message, message);
+static void readEvents(uint32_t fromPosition) {
+    if (g_store.isOpen()) {
+        event_log::Record records[EVENTS_PER_PAGE];
+        uint32_t recordIndexes[EVENTS_PER_PAGE];
+        int numRecords = g_store.readPage(g_filter, fromPosition, EVENTS_PER_PAGE, records, recordIndexes);
 
-    updateIsLongMessageText(event);
+        for (int i = 0; i < EVENTS_PER_PAGE; i++) {
+            auto &event = g_events[i];
 
-    event.logOffset = logOffset;
+            if (i < numRecords) {
+                auto &record = records[i];
 
-    return true;
-}
-
-static void readEvents(uint32_t fromPosition) {
-    if (g_isSdCardMounted) {
-        char filePath[MAX_PATH_LENGTH];
-        getIndexFilePath(g_filter, filePath);
-        File indexFile;
-        if (indexFile.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-            getLogFilePath(filePath);
-            File logFile;
-            if (logFile.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-                for (int i = 0; i < EVENTS_PER_PAGE; i++) {
-                    auto &event = g_events[i];
-                    if (fromPosition + i < g_numEvents) {
-                        if (readEvent(indexFile, logFile, fromPosition + i, event)) {
-                            continue;
-                        }
+                if (record.messageOffset != event_log::NO_MESSAGE) {
+                    if (!g_store.readMessage(record, event.message, sizeof(event.message))) {
+                        event.message[0] = 0;
                     }
-                    memset(&event, 0, sizeof(event));
+                } else {
+                    const char *message = getEventMessage(record.eventId);
+                    strncpy(event.message, message ? message : "", sizeof(event.message) - 1);
+                    event.message[sizeof(event.message) - 1] = 0;
                 }
-                logFile.close();
+
+                event.dateTime = record.dateTime;
+                event.eventType = record.eventType;
+                event.isLongMessageText = -1;
+                event.recordIndex = recordIndexes[i];
+            } else {
+                memset(&event, 0, sizeof(event));
             }
-            indexFile.close();
         }
     } else {
         if (osMutexWait(g_writeQueueMutexId, 5) == osOK) {
@@ -749,9 +632,9 @@ static void readEvents(uint32_t fromPosition) {
                             auto &event = g_events[k];
                             event.dateTime = g_writeQueue[i].dateTime;
                             event.eventType = eventType;
-                            strcpy(event.message, eventType == EVENT_DEBUG_TRACE ? g_writeQueue[i].message : getEventMessage(g_writeQueue[i].eventId));
-                            updateIsLongMessageText(event);
-                            event.logOffset = i;
+                            strcpy(event.message, g_writeQueue[i].eventId == EVENT_DEBUG_TRACE ? g_writeQueue[i].message : getEventMessage(g_writeQueue[i].eventId));
+                            event.isLongMessageText = -1;
+                            event.recordIndex = i;
                             if (++k == EVENTS_PER_PAGE) {
                                 break;
                             }
@@ -793,7 +676,7 @@ using namespace psu::event_queue;
 
 static event_queue::Event *getEventFromValue(const Value &value) {
     for (int i = 0; i < EVENTS_PER_PAGE; i++) {
-        if (g_events[i].logOffset == value.getUInt32()) {
+        if (g_events[i].recordIndex == value.getUInt32()) {
             return &g_events[i];
         }
     }
@@ -818,7 +701,7 @@ Value MakeEventValue(event_queue::Event *e) {
     value.type_ = VALUE_TYPE_EVENT;
     value.options_ = 0;
     value.unit_ = UNIT_UNKNOWN;
-    value.uint32_ = e->logOffset;
+    value.uint32_ = e->recordIndex;
     return value;
 }
 
@@ -285,9 +285,18 @@ void shutdownSave();
 
 int16_t getLastErrorEventId();
 
+int getEventType(int16_t eventId);
 const char *getEventTypeName(int16_t eventId);
+const char *getEventTypeNameByType(int eventType);
 const char *getEventMessage(int16_t eventId);
 
+// Returns ID of the event with the given type and message, 0 if not found.
+int16_t findEventId(int eventType, const char *message);
+
+// Writes the event log as text file. Outside of the low priority thread
+// it is only queued to that thread, which reports the error to the event queue.
+bool exportLog(const char *filePath, int *err);
+
 void setFilter(int filter);
 
 void pushEvent(int16_t eventId);
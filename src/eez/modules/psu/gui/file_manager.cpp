@@ -21,6 +21,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <atomic>
+
 #include <eez/system.h>
 #include <eez/mp.h>
 #include <eez/memory.h>
@@ -73,6 +75,18 @@ struct FileItem {
     const char *description;
 };
 
+// While the directory is loading, items are appended by the low priority thread after
+// the published ones. Loaded items are a staging area, not seen by the GUI, until a whole
+// page is loaded. Page is then sorted and published by increasing g_filesCount, so the
+// published items never move while the GUI can read them. When loading is finished, sorted
+// copy of the whole list is made after the items and published by switching g_fileItems,
+// space for the copy is reserved for every item.
+static const uint32_t LOADING_PAGE_SIZE = 8;
+
+static FileItem *g_fileItems;
+static uint32_t g_numLoadedItems;
+static bool g_isPublishingPages;
+
 static uint8_t *g_frontBufferPosition;
 static uint8_t *g_backBufferPosition;
 
@@ -95,97 +109,6 @@ static void (*g_fileBrowserOnFileSelected)(const char *filePath);
 static ListViewOption g_rootDirectoryListViewOption = LIST_VIEW_LARGE_ICONS;
 static ListViewOption g_scriptsDirectoryListViewOption = LIST_VIEW_SCRIPTS;
 
-void catalogCallback(void *param, const char *name, FileType type, size_t size) {
-    if (g_fileBrowserMode && type != FILE_TYPE_DIRECTORY && type != g_fileBrowserFileType) {
-        return;
-    }
-
-    auto fileInfo = (FileInfo *)param;
- 
-    char fileNameWithoutExtension[MAX_PATH_LENGTH + 1];
-
-    char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
-    size_t descriptionLen = 0;
-
-    if (isScriptsDirectory() && (getListViewOption() == LIST_VIEW_SCRIPTS || getListViewOption() == LIST_VIEW_LARGE_ICONS)) {
-        if (type != FILE_TYPE_MICROPYTHON) {
-            return;
-        }
-
-        description[0] = 0;
-
-        if (getListViewOption() == LIST_VIEW_SCRIPTS) {
-            char filePath[MAX_PATH_LENGTH + 1];
-            strcpy(filePath, g_currentDirectory);
-            strcat(filePath, "/");
-            strcat(filePath, name);
-            File file;
-            if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-                psu::sd_card::BufferedFileRead bufferedFile(file);
-
-                psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
-                if (psu::sd_card::match(bufferedFile, '#')) {
-                    psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
-                    psu::sd_card::matchUntil(bufferedFile, '\n', description, MAX_FILE_DESCRIPTION_LENGTH);
-                    description[MAX_FILE_DESCRIPTION_LENGTH] = 0;
-                }
-
-                file.close();
-            }
-        }
-
-        descriptionLen = strlen(description);
-        if (descriptionLen > 0) {
-            descriptionLen = 4 * ((descriptionLen + 1 + 3) / 4);
-        }
-
-        const char *str = strrchr(name, '.');
-        if (str) {
-            auto n = str - name;
-            strncpy(fileNameWithoutExtension, name, n);
-            fileNameWithoutExtension[n] = 0;
-            name = fileNameWithoutExtension;
-        }
-    }
-
-    size_t nameLen = 4 * ((strlen(name) + 1 + 3) / 4);
-
-    if (g_frontBufferPosition + sizeof(FileItem) > g_backBufferPosition - nameLen - descriptionLen) {
-        return;
-    }
-
-    auto fileItem = (FileItem *)g_frontBufferPosition;
-    g_frontBufferPosition += sizeof(FileItem);
-
-    fileItem->type = type;
-
-    g_backBufferPosition -= nameLen;
-    strcpy((char *)g_backBufferPosition, name);
-    fileItem->name = (const char *)g_backBufferPosition;
-
-    if (descriptionLen > 0) {
-        g_backBufferPosition -= descriptionLen;
-        strcpy((char *)g_backBufferPosition, description);
-        fileItem->description = (const char *)g_backBufferPosition;
-    } else {
-        fileItem->description = nullptr;
-    }
-
-    fileItem->size = size;
-
-    int year = fileInfo->getModifiedYear();
-    int month = fileInfo->getModifiedMonth();
-    int day = fileInfo->getModifiedDay();
-
-    int hour = fileInfo->getModifiedHour();
-    int minute = fileInfo->getModifiedMinute();
-    int second = fileInfo->getModifiedSecond();
-
-    fileItem->dateTime = psu::datetime::makeTime(year, month, day, hour, minute, second);
-
-    g_filesCount++;
-}
-
 RootDirectoryType getRootDirectoryType(FileItem *item) {
 	if (strcmp(item->name, "Scripts") == 0) {
 		return ROOT_DIRECTORY_TYPE_SCRIPTS;
@@ -286,9 +209,420 @@ int compareFunc(const void *p1, const void *p2) {
 } 
 
 void sort() {
-    qsort(FILE_MANAGER_MEMORY, g_filesCount, sizeof(FileItem), compareFunc);
+    qsort(g_fileItems, g_filesCount, sizeof(FileItem), compareFunc);
+}
+
+static void publishPage() {
+    qsort(g_fileItems + g_filesCount, g_numLoadedItems - g_filesCount, sizeof(FileItem), compareFunc);
+    std::atomic_thread_fence(std::memory_order_release);
+    g_filesCount = g_numLoadedItems;
+}
+
+static void publishSortedList() {
+    auto sortedFileItems = (FileItem *)g_frontBufferPosition;
+    memcpy(sortedFileItems, g_fileItems, g_numLoadedItems * sizeof(FileItem));
+    qsort(sortedFileItems, g_numLoadedItems, sizeof(FileItem), compareFunc);
+    g_frontBufferPosition += g_numLoadedItems * sizeof(FileItem);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    g_fileItems = sortedFileItems;
+    g_filesCount = g_numLoadedItems;
+}
+
+static void addFileItem(const char *name, FileType type, uint32_t size, uint32_t dateTime, const char *description) {
+    if (g_fileBrowserMode && type != FILE_TYPE_DIRECTORY && type != g_fileBrowserFileType) {
+        return;
+    }
+
+    char fileNameWithoutExtension[MAX_PATH_LENGTH + 1];
+
+    size_t descriptionLen = 0;
+
+    if (isScriptsDirectory() && (getListViewOption() == LIST_VIEW_SCRIPTS || getListViewOption() == LIST_VIEW_LARGE_ICONS)) {
+        if (type != FILE_TYPE_MICROPYTHON) {
+            return;
+        }
+
+        if (getListViewOption() == LIST_VIEW_SCRIPTS) {
+            descriptionLen = strlen(description);
+            if (descriptionLen > 0) {
+                descriptionLen = 4 * ((descriptionLen + 1 + 3) / 4);
+            }
+        }
+
+        const char *str = strrchr(name, '.');
+        if (str) {
+            auto n = str - name;
+            strncpy(fileNameWithoutExtension, name, n);
+            fileNameWithoutExtension[n] = 0;
+            name = fileNameWithoutExtension;
+        }
+    }
+
+    size_t nameLen = 4 * ((strlen(name) + 1 + 3) / 4);
+
+    // space for the item and for the copy of all the items in the sorted list
+    if (g_frontBufferPosition + sizeof(FileItem) + sizeof(FileItem) * (g_numLoadedItems + 1) > g_backBufferPosition - nameLen - descriptionLen) {
+        return;
+    }
+
+    FileItem fileItem;
+
+    fileItem.type = type;
+
+    g_backBufferPosition -= nameLen;
+    strcpy((char *)g_backBufferPosition, name);
+    fileItem.name = (const char *)g_backBufferPosition;
+
+    if (descriptionLen > 0) {
+        g_backBufferPosition -= descriptionLen;
+        strcpy((char *)g_backBufferPosition, description);
+        fileItem.description = (const char *)g_backBufferPosition;
+    } else {
+        fileItem.description = nullptr;
+    }
+
+    fileItem.size = size;
+    fileItem.dateTime = dateTime;
+
+    memcpy(&g_fileItems[g_numLoadedItems++], &fileItem, sizeof(FileItem));
+    g_frontBufferPosition += sizeof(FileItem);
+
+    if (g_isPublishingPages && g_numLoadedItems - g_filesCount == LOADING_PAGE_SIZE) {
+        publishPage();
+    }
+}
+
+static void readScriptDescription(const char *name, char *description) {
+    description[0] = 0;
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    strcpy(filePath, g_currentDirectory);
+    strcat(filePath, "/");
+    strcat(filePath, name);
+    File file;
+    if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        psu::sd_card::BufferedFileRead bufferedFile(file);
+
+        psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
+        if (psu::sd_card::match(bufferedFile, '#')) {
+            psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
+            psu::sd_card::matchUntil(bufferedFile, '\n', description, MAX_FILE_DESCRIPTION_LENGTH);
+            description[MAX_FILE_DESCRIPTION_LENGTH] = 0;
+        }
+
+        file.close();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/* Directory Index File Format
+
+Catalog of the directory, with the description of every script, is saved in the directory
+to the DIRECTORY_INDEX_FILE_NAME file, so the directory is loaded without opening every script.
+Index is not used for the root directory.
+
+Index is rebuilt when the modification time of the directory changes, or when onSdCardFileChangeHook
+reports a change in the directory. FAT doesn't update the directory modification time when the files
+are added or removed, so after the SD card is mounted the index of the directory is checked once
+against the signature of the directory catalog, in case the card was changed outside of the firmware.
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x58444946L, 0 if the index is not valid
+
+4         U16     2        VERSION = 0x0001L
+
+6         U16     2        Reserved
+
+8         U32     4        Directory modification time (FAT date and time)
+
+12        U32     4        Number of entries
+
+16        U32     4        Signature, FNV-1a hash of the name, size and date and time of every entry
+
+20                         Entries, in the directory order:
+
+          U8      1        File type
+          U8      1        Description length (D)
+          U16     2        Name length (N)
+          U32     4        Size
+          U32     4        Date and time (datetime::makeTime)
+          U8[N]            Name
+          U8[D]            Description, first line of the script if it is a comment
+*/
+
+static const uint32_t DIRECTORY_INDEX_MAGIC = 0x58444946;
+static const uint16_t DIRECTORY_INDEX_VERSION = 1;
+
+static const uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+static const uint32_t FNV_PRIME = 16777619UL;
+
+struct DirectoryIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t directoryModificationTime;
+    uint32_t numEntries;
+    uint32_t signature;
+};
+
+struct DirectoryIndexEntry {
+    uint8_t type;
+    uint8_t descriptionLength;
+    uint16_t nameLength;
+    uint32_t size;
+    uint32_t dateTime;
+};
+
+static const int MAX_VERIFIED_DIRECTORIES = 16;
+static uint32_t g_verifiedDirectories[MAX_VERIFIED_DIRECTORIES];
+static int g_numVerifiedDirectories;
+
+static bool g_isWritingDirectoryIndex;
+static File g_directoryIndexFile;
+static uint32_t g_directoryIndexNumEntries;
+static uint32_t g_directoryIndexSignature;
+
+void getDirectoryIndexFilePath(const char *dirPath, char *indexFilePath) {
+    strcpy(indexFilePath, dirPath);
+    strcat(indexFilePath, "/");
+    strcat(indexFilePath, DIRECTORY_INDEX_FILE_NAME);
+}
+
+static uint32_t fnvHash(uint32_t h, const void *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ ((const uint8_t *)data)[i]) * FNV_PRIME;
+    }
+    return h;
+}
+
+static uint32_t hashEntry(uint32_t h, const char *name, uint32_t size, uint32_t dateTime) {
+    h = fnvHash(h, name, strlen(name));
+    h = fnvHash(h, &size, sizeof(size));
+    return fnvHash(h, &dateTime, sizeof(dateTime));
+}
+
+static uint32_t getFileDateTime(FileInfo &fileInfo) {
+    int year = fileInfo.getModifiedYear();
+    int month = fileInfo.getModifiedMonth();
+    int day = fileInfo.getModifiedDay();
+
+    int hour = fileInfo.getModifiedHour();
+    int minute = fileInfo.getModifiedMinute();
+    int second = fileInfo.getModifiedSecond();
+
+    return psu::datetime::makeTime(year, month, day, hour, minute, second);
+}
+
+void catalogCallback(void *param, const char *name, FileType type, size_t size) {
+    auto fileInfo = (FileInfo *)param;
+    uint32_t dateTime = getFileDateTime(*fileInfo);
+
+    char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
+    description[0] = 0;
+
+    if (type == FILE_TYPE_MICROPYTHON) {
+        // index has the description of every script, so it can be used with every list view option
+        if (g_isWritingDirectoryIndex || (isScriptsDirectory() && getListViewOption() == LIST_VIEW_SCRIPTS)) {
+            readScriptDescription(name, description);
+        }
+    }
+
+    if (g_isWritingDirectoryIndex) {
+        DirectoryIndexEntry entry;
+        entry.type = type;
+        entry.descriptionLength = (uint8_t)strlen(description);
+        entry.nameLength = (uint16_t)strlen(name);
+        entry.size = size;
+        entry.dateTime = dateTime;
+
+        if (
+            g_directoryIndexFile.write(&entry, sizeof(entry)) != sizeof(entry) ||
+            g_directoryIndexFile.write(name, entry.nameLength) != entry.nameLength ||
+            g_directoryIndexFile.write(description, entry.descriptionLength) != entry.descriptionLength
+        ) {
+            g_isWritingDirectoryIndex = false;
+        }
+
+        g_directoryIndexNumEntries++;
+        g_directoryIndexSignature = hashEntry(g_directoryIndexSignature, name, size, dateTime);
+    }
+
+    addFileItem(name, type, size, dateTime, description);
+}
+
+static void signatureCallback(void *param, const char *name, FileType type, size_t size) {
+    auto fileInfo = (FileInfo *)param;
+
+    g_directoryIndexNumEntries++;
+    g_directoryIndexSignature = hashEntry(g_directoryIndexSignature, name, size, getFileDateTime(*fileInfo));
+}
+
+static bool isDirectoryVerified(uint32_t pathHash) {
+    for (int i = 0; i < g_numVerifiedDirectories; i++) {
+        if (g_verifiedDirectories[i] == pathHash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void setDirectoryVerified(uint32_t pathHash) {
+    if (g_numVerifiedDirectories == MAX_VERIFIED_DIRECTORIES) {
+        memmove(g_verifiedDirectories, g_verifiedDirectories + 1, (MAX_VERIFIED_DIRECTORIES - 1) * sizeof(uint32_t));
+        g_numVerifiedDirectories--;
+    }
+    g_verifiedDirectories[g_numVerifiedDirectories++] = pathHash;
+}
+
+// must not be called after some items are published, until the loading is finished
+static void resetFileItems() {
+    g_filesCount = 0;
+    g_numLoadedItems = 0;
+    g_fileItems = (FileItem *)FILE_MANAGER_MEMORY;
+    g_frontBufferPosition = FILE_MANAGER_MEMORY;
+    g_backBufferPosition = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+}
+
+static bool loadDirectoryIndex(DirectoryIndexHeader &header) {
+    uint32_t directorySize;
+    uint32_t directoryModificationTime;
+    if (!psu::sd_card::getSizeAndModificationTime(g_currentDirectory, directorySize, directoryModificationTime)) {
+        return false;
+    }
+
+    char indexFilePath[MAX_PATH_LENGTH + 1];
+    getDirectoryIndexFilePath(g_currentDirectory, indexFilePath);
+
+    File file;
+    if (!file.open(indexFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    psu::sd_card::BufferedFileRead bufferedFile(file);
+
+    bool result =
+        bufferedFile.read(&header, sizeof(header)) == sizeof(header) &&
+        header.magic == DIRECTORY_INDEX_MAGIC &&
+        header.version == DIRECTORY_INDEX_VERSION &&
+        header.directoryModificationTime == directoryModificationTime;
+
+    for (uint32_t i = 0; result && i < header.numEntries; i++) {
+        DirectoryIndexEntry entry;
+        char name[MAX_PATH_LENGTH + 1];
+        char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
+
+        result =
+            bufferedFile.read(&entry, sizeof(entry)) == sizeof(entry) &&
+            entry.nameLength <= MAX_PATH_LENGTH &&
+            entry.descriptionLength <= MAX_FILE_DESCRIPTION_LENGTH &&
+            bufferedFile.read(name, entry.nameLength) == entry.nameLength &&
+            bufferedFile.read(description, entry.descriptionLength) == entry.descriptionLength;
+
+        if (result) {
+            name[entry.nameLength] = 0;
+            description[entry.descriptionLength] = 0;
+            addFileItem(name, (FileType)entry.type, entry.size, entry.dateTime, description);
+        }
+    }
+
+    file.close();
+
+    if (!result) {
+        resetFileItems();
+    }
+
+    return result;
+}
+
+static bool buildDirectoryIndex() {
+    char indexFilePath[MAX_PATH_LENGTH + 1];
+    getDirectoryIndexFilePath(g_currentDirectory, indexFilePath);
+
+    // header is written after all the entries are written, until then the index is not valid
+    DirectoryIndexHeader header;
+    memset(&header, 0, sizeof(header));
+
+    g_isWritingDirectoryIndex =
+        g_directoryIndexFile.open(indexFilePath, FILE_CREATE_ALWAYS | FILE_WRITE) &&
+        g_directoryIndexFile.write(&header, sizeof(header)) == sizeof(header);
+    g_directoryIndexNumEntries = 0;
+    g_directoryIndexSignature = FNV_OFFSET_BASIS;
+
+    int numFiles;
+    int err;
+    bool result = psu::sd_card::catalog(g_currentDirectory, 0, catalogCallback, &numFiles, &err);
+
+    bool indexWritten = g_isWritingDirectoryIndex;
+    g_isWritingDirectoryIndex = false;
+    g_directoryIndexFile.close();
+
+    if (result && indexWritten) {
+        // in the simulator, directory modification time is changed when the index file is created,
+        // so it is taken after the index file is closed
+        uint32_t directorySize;
+        if (psu::sd_card::getSizeAndModificationTime(g_currentDirectory, directorySize, header.directoryModificationTime)) {
+            header.magic = DIRECTORY_INDEX_MAGIC;
+            header.version = DIRECTORY_INDEX_VERSION;
+            header.numEntries = g_directoryIndexNumEntries;
+            header.signature = g_directoryIndexSignature;
+
+            File file;
+            if (file.open(indexFilePath, FILE_OPEN_EXISTING | FILE_READ | FILE_WRITE)) {
+                file.write(&header, sizeof(header));
+                file.close();
+            }
+        }
+    }
+
+    return result;
 }
 
+static bool verifyDirectoryIndex(const DirectoryIndexHeader &header) {
+    g_directoryIndexNumEntries = 0;
+    g_directoryIndexSignature = FNV_OFFSET_BASIS;
+
+    int numFiles;
+    int err;
+    if (!psu::sd_card::catalog(g_currentDirectory, 0, signatureCallback, &numFiles, &err)) {
+        return false;
+    }
+
+    return g_directoryIndexNumEntries == header.numEntries && g_directoryIndexSignature == header.signature;
+}
+
+static void invalidateDirectoryIndex(const char *filePath) {
+    char dirPath[MAX_PATH_LENGTH + 1];
+    getParentDir(filePath, dirPath);
+    if (dirPath[0] == 0 || strcmp(dirPath, "/") == 0) {
+        return;
+    }
+
+    const char *fileName = filePath + strlen(dirPath);
+    if (*fileName == '/') {
+        fileName++;
+    }
+    if (psu::sd_card::isHiddenFile(fileName)) {
+        // hidden files are not in the index
+        return;
+    }
+
+    char indexFilePath[MAX_PATH_LENGTH + 1];
+    getDirectoryIndexFilePath(dirPath, indexFilePath);
+
+    // index file is not deleted, because deleting it would report the change again
+    File file;
+    if (file.open(indexFilePath, FILE_OPEN_EXISTING | FILE_READ | FILE_WRITE)) {
+        uint32_t magic = 0;
+        file.write(&magic, sizeof(magic));
+        file.close();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void loadDirectory() {
     if (g_state == STATE_LOADING) {
         return;
@@ -314,22 +648,56 @@ void doLoadDirectory() {
         return;
     }
 
-    g_frontBufferPosition = FILE_MANAGER_MEMORY;
-    g_backBufferPosition = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+    resetFileItems();
 
-    int numFiles;
-    int err;
-    if (psu::sd_card::catalog(g_currentDirectory, 0, catalogCallback, &numFiles, &err)) {
-        sort();
+    bool result;
+
+    if (isRootDirectory()) {
+        int numFiles;
+        int err;
+        g_isPublishingPages = true;
+        result = psu::sd_card::catalog(g_currentDirectory, 0, catalogCallback, &numFiles, &err);
+    } else {
+        uint32_t pathHash = fnvHash(FNV_OFFSET_BASIS, g_currentDirectory, strlen(g_currentDirectory));
+
+        // items from the index are not published until the index is verified,
+        // catalog is read (slowly, every script is opened) only if the index is not valid
+        g_isPublishingPages = false;
+
+        DirectoryIndexHeader header;
+        if (loadDirectoryIndex(header)) {
+            result = true;
+            if (!isDirectoryVerified(pathHash) && !verifyDirectoryIndex(header)) {
+                resetFileItems();
+                g_isPublishingPages = true;
+                result = buildDirectoryIndex();
+            }
+        } else {
+            g_isPublishingPages = true;
+            result = buildDirectoryIndex();
+        }
+
+        if (result) {
+            setDirectoryVerified(pathHash);
+        }
+    }
+
+    g_isPublishingPages = false;
+
+    if (result) {
+        // also applies the sort option changed while loading
+        publishSortedList();
         setFilesStartPosition(g_savedFilesStartPosition);
         g_state = STATE_READY;
     } else {
     	g_state = STATE_NOT_PRESENT;
     }
-
 }
 
 void onSdCardMountedChange() {
+    // card could be changed while it was not mounted
+    g_numVerifiedDirectories = 0;
+
 	if (psu::sd_card::isMounted(nullptr)) {
 		g_state = STATE_STARTING;
 	} else {
@@ -397,6 +765,11 @@ SortFilesOption getSortFilesOption() {
 void setSortFilesOption(SortFilesOption sortFilesOption) {
     psu::persist_conf::setSortFilesOption(sortFilesOption);
 
+    if (g_state == STATE_LOADING) {
+        // published items can't be moved while loading, whole list is sorted by doLoadDirectory
+        return;
+    }
+
     sort();
 
     g_filesStartPosition = 0;
@@ -411,15 +784,18 @@ const char *getCurrentDirectory() {
 }
 
 static FileItem *getFileItem(uint32_t fileIndex) {
-    if (g_state != STATE_READY) {
+    // while loading, published items are available
+    if (g_state != STATE_READY && g_state != STATE_LOADING) {
         return nullptr;
     }
 
+    FileItem *fileItems = g_fileItems;
     if (fileIndex >= g_filesCount) {
         return nullptr;
     }
+    std::atomic_thread_fence(std::memory_order_acquire);
 
-    return (FileItem *)(FILE_MANAGER_MEMORY + fileIndex * sizeof(FileItem));
+    return fileItems + fileIndex;
 }
 
 State getState() {
@@ -429,6 +805,9 @@ State getState() {
     }
 
     if (g_state == STATE_LOADING) {
+        if (g_filesCount > 0) {
+            return STATE_READY; // show published items
+        }
         if (millis() - g_loadingStartTickCount < 1000) {
             return STATE_STARTING; // during 1st second of loading
         }
@@ -750,8 +1129,8 @@ void uploadFile() {
 #endif
 
 #if OPTION_ETHERNET
-    if (!context && psu::ethernet::isConnected()) {
-        context = &psu::ethernet::g_scpiContext;
+    if (!context) {
+        context = psu::ethernet::getConnectedScpiContext();
     }
 #endif
 
@@ -1267,6 +1646,11 @@ void action_file_manager_new_file() {
 using namespace gui::file_manager;
 
 void onSdCardFileChangeHook(const char *filePath1, const char *filePath2) {
+    invalidateDirectoryIndex(filePath1);
+    if (filePath2) {
+        invalidateDirectoryIndex(filePath2);
+    }
+
 	if (g_fileBrowserMode) {
 		return;
 	}
@@ -100,6 +100,8 @@ void doLoadDirectory();
 void doRenameFile();
 void onSdCardMountedChange();
 
+void getDirectoryIndexFilePath(const char *dirPath, char *indexFilePath);
+
 bool isStorageAlarm();
 void getStorageInfo(Value &value);
 
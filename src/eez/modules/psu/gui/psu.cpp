@@ -1639,6 +1639,45 @@ void takeScreenshot() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static text_run_cache::BenchmarkResult *g_textRunCacheBenchmarkResult;
+
+static void doTextRunCacheBenchmark() {
+    // values as they are shown on the main page in the different views
+    static const text_run_cache::BenchmarkText TEXTS[] = {
+        { STYLE_ID_MON_VALUE_48_RIGHT, 220, 54, "40.000 V" },
+        { STYLE_ID_MON_VALUE_48_RIGHT, 220, 54, "5.000 A" },
+        { STYLE_ID_MON_VALUE_38_RIGHT, 180, 44, "12.345 V" },
+        { STYLE_ID_MON_VALUE_38_RIGHT, 180, 44, "0.500 A" },
+        { STYLE_ID_MON_VALUE_24_RIGHT, 120, 30, "40.00 W" },
+        { STYLE_ID_MON_VALUE_24_RIGHT, 120, 30, "3.300 V" },
+        { STYLE_ID_MON_VALUE_20_LEFT, 100, 26, "1.250 A" },
+        { STYLE_ID_MON_VALUE_20_RIGHT, 100, 26, "24.00 V" },
+        { STYLE_ID_MON_VALUE_14_LEFT, 80, 20, "0.000 V" },
+        { STYLE_ID_MON_VALUE_14_CENTER, 80, 20, "120 mA" },
+        { STYLE_ID_MON_VALUE_14_RIGHT, 80, 20, "6.50 W" }
+    };
+
+    text_run_cache::benchmark(TEXTS, sizeof(TEXTS) / sizeof(TEXTS[0]), 20, *g_textRunCacheBenchmarkResult);
+
+    refreshScreen();
+
+    g_textRunCacheBenchmarkResult = nullptr;
+}
+
+void textRunCacheBenchmark(text_run_cache::BenchmarkResult &result) {
+    g_textRunCacheBenchmarkResult = &result;
+    if (osThreadGetId() == g_guiTaskHandle) {
+        doTextRunCacheBenchmark();
+    } else {
+        sendMessageToGuiThread(GUI_QUEUE_MESSAGE_TYPE_TEXT_RUN_CACHE_BENCHMARK);
+        do {
+            osDelay(1);
+        } while (g_textRunCacheBenchmarkResult);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static int g_findNextFocusCursorState = 0; 
 static Cursor g_nextFocusCursor = Cursor(0);
 static uint16_t g_nextFocusDataId = DATA_ID_CHANNEL_U_EDIT;
@@ -2345,7 +2384,9 @@ void onGuiQueueMessageHook(uint8_t type, int16_t param) {
         g_psuAppContext.doShowAsyncOperationInProgress();
     } else if (type == GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS) {
         g_psuAppContext.doHideAsyncOperationInProgress();
-    } 
+    } else if (type == GUI_QUEUE_MESSAGE_TYPE_TEXT_RUN_CACHE_BENCHMARK) {
+        doTextRunCacheBenchmark();
+    }
 #if defined(EEZ_PLATFORM_STM32)
     else if (type == GUI_QUEUE_MESSAGE_KEY_DOWN) {
     	if (getActivePageId() != PAGE_ID_SYS_SETTINGS_SERIAL) {
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <eez/gui/gui.h>
+#include <eez/gui/text_run_cache.h>
 
 using namespace eez::gui;
 
@@ -120,6 +121,9 @@ void showMainPage();
 void goBack();
 void takeScreenshot();
 
+// Draws the main page numeric values in the GUI thread, with and without the text run cache.
+void textRunCacheBenchmark(text_run_cache::BenchmarkResult &result);
+
 extern Value g_progress;
 
 struct AsyncOperationInProgressParams {
@@ -408,7 +412,8 @@ enum {
     GUI_QUEUE_MESSAGE_TYPE_DIALOG_OPEN,
     GUI_QUEUE_MESSAGE_TYPE_DIALOG_CLOSE,
     GUI_QUEUE_MESSAGE_TYPE_SHOW_ASYNC_OPERATION_IN_PROGRESS,
-    GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS
+    GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS,
+    GUI_QUEUE_MESSAGE_TYPE_TEXT_RUN_CACHE_BENCHMARK
 };
 
 } // namespace gui
@@ -19,11 +19,13 @@
 #include <eez/modules/psu/psu.h>
 
 #include <math.h>
+#include <atomic>
 
 #include <scpi/scpi.h>
 
 #include <eez/system.h>
 #include <eez/firmware.h>
+#include <eez/memory.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel_dispatcher.h>
@@ -39,6 +41,13 @@
 #define CONF_COUNTER_THRESHOLD_IN_SECONDS 5
 #define CONF_SAVE_LIST_TIMEOUT_MS 2000
 
+// number of points in one buffer of the streamed list
+#define CONF_STREAM_SEGMENT_LENGTH 512
+// segment which is not read in time is requested again after this time
+#define CONF_STREAM_FILL_RETRY_US 10000
+// list is aborted if the segment is not read in this time
+#define CONF_STREAM_UNDERRUN_TIMEOUT_US 1000000
+
 namespace eez {
 
 extern char g_listFilePath[CH_MAX][MAX_PATH_LENGTH];
@@ -66,8 +75,61 @@ static struct {
     int32_t currentRemainingDwellTime;
     float currentTotalDwellTime;
     uint32_t lastTickCount;
+
+    uint32_t numSteps;
+    uint32_t numUnderruns;
+    uint32_t minLateness;
+    uint32_t maxLateness;
+    uint64_t sumLateness;
+    uint64_t sumSquaredLateness;
 } g_execution[CH_MAX];
 
+static const uint32_t NO_SEQUENCE = 0xFFFFFFFF;
+
+static const uint32_t STREAM_BUFFER_SIZE = CONF_STREAM_SEGMENT_LENGTH * sizeof(ListBinRecord);
+static_assert(2 * CH_MAX * STREAM_BUFFER_SIZE <= LIST_STREAM_MEMORY_SIZE, "LIST_STREAM_MEMORY is too small");
+
+// Streamed list is executed in the PSU thread from the two buffers of CONF_STREAM_SEGMENT_LENGTH points,
+// while the low priority thread reads the next segment from the SD card into the other buffer.
+// Sequence counts the segments executed since the trigger, sequence k is executed from
+// the buffer k % 2 and it is segment k % numSegments of the list. PSU thread publishes
+// the sequence it executes and the low priority thread fills the buffers for that and the next
+// sequence. Buffer is tagged with the sequence it holds only after it is completely read.
+// Buffer tagged with the other sequence of the same segment is not read again, which
+// keeps the lists with one or two segments in memory.
+struct ListStream {
+    // set by the low priority thread after the stream is filled, read by the PSU and GUI threads
+    std::atomic<bool> isOpen;
+    char filePath[MAX_PATH_LENGTH + 1];
+    uint32_t numPoints;
+    uint32_t numSegments;
+    bool hasVisibleCounter;
+
+    // only the first and the last point are always in memory, used when trigger is finished
+    ListBinRecord firstPoint;
+    ListBinRecord lastPoint;
+
+    ListBinRecord *buffers[2];
+    volatile uint32_t bufferSequence[2];
+    volatile uint32_t sequence;
+
+    // execution state, used only in the PSU thread
+    uint32_t position;
+    bool isStepDue;
+    bool isUnderrun;
+    uint64_t time;
+    uint64_t deadline;
+    uint64_t underrunTime;
+    uint64_t fillRequestTime;
+};
+
+static ListStream g_streams[CH_MAX];
+
+static bool isSegmentReady(ListStream &stream, uint32_t sequence) {
+    uint32_t bufferSequence = stream.bufferSequence[sequence % 2];
+    return bufferSequence != NO_SEQUENCE && bufferSequence % stream.numSegments == sequence % stream.numSegments;
+}
+
 static bool g_active;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -86,6 +148,8 @@ void resetChannelList(Channel &channel) {
     g_channelsLists[i].count = 1;
 
     g_execution[i].counter = -1;
+
+    g_streams[i].isOpen = false;
 }
 
 void reset() {
@@ -95,6 +159,7 @@ void reset() {
 }
 
 void setDwellList(Channel &channel, float *list, uint16_t listLength) {
+    g_streams[channel.channelIndex].isOpen = false;
     memcpy(g_channelsLists[channel.channelIndex].dwellList, list, listLength * sizeof(float));
     g_channelsLists[channel.channelIndex].dwellListLength = listLength;
 }
@@ -105,6 +170,7 @@ float *getDwellList(Channel &channel, uint16_t *listLength) {
 }
 
 void setVoltageList(Channel &channel, float *list, uint16_t listLength) {
+    g_streams[channel.channelIndex].isOpen = false;
     memcpy(g_channelsLists[channel.channelIndex].voltageList, list, listLength * sizeof(float));
     g_channelsLists[channel.channelIndex].voltageListLength = listLength;
 }
@@ -115,6 +181,7 @@ float *getVoltageList(Channel &channel, uint16_t *listLength) {
 }
 
 void setCurrentList(Channel &channel, float *list, uint16_t listLength) {
+    g_streams[channel.channelIndex].isOpen = false;
     memcpy(g_channelsLists[channel.channelIndex].currentList, list, listLength * sizeof(float));
     g_channelsLists[channel.channelIndex].currentListLength = listLength;
 }
@@ -133,6 +200,9 @@ void setListCount(Channel &channel, uint16_t value) {
 }
 
 bool isListEmpty(Channel &channel) {
+    if (g_streams[channel.channelIndex].isOpen) {
+        return false;
+    }
     return g_channelsLists[channel.channelIndex].dwellListLength == 0 &&
            g_channelsLists[channel.channelIndex].voltageListLength == 0 &&
            g_channelsLists[channel.channelIndex].currentListLength == 0;
@@ -149,6 +219,9 @@ bool areListLengthsEquivalent(uint16_t size1, uint16_t size2, uint16_t size3) {
 }
 
 bool areListLengthsEquivalent(Channel &channel) {
+    if (g_streams[channel.channelIndex].isOpen) {
+        return true;
+    }
     return list::areListLengthsEquivalent(g_channelsLists[channel.channelIndex].dwellListLength,
                                           g_channelsLists[channel.channelIndex].voltageListLength,
                                           g_channelsLists[channel.channelIndex].currentListLength);
@@ -172,6 +245,11 @@ bool areVoltageAndCurrentListLengthsEquivalent(Channel &channel) {
 int checkLimits(int iChannel) {
     Channel &channel = Channel::get(iChannel);
 
+    if (g_streams[iChannel].isOpen) {
+        // streamed list is too long to be checked here, every point is checked when it is set
+        return 0;
+    }
+
     uint16_t voltageListLength = g_channelsLists[iChannel].voltageListLength;
     uint16_t currentListLength = g_channelsLists[iChannel].currentListLength;
 
@@ -507,6 +585,343 @@ bool saveList(int iChannel, const char *filePath, int *err) {
     );
 }
 
+static bool convertList(sd_card::BufferedFileRead &csvFile, sd_card::BufferedFileWrite &binFile, uint32_t &numPoints, int *err) {
+    numPoints = 0;
+
+    // column with only one value is used for every point
+    ListBinRecord firstRecord;
+    uint32_t lengths[3] = { 0, 0, 0 };
+
+    while (true) {
+        sd_card::matchZeroOrMoreSpaces(csvFile);
+        if (!csvFile.available() || csvFile.peek() == '`') {
+            break;
+        }
+
+        ListBinRecord record;
+
+        for (int column = 0; column < 3; column++) {
+            if (column > 0) {
+                sd_card::match(csvFile, CSV_SEPARATOR);
+            }
+
+            if (sd_card::match(csvFile, LIST_CSV_FILE_NO_VALUE_CHAR)) {
+                if (lengths[column] != 1) {
+                    if (err) {
+                        *err = SCPI_ERROR_LIST_LENGTHS_NOT_EQUIVALENT;
+                    }
+                    return false;
+                }
+                if (column == 0) {
+                    record.dwell = firstRecord.dwell;
+                } else if (column == 1) {
+                    record.voltage = firstRecord.voltage;
+                } else {
+                    record.current = firstRecord.current;
+                }
+            } else {
+                if (lengths[column] != numPoints) {
+                    if (err) {
+                        *err = SCPI_ERROR_EXECUTION_ERROR;
+                    }
+                    return false;
+                }
+
+                bool success;
+                if (column == 0) {
+                    // dwell is parsed as integer microseconds, float is not precise enough for the long lists
+                    success = sd_card::matchFixedPoint(csvFile, 6, record.dwell);
+                } else if (column == 1) {
+                    success = sd_card::match(csvFile, record.voltage);
+                } else {
+                    success = sd_card::match(csvFile, record.current);
+                }
+
+                if (!success) {
+                    if (err) {
+                        *err = SCPI_ERROR_EXECUTION_ERROR;
+                    }
+                    return false;
+                }
+
+                lengths[column]++;
+            }
+        }
+
+        if (numPoints == 0) {
+            firstRecord = record;
+        }
+
+        if (!binFile.write((const uint8_t *)&record, sizeof(ListBinRecord))) {
+            if (err) {
+                *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+            }
+            return false;
+        }
+
+        numPoints++;
+    }
+
+    // columns shorter than the list, but with more than one value, are not allowed
+    for (int column = 0; column < 3; column++) {
+        if (lengths[column] != 1 && lengths[column] != numPoints) {
+            if (err) {
+                *err = SCPI_ERROR_LIST_LENGTHS_NOT_EQUIVALENT;
+            }
+            return false;
+        }
+    }
+
+    if (numPoints == 0) {
+        if (err) {
+            *err = SCPI_ERROR_LIST_IS_EMPTY;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool convertList(const char *csvFilePath, const char *binFilePath, int *err) {
+    if (!sd_card::isMounted(err)) {
+        return false;
+    }
+
+    if (!sd_card::exists(csvFilePath, err)) {
+        if (err) {
+            *err = SCPI_ERROR_FILE_NOT_FOUND;
+        }
+        return false;
+    }
+
+    if (!sd_card::makeParentDir(binFilePath, err)) {
+        return false;
+    }
+
+    File csvFile;
+    if (!csvFile.open(csvFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    File binFile;
+    if (!binFile.open(binFilePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        csvFile.close();
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    // number of points is written to the header at the end
+    ListBinHeader header;
+    header.magic = LIST_BIN_MAGIC;
+    header.version = LIST_BIN_VERSION;
+    header.recordSize = sizeof(ListBinRecord);
+    header.numPoints = 0;
+    header.reserved = 0;
+
+    bool success = binFile.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+    if (!success && err) {
+        *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+    }
+
+    if (success) {
+        sd_card::BufferedFileRead bufferedCsvFile(csvFile);
+        sd_card::BufferedFileWrite bufferedBinFile(binFile);
+
+        success = convertList(bufferedCsvFile, bufferedBinFile, header.numPoints, err);
+
+        if (success) {
+            success = bufferedBinFile.flush() && binFile.seek(0) && binFile.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+            if (!success && err) {
+                *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+            }
+        }
+    }
+
+    csvFile.close();
+
+    if (!binFile.close()) {
+        if (success && err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        success = false;
+    }
+
+    if (success) {
+        onSdCardFileChangeHook(binFilePath);
+        if (err) {
+            *err = SCPI_RES_OK;
+        }
+    } else {
+        sd_card::deleteFile(binFilePath, nullptr);
+    }
+
+    return success;
+}
+
+static int getExecutingChannelIndex(int iChannel);
+
+bool loadListStream(int iChannel, const char *filePath, int *err) {
+    if (!sd_card::isMounted(err)) {
+        return false;
+    }
+
+    if (!sd_card::exists(filePath, err)) {
+        if (err) {
+            *err = SCPI_ERROR_FILE_NOT_FOUND;
+        }
+        return false;
+    }
+
+    if (strlen(filePath) > MAX_PATH_LENGTH) {
+        if (err) {
+            *err = SCPI_ERROR_FILE_NAME_ERROR;
+        }
+        return false;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    ListBinHeader header;
+    bool success = file.read(&header, sizeof(header)) == sizeof(header) &&
+        header.magic == LIST_BIN_MAGIC &&
+        header.version == LIST_BIN_VERSION &&
+        header.recordSize == sizeof(ListBinRecord) &&
+        header.numPoints > 0 &&
+        file.size() == sizeof(ListBinHeader) + header.numPoints * sizeof(ListBinRecord);
+
+    // the whole file is read once to find if the counter should be displayed and to check dwell times,
+    // voltage and current are checked when the point is set
+    ListBinRecord firstPoint;
+    ListBinRecord lastPoint;
+    bool hasVisibleCounter = false;
+
+    static const uint32_t SCAN_BUFFER_LENGTH = 32;
+    ListBinRecord records[SCAN_BUFFER_LENGTH];
+
+    for (uint32_t i = 0; success && i < header.numPoints; i += SCAN_BUFFER_LENGTH) {
+        uint32_t n = MIN(SCAN_BUFFER_LENGTH, header.numPoints - i);
+        if (file.read(records, n * sizeof(ListBinRecord)) != n * sizeof(ListBinRecord)) {
+            success = false;
+            break;
+        }
+
+        for (uint32_t j = 0; j < n; j++) {
+            if (records[j].dwell < (uint64_t)(LIST_DWELL_MIN * 1000000L + 0.5f) || records[j].dwell > (uint64_t)LIST_DWELL_MAX * 1000000L) {
+                success = false;
+                break;
+            }
+            if (records[j].dwell >= (uint64_t)CONF_LIST_COUNDOWN_DISPLAY_THRESHOLD * 1000000L) {
+                hasVisibleCounter = true;
+            }
+        }
+
+        if (i == 0) {
+            firstPoint = records[0];
+        }
+        lastPoint = records[n - 1];
+    }
+
+    file.close();
+
+    if (!success) {
+        if (err) {
+            *err = SCPI_ERROR_EXECUTION_ERROR;
+        }
+        return false;
+    }
+
+    // list is executed only on the first of the coupled or tracked channels
+    iChannel = getExecutingChannelIndex(iChannel);
+
+    Channel &channel = Channel::get(iChannel);
+    uint16_t count = g_channelsLists[iChannel].count;
+    resetChannelList(channel);
+    g_channelsLists[iChannel].count = count;
+
+    auto &stream = g_streams[iChannel];
+
+    strcpy(stream.filePath, filePath);
+    stream.numPoints = header.numPoints;
+    stream.numSegments = (header.numPoints + CONF_STREAM_SEGMENT_LENGTH - 1) / CONF_STREAM_SEGMENT_LENGTH;
+    stream.hasVisibleCounter = hasVisibleCounter;
+    stream.firstPoint = firstPoint;
+    stream.lastPoint = lastPoint;
+
+    stream.buffers[0] = (ListBinRecord *)(LIST_STREAM_MEMORY + 2 * iChannel * STREAM_BUFFER_SIZE);
+    stream.buffers[1] = (ListBinRecord *)(LIST_STREAM_MEMORY + (2 * iChannel + 1) * STREAM_BUFFER_SIZE);
+    stream.bufferSequence[0] = NO_SEQUENCE;
+    stream.bufferSequence[1] = NO_SEQUENCE;
+    stream.sequence = 0;
+
+    stream.isOpen = true;
+
+    // first two segments are ready before the trigger
+    fillListStream(iChannel);
+
+    if (!isSegmentReady(stream, 0)) {
+        stream.isOpen = false;
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void fillListStream(int iChannel) {
+    auto &stream = g_streams[iChannel];
+    if (!stream.isOpen) {
+        return;
+    }
+
+    File file;
+    bool isFileOpen = false;
+
+    uint32_t sequence = stream.sequence;
+
+    for (uint32_t k = sequence; k != sequence + 2; k++) {
+        if (isSegmentReady(stream, k)) {
+            continue;
+        }
+
+        int b = k % 2;
+
+        if (!isFileOpen) {
+            if (!file.open(stream.filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+                return;
+            }
+            isFileOpen = true;
+        }
+
+        uint32_t firstPoint = (k % stream.numSegments) * CONF_STREAM_SEGMENT_LENGTH;
+        uint32_t size = MIN(CONF_STREAM_SEGMENT_LENGTH, stream.numPoints - firstPoint) * sizeof(ListBinRecord);
+
+        stream.bufferSequence[b] = NO_SEQUENCE;
+
+        if (!file.seek(sizeof(ListBinHeader) + firstPoint * sizeof(ListBinRecord)) || file.read(stream.buffers[b], size) != size) {
+            break;
+        }
+
+        stream.bufferSequence[b] = k;
+    }
+
+    if (isFileOpen) {
+        file.close();
+    }
+}
+
 void updateChannelsWithVisibleCountersList();
 
 void setActive(bool active, bool forceUpdate = false) {
@@ -520,15 +935,49 @@ void setActive(bool active, bool forceUpdate = false) {
     }
 }
 
+static void resetStepTiming(int i) {
+    g_execution[i].numSteps = 0;
+    g_execution[i].numUnderruns = 0;
+    g_execution[i].minLateness = 0xFFFFFFFF;
+    g_execution[i].maxLateness = 0;
+    g_execution[i].sumLateness = 0;
+    g_execution[i].sumSquaredLateness = 0;
+}
+
+static void addStepTiming(int i, uint64_t lateness) {
+    uint32_t value = lateness < 0xFFFFFFFF ? (uint32_t)lateness : 0xFFFFFFFF;
+
+    g_execution[i].numSteps++;
+    if (value < g_execution[i].minLateness) {
+        g_execution[i].minLateness = value;
+    }
+    if (value > g_execution[i].maxLateness) {
+        g_execution[i].maxLateness = value;
+    }
+    g_execution[i].sumLateness += value;
+    g_execution[i].sumSquaredLateness += (uint64_t)value * value;
+}
+
 void executionStart(Channel &channel) {
     g_execution[channel.channelIndex].it = -1;
     g_execution[channel.channelIndex].counter = g_channelsLists[channel.channelIndex].count;
+    resetStepTiming(channel.channelIndex);
+    if (g_streams[channel.channelIndex].isOpen) {
+        g_streams[channel.channelIndex].isStepDue = false;
+        g_streams[channel.channelIndex].isUnderrun = false;
+        g_streams[channel.channelIndex].time = 0;
+        g_execution[channel.channelIndex].lastTickCount = micros();
+    }
     channel_dispatcher::setVoltage(channel, 0);
     channel_dispatcher::setCurrent(channel, 0);
     setActive(true, true);
 }
 
 int maxListsSize(Channel &channel) {
+    if (g_streams[channel.channelIndex].isOpen) {
+        return (int)g_streams[channel.channelIndex].numPoints;
+    }
+
     uint16_t maxSize = 0;
 
     if (g_channelsLists[channel.channelIndex].voltageListLength > maxSize) {
@@ -546,15 +995,15 @@ int maxListsSize(Channel &channel) {
     return maxSize;
 }
 
-bool setListValue(Channel &channel, int16_t it, int *err) {
-    float voltage = channel_dispatcher::roundChannelValue(channel, UNIT_VOLT, g_channelsLists[channel.channelIndex].voltageList[it % g_channelsLists[channel.channelIndex].voltageListLength]);
+static bool setPointValues(Channel &channel, float voltage, float current, int *err) {
+    voltage = channel_dispatcher::roundChannelValue(channel, UNIT_VOLT, voltage);
     if (channel.isVoltageLimitExceeded(voltage)) {
         g_errorChannelIndex = channel.channelIndex;
         *err = SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
         return false;
     }
 
-    float current = channel_dispatcher::roundChannelValue(channel, UNIT_AMPER, g_channelsLists[channel.channelIndex].currentList[it % g_channelsLists[channel.channelIndex].currentListLength]);
+    current = channel_dispatcher::roundChannelValue(channel, UNIT_AMPER, current);
     if (channel.isCurrentLimitExceeded(current)) {
         g_errorChannelIndex = channel.channelIndex;
         *err = SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
@@ -577,6 +1026,149 @@ bool setListValue(Channel &channel, int16_t it, int *err) {
     return true;
 }
 
+bool setListValue(Channel &channel, int it, int *err) {
+    auto &stream = g_streams[channel.channelIndex];
+    if (stream.isOpen) {
+        // only the first and the last point of the streamed list are kept in memory
+        const ListBinRecord *point;
+        if (it == 0) {
+            point = &stream.firstPoint;
+        } else if ((uint32_t)it == stream.numPoints - 1) {
+            point = &stream.lastPoint;
+        } else {
+            if (err) {
+                *err = SCPI_ERROR_CANNOT_SET_LIST_VALUE;
+            }
+            return false;
+        }
+        return setPointValues(channel, point->voltage, point->current, err);
+    }
+
+    auto &channelLists = g_channelsLists[channel.channelIndex];
+    return setPointValues(channel,
+        channelLists.voltageList[it % channelLists.voltageListLength],
+        channelLists.currentList[it % channelLists.currentListLength],
+        err);
+}
+
+static void setRemainingDwellTime(int i, uint64_t remaining) {
+    // same units as in the RAM list execution, see tick
+    if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
+        g_execution[i].currentRemainingDwellTime = (int32_t)(remaining / 1000);
+    } else {
+        g_execution[i].currentRemainingDwellTime = (int32_t)remaining;
+    }
+}
+
+static void requestListStreamFill(int i) {
+    g_streams[i].fillRequestTime = g_streams[i].time;
+    sendMessageToLowPriorityThread(THREAD_MESSAGE_LIST_STREAM_FILL, i, 0);
+}
+
+// Returns false if the list execution is finished or aborted.
+// Dwell time is counted in microseconds from the deadline of the previous point,
+// so the tick period doesn't accumulate into the list time.
+static bool tickStream(Channel &channel, uint32_t tick_usec) {
+    int i = channel.channelIndex;
+    auto &execution = g_execution[i];
+    auto &stream = g_streams[i];
+
+    uint32_t elapsed = tick_usec - execution.lastTickCount;
+    execution.lastTickCount = tick_usec;
+    stream.time += elapsed;
+
+    if (io_pins::isInhibited()) {
+        if (execution.it != -1) {
+            stream.deadline += elapsed;
+        }
+        return true;
+    }
+
+    if (!stream.isStepDue) {
+        if (execution.it == -1) {
+            stream.position = 0;
+            stream.sequence = 0;
+            requestListStreamFill(i);
+        } else {
+            if (stream.time < stream.deadline) {
+                setRemainingDwellTime(i, stream.deadline - stream.time);
+                return true;
+            }
+
+            if (++stream.position == stream.numPoints) {
+                if (execution.counter > 0) {
+                    if (--execution.counter == 0) {
+                        execution.counter = -1;
+                        trigger::setTriggerFinished(channel);
+                        return false;
+                    }
+                }
+
+                stream.position = 0;
+            }
+
+            if (stream.position % CONF_STREAM_SEGMENT_LENGTH == 0) {
+                stream.sequence = stream.sequence + 1;
+                requestListStreamFill(i);
+            }
+        }
+
+        stream.isStepDue = true;
+    }
+
+    uint32_t sequence = stream.sequence;
+
+    if (!isSegmentReady(stream, sequence)) {
+        if (!stream.isUnderrun) {
+            stream.isUnderrun = true;
+            stream.underrunTime = stream.time;
+            execution.numUnderruns++;
+        } else if (stream.time - stream.underrunTime > CONF_STREAM_UNDERRUN_TIMEOUT_US) {
+            generateError(SCPI_ERROR_MASS_STORAGE_ERROR);
+            setActive(false);
+            trigger::abort();
+            return false;
+        }
+
+        if (stream.time - stream.fillRequestTime >= CONF_STREAM_FILL_RETRY_US) {
+            requestListStreamFill(i);
+        }
+
+        return true;
+    }
+
+    const ListBinRecord &point = stream.buffers[sequence % 2][stream.position % CONF_STREAM_SEGMENT_LENGTH];
+
+    int err;
+    if (!setPointValues(channel, point.voltage, point.current, &err)) {
+        generateError(err);
+        setActive(false);
+        trigger::abort();
+        return false;
+    }
+
+    if (execution.it == -1) {
+        execution.it = 0;
+        stream.deadline = stream.time + point.dwell;
+    } else {
+        addStepTiming(i, stream.time - stream.deadline);
+
+        stream.deadline += point.dwell;
+        if (stream.isUnderrun || stream.deadline <= stream.time) {
+            // don't hurry the following points to catch up with the lost time
+            stream.deadline = stream.time + point.dwell;
+        }
+    }
+
+    stream.isStepDue = false;
+    stream.isUnderrun = false;
+
+    execution.currentTotalDwellTime = point.dwell / 1000000.0f;
+    setRemainingDwellTime(i, stream.deadline - stream.time);
+
+    return true;
+}
+
 void tick(uint32_t tick_usec) {
     bool active = false;
 
@@ -591,6 +1183,13 @@ void tick(uint32_t tick_usec) {
 
             active = true;
 
+            if (g_streams[i].isOpen) {
+                if (!tickStream(channel, tick_usec)) {
+                    return;
+                }
+                continue;
+            }
+
             uint32_t tickCount = millis();
             if (g_execution[i].currentTotalDwellTime <= CONF_COUNTER_THRESHOLD_IN_SECONDS) {
                 tickCount *= 1000;
@@ -613,6 +1212,12 @@ void tick(uint32_t tick_usec) {
                 }
 
                 if (set) {
+                    if (g_execution[i].it != -1) {
+                        // remaining dwell time is zero or negative here
+                        uint32_t lateness = (uint32_t)-g_execution[i].currentRemainingDwellTime;
+                        addStepTiming(i, g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS ? lateness * 1000ULL : lateness);
+                    }
+
                     if (++g_execution[i].it == maxListsSize(channel)) {
                         if (g_execution[i].counter > 0) {
                             if (--g_execution[i].counter == 0) {
@@ -675,6 +1280,16 @@ int getFirstTrackingChannel() {
     return -1;
 }
 
+static int getExecutingChannelIndex(int iChannel) {
+    if (iChannel == 1 && (channel_dispatcher::getCouplingType() == channel_dispatcher::COUPLING_TYPE_PARALLEL || channel_dispatcher::getCouplingType() == channel_dispatcher::COUPLING_TYPE_SERIES)) {
+        return 0;
+    }
+    if (Channel::get(iChannel).flags.trackingEnabled) {
+        return getFirstTrackingChannel();
+    }
+    return iChannel;
+}
+
 int32_t getCounter(int channelIndex) {
     if (Channel::get(channelIndex).flags.trackingEnabled) {
         channelIndex = getFirstTrackingChannel();
@@ -686,6 +1301,14 @@ void updateChannelsWithVisibleCountersList() {
     g_numChannelsWithVisibleCounters = 0;
     for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
         if (getCounter(channelIndex) >= 0) {
+            auto &stream = g_streams[getExecutingChannelIndex(channelIndex)];
+            if (stream.isOpen) {
+                if (stream.hasVisibleCounter) {
+                    g_channelsWithVisibleCounters[g_numChannelsWithVisibleCounters++] = channelIndex;
+                }
+                continue;
+            }
+
             auto &channelLists = g_channelsLists[channelIndex];
             for (int j = 0; j < channelLists.dwellListLength; j++) {
                 if (channelLists.dwellList[j] >= CONF_LIST_COUNDOWN_DISPLAY_THRESHOLD) {
@@ -711,6 +1334,27 @@ bool getCurrentDwellTime(Channel &channel, int32_t &remaining, uint32_t &total)
     return false;
 }
 
+void getStepTimingStatistics(Channel &channel, StepTimingStatistics &statistics) {
+    auto &execution = g_execution[getExecutingChannelIndex(channel.channelIndex)];
+
+    statistics.numSteps = execution.numSteps;
+    statistics.numUnderruns = execution.numUnderruns;
+
+    if (execution.numSteps > 0) {
+        statistics.minLateness = execution.minLateness;
+        statistics.maxLateness = execution.maxLateness;
+        double avg = (double)execution.sumLateness / execution.numSteps;
+        double variance = (double)execution.sumSquaredLateness / execution.numSteps - avg * avg;
+        statistics.avgLateness = (float)avg;
+        statistics.jitter = variance > 0 ? (float)sqrt(variance) : 0.0f;
+    } else {
+        statistics.minLateness = 0;
+        statistics.maxLateness = 0;
+        statistics.avgLateness = 0;
+        statistics.jitter = 0;
+    }
+}
+
 void abort() {
     for (int i = 0; i < CH_NUM; ++i) {
         if (g_execution[i].counter >= 0) {
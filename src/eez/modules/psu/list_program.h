@@ -19,6 +19,32 @@
 #pragma once
 
 #define LIST_EXT ".list"
+#define LIST_BIN_EXT ".lbin"
+
+/* Binary List File Format
+
+Lists longer than MAX_LIST_LENGTH are executed from the SD card. Points are stored
+as fixed size records, so any segment of the list is read without parsing.
+Binary list is created from the CSV list file with MMEMory:CONVert:LIST.
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x5453494CL ("LIST")
+
+4         U16     2        VERSION = 0x0001L
+
+6         U16     2        Record size (R) = 16
+
+8         U32     4        Number of points (N)
+
+12        U32     4        Reserved
+
+16                         N records, R bytes each:
+
+          U64     8        Dwell time in microseconds
+          F32     4        Voltage
+          F32     4        Current
+*/
 
 namespace eez {
 
@@ -35,6 +61,27 @@ class BufferedFileWrite;
 
 namespace list {
 
+static const uint32_t LIST_BIN_MAGIC = 0x5453494C;
+static const uint16_t LIST_BIN_VERSION = 1;
+
+#pragma pack(push, 1)
+
+struct ListBinHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t numPoints;
+    uint32_t reserved;
+};
+
+struct ListBinRecord {
+    uint64_t dwell;
+    float voltage;
+    float current;
+};
+
+#pragma pack(pop)
+
 void init();
 
 void resetChannelList(Channel &channel);
@@ -99,11 +146,32 @@ bool saveList(
 );
 bool saveList(int iChannel, const char *filePath, int *err);
 
+// Converts CSV list file to the binary list file, list length is not limited by MAX_LIST_LENGTH
+bool convertList(const char *csvFilePath, const char *binFilePath, int *err);
+
+// Binary list file is executed from the SD card, RAM lists of the channel are cleared
+bool loadListStream(int iChannel, const char *filePath, int *err);
+
+// Called in the low priority thread to read the next segments of the streamed list
+void fillListStream(int iChannel);
+
+struct StepTimingStatistics {
+    uint32_t numSteps;
+    uint32_t numUnderruns; // steps delayed because the segment was not read from the SD card in time
+    uint32_t minLateness;  // us
+    uint32_t maxLateness;  // us
+    float avgLateness;     // us
+    float jitter;          // us, standard deviation of the lateness
+};
+
+// Lateness of every list step after the first one since the last trigger
+void getStepTimingStatistics(Channel &channel, StepTimingStatistics &statistics);
+
 void executionStart(Channel &channel);
 
 int maxListsSize(Channel &channel);
 
-bool setListValue(Channel &channel, int16_t it, int *err);
+bool setListValue(Channel &channel, int it, int *err);
 
 void tick(uint32_t tick_usec);
 
@@ -94,6 +94,7 @@ static DevConfBlock g_devConfBlocks[] = {
     { offsetof(DeviceConfiguration, userSwitchAction), 1, false, 0, 60 * 1000, 0 },
     { offsetof(DeviceConfiguration, ethernetHostName), 1, false, 0, 0, 0 },
     { offsetof(DeviceConfiguration, fanMode), 1, false, 0, 0, 0 },
+    { offsetof(DeviceConfiguration, mqttTelemetryMode), 1, false, 0, 0, 0 },
     { sizeof(DeviceConfiguration), 1, false, 0, 0, 0 },
 };
 
@@ -190,6 +191,13 @@ void initDefaultDevConf() {
     g_defaultDevConf.fanMode = FAN_MODE_AUTO;
     g_defaultDevConf.fanSpeedPercentage = 100;
     g_defaultDevConf.fanSpeedPWM = FAN_MAX_PWM;
+
+    // block 10
+#if OPTION_ETHERNET
+    g_defaultDevConf.mqttTelemetryMode = mqtt::TELEMETRY_MODE_VALUES;
+    g_defaultDevConf.mqttTelemetryOnChange = 0;
+    strcpy(g_defaultDevConf.mqttTelemetryTopic, mqtt::TELEMETRY_TOPIC_DEFAULT);
+#endif
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1149,6 +1157,12 @@ void enableMqtt(bool enable) {
     setMqttSettings(enable, persist_conf::devConf.mqttHost, persist_conf::devConf.mqttPort, persist_conf::devConf.mqttUsername, persist_conf::devConf.mqttPassword, persist_conf::devConf.mqttPeriod);
 }
 
+void setMqttTelemetrySettings(uint8_t mode, bool onChange, const char *topic) {
+    g_devConf.mqttTelemetryMode = mode;
+    g_devConf.mqttTelemetryOnChange = onChange ? 1 : 0;
+    strcpy(g_devConf.mqttTelemetryTopic, topic);
+}
+
 void setSdLocked(bool sdLocked) {
     g_devConf.sdLocked = sdLocked ? 1 : 0;
 }
@@ -1320,6 +1334,8 @@ void loadChannelCalibration(Channel &channel) {
         CH_CAL_CONF_VERSION
     )) {
         channel.clearCalibrationConf();
+    } else {
+        channel.updateCalibrationTables();
     }
 }
 
@@ -196,6 +196,11 @@ struct DeviceConfiguration {
     uint8_t fanMode;
     uint8_t fanSpeedPercentage;
     uint8_t fanSpeedPWM;
+
+    // block 10
+    uint8_t mqttTelemetryMode;
+    unsigned mqttTelemetryOnChange : 1;
+    char mqttTelemetryTopic[32 + 1];
 };
 
 extern const DeviceConfiguration &devConf;
@@ -303,6 +308,7 @@ void setNtpSettings(bool enable, const char *ntpServer);
 
 bool setMqttSettings(bool enable, const char *host, uint16_t port, const char *username, const char *password, float period);
 void enableMqtt(bool enable);
+void setMqttTelemetrySettings(uint8_t mode, bool onChange, const char *topic);
 
 void setSdLocked(bool sdLocked);
 bool isSdLocked();
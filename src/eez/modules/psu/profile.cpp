@@ -16,10 +16,13 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <eez/file_type.h>
 #include <eez/hmi.h>
+#include <eez/system.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel_dispatcher.h>
@@ -83,6 +86,10 @@ enum {
 };
 static bool loadProfileFromFile(const char *filePath, Parameters &profile, List *lists, int options, bool showProgress, int *err);
 
+static bool saveProfileCache(const char *filePath, const Parameters &profile, List *lists);
+static bool loadProfileFromCache(const char *filePath, Parameters &profile, List *lists);
+static bool loadProfile(const char *filePath, Parameters &profile, List *lists, int options, bool showProgress, int *err);
+
 static bool doSaveToLastLocation(int *err);
 static bool doRecallFromLastLocation(int *err);
 
@@ -147,7 +154,7 @@ bool recallFromLocation(int location, int recallOptions, bool showProgress, int
 
     Parameters profile;
     resetProfileToDefaults(profile);
-    if (!loadProfileFromFile(filePath, profile, g_listsProfile0, 0, showProgress, err)) {
+    if (!loadProfile(filePath, profile, g_listsProfile0, 0, showProgress, err)) {
         return false;
     }
 
@@ -227,6 +234,8 @@ bool saveToLocation(int location, const char *name, bool showProgress, int *err)
         return false;
     }
 
+    saveProfileCache(filePath, profile, nullptr);
+
     // save to cache
     memcpy(&g_profilesCache[location], &profile, sizeof(profile));
 
@@ -246,6 +255,12 @@ bool importFileToLocation(const char *filePath, int location, bool showProgress,
     char profileFilePath[MAX_PATH_LENGTH];
     getProfileFilePath(location, profileFilePath);
     if (sd_card::copyFile(filePath, profileFilePath, true, err)) {
+        char cacheFilePath[MAX_PATH_LENGTH + 1];
+        getCacheFilePath(profileFilePath, cacheFilePath);
+        if (sd_card::exists(cacheFilePath, nullptr)) {
+            sd_card::deleteFile(cacheFilePath, nullptr);
+        }
+
         loadProfileParametersToCache(location);
         return true;
     }
@@ -343,7 +358,7 @@ bool setName(int location, const char *name, bool showProgress, int *err) {
 
             Parameters profile;
             resetProfileToDefaults(profile);
-            if (!loadProfileFromFile(filePath, profile, g_listsProfile10, 0, false, err)) {
+            if (!loadProfile(filePath, profile, g_listsProfile10, 0, false, err)) {
                 return false;
             }
 
@@ -356,6 +371,8 @@ bool setName(int location, const char *name, bool showProgress, int *err) {
                 return false;
             }
 
+            saveProfileCache(filePath, profile, g_listsProfile10);
+
             memcpy(profileFromCache, &profile, sizeof(profile));
 
             return true;
@@ -409,7 +426,7 @@ void loadProfileParametersToCache(int location) {
         char filePath[MAX_PATH_LENGTH];
         getProfileFilePath(location, filePath);
         int err;
-        if (!loadProfileFromFile(filePath, g_profilesCache[location], nullptr, 0, false, &err)) {
+        if (!loadProfile(filePath, g_profilesCache[location], nullptr, 0, false, &err)) {
             if (err != SCPI_ERROR_FILE_NOT_FOUND && err != SCPI_ERROR_MISSING_MASS_MEDIA) {
                 generateError(err);
             }
@@ -425,7 +442,7 @@ static void loadProfileName(int location) {
     char filePath[MAX_PATH_LENGTH];
     getProfileFilePath(location, filePath);
     int err;
-    if (!loadProfileFromFile(filePath, g_profilesCache[location], nullptr, LOAD_PROFILE_FROM_FILE_OPTION_ONLY_NAME, false, &err)) {
+    if (!loadProfile(filePath, g_profilesCache[location], nullptr, LOAD_PROFILE_FROM_FILE_OPTION_ONLY_NAME, false, &err)) {
         if (err != SCPI_ERROR_FILE_NOT_FOUND && err != SCPI_ERROR_MISSING_MASS_MEDIA) {
             generateError(err);
         }
@@ -714,6 +731,7 @@ static bool recallState(Parameters &profile, List *lists, int recallOptions, int
     bool mismatch = repositionChannelsInProfileToMatchCurrentChannelConfiguration(profile, lists);
 
     int numTrackingChannels = 0;
+    bool resetHistory = false;
 
     for (int i = 0; i < CH_NUM; ++i) {
         Channel &channel = Channel::get(i);
@@ -761,13 +779,15 @@ static bool recallState(Parameters &profile, List *lists, int recallOptions, int
 
             channel.flags.displayValue1 = profile.channels[i].flags.displayValue1;
             channel.flags.displayValue2 = profile.channels[i].flags.displayValue2;
-            channel.ytViewRate = profile.channels[i].ytViewRate;
             if (channel.flags.displayValue1 == 0 && channel.flags.displayValue2 == 0) {
                 channel.flags.displayValue1 = DISPLAY_VALUE_VOLTAGE;
                 channel.flags.displayValue2 = DISPLAY_VALUE_CURRENT;
             }
-            if (channel.ytViewRate == 0) {
-                channel.ytViewRate = GUI_YT_VIEW_RATE_DEFAULT;
+            float ytViewRate = profile.channels[i].ytViewRate != 0 ? profile.channels[i].ytViewRate : GUI_YT_VIEW_RATE_DEFAULT;
+            if (channel.ytViewRate != ytViewRate) {
+                // history is sampled at the view rate, see channel_dispatcher::setDisplayViewSettings
+                channel.ytViewRate = ytViewRate;
+                resetHistory = true;
             }
 
             channel.flags.voltageTriggerMode = (TriggerMode)profile.channels[i].flags.u_triggerMode;
@@ -812,6 +832,14 @@ static bool recallState(Parameters &profile, List *lists, int recallOptions, int
 
     Channel::updateAllChannels();
 
+    if (resetHistory) {
+        if (!isPsuThread()) {
+            sendMessageToPsu(PSU_MESSAGE_RESET_CHANNELS_HISTORY);
+        } else {
+            Channel::resetHistoryForAllChannels();
+        }
+    }
+
     trigger::g_triggerContinuousInitializationEnabled = profile.flags.triggerContinuousInitializationEnabled;
     trigger::g_triggerSource = (trigger::Source)profile.triggerSource;
     trigger::g_triggerDelay = profile.triggerDelay;
@@ -1168,6 +1196,8 @@ static void saveStateToProfile0(bool merge) {
         generateError(err);
         return;
     }
+
+    saveProfileCache(filePath, g_profilesCache[0], g_listsProfile0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1551,6 +1581,428 @@ static bool loadProfileFromFile(const char *filePath, Parameters &profile, List
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/* Profile Cache File Format
+
+Parsing of the text profile file takes most of the profile recall time, so the profile
+saved to the location is also written in binary form next to the text file.
+Cache file is used only if it matches the size, modification time and content hash of the text
+file and all the checksums are valid, otherwise the text file is loaded and the cache is written
+again. Modification time alone has 2 seconds resolution, so the content hash is also checked.
+Text file is still used for import and export.
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x4E494250L
+
+4         U16     2        VERSION = 0x0003L
+
+6         U16     2        Number of channels (CH_MAX)
+
+8         U32     4        Parameters size (P), changes when profile::Parameters is changed
+
+12        U32     4        Parameters layout, CRC32 of the size and offset of every field
+                           of profile::Parameters, see getParametersLayout
+
+16        U32     4        Profile file size
+
+20        U32     4        Profile file modification time (FAT date and time)
+
+24        U32     4        Profile file content hash (FNV-1a)
+
+28        U32     4        CRC32 of the parameters
+
+32        U8[P]            profile::Parameters
+
+32+P                       Lists, for every channel:
+
+          U16     2        Dwell list length (D)
+          U16     2        Voltage list length (V)
+          U16     2        Current list length (C)
+          U16     2        Reserved
+          U32     4        CRC32 of the dwell list
+          U32     4        CRC32 of the voltage list
+          U32     4        CRC32 of the current list
+          F32[D]           Dwell list
+          F32[V]           Voltage list
+          F32[C]           Current list
+*/
+
+static const uint32_t PROFILE_CACHE_MAGIC = 0x4E494250;
+// Increment when the meaning of some field or the bit fields of profile::Parameters are changed,
+// other changes are detected by the parameters layout.
+static const uint16_t PROFILE_CACHE_VERSION = 3;
+
+static const uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+static const uint32_t FNV_PRIME = 16777619UL;
+
+struct ProfileCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numChannels;
+    uint32_t parametersSize;
+    uint32_t parametersLayout;
+    uint32_t profileFileSize;
+    uint32_t profileFileModificationTime;
+    uint32_t profileFileHash;
+    uint32_t parametersCrc;
+};
+
+struct ProfileCacheListHeader {
+    uint16_t dwellListLength;
+    uint16_t voltageListLength;
+    uint16_t currentListLength;
+    uint16_t reserved;
+    uint32_t dwellListCrc;
+    uint32_t voltageListCrc;
+    uint32_t currentListCrc;
+};
+
+void getCacheFilePath(const char *profileFilePath, char *cacheFilePath) {
+    strcpy(cacheFilePath, profileFilePath);
+    size_t n = strlen(cacheFilePath);
+    size_t extLength = strlen(PROFILE_EXT);
+    if (n >= extLength && strcmp(cacheFilePath + n - extLength, PROFILE_EXT) == 0) {
+        n -= extLength;
+    }
+    strcpy(cacheFilePath + n, PROFILE_CACHE_EXT);
+}
+
+static uint32_t getParametersLayout() {
+    static const uint32_t layout[] = {
+        sizeof(Parameters),
+        offsetof(Parameters, loadStatus),
+        offsetof(Parameters, flags),
+        offsetof(Parameters, name),
+        offsetof(Parameters, channels),
+        offsetof(Parameters, tempProt),
+        offsetof(Parameters, triggerSource),
+        offsetof(Parameters, triggerDelay),
+        offsetof(Parameters, ioPins),
+
+        sizeof(ChannelParameters),
+        offsetof(ChannelParameters, moduleType),
+        offsetof(ChannelParameters, moduleRevision),
+        offsetof(ChannelParameters, flags),
+        offsetof(ChannelParameters, u_set),
+        offsetof(ChannelParameters, u_step),
+        offsetof(ChannelParameters, u_limit),
+        offsetof(ChannelParameters, u_delay),
+        offsetof(ChannelParameters, u_level),
+        offsetof(ChannelParameters, i_set),
+        offsetof(ChannelParameters, i_step),
+        offsetof(ChannelParameters, i_limit),
+        offsetof(ChannelParameters, i_delay),
+        offsetof(ChannelParameters, p_limit),
+        offsetof(ChannelParameters, p_delay),
+        offsetof(ChannelParameters, p_level),
+        offsetof(ChannelParameters, ytViewRate),
+        offsetof(ChannelParameters, u_triggerValue),
+        offsetof(ChannelParameters, i_triggerValue),
+        offsetof(ChannelParameters, listCount),
+        offsetof(ChannelParameters, u_rampDuration),
+        offsetof(ChannelParameters, i_rampDuration),
+        offsetof(ChannelParameters, outputDelayDuration),
+#ifdef EEZ_PLATFORM_SIMULATOR
+        offsetof(ChannelParameters, load_enabled),
+        offsetof(ChannelParameters, load),
+        offsetof(ChannelParameters, voltProgExt),
+#endif
+
+        sizeof(temperature::ProtectionConfiguration),
+        offsetof(temperature::ProtectionConfiguration, delay),
+        offsetof(temperature::ProtectionConfiguration, level),
+        offsetof(temperature::ProtectionConfiguration, state),
+
+        sizeof(io_pins::IOPin)
+    };
+
+    return crc32((const uint8_t *)layout, sizeof(layout));
+}
+
+static bool getProfileFileHash(const char *filePath, uint32_t &hash) {
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    size_t fileSize = file.size();
+    size_t totalRead = 0;
+
+    hash = FNV_OFFSET_BASIS;
+
+    uint8_t buffer[256];
+    while (totalRead < fileSize) {
+        size_t n = file.read(buffer, sizeof(buffer));
+        if (n == 0) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            hash = (hash ^ buffer[i]) * FNV_PRIME;
+        }
+        totalRead += n;
+    }
+
+    file.close();
+
+    return totalRead == fileSize;
+}
+
+static uint32_t getListCrc(const float *list, uint16_t listLength) {
+    return listLength > 0 ? crc32((const uint8_t *)list, listLength * sizeof(float)) : 0;
+}
+
+static bool writeList(File &file, const float *list, uint16_t listLength) {
+    size_t size = listLength * sizeof(float);
+    return size == 0 || file.write(list, size) == size;
+}
+
+static bool readList(File &file, float *list, uint16_t listLength, uint32_t crc) {
+    size_t size = listLength * sizeof(float);
+    if (!list) {
+        return file.seek(file.tell() + size);
+    }
+    return (size == 0 || file.read(list, size) == size) && getListCrc(list, listLength) == crc;
+}
+
+static bool saveProfileCache(const char *filePath, const Parameters &profile, List *lists) {
+    ProfileCacheHeader header;
+    header.magic = PROFILE_CACHE_MAGIC;
+    header.version = PROFILE_CACHE_VERSION;
+    header.numChannels = CH_MAX;
+    header.parametersSize = sizeof(Parameters);
+    header.parametersLayout = getParametersLayout();
+    if (!sd_card::getSizeAndModificationTime(filePath, header.profileFileSize, header.profileFileModificationTime)) {
+        return false;
+    }
+    if (!getProfileFileHash(filePath, header.profileFileHash)) {
+        return false;
+    }
+    header.parametersCrc = crc32((const uint8_t *)&profile, sizeof(Parameters));
+
+    char cacheFilePath[MAX_PATH_LENGTH + 1];
+    getCacheFilePath(filePath, cacheFilePath);
+
+    File file;
+    if (!file.open(cacheFilePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return false;
+    }
+
+    bool result =
+        file.write(&header, sizeof(header)) == sizeof(header) &&
+        file.write(&profile, sizeof(Parameters)) == sizeof(Parameters);
+
+    for (int channelIndex = 0; result && channelIndex < CH_MAX; channelIndex++) {
+        float *dwellList = nullptr;
+        uint16_t dwellListLength = 0;
+        float *voltageList = nullptr;
+        uint16_t voltageListLength = 0;
+        float *currentList = nullptr;
+        uint16_t currentListLength = 0;
+
+        if (profile.channels[channelIndex].flags.parameters_are_valid) {
+            // same lists as written to the text file by profileWrite
+            if (lists) {
+                auto &list = lists[channelIndex];
+                dwellList = list.dwellList;
+                dwellListLength = list.dwellListLength;
+                voltageList = list.voltageList;
+                voltageListLength = list.voltageListLength;
+                currentList = list.currentList;
+                currentListLength = list.currentListLength;
+            } else if (channelIndex < CH_NUM) {
+                auto &channel = Channel::get(channelIndex);
+                dwellList = list::getDwellList(channel, &dwellListLength);
+                voltageList = list::getVoltageList(channel, &voltageListLength);
+                currentList = list::getCurrentList(channel, &currentListLength);
+            }
+        }
+
+        ProfileCacheListHeader listHeader;
+        listHeader.dwellListLength = dwellListLength;
+        listHeader.voltageListLength = voltageListLength;
+        listHeader.currentListLength = currentListLength;
+        listHeader.reserved = 0;
+        listHeader.dwellListCrc = getListCrc(dwellList, dwellListLength);
+        listHeader.voltageListCrc = getListCrc(voltageList, voltageListLength);
+        listHeader.currentListCrc = getListCrc(currentList, currentListLength);
+
+        result =
+            file.write(&listHeader, sizeof(listHeader)) == sizeof(listHeader) &&
+            writeList(file, dwellList, dwellListLength) &&
+            writeList(file, voltageList, voltageListLength) &&
+            writeList(file, currentList, currentListLength);
+    }
+
+    // incompletely written cache file is rejected when loaded
+    file.close();
+
+    return result;
+}
+
+static bool loadProfileFromCache(const char *filePath, Parameters &profile, List *lists) {
+    uint32_t profileFileSize;
+    uint32_t profileFileModificationTime;
+    if (!sd_card::getSizeAndModificationTime(filePath, profileFileSize, profileFileModificationTime)) {
+        return false;
+    }
+
+    char cacheFilePath[MAX_PATH_LENGTH + 1];
+    getCacheFilePath(filePath, cacheFilePath);
+
+    File file;
+    if (!file.open(cacheFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    ProfileCacheHeader header;
+    Parameters parameters;
+    uint32_t profileFileHash;
+
+    // text file is hashed only if the cheaper checks pass
+    bool result =
+        file.read(&header, sizeof(header)) == sizeof(header) &&
+        header.magic == PROFILE_CACHE_MAGIC &&
+        header.version == PROFILE_CACHE_VERSION &&
+        header.numChannels == CH_MAX &&
+        header.parametersSize == sizeof(Parameters) &&
+        header.parametersLayout == getParametersLayout() &&
+        header.profileFileSize == profileFileSize &&
+        header.profileFileModificationTime == profileFileModificationTime &&
+        getProfileFileHash(filePath, profileFileHash) &&
+        header.profileFileHash == profileFileHash &&
+        file.read(&parameters, sizeof(Parameters)) == sizeof(Parameters) &&
+        crc32((const uint8_t *)&parameters, sizeof(Parameters)) == header.parametersCrc;
+
+    for (int channelIndex = 0; result && channelIndex < CH_MAX; channelIndex++) {
+        ProfileCacheListHeader listHeader;
+        result =
+            file.read(&listHeader, sizeof(listHeader)) == sizeof(listHeader) &&
+            listHeader.dwellListLength <= MAX_LIST_LENGTH &&
+            listHeader.voltageListLength <= MAX_LIST_LENGTH &&
+            listHeader.currentListLength <= MAX_LIST_LENGTH;
+
+        if (result) {
+            List *list = lists ? &lists[channelIndex] : nullptr;
+
+            result =
+                readList(file, list ? list->dwellList : nullptr, listHeader.dwellListLength, listHeader.dwellListCrc) &&
+                readList(file, list ? list->voltageList : nullptr, listHeader.voltageListLength, listHeader.voltageListCrc) &&
+                readList(file, list ? list->currentList : nullptr, listHeader.currentListLength, listHeader.currentListCrc);
+
+            if (result && list) {
+                list->dwellListLength = listHeader.dwellListLength;
+                list->voltageListLength = listHeader.voltageListLength;
+                list->currentListLength = listHeader.currentListLength;
+            }
+        }
+    }
+
+    file.close();
+
+    if (!result) {
+        return false;
+    }
+
+    LoadStatus loadStatus = profile.loadStatus;
+    memcpy(&profile, &parameters, sizeof(Parameters));
+    profile.loadStatus = loadStatus;
+
+    return true;
+}
+
+static bool loadProfile(const char *filePath, Parameters &profile, List *lists, int options, bool showProgress, int *err) {
+    if (loadProfileFromCache(filePath, profile, lists)) {
+        return true;
+    }
+
+    if (!loadProfileFromFile(filePath, profile, lists, options, showProgress, err)) {
+        return false;
+    }
+
+    // cache can be written only if lists are also loaded
+    if (lists) {
+        saveProfileCache(filePath, profile, lists);
+    }
+
+    return true;
+}
+
+static bool doBenchmarkLoad(const char *filePath, List *lists, int iterations, BenchmarkResult &result, int *err) {
+    Parameters profile;
+    resetProfileToDefaults(profile);
+    if (!loadProfileFromFile(filePath, profile, lists, 0, false, err)) {
+        return false;
+    }
+
+    if (!saveProfileCache(filePath, profile, lists)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    uint32_t modificationTime;
+    char cacheFilePath[MAX_PATH_LENGTH + 1];
+    getCacheFilePath(filePath, cacheFilePath);
+    sd_card::getSizeAndModificationTime(filePath, result.textFileSize, modificationTime);
+    sd_card::getSizeAndModificationTime(cacheFilePath, result.cacheFileSize, modificationTime);
+
+    uint32_t startTime = micros();
+    for (int i = 0; i < iterations; i++) {
+        resetProfileToDefaults(profile);
+        if (!loadProfileFromFile(filePath, profile, lists, 0, false, err)) {
+            return false;
+        }
+    }
+    result.textLoadTime = (micros() - startTime) / iterations;
+
+    startTime = micros();
+    for (int i = 0; i < iterations; i++) {
+        resetProfileToDefaults(profile);
+        if (!loadProfileFromCache(filePath, profile, lists)) {
+            if (err) {
+                *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+            }
+            return false;
+        }
+    }
+    result.cacheLoadTime = (micros() - startTime) / iterations;
+
+    return true;
+}
+
+bool benchmarkLoad(int location, int iterations, BenchmarkResult &result, int *err) {
+    if (location < 0 || location >= NUM_PROFILE_LOCATIONS || iterations < 1) {
+        if (err) {
+            *err = SCPI_ERROR_DATA_OUT_OF_RANGE;
+        }
+        return false;
+    }
+
+    memset(&result, 0, sizeof(result));
+
+    char filePath[MAX_PATH_LENGTH];
+    getProfileFilePath(location, filePath);
+
+    // Profile lists of the current state must not be changed and file view buffer is owned
+    // by the GUI, so the lists are loaded into the separately allocated buffer.
+    List *lists = (List *)malloc(CH_MAX * sizeof(List));
+    if (!lists) {
+        if (err) {
+            *err = SCPI_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        return false;
+    }
+
+    bool success = doBenchmarkLoad(filePath, lists, iterations, result, err);
+
+    free(lists);
+
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static bool doSaveToLastLocation(int *err) {
     memset(&g_profilesCache[NUM_PROFILE_LOCATIONS - 1], 0, sizeof(Parameters));
     saveState(g_profilesCache[NUM_PROFILE_LOCATIONS - 1], g_listsProfile10);
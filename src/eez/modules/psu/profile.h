@@ -22,6 +22,7 @@
 #include <eez/modules/psu/io_pins.h>
 
 #define PROFILE_EXT ".profile"
+#define PROFILE_CACHE_EXT ".pbin"
 
 namespace eez {
 namespace psu {
@@ -149,6 +150,20 @@ void setFreezeState(bool value);
 
 void loadProfileParametersToCache(int location);
 
+// Binary copy of the profile file kept next to it in the profiles directory.
+void getCacheFilePath(const char *profileFilePath, char *cacheFilePath);
+
+struct BenchmarkResult {
+    uint32_t textFileSize;
+    uint32_t cacheFileSize;
+    uint32_t textLoadTime;  // us
+    uint32_t cacheLoadTime; // us
+};
+
+// Loads profile from the given location, both from the text file and from the binary cache,
+// given number of times and returns average load time.
+bool benchmarkLoad(int location, int iterations, BenchmarkResult &result, int *err);
+
 }
 }
 } // namespace eez::psu::profile
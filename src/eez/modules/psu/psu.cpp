@@ -22,6 +22,7 @@
 
 #include <eez/firmware.h>
 #include <eez/system.h>
+#include <eez/profiler.h>
 #include <eez/sound.h>
 #include <eez/index.h>
 
@@ -66,6 +67,7 @@
 #include <eez/modules/dib-dcp405/dac.h>
 #include <eez/modules/dib-dcp405/adc.h>
 
+#include <eez/modules/bp3c/comm.h>
 #include <eez/modules/bp3c/io_exp.h>
 #include <eez/modules/bp3c/eeprom.h>
 #include <eez/modules/bp3c/flash_slave.h>
@@ -235,7 +237,7 @@ void onThreadMessage(uint8_t type, uint32_t param) {
     } if (type == PSU_MESSAGE_CHANGE_POWER_STATE) {
         changePowerState(param ? true : false);
     } else if (type == PSU_MESSAGE_RESET) {
-        reset();
+        reset(param ? true : false);
     } else if (type == PSU_MESSAGE_TEST) {
         test();
     } else if (type == PSU_MESSAGE_SPI_IRQ) {
@@ -276,6 +278,11 @@ void onThreadMessage(uint8_t type, uint32_t param) {
     } else if (type == PSU_MESSAGE_FLASH_SLAVE_LEAVE_BOOTLOADER_MODE) {
         bp3c::flash_slave::leaveBootloaderMode();
     }
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    else if (type == PSU_MESSAGE_BP3C_COMM_BENCHMARK) {
+        bp3c::comm::doBenchmark();
+    }
+#endif
 }
 
 bool measureAllAdcValuesOnChannel(int channelIndex) {
@@ -326,7 +333,7 @@ bool testChannels() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool psuReset() {
+bool psuReset(bool resetScpiContexts) {
     channel_dispatcher::disableOutputForAllChannels();
 
     // *ESE 0
@@ -401,7 +408,9 @@ bool psuReset() {
     reg_set(SCPI_PSU_CH_REG_QUES_INST_ISUM_ENABLE1, 0);
     reg_set(SCPI_PSU_CH_REG_QUES_INST_ISUM_ENABLE2, 0);
 
-    eez::scpi::resetContext();
+    if (resetScpiContexts) {
+        eez::scpi::resetContext();
+    }
 
 #if OPTION_ETHERNET
     ntp::reset();
@@ -669,14 +678,17 @@ void onProtectionTripped() {
 ////////////////////////////////////////////////////////////////////////////////
 
 typedef void (*TickFunc)(uint32_t tickCount);
-static TickFunc g_tickFuncs[] = {
-    temperature::tick,
+static struct {
+    TickFunc func;
+    profiler::Zone zone;
+} g_tickFuncs[] = {
+    { temperature::tick, profiler::ZONE_TEMPERATURE_TICK },
 #if OPTION_FAN
-    aux_ps::fan::tick,
+    { aux_ps::fan::tick, profiler::ZONE_FAN_TICK },
 #endif
-    datetime::tick
+    { datetime::tick, profiler::ZONE_DATETIME_TICK }
 };
-static const int NUM_TICK_FUNCS = sizeof(g_tickFuncs) / sizeof(TickFunc);
+static const int NUM_TICK_FUNCS = sizeof(g_tickFuncs) / sizeof(g_tickFuncs[0]);
 static int g_tickFuncIndex = 0;
 
 void tick() {
@@ -695,7 +707,10 @@ void tick() {
 
     io_pins::tick(tickCount);
 
-    g_tickFuncs[g_tickFuncIndex](tickCount);
+    {
+        profiler::ZoneScope zoneScope(g_tickFuncs[g_tickFuncIndex].zone);
+        g_tickFuncs[g_tickFuncIndex].func(tickCount);
+    }
     g_tickFuncIndex = (g_tickFuncIndex + 1) % NUM_TICK_FUNCS;
 
     if (g_diagCallback) {
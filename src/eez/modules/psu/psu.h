@@ -90,7 +90,7 @@ bool isPowerUp();
 void changePowerState(bool up);
 void powerDownBySensor();
 
-bool psuReset();
+bool psuReset(bool resetScpiContexts = true);
 
 bool autoRecall(int recallOptions = 0);
 
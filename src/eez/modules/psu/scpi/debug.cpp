@@ -21,6 +21,8 @@
 
 #include <eez/firmware.h>
 #include <eez/system.h>
+#include <eez/mp.h>
+#include <eez/sound.h>
 
 #if OPTION_FAN
 #include <eez/modules/aux_ps/fan.h>
@@ -31,18 +33,36 @@
 #include <eez/modules/psu/temperature.h>
 #include <eez/modules/psu/ontime.h>
 #include <eez/modules/psu/scpi/psu.h>
+#include <eez/scpi/commands_debug.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/event_log.h>
+#include <eez/modules/psu/profile.h>
+#include <eez/modules/psu/calibration.h>
+#include <eez/modules/psu/list_program.h>
 #if OPTION_DISPLAY
 #include <eez/modules/psu/gui/psu.h>
+#include <eez/gui/input.h>
+#include <eez/modules/mcu/display.h>
+#include <eez/libs/image/jpeg.h>
 #endif
 
 #include <eez/modules/mcu/eeprom.h>
 
+#include <eez/modules/bp3c/comm.h>
 #include <eez/modules/bp3c/flash_slave.h>
 #include <eez/modules/bp3c/io_exp.h>
 
 #include <eez/modules/dib-dcp405/channel.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <cmsis_os.h>
+#endif
+
+#if OPTION_ETHERNET
+#include <eez/modules/mcu/ethernet.h>
+#include <eez/mqtt.h>
+#endif
+
 namespace eez {
 namespace psu {
 
@@ -473,6 +493,616 @@ scpi_result_t scpi_cmd_debugEvent(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+#if OPTION_SCPI_DEBUG_QUERIES
+
+scpi_result_t scpi_cmd_debugOsQueueQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    int32_t numIterations;
+    if (!SCPI_ParamInt32(context, &numIterations, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numIterations = 10000;
+    }
+
+    if (numIterations < 1 || numIterations > 1000000) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t minLatency;
+    uint32_t avgLatency;
+    uint32_t maxLatency;
+    if (!osMessageRoundTripBenchmark(numIterations, minLatency, avgLatency, maxLatency)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+        return SCPI_RES_ERR;
+    }
+
+    // round trip latency in microseconds
+    SCPI_ResultUInt32(context, minLatency);
+    SCPI_ResultUInt32(context, avgLatency);
+    SCPI_ResultUInt32(context, maxLatency);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+// representative command mix used to measure SCPI command header lookup speed
+static const char *g_dispatchBenchmarkCommands[] = {
+    "*IDN?",
+    "*OPC?",
+    "SYST:ERR?",
+    "INST CH1",
+    "INST:NSEL?",
+    "VOLT 5",
+    "CURR 0.5",
+    "VOLT?",
+    "CURR?",
+    "OUTP ON",
+    "OUTP?",
+    "MEAS:VOLT?",
+    "MEAS:CURR?",
+    "MEAS:POW?",
+    "MEASure:SCALar:VOLTage:DC?",
+    "SOUR2:VOLT:LIM?",
+    "SOURce:CURRent:PROTection:STATe ON",
+    "SYST:TEMP:PROT? AUX",
+    "SENS:DLOG:TRAC:X:UNIT?",
+    "DISP:WIN:TEXT?",
+    "STAT:QUES:INST:ISUM1:COND?",
+    "NOSUCH:COMMand?",
+};
+
+scpi_result_t scpi_cmd_debugScpiDispatchQ(scpi_t *context) {
+#if USE_COMMAND_INDEX
+    int32_t numIterations;
+    if (!SCPI_ParamInt32(context, &numIterations, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numIterations = 1000;
+    }
+
+    if (numIterations < 1 || numIterations > 100000) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    if (!context->cmd_index) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    static const size_t NUM_COMMANDS = sizeof(g_dispatchBenchmarkCommands) / sizeof(const char *);
+
+    // verify index against the linear search
+    uint32_t numMismatches = 0;
+    for (size_t i = 0; i < NUM_COMMANDS; i++) {
+        const char *header = g_dispatchBenchmarkCommands[i];
+        size_t len = strcspn(header, " ");
+        const scpi_command_t *cmd;
+        if (!SCPI_CommandIndexFind(context->cmd_index, header, len, &cmd) || cmd != SCPI_CommandListFind(context->cmdlist, header, len)) {
+            numMismatches++;
+        }
+    }
+
+    uint32_t numCommands = numIterations * NUM_COMMANDS;
+
+    uint32_t start = micros();
+    for (int32_t iteration = 0; iteration < numIterations; iteration++) {
+        for (size_t i = 0; i < NUM_COMMANDS; i++) {
+            const char *header = g_dispatchBenchmarkCommands[i];
+            const scpi_command_t *cmd;
+            SCPI_CommandIndexFind(context->cmd_index, header, strcspn(header, " "), &cmd);
+        }
+    }
+    uint32_t indexDuration = micros() - start;
+
+    start = micros();
+    for (int32_t iteration = 0; iteration < numIterations; iteration++) {
+        for (size_t i = 0; i < NUM_COMMANDS; i++) {
+            const char *header = g_dispatchBenchmarkCommands[i];
+            SCPI_CommandListFind(context->cmdlist, header, strcspn(header, " "));
+        }
+    }
+    uint32_t linearDuration = micros() - start;
+
+    // commands per second
+    SCPI_ResultUInt32(context, (uint32_t)(1000000.0 * numCommands / (indexDuration > 0 ? indexDuration : 1)));
+    SCPI_ResultUInt32(context, (uint32_t)(1000000.0 * numCommands / (linearDuration > 0 ? linearDuration : 1)));
+    SCPI_ResultUInt32(context, numMismatches);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugEthernetLoad(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR) && OPTION_ETHERNET
+    int32_t numClients;
+    if (!SCPI_ParamInt32(context, &numClients, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numClients = mcu::ethernet::MAX_NUM_CLIENTS;
+    }
+
+    int32_t numRequests;
+    if (!SCPI_ParamInt32(context, &numRequests, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numRequests = 1000;
+    }
+
+    if (numClients < 1 || numClients > mcu::ethernet::MAX_NUM_CLIENTS || numRequests < 1 || numRequests > 1000000) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    char command[64];
+    const char *text;
+    size_t len;
+    if (SCPI_ParamCharacters(context, &text, &len, false)) {
+        if (len == 0 || len >= sizeof(command)) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+        memcpy(command, text, len);
+        command[len] = 0;
+    } else {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        strcpy(command, "MEAS:VOLT?");
+    }
+
+    // Test runs in the background, result is available with DEBU:ETH:LOAD?
+    if (!mcu::ethernet::startLoadTest(numClients, numRequests, command)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugEthernetLoadQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR) && OPTION_ETHERNET
+    mcu::ethernet::LoadTestResult result;
+    mcu::ethernet::getLoadTestResult(result);
+
+    SCPI_ResultBool(context, result.isFinished);
+    SCPI_ResultInt(context, result.numClients);
+    SCPI_ResultInt(context, result.numRequests);
+    SCPI_ResultInt(context, result.numErrors);
+    SCPI_ResultUInt32(context, result.duration);
+
+    // requests per second
+    SCPI_ResultUInt32(context, result.isFinished && result.duration > 0 ?
+        (uint32_t)(1000.0 * result.numClients * result.numRequests / result.duration) : 0);
+
+    // average and max latency in microseconds for each client
+    for (int i = 0; i < result.numClients; i++) {
+        SCPI_ResultUInt32(context, (uint32_t)result.avgLatency[i]);
+        SCPI_ResultUInt32(context, result.maxLatency[i]);
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugMqttQ(scpi_t *context) {
+#if OPTION_ETHERNET
+    mqtt::Stats stats;
+    mqtt::getAndResetStats(stats);
+
+    // published since the last DEBU:MQTT? query
+    SCPI_ResultUInt32(context, stats.numMessages);
+    SCPI_ResultUInt32(context, stats.numBytes);
+    SCPI_ResultUInt32(context, stats.numChannelUpdates);
+    SCPI_ResultUInt32(context, stats.duration);
+
+    // complete channel state updates per second
+    SCPI_ResultFloat(context, stats.duration > 0 ? 1000.0f * stats.numChannelUpdates / stats.duration : 0.0f);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugMpQ(scpi_t *context) {
+    // timings of the last script start, in microseconds
+    SCPI_ResultBool(context, mp::g_startupStats.fromCache);
+    SCPI_ResultUInt32(context, mp::g_startupStats.loadTime);
+    SCPI_ResultUInt32(context, mp::g_startupStats.compileTime);
+    SCPI_ResultUInt32(context, mp::g_startupStats.totalTime);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugEventBenchmarkQ(scpi_t *context) {
+    uint32_t numEvents;
+    if (!SCPI_ParamUInt32(context, &numEvents, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numEvents = 100000;
+    }
+
+    char dirPath[MAX_PATH_LENGTH + 1];
+    strcpy(dirPath, LOGS_DIR);
+    strcat(dirPath, PATH_SEPARATOR "Benchmark");
+
+    event_log::BenchmarkResult result;
+    int err;
+    if (!event_log::benchmark(dirPath, numEvents, result, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    // append time in milliseconds, then for every filter from DEBUG to ERROR:
+    // number of events, number of pages, average and maximum page read time in microseconds
+    SCPI_ResultUInt32(context, result.appendTime);
+    for (int filter = event_queue::EVENT_TYPE_DEBUG; filter <= event_queue::EVENT_TYPE_ERROR; filter++) {
+        SCPI_ResultUInt32(context, result.numEvents[filter]);
+        SCPI_ResultUInt32(context, result.numPages[filter]);
+        SCPI_ResultUInt32(context, result.avgPageReadTime[filter]);
+        SCPI_ResultUInt32(context, result.maxPageReadTime[filter]);
+    }
+    SCPI_ResultUInt32(context, result.cachedPageReadTime);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugProfileBenchmarkQ(scpi_t *context) {
+    int location;
+    if (!get_profile_location_param(context, location, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t iterations;
+    if (!SCPI_ParamUInt32(context, &iterations, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        iterations = 10;
+    }
+
+    profile::BenchmarkResult result;
+    int err;
+    if (!profile::benchmarkLoad(location, (int)iterations, result, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    // text and binary file size in bytes, then text and binary load time in microseconds
+    SCPI_ResultUInt32(context, result.textFileSize);
+    SCPI_ResultUInt32(context, result.cacheFileSize);
+    SCPI_ResultUInt32(context, result.textLoadTime);
+    SCPI_ResultUInt32(context, result.cacheLoadTime);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugEepromStatisticsQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    mcu::eeprom::Statistics statistics;
+    mcu::eeprom::getStatistics(statistics);
+
+    SCPI_ResultUInt32(context, statistics.numReads);
+    SCPI_ResultUInt32(context, statistics.numWrites);
+    SCPI_ResultUInt32(context, statistics.numBytesWritten);
+    SCPI_ResultUInt32(context, statistics.numBytesChanged);
+    SCPI_ResultUInt32(context, statistics.numPageWrites);
+    SCPI_ResultUInt32(context, statistics.maxPageWrites);
+    SCPI_ResultUInt32(context, statistics.numFlushes);
+    SCPI_ResultUInt32(context, statistics.numFlushedBytes);
+    SCPI_ResultUInt32(context, statistics.writeTime);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugEepromStatisticsPagesQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    SCPI_ResultArrayUInt32(context, mcu::eeprom::getPageWrites(), mcu::eeprom::EEPROM_NUM_PAGES, SCPI_FORMAT_ASCII);
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugEepromStatisticsReset(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    mcu::eeprom::resetStatistics();
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugAssetsStatisticsQ(scpi_t *context) {
+#if OPTION_DISPLAY
+    eez::gui::AssetsStatistics statistics;
+    eez::gui::getAssetsStatistics(statistics);
+
+    SCPI_ResultBool(context, statistics.sectioned);
+    SCPI_ResultUInt32(context, statistics.compressedSize);
+    SCPI_ResultUInt32(context, statistics.bootDecompressedSize);
+    SCPI_ResultUInt32(context, statistics.bootTime);
+    SCPI_ResultUInt32(context, statistics.numItems);
+    SCPI_ResultUInt32(context, statistics.cacheSize);
+    SCPI_ResultUInt32(context, statistics.cacheUsed);
+    SCPI_ResultUInt32(context, statistics.cacheHighWaterMark);
+    SCPI_ResultUInt32(context, statistics.numHits);
+    SCPI_ResultUInt32(context, statistics.numLoads);
+    SCPI_ResultUInt32(context, statistics.numEvictions);
+    SCPI_ResultUInt32(context, statistics.numFailedLoads);
+    SCPI_ResultUInt32(context, statistics.numReservedLoads);
+    SCPI_ResultUInt32(context, statistics.loadTime);
+    SCPI_ResultUInt32(context, statistics.maxLoadTime);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugCalibrationBenchmarkQ(scpi_t *context) {
+    calibration::BenchmarkResult result;
+    calibration::benchmark(result);
+
+    SCPI_ResultUInt32(context, result.numConfigurations);
+    SCPI_ResultUInt32(context, result.numSamples);
+    SCPI_ResultUInt32(context, result.numDifferences);
+    SCPI_ResultArrayUInt32(context, result.linearSearchTime, calibration::NUM_BENCHMARK_SIZES, SCPI_FORMAT_ASCII);
+    SCPI_ResultArrayUInt32(context, result.tableTime, calibration::NUM_BENCHMARK_SIZES, SCPI_FORMAT_ASCII);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugListJitterQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::StepTimingStatistics statistics;
+    list::getStepTimingStatistics(*channel, statistics);
+
+    // number of steps and underruns, then min, avg, max and standard deviation of the step lateness in microseconds
+    SCPI_ResultUInt32(context, statistics.numSteps);
+    SCPI_ResultUInt32(context, statistics.numUnderruns);
+    SCPI_ResultUInt32(context, statistics.minLateness);
+    SCPI_ResultFloat(context, statistics.avgLateness);
+    SCPI_ResultUInt32(context, statistics.maxLateness);
+    SCPI_ResultFloat(context, statistics.jitter);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugJpegBenchmarkQ(scpi_t *context) {
+#if OPTION_DISPLAY
+    JpegEncodeParams params;
+
+    uint32_t quality;
+    if (SCPI_ParamUInt32(context, &quality, FALSE)) {
+        if (quality < 1 || quality > 100) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+        params.quality = (uint8_t)quality;
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t subsampling;
+    if (SCPI_ParamUInt32(context, &subsampling, FALSE)) {
+        if (subsampling == 444) {
+            params.subsampling = JPEG_SUBSAMPLING_444;
+        } else if (subsampling == 422) {
+            params.subsampling = JPEG_SUBSAMPLING_422;
+        } else if (subsampling == 420) {
+            params.subsampling = JPEG_SUBSAMPLING_420;
+        } else {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t numThreads;
+    if (SCPI_ParamUInt32(context, &numThreads, FALSE)) {
+        if (numThreads < 1 || numThreads > 16) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+        params.numThreads = (uint8_t)numThreads;
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    const uint8_t *pixels = mcu::display::takeScreenshot();
+    int width = mcu::display::getDisplayWidth();
+    int height = mcu::display::getDisplayHeight();
+
+    JpegBenchmarkResult result;
+    if (!jpegBenchmark(pixels, width, height, 3 * width, params, result)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
+        return SCPI_RES_ERR;
+    }
+
+    // width and height, JPEG size in bytes, single thread and parallel encode time in microseconds,
+    // 1 if parallel output is the same, PSNR of the decoded image in dB
+    SCPI_ResultUInt32(context, width);
+    SCPI_ResultUInt32(context, height);
+    SCPI_ResultUInt32(context, result.imageSize);
+    SCPI_ResultUInt32(context, result.encodeTime);
+    SCPI_ResultUInt32(context, result.parallelEncodeTime);
+    SCPI_ResultBool(context, result.isParallelOutputSame);
+    SCPI_ResultFloat(context, result.psnr);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugTextBenchmarkQ(scpi_t *context) {
+#if OPTION_DISPLAY
+    eez::gui::text_run_cache::BenchmarkResult result;
+    gui::textRunCacheBenchmark(result);
+
+    // number of draws, uncached and cached draw time in microseconds,
+    // number of texts checked in the cache, 1 if cached texts are pixel identical
+    SCPI_ResultUInt32(context, result.numDraws);
+    SCPI_ResultUInt32(context, result.uncachedTime);
+    SCPI_ResultUInt32(context, result.cachedTime);
+    SCPI_ResultUInt32(context, result.numCachedTexts);
+    SCPI_ResultBool(context, result.isPixelIdentical);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugSoundQ(scpi_t *context) {
+    sound::Statistics statistics;
+    sound::getStatistics(statistics);
+    sound::resetStatistics();
+
+    // init time, number of played sounds, number of sounds which stopped another sound,
+    // last, max and average latency from the play request to the first mixed sample,
+    // all times in microseconds
+    SCPI_ResultUInt32(context, statistics.initTime);
+    SCPI_ResultUInt32(context, statistics.numPlays);
+    SCPI_ResultUInt32(context, statistics.numStolenVoices);
+    SCPI_ResultUInt32(context, statistics.lastLatency);
+    SCPI_ResultUInt32(context, statistics.maxLatency);
+    SCPI_ResultUInt32(context, statistics.numPlays > 0 ? statistics.totalLatency / statistics.numPlays : 0);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugInputQ(scpi_t *context) {
+#if OPTION_DISPLAY
+    eez::gui::input::Statistics statistics;
+    eez::gui::input::getStatistics(statistics);
+    eez::gui::input::resetStatistics();
+
+    // for the touch, encoder and keyboard: number of events, number of pushes
+    // refused because the ring was full and max. number of events waiting in the ring
+    for (int i = 0; i < eez::gui::input::NUM_SOURCES; i++) {
+        SCPI_ResultUInt32(context, statistics.numEvents[i]);
+        SCPI_ResultUInt32(context, statistics.numFullRingPushes[i]);
+        SCPI_ResultUInt32(context, statistics.maxQueuedEvents[i]);
+    }
+
+    // number of frames shown after the events, last, max and average latency
+    // from the event to the frame shown in microseconds
+    SCPI_ResultUInt32(context, statistics.numFrames);
+    SCPI_ResultUInt32(context, statistics.lastLatency);
+    SCPI_ResultUInt32(context, statistics.maxLatency);
+    SCPI_ResultUInt32(context, statistics.numFrames > 0 ? (uint32_t)(statistics.totalLatency / statistics.numFrames) : 0);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+static void resultBp3cCommStatistics(scpi_t *context, const bp3c::comm::Statistics &statistics) {
+    // for every slot: number of transfers, retries, CRC errors and other errors,
+    // last, max and average latency from the queue to the module notification in microseconds
+    for (int i = 0; i < NUM_SLOTS; i++) {
+        const bp3c::comm::SlotStatistics &slotStatistics = statistics.slots[i];
+        SCPI_ResultUInt32(context, slotStatistics.numTransfers);
+        SCPI_ResultUInt32(context, slotStatistics.numRetries);
+        SCPI_ResultUInt32(context, slotStatistics.numCrcErrors);
+        SCPI_ResultUInt32(context, slotStatistics.numErrors);
+        SCPI_ResultUInt32(context, slotStatistics.lastLatency);
+        SCPI_ResultUInt32(context, slotStatistics.maxLatency);
+        SCPI_ResultUInt32(context, slotStatistics.numTransfers > 0 ? (uint32_t)(slotStatistics.totalLatency / slotStatistics.numTransfers) : 0);
+    }
+}
+
+scpi_result_t scpi_cmd_debugBp3cStatisticsQ(scpi_t *context) {
+    bp3c::comm::Statistics statistics;
+    bp3c::comm::getStatistics(statistics);
+    bp3c::comm::resetStatistics();
+
+    resultBp3cCommStatistics(context, statistics);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugBp3cBenchmarkQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    bp3c::comm::BusTiming busTiming = { 6750000, 10, 0 };
+    uint32_t numTicks = 1000;
+
+    uint32_t *params[] = { &busTiming.bitRate, &busTiming.transferOverhead, &busTiming.crcErrorRate, &numTicks };
+    for (unsigned i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+        if (!SCPI_ParamUInt32(context, params[i], false)) {
+            if (SCPI_ParamErrorOccurred(context)) {
+                return SCPI_RES_ERR;
+            }
+            break;
+        }
+    }
+
+    if (busTiming.bitRate == 0 || busTiming.crcErrorRate > 1000 || numTicks > bp3c::comm::MAX_BENCHMARK_TICKS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    bp3c::comm::BenchmarkResult result;
+    if (!bp3c::comm::benchmark(busTiming, numTicks, result)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // number of ticks, average tick period in microseconds with the serial
+    // and with the overlapped transfers, statistics of the overlapped transfers
+    SCPI_ResultUInt32(context, result.numTicks);
+    SCPI_ResultUInt32(context, result.serialTickPeriod);
+    SCPI_ResultUInt32(context, result.overlappedTickPeriod);
+    resultBp3cCommStatistics(context, result.statistics);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+#endif // OPTION_SCPI_DEBUG_QUERIES
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
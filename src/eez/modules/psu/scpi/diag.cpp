@@ -16,10 +16,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdarg.h>
 #include <stdio.h>
 
 #include <eez/system.h>
 #include <eez/index.h>
+#include <eez/profiler.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/calibration.h>
@@ -337,6 +339,76 @@ scpi_result_t scpi_cmd_diagnosticInformationRegsQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+static void appendFormatted(char *buffer, size_t bufferSize, const char *format, ...) {
+    size_t length = strlen(buffer);
+    if (length + 1 >= bufferSize) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer + length, bufferSize - length, format, args);
+    va_end(args);
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationProfileQ(scpi_t *context) {
+    using namespace eez::profiler;
+
+    // static, as in debug.cpp, to keep it off the SCPI thread stack,
+    // output is truncated when the buffer is full
+    static char buffer[2048];
+
+    buffer[0] = 0;
+
+    uint32_t elapsedTime = getElapsedTime();
+    appendFormatted(buffer, sizeof(buffer), "ELAPSED %lu ms\n", (unsigned long)elapsedTime);
+
+    // zone columns: count, avg, min and max duration in us, load in % of the elapsed time,
+    // histogram without the trailing empty buckets (bucket i counts durations from 2^i us)
+    for (int thread = 0; thread < NUM_THREADS; thread++) {
+        appendFormatted(buffer, sizeof(buffer), "%s:\n", getThreadName((Thread)thread));
+
+        for (int zone = 0; zone < NUM_ZONES; zone++) {
+            if (getZoneThread((Zone)zone) != thread) {
+                continue;
+            }
+
+            ZoneStatistics statistics;
+            getZoneStatistics((Zone)zone, statistics);
+
+            uint32_t avgDuration = statistics.count > 0 ? (uint32_t)(statistics.totalDuration / statistics.count) : 0;
+            uint32_t load = elapsedTime > 0 ? (uint32_t)(statistics.totalDuration * 10 / elapsedTime) : 0; // 0.01 %
+
+            appendFormatted(buffer, sizeof(buffer), "\t%-16s %lu %lu %lu %lu %lu.%02lu%%",
+                getZoneName((Zone)zone),
+                (unsigned long)statistics.count,
+                (unsigned long)avgDuration,
+                (unsigned long)statistics.minDuration,
+                (unsigned long)statistics.maxDuration,
+                (unsigned long)(load / 100), (unsigned long)(load % 100));
+
+            int numBuckets = NUM_HISTOGRAM_BUCKETS;
+            while (numBuckets > 0 && statistics.histogram[numBuckets - 1] == 0) {
+                numBuckets--;
+            }
+            for (int bucket = 0; bucket < numBuckets; bucket++) {
+                appendFormatted(buffer, sizeof(buffer), " %lu", (unsigned long)statistics.histogram[bucket]);
+            }
+
+            appendFormatted(buffer, sizeof(buffer), "\n");
+        }
+    }
+
+    SCPI_ResultCharacters(context, buffer, strlen(buffer));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationProfileReset(scpi_t *context) {
+    profiler::reset();
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
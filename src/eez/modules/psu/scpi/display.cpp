@@ -169,11 +169,13 @@ scpi_result_t scpi_cmd_displayWindowTextClear(scpi_t *context) {
 scpi_result_t scpi_cmd_displayDataQ(scpi_t *context) {
 #if OPTION_DISPLAY
     const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
+    int width = mcu::display::getDisplayWidth();
+    int height = mcu::display::getDisplayHeight();
 
     unsigned char* imageData;
     size_t imageDataSize;
 
-    if (jpegEncode(screenshotPixels, &imageData, &imageDataSize)) {
+    if (jpegEncode(screenshotPixels, width, height, 3 * width, JpegEncodeParams(), &imageData, &imageDataSize)) {
     	SCPI_ErrorPush(context, SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
     	return SCPI_RES_ERR;
     }
@@ -20,6 +20,8 @@
 
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/dlog_index.h>
+#include <eez/modules/psu/sd_card.h>
 
 namespace eez {
 namespace psu {
@@ -143,6 +145,108 @@ scpi_result_t scpi_cmd_senseDlogFunctionPowerQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_senseDlogIndex(scpi_t *context) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, filePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int err;
+    if (!dlog_index::rebuild(filePath, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseDlogDataQ(scpi_t *context) {
+    static const uint32_t CHUNK_SIZE = 256; // in number of floats
+    static float g_chunk[CHUNK_SIZE];
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, filePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t startSample;
+    if (!SCPI_ParamInt32(context, &startSample, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        startSample = 0;
+    }
+
+    int32_t numSamples;
+    if (!SCPI_ParamInt32(context, &numSamples, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numSamples = -1; // all the samples till the end of file
+    }
+
+    if (startSample < 0 || numSamples < -1) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    int err;
+    if (!sd_card::isMounted(&err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_FILE_NAME_NOT_FOUND);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t dataOffset;
+    uint16_t numYAxes;
+    if (!dlog_index::readDlogHeader(file, dataOffset, numYAxes)) {
+        file.close();
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t rowSize = numYAxes * sizeof(float);
+    uint32_t fileSize = file.size();
+    uint32_t numFileSamples = fileSize > dataOffset ? (fileSize - dataOffset) / rowSize : 0;
+
+    if ((uint32_t)startSample > numFileSamples) {
+        startSample = numFileSamples;
+    }
+    if (numSamples == -1 || (uint32_t)numSamples > numFileSamples - startSample) {
+        numSamples = numFileSamples - startSample;
+    }
+
+    if (!file.seek(dataOffset + startSample * rowSize)) {
+        file.close();
+        SCPI_ErrorPush(context, SCPI_ERROR_MASS_STORAGE_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // values are sent row by row, i.e. numYAxes values for each sample
+    uint32_t numValues = numSamples * numYAxes;
+    resultFloatArrayBegin(context, numValues);
+    while (numValues > 0) {
+        uint32_t n = MIN(numValues, CHUNK_SIZE);
+        if (file.read(g_chunk, n * sizeof(float)) != n * sizeof(float)) {
+            // block length is already sent, so remaining values are filled with NaN
+            for (uint32_t i = 0; i < n; i++) {
+                g_chunk[i] = NAN;
+            }
+        }
+        resultFloatArrayData(context, g_chunk, n);
+        numValues -= n;
+    }
+
+    file.close();
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_senseDlogPeriod(scpi_t *context) {
     if (!dlog_record::isIdle()) {
         SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
@@ -0,0 +1,149 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/modules/psu/psu.h>
+
+#include <eez/modules/psu/scpi/psu.h>
+
+namespace eez {
+namespace psu {
+namespace scpi {
+
+static const size_t BLOCK_DATA_CHUNK_SIZE = 64; // in number of floats
+
+static scpi_choice_def_t dataFormatChoice[] = {
+    { "ASCii", SCPI_FORMAT_ASCII },
+    { "REAL", SCPI_FORMAT_NORMAL },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static scpi_choice_def_t byteOrderChoice[] = {
+    { "NORMal", SCPI_FORMAT_NORMAL },
+    { "SWAPped", SCPI_FORMAT_SWAPPED },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+scpi_array_format_t getDataFormat(scpi_t *context) {
+    scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
+    if (psu_context->dataFormat == SCPI_FORMAT_ASCII) {
+        return SCPI_FORMAT_ASCII;
+    }
+    return psu_context->byteOrder;
+}
+
+static bool isNativeByteOrder(scpi_array_format_t format) {
+    static const uint16_t test = 1;
+    bool isLittleEndian = *(const uint8_t *)&test == 1;
+    return format == (isLittleEndian ? SCPI_FORMAT_SWAPPED : SCPI_FORMAT_NORMAL);
+}
+
+void resultFloatArray(scpi_t *context, const float *values, size_t count) {
+    resultFloatArrayBegin(context, count);
+    resultFloatArrayData(context, values, count);
+}
+
+void resultFloatArrayBegin(scpi_t *context, size_t count) {
+    if (getDataFormat(context) != SCPI_FORMAT_ASCII) {
+        SCPI_ResultArbitraryBlockHeader(context, count * sizeof(float));
+    }
+}
+
+void resultFloatArrayData(scpi_t *context, const float *values, size_t count) {
+    scpi_array_format_t format = getDataFormat(context);
+
+    if (format == SCPI_FORMAT_ASCII) {
+        for (size_t i = 0; i < count; i++) {
+            SCPI_ResultFloat(context, values[i]);
+        }
+    } else if (isNativeByteOrder(format)) {
+        SCPI_ResultArbitraryBlockData(context, values, count * sizeof(float));
+    } else {
+        // swap bytes in chunks, so that interface write is not called for every value
+        uint32_t buffer[BLOCK_DATA_CHUNK_SIZE];
+        const uint32_t *src = (const uint32_t *)values;
+        while (count > 0) {
+            size_t n = MIN(count, BLOCK_DATA_CHUNK_SIZE);
+            for (size_t i = 0; i < n; i++) {
+                uint32_t value = src[i];
+                buffer[i] = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+            }
+            SCPI_ResultArbitraryBlockData(context, buffer, n * sizeof(float));
+            src += n;
+            count -= n;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+scpi_result_t scpi_cmd_formatData(scpi_t *context) {
+    int32_t dataFormat;
+    if (!SCPI_ParamChoice(context, dataFormatChoice, &dataFormat, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t length;
+    if (!SCPI_ParamInt32(context, &length, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        length = dataFormat == SCPI_FORMAT_ASCII ? 0 : 32;
+    }
+
+    // only 32-bit floats are supported in binary format
+    if (dataFormat == SCPI_FORMAT_ASCII ? length != 0 : length != 32) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
+    psu_context->dataFormat = (scpi_array_format_t)dataFormat;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatDataQ(scpi_t *context) {
+    scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
+    resultChoiceName(context, dataFormatChoice, psu_context->dataFormat);
+    SCPI_ResultInt(context, psu_context->dataFormat == SCPI_FORMAT_ASCII ? 0 : 32);
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatBorder(scpi_t *context) {
+    int32_t byteOrder;
+    if (!SCPI_ParamChoice(context, byteOrderChoice, &byteOrder, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
+    psu_context->byteOrder = (scpi_array_format_t)byteOrder;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatBorderQ(scpi_t *context) {
+    scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
+    resultChoiceName(context, byteOrderChoice, psu_context->byteOrder);
+    return SCPI_RES_OK;
+}
+
+} // namespace scpi
+} // namespace psu
+} // namespace eez
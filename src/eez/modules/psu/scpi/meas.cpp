@@ -27,43 +27,83 @@ namespace scpi {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-scpi_result_t scpi_cmd_measureScalarCurrentDcQ(scpi_t *context) {
-    Channel *channel = param_channel(context);
-    if (!channel) {
+enum MeasureFunction {
+    MEASURE_VOLTAGE = 1 << 0,
+    MEASURE_CURRENT = 1 << 1,
+    MEASURE_POWER = 1 << 2
+};
+
+// channel can be repeated in the list, e.g. (@1,2,1)
+static const int MAX_MEASURE_CHANNELS = 4 * CH_MAX;
+
+// Sends requested measurements (in the order U, I, P) for all the channels given in parameter,
+// in the order of the channel list, e.g. MEAS:ALL? (@3,1:2) returns U3,I3,P3,U1,I1,P1,U2,I2,P2.
+// If more than one channel is requested, channel that can't be measured doesn't fail
+// the command: its error is pushed to the error queue and NaN is sent instead of its values.
+static scpi_result_t resultMeasurements(scpi_t *context, int functions) {
+    int channelIndexes[MAX_MEASURE_CHANNELS];
+    int numChannels;
+    if (!param_channel_list(context, channelIndexes, MAX_MEASURE_CHANNELS, numChannels)) {
         return SCPI_RES_ERR;
     }
 
-    char buffer[256] = { 0 };
-    strcatFloat(buffer, channel_dispatcher::getIMonLast(*channel));
-    SCPI_ResultCharacters(context, buffer, strlen(buffer));
-
-    return SCPI_RES_OK;
-}
-
-scpi_result_t scpi_cmd_measureScalarPowerDcQ(scpi_t *context) {
-    Channel *channel = param_channel(context);
-    if (!channel) {
+    if (numChannels == 1 && !check_channel(context, channelIndexes[0])) {
         return SCPI_RES_ERR;
     }
 
-    char buffer[256] = { 0 };
-    strcatFloat(buffer, channel_dispatcher::getUMonLast(*channel) * channel_dispatcher::getIMonLast(*channel));
-    SCPI_ResultCharacters(context, buffer, strlen(buffer));
+    float values[MAX_MEASURE_CHANNELS * 3];
+    size_t numValues = 0;
+
+    for (int j = 0; j < numChannels; j++) {
+        float u;
+        float i;
+        if (numChannels > 1 && !check_channel(context, channelIndexes[j])) {
+            u = NAN;
+            i = NAN;
+        } else {
+            Channel &channel = Channel::get(channelIndexes[j]);
+            u = channel_dispatcher::getUMonLast(channel);
+            i = channel_dispatcher::getIMonLast(channel);
+        }
+
+        if (functions & MEASURE_VOLTAGE) {
+            values[numValues++] = u;
+        }
+        if (functions & MEASURE_CURRENT) {
+            values[numValues++] = i;
+        }
+        if (functions & MEASURE_POWER) {
+            values[numValues++] = u * i;
+        }
+    }
+
+    if (getDataFormat(context) == SCPI_FORMAT_ASCII) {
+        for (size_t i = 0; i < numValues; i++) {
+            char buffer[256] = { 0 };
+            strcatFloat(buffer, values[i]);
+            SCPI_ResultCharacters(context, buffer, strlen(buffer));
+        }
+    } else {
+        resultFloatArray(context, values, numValues);
+    }
 
     return SCPI_RES_OK;
 }
 
-scpi_result_t scpi_cmd_measureScalarVoltageDcQ(scpi_t *context) {
-    Channel *channel = param_channel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
+scpi_result_t scpi_cmd_measureScalarCurrentDcQ(scpi_t *context) {
+    return resultMeasurements(context, MEASURE_CURRENT);
+}
+
+scpi_result_t scpi_cmd_measureScalarPowerDcQ(scpi_t *context) {
+    return resultMeasurements(context, MEASURE_POWER);
+}
 
-    char buffer[256] = { 0 };
-    strcatFloat(buffer, channel_dispatcher::getUMonLast(*channel));
-    SCPI_ResultCharacters(context, buffer, strlen(buffer));
+scpi_result_t scpi_cmd_measureScalarVoltageDcQ(scpi_t *context) {
+    return resultMeasurements(context, MEASURE_VOLTAGE);
+}
 
-    return SCPI_RES_OK;
+scpi_result_t scpi_cmd_measureScalarAllDcQ(scpi_t *context) {
+    return resultMeasurements(context, MEASURE_VOLTAGE | MEASURE_CURRENT | MEASURE_POWER);
 }
 
 } // namespace scpi
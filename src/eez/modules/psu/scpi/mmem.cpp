@@ -561,7 +561,41 @@ scpi_result_t scpi_cmd_mmemoryLoadList(scpi_t *context) {
     }
 
     int err;
-    if (!list::loadList(channel->channelIndex, filePath, &err)) {
+    bool result;
+    if (endsWithNoCase(filePath, LIST_BIN_EXT)) {
+        result = list::loadListStream(channel->channelIndex, filePath, &err);
+    } else {
+        result = list::loadList(channel->channelIndex, filePath, &err);
+    }
+
+    if (!result) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_mmemoryConvertList(scpi_t *context) {
+    if (persist_conf::isSdLocked()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MEDIA_PROTECTED);
+        return SCPI_RES_ERR;
+    }
+
+    char csvFilePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, csvFilePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    char binFilePath[MAX_PATH_LENGTH + sizeof(LIST_BIN_EXT) + 1];
+    if (!getFilePath(context, binFilePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    addExtension(binFilePath, LIST_BIN_EXT);
+
+    int err;
+    if (!list::convertList(csvFilePath, binFilePath, &err)) {
         SCPI_ErrorPush(context, err);
         return SCPI_RES_ERR;
     }
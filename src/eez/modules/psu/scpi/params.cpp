@@ -203,6 +203,100 @@ uint32_t param_channels(scpi_t *context, scpi_parameter_t *parameter, scpi_bool_
     return channels;
 }
 
+static bool addChannelToList(scpi_t *context, int32_t value, int *channelIndexes, int maxChannels, int &numChannels) {
+    if (value < 1 || value > CH_NUM) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CHANNEL_NOT_FOUND);
+        return false;
+    }
+
+    if (numChannels == maxChannels) {
+        SCPI_ErrorPush(context, SCPI_ERROR_TOO_MUCH_DATA);
+        return false;
+    }
+
+    channelIndexes[numChannels++] = value - 1;
+    return true;
+}
+
+// Parses optional channel parameter (CH1...CH6, ALL or channel list, e.g. (@3,1:2))
+// into channel indexes in the given order, without checking the state of the channels.
+// Whole list is validated before anything is returned, so the command can fail
+// before it sends any result.
+bool param_channel_list(scpi_t *context, int *channelIndexes, int maxChannels, int &numChannels) {
+    numChannels = 0;
+
+    scpi_parameter_t parameter;
+    if (!SCPI_Parameter(context, &parameter, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return false;
+        }
+        int channelIndex = getSelectedChannelIndex(context);
+        if (channelIndex == -1) {
+            return false;
+        }
+        return addChannelToList(context, channelIndex + 1, channelIndexes, maxChannels, numChannels);
+    }
+
+    if (parameter.type == SCPI_TOKEN_PROGRAM_EXPRESSION) {
+        bool isRange;
+        int32_t valueFrom;
+        int32_t valueTo;
+        for (int i = 0; ; i++) {
+            scpi_expr_result_t result = SCPI_ExprNumericListEntryInt(context, &parameter, i, &isRange, &valueFrom, &valueTo);
+            if (result == SCPI_EXPR_NO_MORE) {
+                break;
+            }
+            if (result != SCPI_EXPR_OK) {
+                return false;
+            }
+
+            if (!isRange) {
+                valueTo = valueFrom;
+            }
+
+            // both ends are checked first, so the range can't be used to loop over huge number of values
+            if (valueFrom < 1 || valueFrom > CH_NUM || valueTo < 1 || valueTo > CH_NUM) {
+                SCPI_ErrorPush(context, SCPI_ERROR_CHANNEL_NOT_FOUND);
+                return false;
+            }
+
+            int step = valueFrom <= valueTo ? 1 : -1;
+            for (int32_t value = valueFrom; ; value += step) {
+                if (!addChannelToList(context, value, channelIndexes, maxChannels, numChannels)) {
+                    return false;
+                }
+                if (value == valueTo) {
+                    break;
+                }
+            }
+        }
+
+        if (numChannels == 0) {
+            SCPI_ErrorPush(context, SCPI_ERROR_CHANNEL_NOT_FOUND);
+            return false;
+        }
+
+        return true;
+    }
+
+    int32_t value;
+    if (!SCPI_ParamToChoice(context, &parameter, channelChoiceWithAll, &value)) {
+        return false;
+    }
+
+    if (value > 0) {
+        return addChannelToList(context, value, channelIndexes, maxChannels, numChannels);
+    }
+
+    for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
+        if (!addChannelToList(context, channelIndex + 1, channelIndexes, maxChannels, numChannels)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 Channel *set_channel_from_command_number(scpi_t *context) {
     int32_t channelIndex;
     SCPI_CommandNumbers(context, &channelIndex, 1, -1);
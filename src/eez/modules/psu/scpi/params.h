@@ -31,6 +31,7 @@ Channel *getSelectedChannel(scpi_t *context);
 Channel *param_channel(scpi_t *context, scpi_bool_t mandatory = FALSE, scpi_bool_t skip_channel_check = FALSE);
 uint32_t param_channels(scpi_t *context, scpi_bool_t mandatory = FALSE, scpi_bool_t skip_channel_check = FALSE);
 uint32_t param_channels(scpi_t *context, scpi_parameter_t *parameter, scpi_bool_t skip_channel_check = FALSE);
+bool param_channel_list(scpi_t *context, int *channelIndexes, int maxChannels, int &numChannels);
 bool check_channel(scpi_t *context, int32_t channelIndex);
 Channel *set_channel_from_command_number(scpi_t *context);
 
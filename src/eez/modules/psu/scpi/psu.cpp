@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 
+#include <eez/debug.h>
 #include <eez/sound.h>
 #include <eez/system.h>
 
@@ -40,6 +41,82 @@ SCPI_COMMANDS
 
 #define SCPI_COMMAND(P, C) { P, C },
 static const scpi_command_t scpi_commands[] = { SCPI_COMMANDS SCPI_CMD_LIST_END };
+#undef SCPI_COMMAND
+
+// Command index storage is sized at compile time from the command list. Bounds are
+// computed the same way SCPI_CommandIndexBuild adds the patterns: every pattern is added
+// once for each combination of its optional nodes (so keyword can get a node for each
+// combination of optional nodes in front of it) and keywords from the start of the
+// pattern which are the same as in the previous pattern are already in the trie.
+
+#define SCPI_COMMAND(P, C) P,
+static constexpr const char *g_commandPatterns[] = { SCPI_COMMANDS };
+#undef SCPI_COMMAND
+
+static constexpr size_t NUM_COMMANDS = sizeof(g_commandPatterns) / sizeof(const char *);
+
+static constexpr bool isKeywordEnd(char c) {
+    return c == 0 || c == '[' || c == ']' || c == ':' || c == '?';
+}
+
+static constexpr size_t findKeywordEnd(const char *pattern, size_t i) {
+    return isKeywordEnd(pattern[i]) ? i : findKeywordEnd(pattern, i + 1);
+}
+
+static constexpr bool isSameKeyword(const char *pattern, const char *prevPattern, size_t i, size_t end) {
+    return i == end ? isKeywordEnd(prevPattern[end]) : pattern[i] == prevPattern[i] && isSameKeyword(pattern, prevPattern, i + 1, end);
+}
+
+static constexpr uint32_t countPatternNodes(const char *pattern, const char *prevPattern, size_t i, uint32_t numOptional, bool isSamePrefix);
+
+static constexpr uint32_t countKeywordNodes(const char *pattern, const char *prevPattern, size_t i, size_t end, uint32_t numOptional, bool isSamePrefix) {
+    return (isSamePrefix ? 0 : 1u << numOptional) + countPatternNodes(pattern, prevPattern, end, numOptional, isSamePrefix);
+}
+
+static constexpr uint32_t countPatternNodes(const char *pattern, const char *prevPattern, size_t i, uint32_t numOptional, bool isSamePrefix) {
+    return pattern[i] == 0 || pattern[i] == '?' ? 0 :
+        pattern[i] == '[' || pattern[i] == ':' ? countPatternNodes(pattern, prevPattern, i + 1, numOptional, isSamePrefix && prevPattern[i] == pattern[i]) :
+        pattern[i] == ']' ? countPatternNodes(pattern, prevPattern, i + 1, numOptional + 1, isSamePrefix && prevPattern[i] == ']') :
+        countKeywordNodes(pattern, prevPattern, i, findKeywordEnd(pattern, i), numOptional,
+            isSamePrefix && isSameKeyword(pattern, prevPattern, i, findKeywordEnd(pattern, i)));
+}
+
+static constexpr uint32_t countPatternCandidates(const char *pattern) {
+    return *pattern == 0 ? 1 : (*pattern == '[' ? 2 : 1) * countPatternCandidates(pattern + 1);
+}
+
+static constexpr uint32_t countNodes(size_t first, size_t last) {
+    return last - first == 1 ?
+        countPatternNodes(g_commandPatterns[first], first > 0 ? g_commandPatterns[first - 1] : "", 0, 0, first > 0) :
+        countNodes(first, (first + last) / 2) + countNodes((first + last) / 2, last);
+}
+
+static constexpr uint32_t countCandidates(size_t first, size_t last) {
+    return last - first == 1 ?
+        countPatternCandidates(g_commandPatterns[first]) :
+        countCandidates(first, (first + last) / 2) + countCandidates((first + last) / 2, last);
+}
+
+static constexpr uint32_t COMMAND_INDEX_MAX_NODES = 1 + countNodes(0, NUM_COMMANDS); // + root
+static constexpr uint32_t COMMAND_INDEX_MAX_CANDIDATES = countCandidates(0, NUM_COMMANDS);
+
+static_assert(NUM_COMMANDS < SCPI_COMMAND_INDEX_NONE, "too many SCPI commands for the command index");
+static_assert(COMMAND_INDEX_MAX_NODES < SCPI_COMMAND_INDEX_NONE, "too many SCPI command index nodes");
+static_assert(COMMAND_INDEX_MAX_CANDIDATES < SCPI_COMMAND_INDEX_NONE, "too many SCPI command index candidates");
+
+static scpi_command_index_node_t g_commandIndexNodes[COMMAND_INDEX_MAX_NODES];
+static scpi_command_index_candidate_t g_commandIndexCandidates[COMMAND_INDEX_MAX_CANDIDATES];
+static scpi_command_index_t g_commandIndex;
+
+static bool buildCommandIndex() {
+    bool result = SCPI_CommandIndexBuild(&g_commandIndex, scpi_commands,
+        g_commandIndexNodes, COMMAND_INDEX_MAX_NODES,
+        g_commandIndexCandidates, COMMAND_INDEX_MAX_CANDIDATES);
+    if (!result) {
+        DebugTrace("SCPI command index not built, linear search is used\n");
+    }
+    return result;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -50,10 +127,18 @@ void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *
               getSerialNumber(), MCU_FIRMWARE, input_buffer, input_buffer_length,
               error_queue_data, error_queue_size);
 
+    // index is shared by all SCPI contexts, it is built on the first init
+    static bool isCommandIndexBuilt = buildCommandIndex();
+    if (isCommandIndexBuilt) {
+        SCPI_SetCommandIndex(&scpi_context, &g_commandIndex);
+    }
+
     scpi_psu_context.selectedChannels = 1 << 0; // first channel is selected by default
     scpi_psu_context.currentDirectory[0] = 0;
     scpi_psu_context.isBufferOverrun = false;
     scpi_psu_context.bufferOverrunTime = 0;
+    scpi_psu_context.dataFormat = SCPI_FORMAT_ASCII;
+    scpi_psu_context.byteOrder = SCPI_FORMAT_NORMAL;
 
     scpi_context.user_context = &scpi_psu_context;
 
@@ -71,7 +156,7 @@ void onBufferOverrun(scpi_t &context) {
     psu_context->bufferOverrunTime = micros();
 }
 
-void input(scpi_t &context, const char *str, size_t size) {
+static bool isBufferOverrun(scpi_t &context) {
     scpi_psu_t *psu_context = (scpi_psu_t *)context.user_context;
     if (psu_context->isBufferOverrun) {
         // wait for 500ms of idle input to declare buffer overrun finished
@@ -81,9 +166,16 @@ void input(scpi_t &context, const char *str, size_t size) {
             psu_context->isBufferOverrun = false;
         } else {
             psu_context->bufferOverrunTime = tickCount;
-            return;
+            return true;
         }
     }
+    return false;
+}
+
+void input(scpi_t &context, const char *str, size_t size) {
+    if (isBufferOverrun(context)) {
+        return;
+    }
 
     int result = SCPI_Input(&context, str, size);
     if (result == -1) {
@@ -91,6 +183,17 @@ void input(scpi_t &context, const char *str, size_t size) {
     }
 }
 
+void inputInPlace(scpi_t &context, char *str, size_t size) {
+    if (isBufferOverrun(context)) {
+        return;
+    }
+
+    int result = SCPI_InputInPlace(&context, str, size);
+    if (result == -1) {
+        onBufferOverrun(context);
+    }
+}
+
 void printError(int_fast16_t err) {
     sound::playBeep();
 
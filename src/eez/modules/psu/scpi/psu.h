@@ -35,6 +35,8 @@ struct scpi_psu_t {
     char currentDirectory[MAX_PATH_LENGTH + 1];
     bool isBufferOverrun;
     uint32_t bufferOverrunTime;
+    scpi_array_format_t dataFormat; // SCPI_FORMAT_ASCII or SCPI_FORMAT_NORMAL (REAL,32)
+    scpi_array_format_t byteOrder; // SCPI_FORMAT_NORMAL or SCPI_FORMAT_SWAPPED
 };
 
 void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *interface,
@@ -42,6 +44,8 @@ void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *
           int16_t error_queue_size);
 
 void input(scpi_t &scpi_context, const char *str, size_t size);
+// input without copying complete messages, str is modified by the parser
+void inputInPlace(scpi_t &scpi_context, char *str, size_t size);
 
 void emptyBuffer(scpi_t &context);
 void onBufferOverrun(scpi_t &context);
@@ -50,6 +54,16 @@ void printError(int_fast16_t err);
 
 void resultChoiceName(scpi_t *context, scpi_choice_def_t *choice, int tag);
 
+/// Returns array format selected with FORMat[:DATA] and FORMat:BORDer commands.
+scpi_array_format_t getDataFormat(scpi_t *context);
+
+/// Sends float values as ASCII or as IEEE 488.2 definite length block, depending on the data format.
+void resultFloatArray(scpi_t *context, const float *values, size_t count);
+
+/// Same as resultFloatArray, but values can be sent in multiple resultFloatArrayData calls.
+void resultFloatArrayBegin(scpi_t *context, size_t count);
+void resultFloatArrayData(scpi_t *context, const float *values, size_t count);
+
 void abortDownloading();
 
 bool mmemUpload(const char *filePath, scpi_t *context, int *err);
@@ -996,7 +996,7 @@ scpi_result_t scpi_cmd_sourceListCurrentLevelQ(scpi_t *context) {
 
     uint16_t listLength;
     float *list = list::getCurrentList(*channel, &listLength);
-    SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
+    resultFloatArray(context, list, listLength);
 
     return SCPI_RES_OK;
 }
@@ -1054,7 +1054,7 @@ scpi_result_t scpi_cmd_sourceListDwellQ(scpi_t *context) {
 
     uint16_t listLength;
     float *list = list::getDwellList(*channel, &listLength);
-    SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
+    resultFloatArray(context, list, listLength);
 
     return SCPI_RES_OK;
 }
@@ -1128,7 +1128,7 @@ scpi_result_t scpi_cmd_sourceListVoltageLevelQ(scpi_t *context) {
 
     uint16_t listLength;
     float *list = list::getVoltageList(*channel, &listLength);
-    SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
+    resultFloatArray(context, list, listLength);
 
     return SCPI_RES_OK;
 }
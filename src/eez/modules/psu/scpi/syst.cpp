@@ -33,6 +33,7 @@
 #endif
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/datetime.h>
+#include <eez/modules/psu/event_queue.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/sound.h>
 #if OPTION_DISPLAY
@@ -265,6 +266,21 @@ scpi_result_t scpi_cmd_systemBeeperImmediate(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_systemBeeperWav(scpi_t *context) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, filePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int err;
+    if (!sound::playWav(filePath, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_systemBeeperState(scpi_t *context) {
     bool enable;
     if (!SCPI_ParamBool(context, &enable, TRUE)) {
@@ -820,6 +836,33 @@ scpi_result_t scpi_cmd_systemLocal(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_systemLogExport(scpi_t *context) {
+    if (persist_conf::isSdLocked()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MEDIA_PROTECTED);
+        return SCPI_RES_ERR;
+    }
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    bool isParameterSpecified;
+    if (!getFilePath(context, filePath, false, &isParameterSpecified)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!isParameterSpecified) {
+        strcpy(filePath, LOGS_DIR);
+        // not log.txt, it is the log file of the older firmware which is imported on mount
+        strcat(filePath, PATH_SEPARATOR "events.txt");
+    }
+
+    int err;
+    if (!event_queue::exportLog(filePath, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_systemRemote(scpi_t *context) {
     g_rlState = RL_STATE_REMOTE;
 
@@ -1760,6 +1803,77 @@ scpi_result_t scpi_cmd_systemCommunicateMqttStateQ(scpi_t *context) {
 #endif
 }
 
+#if OPTION_ETHERNET
+static scpi_choice_def_t mqttTelemetryModeChoice[] = {
+    { "VALues", mqtt::TELEMETRY_MODE_VALUES },
+    { "JSON", mqtt::TELEMETRY_MODE_JSON },
+    { "BINary", mqtt::TELEMETRY_MODE_BINARY },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+#endif
+
+scpi_result_t scpi_cmd_systemCommunicateMqttTelemetry(scpi_t *context) {
+#if OPTION_ETHERNET
+    int32_t mode;
+    if (!SCPI_ParamChoice(context, mqttTelemetryModeChoice, &mode, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    bool onChange;
+    if (!SCPI_ParamBool(context, &onChange, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        onChange = persist_conf::devConf.mqttTelemetryOnChange ? true : false;
+    }
+
+    char topic[mqtt::TELEMETRY_TOPIC_MAX_LENGTH + 1];
+    const char *topicParam;
+    size_t topicLength;
+    if (SCPI_ParamCharacters(context, &topicParam, &topicLength, false)) {
+        if (topicLength == 0) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+        if (topicLength > mqtt::TELEMETRY_TOPIC_MAX_LENGTH) {
+            SCPI_ErrorPush(context, SCPI_ERROR_CHARACTER_DATA_TOO_LONG);
+            return SCPI_RES_ERR;
+        }
+        memcpy(topic, topicParam, topicLength);
+        topic[topicLength] = 0;
+        if (strpbrk(topic, "+#")) {
+            // wildcards are not allowed in the topic name
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    } else {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        strcpy(topic, persist_conf::devConf.mqttTelemetryTopic);
+    }
+
+    persist_conf::setMqttTelemetrySettings((uint8_t)mode, onChange, topic);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_systemCommunicateMqttTelemetryQ(scpi_t *context) {
+#if OPTION_ETHERNET
+    resultChoiceName(context, mqttTelemetryModeChoice, persist_conf::devConf.mqttTelemetryMode);
+    SCPI_ResultBool(context, persist_conf::devConf.mqttTelemetryOnChange);
+    SCPI_ResultText(context, persist_conf::devConf.mqttTelemetryTopic);
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
 scpi_choice_def_t dateFormatChoice[] = {
     { "DMY", 1 },
     { "MDY", 2 },
@@ -26,6 +26,7 @@
 #endif
 
 #include <eez/firmware.h>
+#include <eez/mp.h>
 #include <eez/usb.h>
 
 #include <eez/modules/psu/psu.h>
@@ -34,6 +35,7 @@
 
 #include <eez/modules/psu/datetime.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/dlog_index.h>
 #include <eez/modules/psu/list_program.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/sd_card.h>
@@ -192,6 +194,13 @@ bool exists(const char *dirPath, int *err) {
     return true;
 }
 
+bool isHiddenFile(const char *name) {
+    return strcmp(name, DIRECTORY_INDEX_FILE_NAME) == 0 ||
+        endsWithNoCase(name, DLOG_INDEX_EXT) ||
+        endsWithNoCase(name, PROFILE_CACHE_EXT) ||
+        endsWithNoCase(name, MP_CACHE_EXT);
+}
+
 bool catalog(const char *dirPath, void *param,
              void (*callback)(void *param, const char *name, FileType type, size_t size),
              int *numFiles, int *err) {
@@ -214,7 +223,7 @@ bool catalog(const char *dirPath, void *param,
         char name[MAX_PATH_LENGTH + 1] = { 0 };
         fileInfo.getName(name, MAX_PATH_LENGTH);
 
-        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0 && !isHiddenFile(name)) {
             (*numFiles)++;
 
             FileType type;
@@ -256,7 +265,7 @@ bool catalogLength(const char *dirPath, size_t *length, int *err) {
     while (fileInfo) {
         char name[MAX_PATH_LENGTH + 1] = { 0 };
         fileInfo.getName(name, MAX_PATH_LENGTH);
-        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0 && !isHiddenFile(name)) {
             ++(*length);
         }
 
@@ -415,6 +424,26 @@ bool moveFile(const char *sourcePath, const char *destinationPath, int *err) {
         return false;
     }
 
+    if (getFileTypeFromExtension(sourcePath) == FILE_TYPE_DLOG) {
+        // also move dlog index file, if exists, or remove it if destination is not a dlog file
+        char indexFilePath[MAX_PATH_LENGTH + 1];
+        dlog_index::getIndexFilePath(sourcePath, indexFilePath);
+        if (SD.exists(indexFilePath)) {
+            if (getFileTypeFromExtension(destinationPath) == FILE_TYPE_DLOG) {
+                char destinationIndexFilePath[MAX_PATH_LENGTH + 1];
+                dlog_index::getIndexFilePath(destinationPath, destinationIndexFilePath);
+                if (SD.exists(destinationIndexFilePath)) {
+                    SD.remove(destinationIndexFilePath);
+                }
+                if (!SD.rename(indexFilePath, destinationIndexFilePath)) {
+                    SD.remove(indexFilePath);
+                }
+            } else {
+                SD.remove(indexFilePath);
+            }
+        }
+    }
+
     onSdCardFileChangeHook(sourcePath, destinationPath);
 
     return true;
@@ -514,6 +543,29 @@ bool deleteFile(const char *filePath, int *err) {
         return false;
     }
 
+    if (getFileTypeFromExtension(filePath) == FILE_TYPE_DLOG) {
+        // also remove dlog index file, if exists
+        char indexFilePath[MAX_PATH_LENGTH + 1];
+        dlog_index::getIndexFilePath(filePath, indexFilePath);
+        if (SD.exists(indexFilePath)) {
+            SD.remove(indexFilePath);
+        }
+    } else if (getFileTypeFromExtension(filePath) == FILE_TYPE_MICROPYTHON) {
+        // also remove compiled script cache file, if exists
+        char cacheFilePath[MAX_PATH_LENGTH + 1];
+        mp::getCacheFilePath(filePath, cacheFilePath);
+        if (SD.exists(cacheFilePath)) {
+            SD.remove(cacheFilePath);
+        }
+    } else if (getFileTypeFromExtension(filePath) == FILE_TYPE_PROFILE) {
+        // also remove binary profile cache file, if exists
+        char cacheFilePath[MAX_PATH_LENGTH + 1];
+        profile::getCacheFilePath(filePath, cacheFilePath);
+        if (SD.exists(cacheFilePath)) {
+            SD.remove(cacheFilePath);
+        }
+    }
+
     onSdCardFileChangeHook(filePath);
 
     return true;
@@ -540,6 +592,13 @@ bool removeDir(const char *dirPath, int *err) {
         return false;
     }
 
+    // also remove file manager directory index file, if exists
+    char indexFilePath[MAX_PATH_LENGTH + 1];
+    eez::gui::file_manager::getDirectoryIndexFilePath(dirPath, indexFilePath);
+    if (SD.exists(indexFilePath)) {
+        SD.remove(indexFilePath);
+    }
+
     if (!SD.rmdir(dirPath)) {
         if (err)
             *err = SCPI_ERROR_MASS_STORAGE_ERROR;
@@ -607,6 +666,26 @@ bool getTime(const char *filePath, uint8_t &hour, uint8_t &minute, uint8_t &seco
     return true;
 }
 
+bool getSizeAndModificationTime(const char *filePath, uint32_t &size, uint32_t &modificationTime) {
+    FileInfo fileInfo;
+    if (fileInfo.fstat(filePath) != SD_FAT_RESULT_OK) {
+        return false;
+    }
+
+    size = fileInfo.getSize();
+
+    // FAT date and time format
+    modificationTime =
+        ((uint32_t)(fileInfo.getModifiedYear() - 1980) << 25) |
+        (fileInfo.getModifiedMonth() << 21) |
+        (fileInfo.getModifiedDay() << 16) |
+        (fileInfo.getModifiedHour() << 11) |
+        (fileInfo.getModifiedMinute() << 5) |
+        (fileInfo.getModifiedSecond() / 2);
+
+    return true;
+}
+
 int getInfoVersion() {
 	return g_getInfoVersion;
 }
@@ -959,6 +1038,55 @@ bool match(BufferedFileRead &file, float &result) {
     }
 }
 
+bool matchFixedPoint(BufferedFileRead &file, int numDecimalDigits, uint64_t &result) {
+    matchZeroOrMoreSpaces(file);
+
+    int c = file.peek();
+
+    bool isFraction = false;
+    int numFractionDigits = 0;
+    bool roundUp = false;
+
+    uint64_t value = 0;
+    bool hasDigits = false;
+
+    while (true) {
+        if (c == '.') {
+            if (isFraction) {
+                return false;
+            }
+            isFraction = true;
+        } else if (c >= '0' && c <= '9') {
+            hasDigits = true;
+            if (!isFraction) {
+                value = value * 10 + c - '0';
+            } else if (numFractionDigits < numDecimalDigits) {
+                value = value * 10 + c - '0';
+                numFractionDigits++;
+            } else if (numFractionDigits == numDecimalDigits) {
+                // first digit after the last kept digit decides the rounding
+                roundUp = c >= '5';
+                numFractionDigits++;
+            }
+        } else {
+            if (!hasDigits) {
+                return false;
+            }
+
+            for (; numFractionDigits < numDecimalDigits; numFractionDigits++) {
+                value *= 10;
+            }
+
+            result = roundUp ? value + 1 : value;
+
+            return true;
+        }
+
+        file.read();
+        c = file.peek();
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static void setState(State state) {
@@ -52,6 +52,15 @@ bool isBusy();
 bool makeParentDir(const char *filePath, int *err);
 
 bool exists(const char *dirPath, int *err);
+
+// file with the cached catalog of the directory, see file_manager.cpp,
+// it is not reported by catalog and catalogLength
+#define DIRECTORY_INDEX_FILE_NAME ".index"
+
+// True for the files which are not reported by catalog and catalogLength: directory index file
+// and the files maintained next to the user files (dlog index, profile and MicroPython script cache).
+bool isHiddenFile(const char *name);
+
 bool catalog(const char *dirPath, void *param, void (*callback)(void *param, const char *name, FileType type, size_t size), int *numFiles, int *err);
 bool catalogLength(const char *dirPath, size_t *length, int *err);
 bool upload(const char *filePath, void *param, void (*callback)(void *param, const void *buffer, int size), int *err);
@@ -65,6 +74,9 @@ bool removeDir(const char *dirPath, int *err);
 bool getDate(const char *filePath, uint8_t &year, uint8_t &month, uint8_t &day, int *err);
 bool getTime(const char *filePath, uint8_t &hour, uint8_t &minute, uint8_t &second, int *err);
 
+// Used to check if the file derived from the given file (e.g. cache) is up to date.
+bool getSizeAndModificationTime(const char *filePath, uint32_t &size, uint32_t &modificationTime);
+
 int getInfoVersion();
 bool getInfo(uint64_t &usedSpace, uint64_t &freeSpace, bool fromCache);
 
@@ -120,6 +132,9 @@ void skipUntilEOL(BufferedFileRead &file);
 bool matchQuotedString(BufferedFileRead &file, char *str, unsigned int strLength);
 bool match(BufferedFileRead &file, unsigned int &result);
 bool match(BufferedFileRead &file, float &result);
+// Non-negative decimal number scaled by 10^numDecimalDigits, e.g. "1.25" with 3 digits is 1250,
+// without the float rounding errors. Extra fraction digits are rounded.
+bool matchFixedPoint(BufferedFileRead &file, int numDecimalDigits, uint64_t &result);
 
 } // namespace sd_card
 } // namespace psu
@@ -39,7 +39,9 @@ uint32_t g_length;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-uint8_t g_serialInputChars[LOW_PRIORITY_THREAD_QUEUE_SIZE + 1];
+// one more than the queued chars and the char being processed,
+// so put blocks on the full queue before it overwrites the char being processed
+uint8_t g_serialInputChars[LOW_PRIORITY_THREAD_QUEUE_SIZE + 2];
 int g_serialInputCharPosition = 0;
 #endif
 
@@ -73,7 +75,7 @@ void UARTClass::put(int ch) {
     using namespace eez;
     sendMessageToLowPriorityThread(SERIAL_INPUT_AVAILABLE, g_serialInputCharPosition);
     
-    g_serialInputCharPosition = (g_serialInputCharPosition + 1) % (LOW_PRIORITY_THREAD_QUEUE_SIZE + 1);
+    g_serialInputCharPosition = (g_serialInputCharPosition + 1) % (LOW_PRIORITY_THREAD_QUEUE_SIZE + 2);
 }
 #endif
 
@@ -20,6 +20,7 @@
 
 #include <eez/firmware.h>
 #include <eez/usb.h>
+#include <eez/scpi/scpi.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/serial_psu.h>
@@ -78,7 +79,9 @@ scpi_result_t SCPI_Reset(scpi_t *context) {
         Serial.println(errorOutputBuffer);
     }
 
-    return reset() ? SCPI_RES_OK : SCPI_RES_ERR;
+    eez::scpi::resetContext(context);
+
+    return reset(false) ? SCPI_RES_OK : SCPI_RES_ERR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -105,6 +108,9 @@ void init() {
 
 #ifdef EEZ_PLATFORM_SIMULATOR
     if (usb::isVirtualComPortActive()) {
+        // console (or the script of the headless simulator) is always connected to the serial port
+        g_testResult = TEST_OK;
+
         Serial.print("EEZ BB3 software simulator ver. ");
         Serial.println(MCU_FIRMWARE);
     }
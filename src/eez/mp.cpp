@@ -22,11 +22,13 @@
 #include <eez/firmware.h>
 #include <eez/mp.h>
 #include <eez/system.h>
+#include <eez/scpi/scpi.h>
 
 #include <eez/libs/sd_fat/sd_fat.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/sd_card.h>
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/gui/psu.h>
 
@@ -42,6 +44,7 @@ extern "C" {
 #include "py/runtime.h"
 #include "py/gc.h"
 #include "py/stackctrl.h"
+#include "py/persistentcode.h"
 }
 
 #ifdef _MSC_VER
@@ -78,6 +81,49 @@ static char *g_scriptSource = g_scriptPath + MAX_PATH_LENGTH + 1;
 static const size_t MAX_SCRIPT_LENGTH = 32 * 1024;
 static size_t g_scriptSourceLength;
 
+// g_scriptSource contains compiled script loaded from the cache instead of the source
+static bool g_isScriptCompiled;
+
+StartupStats g_startupStats;
+static uint32_t g_startScriptTime;
+
+/* Compiled script cache file format
+
+Cache file is stored next to the script, with ".py" extension replaced by ".mpy".
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U32     4        MAGIC = 0x4359504DL
+
+4         U16     2        VERSION = 0x0001L
+
+6         U16     2        MicroPython .mpy version
+
+8         U32     4        Script file size
+
+12        U32     4        Script file modification time (FAT date and time)
+
+16        U32     4        Compiled code size (N)
+
+20        U8[N]            Compiled code (MicroPython .mpy format)
+*/
+
+struct ScriptCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t mpyVersion;
+    uint32_t scriptSize;
+    uint32_t scriptModificationTime;
+    uint32_t codeSize;
+};
+
+static const uint32_t SCRIPT_CACHE_MAGIC = 0x4359504D;
+static const uint16_t SCRIPT_CACHE_VERSION = 1;
+
+static ScriptCacheHeader g_scriptCacheHeader;
+static size_t g_scriptCacheCodeSize;
+static bool g_scriptCacheOverflow;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 using namespace eez::scpi;
@@ -120,7 +166,9 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
 }
 
 scpi_result_t SCPI_Reset(scpi_t *context) {
-    return eez::reset() ? SCPI_RES_OK : SCPI_RES_ERR;
+    eez::scpi::resetContext(context);
+
+    return eez::reset(false) ? SCPI_RES_OK : SCPI_RES_ERR;
 }
 
 static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
@@ -163,6 +211,57 @@ enum {
     QUEUE_MESSAGE_SCPI_RESULT
 };
 
+static void cachePrintStrn(void *data, const char *str, size_t len) {
+    if (g_scriptCacheOverflow) {
+        return;
+    }
+
+    if (g_scriptCacheCodeSize + len > MAX_SCRIPT_LENGTH) {
+        g_scriptCacheOverflow = true;
+        return;
+    }
+
+    memcpy(g_scriptSource + g_scriptCacheCodeSize, str, len);
+    g_scriptCacheCodeSize += len;
+}
+
+// Script source is no longer needed after it is compiled,
+// so compiled code is stored in the same buffer and saved from the low priority thread.
+static void saveScriptCache(mp_raw_code_t *rc) {
+    g_scriptCacheCodeSize = 0;
+    g_scriptCacheOverflow = false;
+
+    mp_print_t print = { nullptr, cachePrintStrn };
+    mp_raw_code_save(rc, &print);
+
+    if (!g_scriptCacheOverflow) {
+        g_scriptCacheHeader.codeSize = g_scriptCacheCodeSize;
+        sendMessageToLowPriorityThread(MP_SAVE_SCRIPT_CACHE);
+    } else {
+        g_scriptCacheHeader.codeSize = 0;
+    }
+}
+
+static mp_obj_t compileScript() {
+    uint32_t startTime = micros();
+
+    mp_raw_code_t *rc;
+
+    if (g_isScriptCompiled) {
+        rc = mp_raw_code_load_mem((const byte *)g_scriptSource, g_scriptSourceLength);
+        g_startupStats.compileTime = micros() - startTime;
+    } else {
+        mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_stdin_gt_, g_scriptSource, g_scriptSourceLength, 0);
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        rc = mp_compile_to_raw_code(&parse_tree, source_name, true);
+        g_startupStats.compileTime = micros() - startTime;
+        saveScriptCache(rc);
+    }
+
+    return mp_make_function_from_raw_code(rc, MP_OBJ_NULL, MP_OBJ_NULL);
+}
+
 void oneIter() {
     osEvent event = osMessageGet(g_mpMessageQueueId, osWaitForever);
     if (event.status == osEventMessage) {
@@ -206,16 +305,13 @@ void oneIter() {
 
 			nlr_buf_t nlr;
 			if (nlr_push(&nlr) == 0) {
-				mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_stdin_gt_, g_scriptSource, g_scriptSourceLength, 0);
-				qstr source_name = lex->source_name;
-				mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
-				mp_obj_t module_fun = mp_compile(&parse_tree, source_name/*, MP_EMIT_OPT_NONE*/, true);
-                //DebugTrace("T3 %d\n", millis());
-				mp_call_function_0(module_fun);
+                mp_obj_t module_fun = compileScript();
+                g_startupStats.totalTime = micros() - g_startScriptTime;
+                mp_call_function_0(module_fun);
 				nlr_pop();
 			} else {
 				// uncaught exception
-				mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
+                mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
                 onUncaughtScriptExceptionHook();
 			}
 #endif
@@ -233,54 +329,130 @@ void startScript(const char *filePath) {
     if (g_state == STATE_IDLE) {
         g_state = STATE_EXECUTING;
         strcpy(g_scriptPath, filePath);
-        //DebugTrace("T1 %d\n", millis());
+        g_startScriptTime = micros();
         sendMessageToLowPriorityThread(MP_LOAD_SCRIPT);
 
         psu::gui::showAsyncOperationInProgress();
     }
 }
 
-void loadScript() {
-    uint32_t fileSize;
-    uint32_t bytesRead;
+void getCacheFilePath(const char *scriptPath, char *cacheFilePath) {
+    strcpy(cacheFilePath, scriptPath);
+    size_t n = strlen(cacheFilePath);
+    if (n >= 3 && strcmp(cacheFilePath + n - 3, ".py") == 0) {
+        n -= 3;
+    }
+    strcpy(cacheFilePath + n, MP_CACHE_EXT);
+}
+
+static bool initScriptCacheHeader(const char *scriptPath) {
+    if (!psu::sd_card::getSizeAndModificationTime(scriptPath, g_scriptCacheHeader.scriptSize, g_scriptCacheHeader.scriptModificationTime)) {
+        return false;
+    }
+
+    g_scriptCacheHeader.magic = SCRIPT_CACHE_MAGIC;
+    g_scriptCacheHeader.version = SCRIPT_CACHE_VERSION;
+    g_scriptCacheHeader.mpyVersion = MPY_VERSION;
+    g_scriptCacheHeader.codeSize = 0;
+
+    return true;
+}
+
+// Loads compiled code if the cache file matches g_scriptCacheHeader.
+static bool readScriptCache(const char *scriptPath) {
+    char cacheFilePath[MAX_PATH_LENGTH + 1];
+    getCacheFilePath(scriptPath, cacheFilePath);
+
+    eez::File file;
+    if (!file.open(cacheFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    ScriptCacheHeader header;
+    bool result =
+        file.read(&header, sizeof(header)) == sizeof(header) &&
+        header.magic == g_scriptCacheHeader.magic &&
+        header.version == g_scriptCacheHeader.version &&
+        header.mpyVersion == g_scriptCacheHeader.mpyVersion &&
+        header.scriptSize == g_scriptCacheHeader.scriptSize &&
+        header.scriptModificationTime == g_scriptCacheHeader.scriptModificationTime &&
+        header.codeSize > 0 && header.codeSize <= MAX_SCRIPT_LENGTH &&
+        file.size() == sizeof(header) + header.codeSize;
+
+    if (result) {
+        result = file.read(g_scriptSource, header.codeSize) == header.codeSize;
+        if (result) {
+            g_scriptSourceLength = header.codeSize;
+        }
+    }
+
+    file.close();
+
+    return result;
+}
 
+static void saveScriptCache() {
+    char cacheFilePath[MAX_PATH_LENGTH + 1];
+    getCacheFilePath(g_scriptPath, cacheFilePath);
+
+    eez::File file;
+    if (!file.open(cacheFilePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return;
+    }
+
+    // partially written file is rejected by readScriptCache because of the size mismatch
+    if (file.write(&g_scriptCacheHeader, sizeof(g_scriptCacheHeader)) == sizeof(g_scriptCacheHeader)) {
+        file.write(g_scriptSource, g_scriptCacheHeader.codeSize);
+    }
+
+    file.close();
+
+    onSdCardFileChangeHook(cacheFilePath);
+}
+
+static bool readScriptSource() {
     eez::File file;
     if (!file.open(g_scriptPath, FILE_OPEN_EXISTING | FILE_READ)) {
         generateError(SCPI_ERROR_FILE_NOT_FOUND);
-        goto ErrorNoClose;
+        return false;
     }
 
-    fileSize = file.size();
+    uint32_t fileSize = file.size();
     if (fileSize > MAX_SCRIPT_LENGTH) {
+        file.close();
         generateError(SCPI_ERROR_OUT_OF_DEVICE_MEMORY);
-        goto Error;
+        return false;
     }
 
-    bytesRead = file.read(g_scriptSource, fileSize);
+    uint32_t bytesRead = file.read(g_scriptSource, fileSize);
 
     file.close();
 
     if (bytesRead != fileSize) {
         generateError(SCPI_ERROR_MASS_STORAGE_ERROR);
-        goto Error;
+        return false;
     }
 
     g_scriptSourceLength = fileSize;
 
-    //DebugTrace("T2 %d\n", millis());
-    osMessagePut(g_mpMessageQueueId, QUEUE_MESSAGE_START_SCRIPT, osWaitForever);
+    return true;
+}
 
-    return;
+void loadScript() {
+    uint32_t startTime = micros();
 
-Error:
-    file.close();
+    g_isScriptCompiled = initScriptCacheHeader(g_scriptPath) && readScriptCache(g_scriptPath);
+
+    if (!g_isScriptCompiled && !readScriptSource()) {
+        psu::gui::hideAsyncOperationInProgress();
+        g_state = STATE_IDLE;
+        return;
+    }
 
-ErrorNoClose:
-    psu::gui::hideAsyncOperationInProgress();
+    g_startupStats.fromCache = g_isScriptCompiled;
+    g_startupStats.loadTime = micros() - startTime;
 
-    g_state = STATE_IDLE;
-    
-    return;
+    osMessagePut(g_mpMessageQueueId, QUEUE_MESSAGE_START_SCRIPT, osWaitForever);
 }
 
 static const char *g_commandOrQueryText;
@@ -293,6 +465,8 @@ void onQueueMessage(uint32_t type, uint32_t param) {
         input(g_scpiContext, "\r\n", 2);
 
         osMessagePut(g_mpMessageQueueId, QUEUE_MESSAGE_SCPI_RESULT, osWaitForever);
+    } else if (type == MP_SAVE_SCRIPT_CACHE) {
+        saveScriptCache();
     }
 }
 
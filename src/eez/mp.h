@@ -21,6 +21,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#define MP_CACHE_EXT ".mpy"
+
 namespace eez {
 namespace mp {
 
@@ -33,6 +35,16 @@ enum State {
 extern State g_state;
 extern char *g_scriptPath;
 
+// Timings (in microseconds) of the last script start
+struct StartupStats {
+    bool fromCache;       // compiled code was loaded from the .mpy cache file
+    uint32_t loadTime;    // reading script or cache file from SD card
+    uint32_t compileTime; // compiling source or loading compiled code
+    uint32_t totalTime;   // from startScript until script execution started
+};
+
+extern StartupStats g_startupStats;
+
 void initMessageQueue();
 void startThread();
 
@@ -42,6 +54,8 @@ void startScript(const char *filePath);
 inline bool isIdle() { return g_state == STATE_IDLE; }
 bool scpi(const char *commandOrQueryText, const char **resultText, size_t *resultTextLen);
 
+void getCacheFilePath(const char *scriptPath, char *cacheFilePath);
+
 void onUncaughtScriptExceptionHook();
 
 } // mp
@@ -100,6 +100,11 @@ static const char *SUB_TOPIC_DCPSUPPLY_PATTERN = "%s/dcpsupply/ch/+/set/+";
 
 static const size_t MAX_PAYLOAD_LENGTH = 100;
 
+static const uint8_t TELEMETRY_BINARY_VERSION = 1;
+static const size_t TELEMETRY_BINARY_HEADER_SIZE = 4;
+static const size_t TELEMETRY_BINARY_RECORD_SIZE = 24;
+static const size_t MAX_TELEMETRY_PAYLOAD_LENGTH = 16 + CH_MAX * 128;
+
 static const size_t MAX_TOPIC_LEN = 128;
 static char g_topic[MAX_TOPIC_LEN + 1];
 static const size_t MAX_PAYLOAD_LEN = 128;
@@ -156,6 +161,26 @@ static uint8_t g_lastChannelIndex = 0;
 static uint8_t g_lastValueIndex = 0;
 static bool g_publishing;
 
+struct TelemetryChannelState {
+    uint8_t flags;
+    float uSet;
+    float iSet;
+    float uMon;
+    float iMon;
+    float temperature;
+};
+
+static const uint8_t TELEMETRY_FLAG_OE = 1;
+static const uint8_t TELEMETRY_FLAG_CC = 2;
+
+static TelemetryChannelState g_telemetryStates[CH_MAX];
+static bool g_telemetryPublished;
+static uint32_t g_telemetryTick;
+static char g_telemetryPayload[MAX_TELEMETRY_PAYLOAD_LENGTH + 1];
+
+static Stats g_stats;
+static uint32_t g_statsResetTick;
+
 enum {
     EEZ_MQTT_ERROR_NONE,
     EEZ_MQTT_ERROR_DNS,
@@ -387,11 +412,11 @@ void incomingPublishCallback(void** unused, struct mqtt_response_publish *publis
 }
 #endif
 
-bool publish(char *topic, char *payload, bool retain) {
+bool publish(const char *topic, const void *payload, size_t payloadLength, bool retain) {
 #if defined(EEZ_PLATFORM_STM32)
 	g_publishing = true;
     LOCK_TCPIP_CORE();
-    err_t result = mqtt_publish(&g_client, topic, payload, strlen(payload), 0, retain ? 1 : 0, requestCallback, nullptr);
+    err_t result = mqtt_publish(&g_client, topic, payload, payloadLength, 0, retain ? 1 : 0, requestCallback, nullptr);
     UNLOCK_TCPIP_CORE();
     if (result != ERR_OK) {
     	g_publishing = false;
@@ -410,7 +435,7 @@ bool publish(char *topic, char *payload, bool retain) {
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    mqtt_publish(&g_client, topic, payload, strlen(payload), MQTT_PUBLISH_QOS_0 | (retain ? MQTT_PUBLISH_RETAIN : 0));
+    mqtt_publish(&g_client, topic, (void *)payload, payloadLength, MQTT_PUBLISH_QOS_0 | (retain ? MQTT_PUBLISH_RETAIN : 0));
     if (g_client.error != MQTT_OK) {
         if (g_lastError != EEZ_MQTT_ERROR_PUBLISH) {
             g_lastError = EEZ_MQTT_ERROR_PUBLISH;
@@ -420,10 +445,17 @@ bool publish(char *topic, char *payload, bool retain) {
         return false;
     }
 #endif
-    
+
+    g_stats.numMessages++;
+    g_stats.numBytes += strlen(topic) + payloadLength;
+
     return true;
 }
 
+bool publish(char *topic, char *payload, bool retain) {
+    return publish(topic, payload, strlen(payload), retain);
+}
+
 bool publish(const char *pubTopic, int value, bool retain) {
     char topic[MAX_PUB_TOPIC_LENGTH + 1];
     sprintf(topic, pubTopic, persist_conf::devConf.ethernetHostName);
@@ -523,6 +555,146 @@ bool publishOnTimeCounter(int channelIndex, const char *pubTopic, uint32_t value
     return publish(topic, payload, retain);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+static bool isTelemetryBatched() {
+    return persist_conf::devConf.mqttTelemetryMode == TELEMETRY_MODE_JSON || persist_conf::devConf.mqttTelemetryMode == TELEMETRY_MODE_BINARY;
+}
+
+static void getTelemetryChannelState(Channel &channel, TelemetryChannelState &state) {
+    // clear padding too, states are compared with memcmp
+    memset(&state, 0, sizeof(TelemetryChannelState));
+
+    if (channel.isOutputEnabled()) {
+        state.flags |= TELEMETRY_FLAG_OE;
+        if (channel.isCcMode()) {
+            state.flags |= TELEMETRY_FLAG_CC;
+        }
+    }
+
+    state.uSet = channel_dispatcher::getUSet(channel);
+    state.iSet = channel_dispatcher::getISet(channel);
+
+    if (channel.isOutputEnabled()) {
+        state.uMon = channel_dispatcher::getUMonLast(channel);
+        state.iMon = channel_dispatcher::getIMonLast(channel);
+    }
+
+    temperature::TempSensorTemperature &tempSensor = temperature::sensors[temp_sensor::CH1 + channel.channelIndex];
+    if (tempSensor.isInstalled() && tempSensor.isTestOK()) {
+        state.temperature = tempSensor.temperature;
+    } else {
+        state.temperature = NAN;
+    }
+}
+
+static size_t appendJsonFloat(char *payload, size_t length, const char *name, float value) {
+    if (isNaN(value)) {
+        return length + snprintf(payload + length, MAX_TELEMETRY_PAYLOAD_LENGTH - length, ",\"%s\":null", name);
+    }
+    return length + snprintf(payload + length, MAX_TELEMETRY_PAYLOAD_LENGTH - length, ",\"%s\":%g", name, value);
+}
+
+static size_t encodeTelemetryJson(const TelemetryChannelState *states, char *payload) {
+    size_t length = 0;
+
+    payload[length++] = '[';
+
+    for (int i = 0; i < CH_NUM; i++) {
+        const TelemetryChannelState &state = states[i];
+
+        length += snprintf(payload + length, MAX_TELEMETRY_PAYLOAD_LENGTH - length, "%s{\"ch\":%d,\"oe\":%d,\"cc\":%d", i > 0 ? "," : "",
+            i + 1, state.flags & TELEMETRY_FLAG_OE ? 1 : 0, state.flags & TELEMETRY_FLAG_CC ? 1 : 0);
+        length = appendJsonFloat(payload, length, "uset", state.uSet);
+        length = appendJsonFloat(payload, length, "iset", state.iSet);
+        length = appendJsonFloat(payload, length, "umon", state.uMon);
+        length = appendJsonFloat(payload, length, "imon", state.iMon);
+        length = appendJsonFloat(payload, length, "temp", state.temperature);
+
+        payload[length++] = '}';
+    }
+
+    payload[length++] = ']';
+    payload[length] = 0;
+
+    return length;
+}
+
+static void encodeFloat(uint8_t *p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    p[0] = bits & 0xFF;
+    p[1] = (bits >> 8) & 0xFF;
+    p[2] = (bits >> 16) & 0xFF;
+    p[3] = bits >> 24;
+}
+
+static size_t encodeTelemetryBinary(const TelemetryChannelState *states, uint8_t *payload) {
+    payload[0] = TELEMETRY_BINARY_VERSION;
+    payload[1] = (uint8_t)CH_NUM;
+    payload[2] = 0;
+    payload[3] = 0;
+
+    uint8_t *p = payload + TELEMETRY_BINARY_HEADER_SIZE;
+    for (int i = 0; i < CH_NUM; i++) {
+        const TelemetryChannelState &state = states[i];
+        p[0] = (uint8_t)(i + 1);
+        p[1] = state.flags;
+        p[2] = 0;
+        p[3] = 0;
+        encodeFloat(p + 4, state.uSet);
+        encodeFloat(p + 8, state.iSet);
+        encodeFloat(p + 12, state.uMon);
+        encodeFloat(p + 16, state.iMon);
+        encodeFloat(p + 20, state.temperature);
+        p += TELEMETRY_BINARY_RECORD_SIZE;
+    }
+
+    return p - payload;
+}
+
+// publish state of all the channels in one message
+static bool publishTelemetry(uint32_t tickCount, uint32_t period) {
+    if (g_telemetryPublished && (tickCount - g_telemetryTick) < period) {
+        return false;
+    }
+
+    TelemetryChannelState states[CH_MAX];
+    for (int i = 0; i < CH_NUM; i++) {
+        getTelemetryChannelState(Channel::get(i), states[i]);
+    }
+
+    if (g_telemetryPublished && persist_conf::devConf.mqttTelemetryOnChange &&
+        memcmp(states, g_telemetryStates, CH_NUM * sizeof(TelemetryChannelState)) == 0) {
+        g_telemetryTick = tickCount;
+        return false;
+    }
+
+    char topic[MAX_PUB_TOPIC_LENGTH + 1];
+    snprintf(topic, MAX_PUB_TOPIC_LENGTH + 1, "%s/%s", persist_conf::devConf.ethernetHostName, persist_conf::devConf.mqttTelemetryTopic);
+
+    size_t payloadLength;
+    if (persist_conf::devConf.mqttTelemetryMode == TELEMETRY_MODE_JSON) {
+        payloadLength = encodeTelemetryJson(states, g_telemetryPayload);
+    } else {
+        payloadLength = encodeTelemetryBinary(states, (uint8_t *)g_telemetryPayload);
+    }
+
+    if (!publish(topic, g_telemetryPayload, payloadLength, false)) {
+        return false;
+    }
+
+    memcpy(g_telemetryStates, states, CH_NUM * sizeof(TelemetryChannelState));
+    g_telemetryPublished = true;
+    g_telemetryTick = tickCount;
+
+    g_stats.numChannelUpdates += CH_NUM;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 const char *getClientId() {
     static char g_clientId[50 + 1] = { 0 };
 
@@ -579,6 +751,8 @@ void setState(ConnectionState connectionState) {
 
         g_lastChannelIndex = 0;
         g_lastValueIndex = 0;
+
+        g_telemetryPublished = false;
     }
 
     g_connectionState = connectionState;
@@ -703,6 +877,15 @@ void tick() {
             }
         }
 
+        bool isBatched = isTelemetryBatched();
+
+        if (CH_NUM > 0 && isBatched) {
+            // publish oe, u_set, i_set, u_mon, i_mon and temperature of all channels at once
+            if (publishTelemetry(tickCount, period) && g_publishing) {
+                return;
+            }
+        }
+
         if (CH_NUM > 0) {
             // publish channel state (oe, u_mon, i_mon, u_set, i_set)
             uint8_t channelIndex = g_lastChannelIndex;
@@ -710,7 +893,9 @@ void tick() {
 
             int oe = channel.isOutputEnabled() ? 1 : 0;
 
-            if (g_lastValueIndex == 0) {
+            if (isBatched && g_lastValueIndex >= 1 && g_lastValueIndex <= 5) {
+                // already published with telemetry
+            } else if (g_lastValueIndex == 0) {
                 if (!g_channelStates[channelIndex].modelPublished) {
                     char moduleInfo[50];
                     auto &slot = *g_slots[channel.slotIndex];
@@ -720,7 +905,7 @@ void tick() {
                     }
                 }
 
-                if (oe != g_channelStates[channelIndex].oe) {
+                if (!isBatched && oe != g_channelStates[channelIndex].oe) {
                     if (publish(channelIndex, PUB_TOPIC_DCPSUPPLY_OE, oe, true)) {
                         g_channelStates[channelIndex].oe = oe;
                     }
@@ -804,6 +989,9 @@ void tick() {
 
             if (++g_lastValueIndex == 8) {
                 g_lastValueIndex = 0;
+                if (!isBatched) {
+                    g_stats.numChannelUpdates++;
+                }
                 if (++g_lastChannelIndex == CH_NUM) {
                     g_lastChannelIndex = 0;
                 }
@@ -986,6 +1174,16 @@ void pushEvent(int16_t eventId) {
     g_eventQueue.full = g_eventQueue.head == g_eventQueue.tail;
 }
 
+void getAndResetStats(Stats &stats) {
+    uint32_t tickCount = millis();
+
+    stats = g_stats;
+    stats.duration = tickCount - g_statsResetTick;
+
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_statsResetTick = tickCount;
+}
+
 bool peekEvent(int16_t &eventId) {
     if (g_eventQueue.full || g_eventQueue.tail != g_eventQueue.head) {
         eventId = g_eventQueue.buffer[g_eventQueue.tail];
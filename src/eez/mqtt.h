@@ -18,6 +18,43 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+/* Telemetry
+
+In TELEMETRY_MODE_VALUES every channel value is published to its own topic
+(<host>/dcpsupply/ch/<n>/uset, ...), one value per tick.
+
+In TELEMETRY_MODE_JSON and TELEMETRY_MODE_BINARY state of all channels is published
+in a single message to the <host>/<telemetry topic> topic once per period, or only when
+something changed if "on change" option is enabled.
+
+JSON payload:
+
+    [{"ch":1,"oe":1,"uset":5,"iset":1,"umon":4.9998,"imon":0.1002,"temp":25.5}, ...]
+
+Binary payload (little endian):
+
+OFFSET    TYPE    WIDTH    DESCRIPTION
+----------------------------------------------------------------------
+0         U8      1        VERSION = 1
+1         U8      1        Number of channels (N)
+2         U16     2        Reserved
+4                          N channel records
+
+Channel record:
+
+0         U8      1        Channel number (1 based)
+1         U8      1        Flags: bit 0 - output enabled, bit 1 - CC mode
+2         U16     2        Reserved
+4         F32     4        Voltage set
+8         F32     4        Current set
+12        F32     4        Voltage monitored
+16        F32     4        Current monitored
+20        F32     4        Temperature (NaN if not available)
+*/
+
 namespace eez {
 namespace mqtt {
 
@@ -40,11 +77,30 @@ static const float PERIOD_MIN = 0.1f;
 static const float PERIOD_MAX = 120.0f;
 static const float PERIOD_DEFAULT = 1.0f;
 
+enum TelemetryMode {
+    TELEMETRY_MODE_VALUES,
+    TELEMETRY_MODE_JSON,
+    TELEMETRY_MODE_BINARY
+};
+
+static const char *TELEMETRY_TOPIC_DEFAULT = "dcpsupply/telemetry";
+static const size_t TELEMETRY_TOPIC_MAX_LENGTH = 32;
+
+struct Stats {
+    uint32_t numMessages;
+    uint32_t numBytes;
+    uint32_t numChannelUpdates; // number of times complete channel state was published
+    uint32_t duration; // ms since the last reset
+};
+
 extern ConnectionState g_connectionState;
     
 void tick();
 void reconnect();
 void pushEvent(int16_t eventId);
 
+// returns publishing statistics and starts counting from zero
+void getAndResetStats(Stats &stats);
+
 } // mqtt
 } // eez
@@ -3,6 +3,9 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include <chrono>
+#include <thread>
+
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
 #include <windows.h>
 #else
@@ -21,10 +24,150 @@ static Thread g_threads[MAX_THREADS];
 Thread *g_currentThread;
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+
+struct VirtualClock {
+    std::mutex mutex;
+    std::condition_variable changed; // time is advanced or condition of some waiting thread could be changed
+    std::condition_variable idle; // thread started to wait or finished
+    bool isEnabled;
+    std::atomic<uint32_t> time; // ms
+    uint32_t epoch; // incremented on every change, threads are counted as waiting again after they recheck
+    uint32_t numThreads; // created by osThreadCreate and not finished
+    uint32_t numWaitingThreads;
+    time_t startCalendarTime;
+    uint32_t startTime;
+};
+
+static VirtualClock g_virtualClock;
+
+// only the threads created by osThreadCreate wait for the virtual time
+static thread_local bool t_isOsThread;
+
+static bool isVirtualWait() {
+    return g_virtualClock.isEnabled && t_isOsThread;
+}
+
+// Called with the virtual clock mutex locked.
+static void wakeUpVirtualWaits() {
+    g_virtualClock.epoch++;
+    g_virtualClock.numWaitingThreads = 0;
+    g_virtualClock.changed.notify_all();
+}
+
+static void notifyVirtualWaits() {
+    std::lock_guard<std::mutex> lock(g_virtualClock.mutex);
+    wakeUpVirtualWaits();
+}
+
+template <typename Predicate>
+static bool virtualWait(uint32_t millisec, Predicate tryOperation) {
+    std::unique_lock<std::mutex> lock(g_virtualClock.mutex);
+
+    uint32_t startTime = g_virtualClock.time;
+
+    for (;;) {
+        if (tryOperation()) {
+            return true;
+        }
+
+        if (millisec != osWaitForever && g_virtualClock.time - startTime >= millisec) {
+            return false;
+        }
+
+        g_virtualClock.numWaitingThreads++;
+        g_virtualClock.idle.notify_all();
+
+        uint32_t epoch = g_virtualClock.epoch;
+        do {
+            g_virtualClock.changed.wait(lock);
+        } while (g_virtualClock.epoch == epoch);
+    }
+}
+
+void osVirtualTimeEnable() {
+    std::lock_guard<std::mutex> lock(g_virtualClock.mutex);
+    if (!g_virtualClock.isEnabled) {
+        g_virtualClock.time = osKernelSysTick();
+        g_virtualClock.startCalendarTime = time(0);
+        g_virtualClock.startTime = g_virtualClock.time;
+        g_virtualClock.isEnabled = true;
+    }
+}
+
+bool osVirtualTimeIsEnabled() {
+    return g_virtualClock.isEnabled;
+}
+
+void osVirtualTimeAdvance(uint32_t millisec) {
+    std::unique_lock<std::mutex> lock(g_virtualClock.mutex);
+
+    auto isIdle = [] {
+        return g_virtualClock.numWaitingThreads >= g_virtualClock.numThreads - (t_isOsThread ? 1 : 0);
+    };
+
+    for (uint32_t i = 0; ; i++) {
+        g_virtualClock.idle.wait(lock, isIdle);
+
+        if (i == millisec) {
+            break;
+        }
+
+        g_virtualClock.time++;
+        wakeUpVirtualWaits();
+    }
+}
+
+time_t osKernelTime() {
+    if (!g_virtualClock.isEnabled) {
+        return time(0);
+    }
+    return g_virtualClock.startCalendarTime + (g_virtualClock.time - g_virtualClock.startTime) / 1000;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __EMSCRIPTEN__
+struct ThreadStart {
+    const osThreadDef_t *thread_def;
+    void *argument;
+};
+
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+static DWORD WINAPI threadStartRoutine(LPVOID param) {
+#else
+static void *threadStartRoutine(void *param) {
+#endif
+    ThreadStart threadStart = *(ThreadStart *)param;
+    delete (ThreadStart *)param;
+
+    t_isOsThread = true;
+    threadStart.thread_def->pthread(threadStart.argument);
+
+    std::lock_guard<std::mutex> lock(g_virtualClock.mutex);
+    g_virtualClock.numThreads--;
+    g_virtualClock.idle.notify_all();
+
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    return 0;
+#else
+    return nullptr;
+#endif
+}
+#endif
+
 osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
+#ifndef __EMSCRIPTEN__
+    {
+        // counted before it is started, so the time is not advanced until it waits
+        std::lock_guard<std::mutex> lock(g_virtualClock.mutex);
+        g_virtualClock.numThreads++;
+    }
+#endif
+
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     DWORD threadId;
-    CreateThread(NULL, thread_def->stacksize, (LPTHREAD_START_ROUTINE)thread_def->pthread, argument, 0, &threadId);
+    CreateThread(NULL, thread_def->stacksize, threadStartRoutine, new ThreadStart{ thread_def, argument }, 0, &threadId);
     return threadId;
 #elif defined(__EMSCRIPTEN__)
     for (int i = 0; i < MAX_THREADS; ++i) {
@@ -38,7 +181,7 @@ osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
     return nullptr;
 #else
     pthread_t thread;
-    pthread_create(&thread, 0, thread_def->pthread, 0);
+    pthread_create(&thread, 0, threadStartRoutine, new ThreadStart{ thread_def, argument });
     return thread;
 #endif    
 }
@@ -69,6 +212,14 @@ osStatus osKernelStart(void) {
 }
 
 osStatus osDelay(uint32_t millisec) {
+    if (isVirtualWait()) {
+        // osDelay(0) is used to yield in the loops which wait for the other thread
+        // (e.g. takeScreenshot), so it waits for 1 ms, otherwise thread spinning in
+        // such loop is never counted as waiting and the virtual time can't be advanced
+        virtualWait(millisec > 0 ? millisec : 1, [] { return false; });
+        return osOK;
+    }
+
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     Sleep(millisec);
     return osOK;
@@ -88,6 +239,10 @@ uint32_t osKernelSysTickFrequency = 1000000;
 #endif
 
 uint32_t osKernelSysTick() {
+    if (g_virtualClock.isEnabled) {
+        return g_virtualClock.time;
+    }
+
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     static bool isFirstTime = true;
     static LARGE_INTEGER frequency;
@@ -115,47 +270,134 @@ uint32_t osKernelSysTick() {
 }
 
 osMessageQId osMessageCreate(osMessageQId queue_id, osThreadId thread_id) {
-    queue_id->tail = 0;
-    queue_id->head = 0;
-    queue_id->overflow = 0;
+    for (uint32_t i = 0; i < queue_id->numSlots; i++) {
+        queue_id->slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    queue_id->head.store(0, std::memory_order_relaxed);
+    queue_id->tail.store(0, std::memory_order_relaxed);
+    queue_id->numWaitingReaders.store(0, std::memory_order_relaxed);
+    queue_id->numWaitingWriters.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
     return queue_id;
 }
 
-osEvent osMessageGet(osMessageQId queue_id, uint32_t millisec) {
-    if (millisec == 0) millisec = 1;
+static bool tryPut(osMessageQId queue_id, uint32_t info) {
+    uint32_t mask = queue_id->numSlots - 1;
+    uint32_t pos = queue_id->head.load(std::memory_order_relaxed);
+    for (;;) {
+        MessageQueueSlot &slot = queue_id->slots[pos & mask];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(sequence - pos);
+        if (diff == 0) {
+            if (pos - queue_id->tail.load(std::memory_order_acquire) >= queue_id->numElements) {
+                // full
+                return false;
+            }
+            if (queue_id->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.value = info;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // full
+            return false;
+        } else {
+            pos = queue_id->head.load(std::memory_order_relaxed);
+        }
+    }
+}
 
-    while (queue_id->tail == queue_id->head) {
-        if (queue_id->overflow) {
-            queue_id->overflow = 0;
+static bool tryGet(osMessageQId queue_id, uint32_t &info) {
+    uint32_t mask = queue_id->numSlots - 1;
+    uint32_t pos = queue_id->tail.load(std::memory_order_relaxed);
+    for (;;) {
+        MessageQueueSlot &slot = queue_id->slots[pos & mask];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(sequence - (pos + 1));
+        if (diff == 0) {
+            if (queue_id->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                info = slot.value;
+                slot.sequence.store(pos + queue_id->numSlots, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // empty
+            return false;
+        } else {
+            pos = queue_id->tail.load(std::memory_order_relaxed);
         }
+    }
+}
+
+// Wakes up the threads parked in wait() below. Waiter counter is checked after the fence, so
+// the waiter either sees our change to the queue or we see the waiter and notify it under the lock.
+static void notify(osMessageQId queue_id, std::atomic<uint32_t> &numWaiting, std::condition_variable &condition) {
+    if (g_virtualClock.isEnabled) {
+        notifyVirtualWaits();
+    }
 
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numWaiting.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(queue_id->waitMutex);
+        condition.notify_all();
+    }
+}
+
+template <typename Predicate>
+static bool wait(osMessageQId queue_id, std::atomic<uint32_t> &numWaiting, std::condition_variable &condition, uint32_t millisec, Predicate tryOperation) {
 #ifdef __EMSCRIPTEN__
-        return {
-            osOK,
-            0
-        };
+    // all the threads are executed from the same loop, so it is not possible to wait here
+    return false;
 #else
-        
-        osDelay(1);
-        millisec -= 1;
-
-        if (millisec == 0) {
-            return {
-                osOK,
-                0
-            };
+    if (isVirtualWait()) {
+        return virtualWait(millisec, tryOperation);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(millisec);
+
+    std::unique_lock<std::mutex> lock(queue_id->waitMutex);
+    numWaiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool result;
+    for (;;) {
+        result = tryOperation();
+        if (result) {
+            break;
+        }
+
+        if (millisec == osWaitForever) {
+            condition.wait(lock);
+        } else if (condition.wait_until(lock, deadline) == std::cv_status::timeout) {
+            result = tryOperation();
+            break;
         }
-#endif
     }
-    uint16_t tail = queue_id->tail + 1;
-    if (tail >= queue_id->numElements) {
-        tail = 0;
+
+    numWaiting.fetch_sub(1, std::memory_order_relaxed);
+    return result;
+#endif
+}
+
+osEvent osMessageGet(osMessageQId queue_id, uint32_t millisec) {
+    uint32_t info;
+
+    bool result = tryGet(queue_id, info);
+    if (!result && millisec != 0) {
+        result = wait(queue_id, queue_id->numWaitingReaders, queue_id->notEmpty, millisec, [&] {
+            return tryGet(queue_id, info);
+        });
     }
-    queue_id->tail = tail;
-    uint32_t info = ((uint32_t *)queue_id->data)[tail];
-    if (queue_id->overflow) {
-        queue_id->overflow = 0;
+
+    if (!result) {
+        return {
+            millisec != 0 ? osEventTimeout : osOK,
+            0
+        };
     }
+
+    notify(queue_id, queue_id->numWaitingWriters, queue_id->notFull);
+
     return {
         osEventMessage,
         info
@@ -163,23 +405,90 @@ osEvent osMessageGet(osMessageQId queue_id, uint32_t millisec) {
 }
 
 osStatus osMessagePut(osMessageQId queue_id, uint32_t info, uint32_t millisec) {
-    while (queue_id->overflow) {
-        osDelay(0);
+    bool result = tryPut(queue_id, info);
+    if (!result && millisec != 0) {
+        result = wait(queue_id, queue_id->numWaitingWriters, queue_id->notFull, millisec, [&] {
+            return tryPut(queue_id, info);
+        });
     }
-    uint16_t head = queue_id->head + 1;
-    if (head >= queue_id->numElements) {
-        head = 0;
-    }
-    ((uint32_t *)queue_id->data)[head] = info;
-    queue_id->head = head;
-    if (queue_id->head == queue_id->tail) {
-        queue_id->overflow = 1;
+
+    if (!result) {
+        return millisec != 0 ? osErrorTimeoutResource : osErrorResource;
     }
+
+    notify(queue_id, queue_id->numWaitingReaders, queue_id->notEmpty);
+
     return osOK;
 }
 
 uint32_t osMessageWaiting(osMessageQId queue_id) {
-    return queue_id->head - queue_id->tail;
+    uint32_t tail = queue_id->tail.load(std::memory_order_relaxed);
+    uint32_t head = queue_id->head.load(std::memory_order_relaxed);
+    return head - tail;
+}
+
+bool osMessageRoundTripBenchmark(uint32_t numIterations, uint32_t &minLatency, uint32_t &avgLatency, uint32_t &maxLatency) {
+#ifdef __EMSCRIPTEN__
+    return false;
+#else
+    static MessageQueueSlot requestSlots[4];
+    static MessageQueue requestQueue = { &requestSlots[0], 4, 4 };
+    static MessageQueueSlot responseSlots[4];
+    static MessageQueue responseQueue = { &responseSlots[0], 4, 4 };
+    static std::mutex benchmarkMutex;
+
+    std::lock_guard<std::mutex> lock(benchmarkMutex);
+
+    osMessageCreate(&requestQueue, 0);
+    osMessageCreate(&responseQueue, 0);
+
+    // echo thread, sends back every received message, stops at 0
+    std::thread echoThread([] {
+        for (;;) {
+            osEvent event = osMessageGet(&requestQueue, osWaitForever);
+            if (event.status == osEventMessage) {
+                osMessagePut(&responseQueue, event.value.v, osWaitForever);
+                if (event.value.v == 0) {
+                    break;
+                }
+            }
+        }
+    });
+
+    uint64_t total = 0;
+    minLatency = UINT32_MAX;
+    maxLatency = 0;
+
+    for (uint32_t i = 1; i <= numIterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+
+        osMessagePut(&requestQueue, i, osWaitForever);
+        osEvent event = osMessageGet(&responseQueue, osWaitForever);
+
+        auto latency = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        assert(event.status == osEventMessage && event.value.v == i);
+
+        total += latency;
+        if (latency < minLatency) {
+            minLatency = latency;
+        }
+        if (latency > maxLatency) {
+            maxLatency = latency;
+        }
+    }
+
+    osMessagePut(&requestQueue, 0, osWaitForever);
+    osMessageGet(&responseQueue, osWaitForever);
+    echoThread.join();
+
+    if (numIterations == 0) {
+        minLatency = 0;
+    }
+    avgLatency = numIterations > 0 ? (uint32_t)(total / numIterations) : 0;
+
+    return true;
+#endif
 }
 
 Mutex *osMutexCreate(Mutex &mutex) {
@@ -187,13 +496,34 @@ Mutex *osMutexCreate(Mutex &mutex) {
 }
 
 osStatus osMutexWait(Mutex *mutex, unsigned int timeout) {
-    while (mutex->locked) {
-    	osDelay(1);
+#ifdef __EMSCRIPTEN__
+    // all the threads are executed from the same loop, so it is not possible to wait here
+    return mutex->mutex.try_lock() ? osOK : osErrorTimeoutResource;
+#else
+    if (isVirtualWait()) {
+        if (timeout == 0) {
+            return mutex->mutex.try_lock() ? osOK : osErrorResource;
+        }
+        return virtualWait(timeout, [&] { return mutex->mutex.try_lock(); }) ? osOK : osErrorTimeoutResource;
     }
-    mutex->locked = true;
-    return osOK;
+
+    if (timeout == osWaitForever) {
+        mutex->mutex.lock();
+        return osOK;
+    }
+
+    if (timeout == 0) {
+        return mutex->mutex.try_lock() ? osOK : osErrorResource;
+    }
+
+    return mutex->mutex.try_lock_for(std::chrono::milliseconds(timeout)) ? osOK : osErrorTimeoutResource;
+#endif
 }
 
 void osMutexRelease(Mutex *mutex) {
-    mutex->locked = false;
+    mutex->mutex.unlock();
+
+    if (g_virtualClock.isEnabled) {
+        notifyVirtualWaits();
+    }
 }
@@ -1,10 +1,18 @@
 #pragma once
 
 #include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 typedef enum {
     osOK = 0,
-    osEventMessage = 0x10
+    osEventMessage = 0x10,
+    osEventTimeout = 0x40,
+    osErrorResource = 0x81,
+    osErrorTimeoutResource = 0xC1
 } osStatus;
 
 typedef enum {
@@ -73,6 +81,23 @@ uint32_t osKernelSysTick(void);
 
 extern uint32_t osKernelSysTickFrequency;
 
+// Virtual time
+//
+// When enabled, time doesn't follow the host clock but advances only by osVirtualTimeAdvance,
+// one millisecond at a time and only after all the threads created by osThreadCreate (except
+// the caller) are waiting in osDelay, osMessageGet, osMessagePut or osMutexWait. So every thread
+// is done with the work of the current millisecond before the next one starts and the timing
+// doesn't depend on the host scheduling (only the order of the threads within the same millisecond
+// still does). Thread waiting for the host (e.g. socket input) must not block, it should poll
+// and wait with osDelay instead.
+// Must be enabled before the first thread is created.
+void osVirtualTimeEnable();
+bool osVirtualTimeIsEnabled();
+void osVirtualTimeAdvance(uint32_t millisec);
+
+// Calendar time, follows the virtual time when it is enabled.
+time_t osKernelTime();
+
 //
 
 #define osWaitForever     0xFFFFFFFF
@@ -86,21 +111,40 @@ struct osEvent {
 
 // Message Queue
 
+// Bounded lock-free queue (per slot sequence numbers, multiple producers and consumers).
+// Mutex and condition variables are used only to park the thread when queue is empty/full.
+
+struct MessageQueueSlot {
+    std::atomic<uint32_t> sequence;
+    uint32_t value;
+};
+
 struct MessageQueue {
-    void *data;
-    uint8_t numElements;
-    volatile uint16_t tail;
-    volatile uint16_t head;
-    volatile uint8_t overflow;
+    MessageQueueSlot *slots;
+    uint32_t numSlots; // always power of two
+    uint32_t numElements; // queue capacity, not greater than numSlots
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> numWaitingReaders;
+    std::atomic<uint32_t> numWaitingWriters;
+    std::mutex waitMutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
 };
 
 typedef MessageQueue *osMessageQId;
 
-#define osMessageQDef(name, numElements, ElementType) \
-    static ElementType name##Data[numElements];       \
-    static MessageQueue name = {                      \
-        (void *)&name##Data[0],                       \
-        numElements                                   \
+constexpr uint32_t osMessageQNumSlots(uint32_t numElements, uint32_t numSlots = 1) {
+    return numSlots >= numElements ? numSlots : osMessageQNumSlots(numElements, numSlots << 1);
+}
+
+#define osMessageQDef(name, numElements, ElementType)                                       \
+    static_assert(sizeof(ElementType) <= sizeof(uint32_t), "unsupported message type");     \
+    static MessageQueueSlot name##Slots[osMessageQNumSlots(numElements)];                   \
+    static MessageQueue name = {                                                            \
+        &name##Slots[0],                                                                    \
+        osMessageQNumSlots(numElements),                                                    \
+        numElements                                                                         \
     }
 #define osMessageQ(name) (&name)
 
@@ -109,10 +153,14 @@ osEvent osMessageGet(osMessageQId queue_id, uint32_t millisec);
 osStatus osMessagePut(osMessageQId queue_id, uint32_t info, uint32_t millisec);
 uint32_t osMessageWaiting(osMessageQId queue_id);
 
+// Measures message round trip latency (in microseconds) between two threads,
+// returns false if not supported (Emscripten).
+bool osMessageRoundTripBenchmark(uint32_t numIterations, uint32_t &minLatency, uint32_t &avgLatency, uint32_t &maxLatency);
+
 // Mutex
 
 struct Mutex {
-    bool locked;
+    std::timed_mutex mutex;
 };
 
 #define osMutexDef(mutex) Mutex mutex
@@ -18,7 +18,9 @@
 
 #include <eez/platform/simulator/events.h>
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
+#endif
 
 #include <eez/firmware.h>
 #include <eez/system.h>
@@ -37,6 +39,14 @@ int g_mouseButton1DownX;
 int g_mouseButton1DownY;
 bool g_mouseButton1IsPressed;
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+
+void readEvents() {
+    // mouse state is set by the headless script
+}
+
+#else
+
 void readEvents() {
     int yMouseWheel = 0;
     bool mouseButton2IsUp = false;
@@ -78,6 +88,8 @@ void readEvents() {
 #endif
 }
 
+#endif
+
 } // namespace simulator
 } // namespace platform
 } // namespace eez
\ No newline at end of file
@@ -0,0 +1,363 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include <cmsis_os.h>
+
+#include <eez/platform/simulator/headless.h>
+#include <eez/platform/simulator/events.h>
+
+#include <eez/firmware.h>
+#include <eez/system.h>
+#include <eez/tasks.h>
+
+#include <eez/modules/psu/serial.h>
+
+#include <eez/modules/mcu/simulator/pixel_kernels.h>
+
+#include <eez/gui/assets.h>
+
+namespace eez {
+namespace platform {
+namespace simulator {
+namespace headless {
+
+static const char *g_scriptFilePath;
+static const char *g_reportFilePath;
+static bool g_reportWritten;
+static bool g_pixelKernels;
+static bool g_virtualTime;
+
+static uint64_t g_startTime;
+static uint32_t g_startSysTick;
+
+struct Stats {
+    uint32_t count;
+    uint64_t totalDuration;
+    uint32_t minDuration;
+    uint32_t maxDuration;
+    uint64_t totalQueueDepth;
+    uint32_t maxQueueDepth;
+
+    void add(uint32_t duration, uint32_t queueDepth) {
+        if (count == 0 || duration < minDuration) {
+            minDuration = duration;
+        }
+        if (duration > maxDuration) {
+            maxDuration = duration;
+        }
+        totalDuration += duration;
+
+        totalQueueDepth += queueDepth;
+        if (queueDepth > maxQueueDepth) {
+            maxQueueDepth = queueDepth;
+        }
+
+        count++;
+    }
+};
+
+static Stats g_threadStats[NUM_THREADS];
+static Stats g_frameStats;
+
+static const char *g_threadNames[NUM_THREADS] = { "psu", "low_priority", "gui" };
+
+static uint32_t g_numScriptCommands;
+static uint32_t g_numScpiCommands;
+static uint32_t g_numTouchEvents;
+static uint32_t g_numScriptErrors;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void scriptTask(const void *);
+osThreadDef(g_scriptTask, scriptTask, osPriorityNormal, 0, 1024);
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool init(int argc, char **argv) {
+    g_startTime = getTimeUs();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            g_scriptFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            g_reportFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--pixel-kernels") == 0) {
+            g_pixelKernels = true;
+        } else if (strcmp(argv[i], "--virtual-time") == 0) {
+            g_virtualTime = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--script <file>] [--report <file>] [--pixel-kernels] [--virtual-time]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (g_virtualTime) {
+        if (!g_scriptFilePath) {
+            // time would never advance
+            fprintf(stderr, "--virtual-time requires --script\n");
+            return false;
+        }
+        osVirtualTimeEnable();
+    }
+
+    g_startSysTick = osKernelSysTick();
+
+    return true;
+}
+
+bool hasScript() {
+    return g_scriptFilePath != nullptr;
+}
+
+void startScript() {
+    osThreadCreate(osThread(g_scriptTask), nullptr);
+}
+
+uint64_t getTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void onThreadIteration(Thread thread, uint32_t duration, uint32_t queueDepth) {
+    g_threadStats[thread].add(duration, queueDepth);
+}
+
+void onFrameRendered(uint32_t duration) {
+    g_frameStats.add(duration, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void writeDurationStats(FILE *fp, const Stats &stats) {
+    fprintf(fp, "\"count\": %u, ", (unsigned)stats.count);
+    fprintf(fp, "\"total_us\": %llu, ", (unsigned long long)stats.totalDuration);
+    fprintf(fp, "\"avg_us\": %.2f, ", stats.count > 0 ? 1.0 * stats.totalDuration / stats.count : 0.0);
+    fprintf(fp, "\"min_us\": %u, ", (unsigned)stats.minDuration);
+    fprintf(fp, "\"max_us\": %u", (unsigned)stats.maxDuration);
+}
+
+static void writePixelKernels(FILE *fp) {
+    using namespace eez::mcu::display::kernels;
+
+    fprintf(fp, "  \"pixel_kernels\": {\n");
+    fprintf(fp, "    \"selected\": \"%s\",\n", g_kernels->name);
+
+    int numKernelSets = getNumKernelSets();
+    for (int i = 0; i < numKernelSets; i++) {
+        const PixelKernels &kernels = *getKernelSet(i);
+
+        uint32_t numDifferences = verify(kernels);
+
+        BenchmarkResult result;
+        benchmark(kernels, result);
+
+        fprintf(fp, "    \"%s\": { \"different_pixels\": %u, \"mpix_per_s\": { ", kernels.name, (unsigned)numDifferences);
+        fprintf(fp, "\"fill\": %.1f, \"fill_blend\": %.1f, \"blend_mask\": %.1f, \"blend_opacity\": %.1f, \"blend_scaled_alpha\": %.1f, \"copy_rgb565\": %.1f",
+            result.fill, result.fillBlend, result.blendMask, result.blendOpacity, result.blendScaledAlpha, result.copyRgb565);
+        fprintf(fp, " } }%s\n", i < numKernelSets - 1 ? "," : "");
+    }
+
+    fprintf(fp, "  },\n");
+}
+
+static void writeAssets(FILE *fp) {
+    eez::gui::AssetsStatistics statistics;
+    eez::gui::getAssetsStatistics(statistics);
+
+    fprintf(fp, "  \"assets\": { \"sectioned\": %s, \"compressed_size\": %u, \"boot_decompressed_size\": %u, \"boot_us\": %u, ",
+        statistics.sectioned ? "true" : "false", (unsigned)statistics.compressedSize, (unsigned)statistics.bootDecompressedSize, (unsigned)statistics.bootTime);
+    fprintf(fp, "\"cache\": { \"size\": %u, \"used\": %u, \"high_water_mark\": %u, \"items\": %u, \"hits\": %u, \"loads\": %u, \"evictions\": %u, \"failed_loads\": %u, \"reserved_loads\": %u, \"load_us\": %u, \"max_load_us\": %u } },\n",
+        (unsigned)statistics.cacheSize, (unsigned)statistics.cacheUsed, (unsigned)statistics.cacheHighWaterMark, (unsigned)statistics.numItems,
+        (unsigned)statistics.numHits, (unsigned)statistics.numLoads, (unsigned)statistics.numEvictions, (unsigned)statistics.numFailedLoads, (unsigned)statistics.numReservedLoads, (unsigned)statistics.loadTime, (unsigned)statistics.maxLoadTime);
+}
+
+void writeReport() {
+    if (g_reportWritten) {
+        return;
+    }
+    g_reportWritten = true;
+
+    FILE *fp = stdout;
+    if (g_reportFilePath) {
+        fp = fopen(g_reportFilePath, "w");
+        if (!fp) {
+            fprintf(stderr, "Can't create report file %s\n", g_reportFilePath);
+            return;
+        }
+    }
+
+    uint64_t duration = getTimeUs() - g_startTime;
+
+    fprintf(fp, "{\n");
+
+    fprintf(fp, "  \"duration_ms\": %llu,\n", (unsigned long long)(duration / 1000));
+
+    fprintf(fp, "  \"virtual_time\": { \"enabled\": %s, \"duration_ms\": %u },\n",
+        g_virtualTime ? "true" : "false", g_virtualTime ? (unsigned)(osKernelSysTick() - g_startSysTick) : 0);
+
+    fprintf(fp, "  \"script\": { \"commands\": %u, \"scpi_commands\": %u, \"touch_events\": %u, \"errors\": %u },\n",
+        (unsigned)g_numScriptCommands, (unsigned)g_numScpiCommands, (unsigned)g_numTouchEvents, (unsigned)g_numScriptErrors);
+
+    if (g_pixelKernels) {
+        writePixelKernels(fp);
+    }
+
+    writeAssets(fp);
+
+    fprintf(fp, "  \"threads\": {\n");
+    for (int i = 0; i < NUM_THREADS; i++) {
+        const Stats &stats = g_threadStats[i];
+        fprintf(fp, "    \"%s\": { \"iterations\": { ", g_threadNames[i]);
+        writeDurationStats(fp, stats);
+        fprintf(fp, " }, \"queue_depth\": { \"avg\": %.2f, \"max\": %u } }%s\n",
+            stats.count > 0 ? 1.0 * stats.totalQueueDepth / stats.count : 0.0,
+            (unsigned)stats.maxQueueDepth,
+            i < NUM_THREADS - 1 ? "," : "");
+    }
+    fprintf(fp, "  },\n");
+
+    fprintf(fp, "  \"frames\": { ");
+    writeDurationStats(fp, g_frameStats);
+    fprintf(fp, ", \"fps\": %.2f }\n", duration > 0 ? 1000000.0 * g_frameStats.count / duration : 0.0);
+
+    fprintf(fp, "}\n");
+
+    if (fp != stdout) {
+        fclose(fp);
+    } else {
+        fflush(fp);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void sendScpiCommand(const char *command) {
+    for (const char *p = command; *p; p++) {
+        Serial.put(*p);
+    }
+    Serial.put('\n');
+    g_numScpiCommands++;
+}
+
+static void setTouch(bool isPressed, int x, int y) {
+    g_mouseX = x;
+    g_mouseY = y;
+    g_mouseButton1IsPressed = isPressed;
+    g_numTouchEvents++;
+}
+
+static void wait(uint32_t ms) {
+    if (g_virtualTime) {
+        osVirtualTimeAdvance(ms);
+    } else {
+        osDelay(ms);
+    }
+}
+
+static bool executeCommand(char *line) {
+    // trim
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ' || line[len - 1] == '\t')) {
+        line[--len] = 0;
+    }
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+
+    if (*line == 0 || *line == '#') {
+        return true;
+    }
+
+    g_numScriptCommands++;
+
+    int x, y, ms;
+    int n;
+
+    if (strncmp(line, "scpi ", 5) == 0) {
+        sendScpiCommand(line + 5);
+    } else if (sscanf(line, "wait %d", &ms) == 1) {
+        wait(ms);
+    } else if (sscanf(line, "press %d %d", &x, &y) == 2) {
+        setTouch(true, x, y);
+    } else if (sscanf(line, "move %d %d", &x, &y) == 2) {
+        setTouch(g_mouseButton1IsPressed, x, y);
+    } else if (strcmp(line, "release") == 0) {
+        setTouch(false, g_mouseX, g_mouseY);
+    } else if ((n = sscanf(line, "tap %d %d %d", &x, &y, &ms)) >= 2) {
+        if (n == 2) {
+            ms = 100;
+        }
+        setTouch(true, x, y);
+        wait(ms);
+        setTouch(false, x, y);
+    } else if (strcmp(line, "quit") == 0) {
+        return false;
+    } else {
+        fprintf(stderr, "Unknown script command: %s\n", line);
+        g_numScriptErrors++;
+    }
+
+    return true;
+}
+
+void scriptTask(const void *) {
+    while (!g_isBooted) {
+        wait(1);
+    }
+
+    sendMessageToLowPriorityThread(SERIAL_LINE_STATE_CHANGED, 1);
+
+    FILE *fp = fopen(g_scriptFilePath, "r");
+    if (fp) {
+        char line[1024];
+        while (fgets(line, sizeof(line), fp)) {
+            if (!executeCommand(line)) {
+                break;
+            }
+        }
+        fclose(fp);
+    } else {
+        fprintf(stderr, "Can't open script file %s\n", g_scriptFilePath);
+        g_numScriptErrors++;
+    }
+
+    writeReport();
+
+    eez::shutdown();
+
+    if (g_virtualTime) {
+        // nobody else advances the time
+        while (!g_shutdown) {
+            osVirtualTimeAdvance(1);
+        }
+    }
+}
+
+} // namespace headless
+} // namespace simulator
+} // namespace platform
+} // namespace eez
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+
+#include <stdint.h>
+
+/* Headless simulator
+
+Simulator built without SDL. Display is rendered into VRAM buffers only and the GUI thread
+is not paced to 60 fps. Command line:
+
+    modular-psu-firmware-headless [--script <file>] [--report <file>] [--pixel-kernels] [--virtual-time]
+
+Script is a text file with one command per line:
+
+    # comment
+    scpi <command>        send SCPI command to the serial port
+    wait <ms>             wait
+    press <x> <y>         touch down
+    move <x> <y>          move while touch is down
+    release               touch up
+    tap <x> <y> [<ms>]    press, wait (default 100 ms) and release
+    quit                  stop executing script
+
+When script is finished JSON report with per thread iteration times, queue depths and
+frame render times is written to the report file (or stdout) and simulator is shut down.
+Without script, SCPI commands are read from stdin and report is written at the exit.
+
+With --pixel-kernels, report also contains, for every display pixel kernel set supported
+by the CPU, the number of pixels different from the scalar reference and the throughput
+of every kernel. EEZ_PIXEL_KERNELS environment variable selects the set used for rendering.
+
+With --virtual-time (only with the script), simulator time doesn't follow the host clock
+but is advanced by the script: wait and tap advance it one millisecond at a time, each time
+after all the firmware threads are done with the previous millisecond. Timing of the lists,
+ramps, recordings and protections is then the same on every run and long scripts run
+as fast as the host can execute them. Report contains the virtual duration.
+*/
+
+namespace eez {
+namespace platform {
+namespace simulator {
+namespace headless {
+
+enum Thread {
+    THREAD_PSU,
+    THREAD_LOW_PRIORITY,
+    THREAD_GUI,
+    NUM_THREADS
+};
+
+bool init(int argc, char **argv);
+
+bool hasScript();
+void startScript();
+
+void writeReport();
+
+uint64_t getTimeUs();
+
+void onThreadIteration(Thread thread, uint32_t duration, uint32_t queueDepth);
+void onFrameRendered(uint32_t duration);
+
+struct ThreadIterationScope {
+    ThreadIterationScope(Thread thread_, uint32_t queueDepth_)
+        : thread(thread_), queueDepth(queueDepth_), startTime(getTimeUs()) {
+    }
+
+    ~ThreadIterationScope() {
+        onThreadIteration(thread, (uint32_t)(getTimeUs() - startTime), queueDepth);
+    }
+
+    Thread thread;
+    uint32_t queueDepth;
+    uint64_t startTime;
+};
+
+struct FrameRenderScope {
+    FrameRenderScope() : startTime(getTimeUs()) {
+    }
+
+    ~FrameRenderScope() {
+        onFrameRendered((uint32_t)(getTimeUs() - startTime));
+    }
+
+    uint64_t startTime;
+};
+
+} // namespace headless
+} // namespace simulator
+} // namespace platform
+} // namespace eez
+
+#endif
@@ -255,9 +255,7 @@ void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
 
 	deselect(slotIndex);
 
-	auto &slot = *g_slots[slotIndex];
-
-	slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_OK);
+	onDmaTransferCompleted(slotIndex, TRANSFER_STATUS_OK);
 }
 
 void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
@@ -276,12 +274,10 @@ void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
 
 	deselect(slotIndex);
 
-	auto &slot = *g_slots[slotIndex];
-
 	if (spi::handle[slotIndex]->ErrorCode == HAL_SPI_ERROR_CRC) {
-		slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_CRC_ERROR);
+		onDmaTransferCompleted(slotIndex, TRANSFER_STATUS_CRC_ERROR);
 	} else {
-		slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_ERROR);
+		onDmaTransferCompleted(slotIndex, TRANSFER_STATUS_ERROR);
 	}
 }
 
@@ -0,0 +1,154 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <chrono>
+#endif
+
+#include <eez/system.h>
+#include <eez/profiler.h>
+
+namespace eez {
+namespace profiler {
+
+struct ZoneInfo {
+    Thread thread;
+    const char *name;
+};
+
+#define PROFILER_ZONE_INFO(id, thread, name) { thread, name },
+static const ZoneInfo g_zoneInfos[NUM_ZONES] = {
+    PROFILER_ZONES(PROFILER_ZONE_INFO)
+};
+#undef PROFILER_ZONE_INFO
+
+static const char *g_threadNames[NUM_THREADS] = {
+    "PSU",
+    "LOW_PRIORITY",
+    "GUI"
+};
+
+#if OPTION_PROFILER
+
+struct ZoneData {
+    // statistics belong to the generation, zone is cleared when generation is changed by reset
+    volatile uint32_t generation;
+    ZoneStatistics statistics;
+};
+
+static ZoneData g_zones[NUM_ZONES];
+static volatile uint32_t g_generation = 1;
+static uint32_t g_resetTime;
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char *getThreadName(Thread thread) {
+    return g_threadNames[thread];
+}
+
+const char *getZoneName(Zone zone) {
+    return g_zoneInfos[zone].name;
+}
+
+Thread getZoneThread(Zone zone) {
+    return g_zoneInfos[zone].thread;
+}
+
+#if OPTION_PROFILER
+
+uint32_t getTime() {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // micros() in the simulator has only millisecond resolution
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+void addZoneDuration(Zone zone, uint32_t duration) {
+    ZoneData &z = g_zones[zone];
+    ZoneStatistics &statistics = z.statistics;
+
+    uint32_t generation = g_generation;
+    if (z.generation != generation) {
+        memset(&statistics, 0, sizeof(ZoneStatistics));
+        statistics.minDuration = 0xFFFFFFFF;
+        z.generation = generation;
+    }
+
+    statistics.count++;
+    statistics.totalDuration += duration;
+
+    if (duration < statistics.minDuration) {
+        statistics.minDuration = duration;
+    }
+
+    if (duration > statistics.maxDuration) {
+        statistics.maxDuration = duration;
+    }
+
+    int bucket = 0;
+    for (uint32_t d = duration >> 1; d && bucket < NUM_HISTOGRAM_BUCKETS - 1; d >>= 1) {
+        bucket++;
+    }
+    statistics.histogram[bucket]++;
+}
+
+void getZoneStatistics(Zone zone, ZoneStatistics &statistics) {
+    ZoneData &z = g_zones[zone];
+    if (z.generation == g_generation) {
+        memcpy(&statistics, &z.statistics, sizeof(ZoneStatistics));
+        if (statistics.count == 0) {
+            statistics.minDuration = 0;
+        }
+    } else {
+        memset(&statistics, 0, sizeof(ZoneStatistics));
+    }
+}
+
+uint32_t getElapsedTime() {
+    return millis() - g_resetTime;
+}
+
+void reset() {
+    g_resetTime = millis();
+    g_generation = g_generation + 1;
+}
+
+#else
+
+void getZoneStatistics(Zone zone, ZoneStatistics &statistics) {
+    memset(&statistics, 0, sizeof(ZoneStatistics));
+}
+
+uint32_t getElapsedTime() {
+    return 0;
+}
+
+void reset() {
+}
+
+#endif
+
+} // namespace profiler
+} // namespace eez
@@ -0,0 +1,130 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef OPTION_PROFILER
+#define OPTION_PROFILER 1
+#endif
+
+/* Profiler
+
+Zone is the named code region which duration is measured on every execution:
+
+    void Channel::tick(uint32_t tick_usec) {
+        PROFILER_ZONE(CHANNEL_TICK);
+        ...
+    }
+
+All zones are listed in PROFILER_ZONES, so there is no registration at runtime.
+Every zone is executed only in its own thread, statistics of the zone are updated
+only by that thread and no locking is needed.
+
+Duration histogram has power of two buckets: bucket 0 counts durations below 2 us,
+bucket i counts durations from 2^i to 2^(i+1) - 1 us and the last bucket also counts
+all the longer durations.
+
+Statistics are returned by DIAGnostic:PROFile? and, in the debug build, shown
+on the debug variables page. Build with OPTION_PROFILER=0 to remove the profiler.
+*/
+
+//  ZONE(id, thread, name)
+#define PROFILER_ZONES(ZONE) \
+    ZONE(PSU_ITER, THREAD_PSU, "PSU_ITER") \
+    ZONE(CHANNEL_TICK, THREAD_PSU, "CH_TICK") \
+    ZONE(TEMPERATURE_TICK, THREAD_PSU, "TEMP_TICK") \
+    ZONE(FAN_TICK, THREAD_PSU, "FAN_TICK") \
+    ZONE(DATETIME_TICK, THREAD_PSU, "DATETIME_TICK") \
+    ZONE(LOW_PRIORITY_ITER, THREAD_LOW_PRIORITY, "LP_ITER") \
+    ZONE(DLOG_FILE_WRITE, THREAD_LOW_PRIORITY, "DLOG_FILE_WRITE") \
+    ZONE(GUI_ITER, THREAD_GUI, "GUI_ITER")
+
+namespace eez {
+namespace profiler {
+
+enum Thread {
+    THREAD_PSU,
+    THREAD_LOW_PRIORITY,
+    THREAD_GUI,
+    NUM_THREADS
+};
+
+#define PROFILER_ZONE_ENUM(id, thread, name) ZONE_##id,
+enum Zone {
+    PROFILER_ZONES(PROFILER_ZONE_ENUM)
+    NUM_ZONES
+};
+#undef PROFILER_ZONE_ENUM
+
+static const int NUM_HISTOGRAM_BUCKETS = 16;
+
+struct ZoneStatistics {
+    uint32_t count;
+    uint32_t minDuration; // us
+    uint32_t maxDuration; // us
+    uint64_t totalDuration; // us
+    uint32_t histogram[NUM_HISTOGRAM_BUCKETS];
+};
+
+const char *getThreadName(Thread thread);
+const char *getZoneName(Zone zone);
+Thread getZoneThread(Zone zone);
+
+#if OPTION_PROFILER
+
+// microseconds, with better resolution than micros() in the simulator
+uint32_t getTime();
+
+void addZoneDuration(Zone zone, uint32_t duration);
+
+struct ZoneScope {
+    ZoneScope(Zone zone_) : zone(zone_), startTime(getTime()) {
+    }
+
+    ~ZoneScope() {
+        addZoneDuration(zone, getTime() - startTime);
+    }
+
+    Zone zone;
+    uint32_t startTime;
+};
+
+#else
+
+struct ZoneScope {
+    ZoneScope(Zone zone_) {
+    }
+};
+
+#endif
+
+#define PROFILER_ZONE(id) ::eez::profiler::ZoneScope profilerZoneScope(::eez::profiler::ZONE_##id)
+
+void getZoneStatistics(Zone zone, ZoneStatistics &statistics);
+
+// milliseconds since the last reset
+uint32_t getElapsedTime();
+
+// Can be called from any thread, zone statistics are cleared by the zone thread
+// on the next zone execution.
+void reset();
+
+} // namespace profiler
+} // namespace eez
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <eez/scpi/commands_debug.h>
+
 #if defined(EEZ_PLATFORM_STM32)
 #include <eez/scpi/commands_stm32.h>
 #elif defined(EEZ_PLATFORM_SIMULATOR)
@@ -0,0 +1,55 @@
+/*
+* EEZ Generic Firmware
+* Copyright (C) 2018-present, Envox d.o.o.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#pragma once
+
+// Benchmark and statistics queries used during the development. They are not built into
+// the STM32 firmware, unless OPTION_SCPI_DEBUG_QUERIES is set to 1 in the project settings.
+#ifndef OPTION_SCPI_DEBUG_QUERIES
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#define OPTION_SCPI_DEBUG_QUERIES 1
+#else
+#define OPTION_SCPI_DEBUG_QUERIES 0
+#endif
+#endif
+
+#if OPTION_SCPI_DEBUG_QUERIES
+#define SCPI_DEBUG_COMMANDS \
+    SCPI_COMMAND("DEBUg:OS:QUEue?", scpi_cmd_debugOsQueueQ) \
+    SCPI_COMMAND("DEBUg:SCPI:DISPatch?", scpi_cmd_debugScpiDispatchQ) \
+    SCPI_COMMAND("DEBUg:ETHernet:LOAD", scpi_cmd_debugEthernetLoad) \
+    SCPI_COMMAND("DEBUg:ETHernet:LOAD?", scpi_cmd_debugEthernetLoadQ) \
+    SCPI_COMMAND("DEBUg:MQTT?", scpi_cmd_debugMqttQ) \
+    SCPI_COMMAND("DEBUg:MP?", scpi_cmd_debugMpQ) \
+    SCPI_COMMAND("DEBUg:EVENt:BENChmark?", scpi_cmd_debugEventBenchmarkQ) \
+    SCPI_COMMAND("DEBUg:PROFile:BENChmark?", scpi_cmd_debugProfileBenchmarkQ) \
+    SCPI_COMMAND("DEBUg:EEPRom:STATistics?", scpi_cmd_debugEepromStatisticsQ) \
+    SCPI_COMMAND("DEBUg:EEPRom:STATistics:PAGes?", scpi_cmd_debugEepromStatisticsPagesQ) \
+    SCPI_COMMAND("DEBUg:EEPRom:STATistics:RESet", scpi_cmd_debugEepromStatisticsReset) \
+    SCPI_COMMAND("DEBUg:ASSets:STATistics?", scpi_cmd_debugAssetsStatisticsQ) \
+    SCPI_COMMAND("DEBUg:CALibration:BENChmark?", scpi_cmd_debugCalibrationBenchmarkQ) \
+    SCPI_COMMAND("DEBUg:LIST:JITTer?", scpi_cmd_debugListJitterQ) \
+    SCPI_COMMAND("DEBUg:JPEG:BENChmark?", scpi_cmd_debugJpegBenchmarkQ) \
+    SCPI_COMMAND("DEBUg:TEXT:BENChmark?", scpi_cmd_debugTextBenchmarkQ) \
+    SCPI_COMMAND("DEBUg:SOUNd?", scpi_cmd_debugSoundQ) \
+    SCPI_COMMAND("DEBUg:INPut?", scpi_cmd_debugInputQ) \
+    SCPI_COMMAND("DEBUg:BP3C:STATistics?", scpi_cmd_debugBp3cStatisticsQ) \
+    SCPI_COMMAND("DEBUg:BP3C:BENChmark?", scpi_cmd_debugBp3cBenchmarkQ)
+#else
+#define SCPI_DEBUG_COMMANDS
+#endif
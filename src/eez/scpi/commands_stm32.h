@@ -34,6 +34,8 @@
     SCPI_COMMAND("CALibration:SCReen:INIT", scpi_cmd_calibrationScreenInit) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:ADC?", scpi_cmd_diagnosticInformationAdcQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:CALibration?", scpi_cmd_diagnosticInformationCalibrationQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROFile?", scpi_cmd_diagnosticInformationProfileQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROFile:RESet", scpi_cmd_diagnosticInformationProfileReset) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection?", scpi_cmd_diagnosticInformationProtectionQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:TEST?", scpi_cmd_diagnosticInformationTestQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:REGS?", scpi_cmd_diagnosticInformationRegsQ) \
@@ -55,6 +57,10 @@
     SCPI_COMMAND("DISPlay[:WINdow]:DIALog:DATA", scpi_cmd_displayWindowDialogData) \
     SCPI_COMMAND("DISPlay[:WINdow]:DIALog:CLOSe", scpi_cmd_displayWindowDialogClose) \
     SCPI_COMMAND("DISPlay[:WINdow]:ERRor", scpi_cmd_displayWindowError) \
+    SCPI_COMMAND("FORMat[:DATA]", scpi_cmd_formatData) \
+    SCPI_COMMAND("FORMat[:DATA]?", scpi_cmd_formatDataQ) \
+    SCPI_COMMAND("FORMat:BORDer", scpi_cmd_formatBorder) \
+    SCPI_COMMAND("FORMat:BORDer?", scpi_cmd_formatBorderQ) \
     SCPI_COMMAND("INITiate:CONTinuous", scpi_cmd_initiateContinuous) \
     SCPI_COMMAND("INITiate:CONTinuous?", scpi_cmd_initiateContinuousQ) \
     SCPI_COMMAND("INITiate:DLOG", scpi_cmd_initiateDlog) \
@@ -79,6 +85,7 @@
     SCPI_COMMAND("MEASure[:SCALar]:CURRent[:DC]?", scpi_cmd_measureScalarCurrentDcQ) \
     SCPI_COMMAND("MEASure[:SCALar]:POWer[:DC]?", scpi_cmd_measureScalarPowerDcQ) \
     SCPI_COMMAND("MEASure[:SCALar][:VOLTage][:DC]?", scpi_cmd_measureScalarVoltageDcQ) \
+    SCPI_COMMAND("MEASure[:SCALar]:ALL[:DC]?", scpi_cmd_measureScalarAllDcQ) \
     SCPI_COMMAND("MEMory:NSTates?", scpi_cmd_memoryNstatesQ) \
     SCPI_COMMAND("MEMory:STATe:CATalog?", scpi_cmd_memoryStateCatalogQ) \
     SCPI_COMMAND("MEMory:STATe:DELete", scpi_cmd_memoryStateDelete) \
@@ -96,6 +103,7 @@
     SCPI_COMMAND("MMEMory:CATalog?", scpi_cmd_mmemoryCatalogQ) \
     SCPI_COMMAND("MMEMory:CDIRectory", scpi_cmd_mmemoryCdirectory) \
     SCPI_COMMAND("MMEMory:CDIRectory?", scpi_cmd_mmemoryCdirectoryQ) \
+    SCPI_COMMAND("MMEMory:CONVert:LIST", scpi_cmd_mmemoryConvertList) \
     SCPI_COMMAND("MMEMory:COPY", scpi_cmd_mmemoryCopy) \
     SCPI_COMMAND("MMEMory:DATE?", scpi_cmd_mmemoryDateQ) \
     SCPI_COMMAND("MMEMory:DELete", scpi_cmd_mmemoryDelete) \
@@ -137,6 +145,8 @@
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:POWer?", scpi_cmd_senseDlogFunctionPowerQ) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:VOLTage", scpi_cmd_senseDlogFunctionVoltage) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:VOLTage?", scpi_cmd_senseDlogFunctionVoltageQ) \
+    SCPI_COMMAND("SENSe:DLOG:INDex", scpi_cmd_senseDlogIndex) \
+    SCPI_COMMAND("SENSe:DLOG:DATA?", scpi_cmd_senseDlogDataQ) \
     SCPI_COMMAND("SENSe:DLOG:PERiod", scpi_cmd_senseDlogPeriod) \
     SCPI_COMMAND("SENSe:DLOG:PERiod?", scpi_cmd_senseDlogPeriodQ) \
     SCPI_COMMAND("SENSe:DLOG:TIME", scpi_cmd_senseDlogTime) \
@@ -255,6 +265,7 @@
     SCPI_COMMAND("SYSTem:BEEPer:STATe", scpi_cmd_systemBeeperState) \
     SCPI_COMMAND("SYSTem:BEEPer:STATe?", scpi_cmd_systemBeeperStateQ) \
     SCPI_COMMAND("SYSTem:BEEPer[:IMMediate]", scpi_cmd_systemBeeperImmediate) \
+    SCPI_COMMAND("SYSTem:BEEPer:WAV", scpi_cmd_systemBeeperWav) \
     SCPI_COMMAND("SYSTem:CAPability?", scpi_cmd_systemCapabilityQ) \
     SCPI_COMMAND("SYSTem:SLOT[:COUNt]?", scpi_cmd_systemSlotCountQ) \
     SCPI_COMMAND("SYSTem:SLOT:MODel?", scpi_cmd_systemSlotModelQ) \
@@ -295,6 +306,8 @@
     SCPI_COMMAND("SYSTem:COMMunicate:RLSTate?", scpi_cmd_systemCommunicateRlstateQ) \
     SCPI_COMMAND("SYSTem:COMMunicate:MQTT:SETTings", scpi_cmd_systemCommunicateMqttSettings) \
     SCPI_COMMAND("SYSTem:COMMunicate:MQTT:STATe?", scpi_cmd_systemCommunicateMqttStateQ) \
+    SCPI_COMMAND("SYSTem:COMMunicate:MQTT:TELemetry", scpi_cmd_systemCommunicateMqttTelemetry) \
+    SCPI_COMMAND("SYSTem:COMMunicate:MQTT:TELemetry?", scpi_cmd_systemCommunicateMqttTelemetryQ) \
     SCPI_COMMAND("SYSTem:CPU:INFOrmation:ONTime:LAST?", scpi_cmd_systemCpuInformationOntimeLastQ) \
     SCPI_COMMAND("SYSTem:CPU:INFOrmation:ONTime:TOTal?", scpi_cmd_systemCpuInformationOntimeTotalQ) \
     SCPI_COMMAND("SYSTem:CPU:MODel?", scpi_cmd_systemCpuModelQ) \
@@ -322,6 +335,7 @@
     SCPI_COMMAND("SYSTem:INHibit?", scpi_cmd_systemInhibitQ) \
     SCPI_COMMAND("SYSTem:KLOCk", scpi_cmd_systemKlock) \
     SCPI_COMMAND("SYSTem:LOCal", scpi_cmd_systemLocal) \
+    SCPI_COMMAND("SYSTem:LOG:EXPort", scpi_cmd_systemLogExport) \
     SCPI_COMMAND("SYSTem:PASSword:CALibration:RESet", scpi_cmd_systemPasswordCalibrationReset) \
     SCPI_COMMAND("SYSTem:PASSword:FPANel:RESet", scpi_cmd_systemPasswordFpanelReset) \
     SCPI_COMMAND("SYSTem:PASSword:NEW", scpi_cmd_systemPasswordNew) \
@@ -401,6 +415,7 @@
     SCPI_COMMAND("DEBUg:IOEXp?", scpi_cmd_debugIoexpQ) \
     SCPI_COMMAND("DEBUg:DCM220?", scpi_cmd_debugDcm220Q) \
     SCPI_COMMAND("DEBUg:DOWNload:FIRMware", scpi_cmd_debugDownloadFirmware) \
+    SCPI_DEBUG_COMMANDS \
     SCPI_COMMAND("DEBUg:EVENt", scpi_cmd_debugEvent) \
     SCPI_COMMAND("SYSTem:DATE:CLEar", scpi_cmd_systemDateClear) \
     SCPI_COMMAND("SYSTem:TIME:CLEar", scpi_cmd_systemTimeClear)
@@ -35,7 +35,9 @@ void scpi_reg_set(scpi_reg_name_t name, scpi_reg_val_t val) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSet(&ethernet::g_scpiContext, name, val);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            SCPI_RegSet(&ethernet::g_scpiContexts[client], name, val);
+        }
     }
 #endif
 }
@@ -227,7 +229,9 @@ void reg_set(scpi_psu_reg_name_t name, scpi_reg_val_t val) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set(&ethernet::g_scpiContext, name, val);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            reg_set(&ethernet::g_scpiContexts[client], name, val);
+        }
     }
 #endif
 }
@@ -238,7 +242,9 @@ void reg_set_esr_bits(int bit_mask) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSetBits(&ethernet::g_scpiContext, SCPI_REG_ESR, bit_mask);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            SCPI_RegSetBits(&ethernet::g_scpiContexts[client], SCPI_REG_ESR, bit_mask);
+        }
     }
 #endif
 }
@@ -266,7 +272,9 @@ void reg_set_ques_bit(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            reg_set_ques_bit(&ethernet::g_scpiContexts[client], bit_mask, on);
+        }
     }
 #endif
 }
@@ -296,7 +304,9 @@ void reg_set_ques_isum_bit(int iChannel, int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_isum_bit(&ethernet::g_scpiContext, iChannel, bit_mask, on);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            reg_set_ques_isum_bit(&ethernet::g_scpiContexts[client], iChannel, bit_mask, on);
+        }
     }
 #endif
 }
@@ -324,7 +334,9 @@ void reg_set_oper_bit(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            reg_set_oper_bit(&ethernet::g_scpiContexts[client], bit_mask, on);
+        }
     }
 #endif
 }
@@ -355,7 +367,9 @@ void reg_set_oper_isum_bit(int iChannel, int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_isum_bit(&ethernet::g_scpiContext, iChannel, bit_mask, on);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            reg_set_oper_isum_bit(&ethernet::g_scpiContexts[client], iChannel, bit_mask, on);
+        }
     }
 #endif
 }
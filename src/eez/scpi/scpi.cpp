@@ -33,6 +33,8 @@ void resetContext(scpi_t *context) {
     auto psuContext = (eez::psu::scpi::scpi_psu_t *)context->user_context;
     psuContext->selectedChannels = 1 << 0; // first channel is selected by default
     psuContext->currentDirectory[0] = 0;
+    psuContext->dataFormat = SCPI_FORMAT_ASCII;
+    psuContext->byteOrder = SCPI_FORMAT_NORMAL;
     SCPI_ErrorClear(context);
 }
 
@@ -44,7 +46,9 @@ void resetContext() {
 
 #if OPTION_ETHERNET
     if (psu::ethernet::g_testResult == TEST_OK) {
-        scpi::resetContext(&psu::ethernet::g_scpiContext);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            scpi::resetContext(&psu::ethernet::g_scpiContexts[client]);
+        }
     }
 #endif
 }
@@ -55,7 +59,9 @@ void generateError(int error) {
     }
 #if OPTION_ETHERNET
     if (psu::ethernet::g_testResult == TEST_OK) {
-        SCPI_ErrorPush(&psu::ethernet::g_scpiContext, error);
+        for (int client = 0; client < mcu::ethernet::MAX_NUM_CLIENTS; client++) {
+            SCPI_ErrorPush(&psu::ethernet::g_scpiContexts[client], error);
+        }
     }
 #endif
     psu::event_queue::pushEvent(error);
@@ -18,10 +18,14 @@
 
 #pragma once
 
+typedef struct _scpi_t scpi_t;
+
 namespace eez {
 namespace scpi {
 
+// resets all serial and ethernet SCPI contexts
 void resetContext();
+void resetContext(scpi_t *context);
 void generateError(int error);
 
 }
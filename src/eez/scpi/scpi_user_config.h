@@ -141,6 +141,10 @@ extern "C" {
 	X(SCPI_ERROR_CANNOT_LOAD_EMPTY_PROFILE,                  400, "Cannot load empty profile")                    \
     X(SCPI_ERROR_PROFILE_MODULE_MISMATCH,                    401, "Module mismatch in profile")                   \
 	X(SCPI_ERROR_MASS_MEDIA_NO_FILESYSTEM,                   410, "No FAT file system on mass media")             \
+    X(SCPI_ERROR_INVALID_DLOG_FILE,                          411, "Invalid DLOG file")                            \
+    X(SCPI_ERROR_DLOG_FILE_IS_RECORDING,                     412, "DLOG file is being recorded")                  \
+    X(SCPI_ERROR_INVALID_WAV_FILE,                           413, "Invalid or unsupported WAV file")              \
+    X(SCPI_ERROR_WAV_FILE_TOO_LONG,                          414, "WAV file is too long")                         \
     X(SCPI_ERROR_CH1_DOWN_PROGRAMMER_SWITCHED_OFF,           500, "Down-programmer on CH1 switched off")          \
     X(SCPI_ERROR_CH2_DOWN_PROGRAMMER_SWITCHED_OFF,           501, "Down-programmer on CH2 switched off")          \
     X(SCPI_ERROR_CH3_DOWN_PROGRAMMER_SWITCHED_OFF,           502, "Down-programmer on CH3 switched off")          \
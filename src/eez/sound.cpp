@@ -19,14 +19,17 @@
 #include <math.h>
 #include <memory.h>
 #include <assert.h>
+#include <atomic>
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
 
 #include <cmath>
 #include <queue>
 #include <stdio.h>
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
 #include <SDL_audio.h>
+#endif
 
 #elif defined(EEZ_PLATFORM_STM32)
 
@@ -41,6 +44,10 @@
 #include <eez/memory.h>
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/persist_conf.h>
+#include <eez/modules/psu/sd_card.h>
+#include <eez/libs/sd_fat/sd_fat.h>
+
+#include <scpi/scpi.h>
 
 #define NOTE_B0 31.0f
 #define NOTE_C1 33.0f
@@ -142,7 +149,8 @@ enum {
 	SHUTTER_TUNE,
 	BEEP_TUNE,
 	POWER_UP_TUNE,
-	POWER_DOWN_TUNE
+	POWER_DOWN_TUNE,
+	USER_SOUND
 };
 
 float g_clickTune[] = {
@@ -1436,116 +1444,283 @@ uint8_t g_shutterSamples[16377] = {
 static const size_t g_shutterSamplesSize = sizeof(g_shutterSamples) / sizeof(uint8_t);
 #endif
 
-struct Tune {
-	float *tune;
-	uint32_t sampleRate;
-	float durationBetweenNotesFactor;
+#if !defined(__EMSCRIPTEN__)
+
+// All the sounds are mixed into the single stream of SAMPLE_RATE samples. Stream is pulled
+// by the SDL audio callback in the simulator and by the DAC DMA interrupt on STM32, where DMA
+// runs in the circular mode and the mixer fills the half of the buffer that was just played.
+// Tunes are not rendered in advance, notes are synthesized from the sine table while mixing.
+
+#define SAMPLE_RATE 48000
+
 #if defined(EEZ_PLATFORM_SIMULATOR)
-	int16_t *pSamples;
+typedef int16_t Sample;
+#define SILENCE_SAMPLE 0
 #elif defined(EEZ_PLATFORM_STM32)
-	uint8_t *pSamples;
+typedef uint8_t Sample;
+#define SILENCE_SAMPLE 0
 #endif
-	unsigned int numSamples;
-};
-
-#if !defined(__EMSCRIPTEN__)
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-#define SAMPLE_RATE 48000
+static const int NUM_BUFFER_SAMPLES = 512;
 #elif defined(EEZ_PLATFORM_STM32)
-#define SAMPLE_RATE 12000
+static const int NUM_BUFFER_SAMPLES = 256; // half of the DMA buffer
 #endif
 
-Tune g_tunes[] = {
-	{ g_clickTune, SAMPLE_RATE, 1.3f },
-	{ nullptr, 48000, 0, g_shutterSamples, g_shutterSamplesSize },
-	{ g_beepTune, SAMPLE_RATE, 1.3f },
-	{ g_powerUpTune, SAMPLE_RATE, 1.3f },
-	{ g_powerDownTune, SAMPLE_RATE, 0.75f }
+static const int MAX_VOICES = 4;
+
+static const int SINE_TABLE_SIZE_BITS = 10;
+static const int SINE_TABLE_SIZE = 1 << SINE_TABLE_SIZE_BITS;
+
+static const int MAX_TUNE_SEGMENTS = 8;
+
+struct Segment {
+    uint32_t phaseIncrement; // 0 for the silence between notes
+    uint32_t numSamples;
 };
 
-#endif
+struct Sound {
+    float *tune;
+    float durationBetweenNotesFactor;
+    const Sample *pSamples;
+    uint32_t numSamples;
 
-static int g_playNextTuneIndex = -1;
-static int g_currentTuneIndex = -1;
-static uint32_t g_currentTuneStartPlayTime;
+    Segment segments[MAX_TUNE_SEGMENTS];
+    int numSegments;
 
-////////////////////////////////////////////////////////////////////////////////
+    // Incremented by playSound from any thread, mixer starts the sound when it sees the new value.
+    // Two simultaneous requests of the same sound can be counted as one, which is the same sound anyway.
+    std::atomic<uint32_t> numRequests;
+    std::atomic<uint32_t> requestTime;
+    uint32_t numStartedRequests;
 
-#define PI 3.14159265f
+    // Incremented by stopSound, mixer stops the voice playing the sound and confirms it
+    // by setting numStoppedRequests, after that the sound samples can be changed.
+    std::atomic<uint32_t> numStopRequests;
+    std::atomic<uint32_t> numStoppedRequests;
+};
 
-#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
-static const uint32_t g_memoryForTuneSamplesSize = 256000;
-int16_t g_memoryForTuneSamples[g_memoryForTuneSamplesSize];
-SDL_AudioDeviceID g_audioDevice;
-#elif defined(EEZ_PLATFORM_STM32)
-static const uint32_t g_memoryForTuneSamplesSize = SOUND_TUNES_MEMORY_SIZE;
-uint8_t *g_memoryForTuneSamples = SOUND_TUNES_MEMORY;
-#endif
+struct Voice {
+    Sound *sound;
+    int segmentIndex;
+    uint32_t position;
+    uint32_t phase;
+};
 
-#if !defined(__EMSCRIPTEN__)
+static Sound g_sounds[] = {
+	{ g_clickTune, 1.3f },
+	{ nullptr, 0, g_shutterSamples, g_shutterSamplesSize },
+	{ g_beepTune, 1.3f },
+	{ g_powerUpTune, 1.3f },
+	{ g_powerDownTune, 0.75f },
+	{ nullptr, 0, (const Sample *)SOUND_TUNES_MEMORY, 0 }
+};
+
+static const int NUM_SOUNDS = sizeof(g_sounds) / sizeof(Sound);
 
-uint32_t g_memoryForTuneSamplesOffset;
+static int16_t g_sineTable[SINE_TABLE_SIZE + 1];
+
+static Voice g_voices[MAX_VOICES];
+
+static Statistics g_statistics;
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-unsigned int generateTuneSamples(float *tune, int sampleRate, int16_t *pMemBuffer, float durationBetweenNotesFactor) {
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+uint32_t g_audioDevice; // no audio in headless simulator
+#else
+SDL_AudioDeviceID g_audioDevice;
+#endif
 #elif defined(EEZ_PLATFORM_STM32)
-unsigned int generateTuneSamples(float *tune, int sampleRate, uint8_t *pMemBuffer, float durationBetweenNotesFactor) {
+static Sample g_dmaBuffer[2 * NUM_BUFFER_SAMPLES];
 #endif
 
-    unsigned int size = 0;
+////////////////////////////////////////////////////////////////////////////////
+
+#define PI 3.14159265f
+
+static void initSineTable() {
+    for (int i = 0; i <= SINE_TABLE_SIZE; i++) {
+        g_sineTable[i] = (int16_t)clamp(32767.5f * sinf(2 * PI * i / SINE_TABLE_SIZE), -32768.0f, 32767.0f);
+    }
+}
+
+static void initTuneSegments(Sound &sound) {
+    float *tune = sound.tune;
+    sound.numSegments = 0;
 	for (int i = 0; !isNaN(tune[i]); i += 2) {
+        // there must be room for the silence and the note
+        if (sound.numSegments > MAX_TUNE_SEGMENTS - 2) {
+            assert(false); // tune is too long
+            break;
+        }
+
         if (i > 0) {
             // add silence between notes
-			unsigned int silence = (unsigned int)roundf(durationBetweenNotesFactor * sampleRate * tune[i - 1]);
-            memset(pMemBuffer, 0, silence * sizeof(uint16_t));
-			size += silence;
-            pMemBuffer += silence;
+            Segment &silence = sound.segments[sound.numSegments++];
+            silence.phaseIncrement = 0;
+			silence.numSamples = (uint32_t)roundf(sound.durationBetweenNotesFactor * SAMPLE_RATE * tune[i - 1]);
 		}
 
-		unsigned int duration = (unsigned int)roundf(sampleRate * tune[i + 1]);
-		size += duration;
-		
-        float f = 2 * PI * tune[i] / sampleRate;
+        Segment &note = sound.segments[sound.numSegments++];
+        note.phaseIncrement = (uint32_t)(tune[i] / SAMPLE_RATE * 4294967296.0f);
+		note.numSamples = (uint32_t)roundf(SAMPLE_RATE * tune[i + 1]);
+	}
+}
+
+// returns sample in -32768 ... 32767 range or false if voice is silent
+static bool getVoiceSample(Voice &voice, int32_t &sample) {
+    Sound &sound = *voice.sound;
 
-		for (unsigned int k = 0; k < duration; k++) {
+    if (sound.pSamples) {
+        if (voice.position >= sound.numSamples) {
+            voice.sound = nullptr;
+            return false;
+        }
 #if defined(EEZ_PLATFORM_SIMULATOR)
-			*pMemBuffer++ = (int16_t)clamp(32767.5f * sinf(k * f), -32768.0f, 32767.0f);
+        sample = sound.pSamples[voice.position++];
 #elif defined(EEZ_PLATFORM_STM32)
-			*pMemBuffer++ = (uint8_t)clamp(127.5f + 127.5f * sinf(k * f), 0.0f, 255.0f);
+        sample = ((int32_t)sound.pSamples[voice.position++] - 128) << 8;
 #endif
-		}
+        return true;
+    }
 
-	}
+    while (voice.position >= sound.segments[voice.segmentIndex].numSamples) {
+        if (++voice.segmentIndex == sound.numSegments) {
+            voice.sound = nullptr;
+            return false;
+        }
+        voice.position = 0;
+        voice.phase = 0;
+    }
+
+    Segment &segment = sound.segments[voice.segmentIndex];
+    voice.position++;
+
+    if (segment.phaseIncrement == 0) {
+        return false;
+    }
+
+    // linear interpolation between the sine table entries
+    uint32_t index = voice.phase >> (32 - SINE_TABLE_SIZE_BITS);
+    int32_t fraction = (voice.phase >> (16 - SINE_TABLE_SIZE_BITS)) & 0xFFFF;
+    int32_t a = g_sineTable[index];
+    int32_t b = g_sineTable[index + 1];
+    sample = a + (((b - a) * fraction) >> 16);
 
-	// add zero to the end
-	*pMemBuffer = 0;
-	size++;
+    voice.phase += segment.phaseIncrement;
 
-	return size;
+    return true;
 }
 
-#endif
+static void startVoice(Sound &sound) {
+    Voice *voice = nullptr;
 
-////////////////////////////////////////////////////////////////////////////////
+    for (int i = 0; i < MAX_VOICES; i++) {
+        // the same sound is restarted
+        if (g_voices[i].sound == &sound) {
+            voice = &g_voices[i];
+            break;
+        }
+        if (!voice && !g_voices[i].sound) {
+            voice = &g_voices[i];
+        }
+    }
 
-#if !defined(__EMSCRIPTEN__)
-void initTune(Tune &tuneDef) {
-    if (!tuneDef.pSamples) {
-		tuneDef.pSamples = g_memoryForTuneSamples + g_memoryForTuneSamplesOffset;
-		tuneDef.numSamples = generateTuneSamples(tuneDef.tune, tuneDef.sampleRate, tuneDef.pSamples, tuneDef.durationBetweenNotesFactor);
-        g_memoryForTuneSamplesOffset += tuneDef.numSamples;
-        assert(g_memoryForTuneSamplesOffset * sizeof(uint8_t) <= g_memoryForTuneSamplesSize);
-	}
+    if (!voice) {
+        // all voices are busy, steal the one which plays the longest
+        voice = &g_voices[0];
+        for (int i = 1; i < MAX_VOICES; i++) {
+            if (g_voices[i].segmentIndex > voice->segmentIndex || (g_voices[i].segmentIndex == voice->segmentIndex && g_voices[i].position > voice->position)) {
+                voice = &g_voices[i];
+            }
+        }
+        g_statistics.numStolenVoices++;
+    }
+
+    voice->sound = &sound;
+    voice->segmentIndex = 0;
+    voice->position = 0;
+    voice->phase = 0;
 }
+
+static void mix(Sample *buffer, int numSamples) {
+    for (int i = 0; i < NUM_SOUNDS; i++) {
+        Sound &sound = g_sounds[i];
+        uint32_t numRequests = sound.numRequests.load(std::memory_order_acquire);
+        if (numRequests != sound.numStartedRequests) {
+            sound.numStartedRequests = numRequests;
+
+            startVoice(sound);
+
+            uint32_t latency = micros() - sound.requestTime.load(std::memory_order_relaxed);
+            g_statistics.numPlays++;
+            g_statistics.lastLatency = latency;
+            g_statistics.totalLatency += latency;
+            if (latency > g_statistics.maxLatency) {
+                g_statistics.maxLatency = latency;
+            }
+        }
+
+        uint32_t numStopRequests = sound.numStopRequests.load(std::memory_order_acquire);
+        if (numStopRequests != sound.numStoppedRequests.load(std::memory_order_relaxed)) {
+            for (int j = 0; j < MAX_VOICES; j++) {
+                if (g_voices[j].sound == &sound) {
+                    g_voices[j].sound = nullptr;
+                }
+            }
+            sound.numStoppedRequests.store(numStopRequests, std::memory_order_release);
+        }
+    }
+
+    for (int i = 0; i < numSamples; i++) {
+        int32_t sum = 0;
+        bool isSilence = true;
+
+        for (int j = 0; j < MAX_VOICES; j++) {
+            Voice &voice = g_voices[j];
+            int32_t sample;
+            if (voice.sound && getVoiceSample(voice, sample)) {
+                sum += sample;
+                isSilence = false;
+            }
+        }
+
+        if (isSilence) {
+            buffer[i] = SILENCE_SAMPLE;
+        } else {
+            sum = sum < -32768 ? -32768 : sum > 32767 ? 32767 : sum;
+#if defined(EEZ_PLATFORM_SIMULATOR)
+            buffer[i] = (Sample)sum;
+#elif defined(EEZ_PLATFORM_STM32)
+            buffer[i] = (Sample)((sum >> 8) + 128);
 #endif
+        }
+    }
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+static void audioCallback(void *userdata, Uint8 *stream, int len) {
+    mix((Sample *)stream, len / sizeof(Sample));
+}
+#endif
+
+#endif // !__EMSCRIPTEN__
+
+////////////////////////////////////////////////////////////////////////////////
 
 void init() {
 #if !defined(__EMSCRIPTEN__)
-	initTune(g_tunes[POWER_UP_TUNE]);
-#endif
+    uint32_t startTime = micros();
 
-#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+    initSineTable();
+
+    for (int i = 0; i < NUM_SOUNDS; i++) {
+        if (g_sounds[i].tune) {
+            initTuneSegments(g_sounds[i]);
+        }
+    }
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 	SDL_InitSubSystem(SDL_INIT_AUDIO);
 
 	SDL_AudioSpec desiredSpec;
@@ -1555,79 +1730,74 @@ void init() {
 	desiredSpec.freq = SAMPLE_RATE;
 	desiredSpec.format = AUDIO_S16SYS;
 	desiredSpec.channels = 1;
-	desiredSpec.samples = 2048;
+	desiredSpec.samples = NUM_BUFFER_SAMPLES;
+	desiredSpec.callback = audioCallback;
 
 	SDL_AudioSpec obtainedSpec;
 
 	g_audioDevice = SDL_OpenAudioDevice(NULL, 0, &desiredSpec, &obtainedSpec, 0);
 	if (g_audioDevice == 0) {
 		printf("Failed to open audio: %s\n", SDL_GetError());
-	}
-#endif
-}
-
-void startPlay(int iTune) {
-#if !defined(__EMSCRIPTEN__)
-    Tune &tuneDef = g_tunes[iTune];
-	initTune(tuneDef);
-#if defined(EEZ_PLATFORM_SIMULATOR)
-    SDL_QueueAudio(g_audioDevice, tuneDef.pSamples, tuneDef.numSamples * 2);
-    SDL_PauseAudioDevice(g_audioDevice, 0);
+	} else {
+        SDL_PauseAudioDevice(g_audioDevice, 0);
+    }
 #elif defined(EEZ_PLATFORM_STM32)
-	HAL_DAC_Stop_DMA(&hdac, DAC_CHANNEL_1);
+    mix(g_dmaBuffer, 2 * NUM_BUFFER_SAMPLES);
+
+    // mixer fills one half of the buffer while the other half is played
+    hdac.DMA_Handle1->Init.Mode = DMA_CIRCULAR;
+    HAL_DMA_Init(hdac.DMA_Handle1);
+
 	HAL_TIM_Base_Stop(&htim6);
 	HAL_TIM_Base_DeInit(&htim6);
-	htim6.Init.Period = 108000000 / tuneDef.sampleRate - 1;
+	htim6.Init.Period = 108000000 / SAMPLE_RATE - 1;
 	HAL_TIM_Base_Init(&htim6);
 	HAL_TIM_Base_Start(&htim6);
-	HAL_DAC_Start_DMA(&hdac, DAC_CHANNEL_1, (uint32_t *)tuneDef.pSamples, tuneDef.numSamples, DAC_ALIGN_8B_R);
+
+	HAL_DAC_Start_DMA(&hdac, DAC_CHANNEL_1, (uint32_t *)g_dmaBuffer, 2 * NUM_BUFFER_SAMPLES, DAC_ALIGN_8B_R);
 #endif
+
+    g_statistics.initTime = micros() - startTime;
 #endif
 }
 
-void tick() {
+static void playSound(int iSound) {
 #if !defined(__EMSCRIPTEN__)
-#if defined(EEZ_PLATFORM_SIMULATOR)
-	if (!g_audioDevice) {
-		return;
-	}
+    Sound &sound = g_sounds[iSound];
+    sound.requestTime.store(micros(), std::memory_order_relaxed);
+    sound.numRequests.fetch_add(1, std::memory_order_release);
 #endif
+}
 
-	if (g_currentTuneIndex != -1) {
-		Tune &tuneDef = g_tunes[g_currentTuneIndex];
-		uint32_t duration = tuneDef.numSamples * 1000 / tuneDef.sampleRate;
-		if (millis() - g_currentTuneStartPlayTime > duration) {
-			g_currentTuneIndex = -1;
-		}
-	}
+#if !defined(__EMSCRIPTEN__)
+static bool isMixerRunning() {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    return g_audioDevice != 0;
+#elif defined(EEZ_PLATFORM_STM32)
+    return true;
+#endif
+}
 
-	int iTune = g_playNextTuneIndex;
-	if (iTune != -1) {
-		g_currentTuneIndex = g_playNextTuneIndex;
-		g_playNextTuneIndex = -1;
+// Returns when the mixer doesn't use the sound anymore, false on timeout.
+static bool stopSound(int iSound) {
+    Sound &sound = g_sounds[iSound];
+    uint32_t numStopRequests = sound.numStopRequests.fetch_add(1, std::memory_order_release) + 1;
 
-    	startPlay(g_currentTuneIndex);
+    if (!isMixerRunning()) {
+        return true;
+    }
 
-        g_currentTuneStartPlayTime = millis();
-	}
-#endif
-}
+    // mixer is called every NUM_BUFFER_SAMPLES / SAMPLE_RATE
+    for (int i = 0; i < 100; i++) {
+        if (sound.numStoppedRequests.load(std::memory_order_acquire) == numStopRequests) {
+            return true;
+        }
+        osDelay(1);
+    }
 
-static void playTune(int iTune) {
-	if (iTune > g_playNextTuneIndex && iTune > g_currentTuneIndex) {
-		g_playNextTuneIndex = iTune;
-    	if (
-			isLowPriorityThread() ||
-			isPsuThread() ||
-			g_playNextTuneIndex == POWER_UP_TUNE ||
-			(g_playNextTuneIndex == BEEP_TUNE && !g_isBooted)
-		) {
-			tick();
-		} else {
-			sendMessageToLowPriorityThread(THREAD_MESSAGE_SOUND_TICK);
-		}
-	}
+    return false;
 }
+#endif
 
 void playPowerUp(PlayPowerUpCondition condition) {
 #if OPTION_DISPLAY
@@ -1638,7 +1808,7 @@ void playPowerUp(PlayPowerUpCondition condition) {
 	) {
 		g_playPowerUpCondition = PLAY_POWER_UP_CONDITION_NONE;
     	if (psu::persist_conf::isSoundEnabled()) {
-			playTune(POWER_UP_TUNE);
+			playSound(POWER_UP_TUNE);
     	}
 	} else {
 		g_playPowerUpCondition = condition;
@@ -1646,7 +1816,7 @@ void playPowerUp(PlayPowerUpCondition condition) {
 #else
 	if (condition == PLAY_POWER_UP_CONDITION_TEST_SUCCESSFUL) {
     	if (psu::persist_conf::isSoundEnabled()) {
-			playTune(POWER_UP_TUNE);
+			playSound(POWER_UP_TUNE);
     	}
 	}
 #endif
@@ -1654,27 +1824,231 @@ void playPowerUp(PlayPowerUpCondition condition) {
 
 void playPowerDown() {
     if (psu::persist_conf::isSoundEnabled()) {
-		playTune(POWER_DOWN_TUNE);
+		playSound(POWER_DOWN_TUNE);
     }
 }
 
 void playBeep(bool force) {
     if (force || psu::persist_conf::isSoundEnabled()) {
-		playTune(BEEP_TUNE);
+		playSound(BEEP_TUNE);
     }
 }
 
 void playClick() {
     if (psu::persist_conf::isClickSoundEnabled()) {
-		playTune(CLICK_TUNE);
+		playSound(CLICK_TUNE);
     }
 }
 
 void playShutter() {
     if (psu::persist_conf::isSoundEnabled()) {
-		playTune(SHUTTER_TUNE);
+		playSound(SHUTTER_TUNE);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma pack(push, 1)
+
+struct WavChunkHeader {
+    char id[4];
+    uint32_t size;
+};
+
+struct WavFormat {
+    uint16_t audioFormat;
+    uint16_t numChannels;
+    uint32_t sampleRate;
+    uint32_t byteRate;
+    uint16_t blockAlign;
+    uint16_t bitsPerSample;
+};
+
+#pragma pack(pop)
+
+#if !defined(__EMSCRIPTEN__)
+
+// Reads WAV header until the "data" chunk, returns SCPI error or 0.
+static int readWavHeader(File &file, WavFormat &format, uint32_t &dataSize) {
+    char riff[12];
+    if (file.read(riff, sizeof(riff)) != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        return SCPI_ERROR_INVALID_WAV_FILE;
+    }
+
+    // find "data" chunk, "fmt " chunk must be before it
+    WavChunkHeader chunkHeader;
+    bool isFormatRead = false;
+    while (true) {
+        if (file.read(&chunkHeader, sizeof(chunkHeader)) != sizeof(chunkHeader)) {
+            return SCPI_ERROR_INVALID_WAV_FILE;
+        }
+
+        if (memcmp(chunkHeader.id, "fmt ", 4) == 0) {
+            if (chunkHeader.size < sizeof(WavFormat) || file.read(&format, sizeof(WavFormat)) != sizeof(WavFormat)) {
+                return SCPI_ERROR_INVALID_WAV_FILE;
+            }
+            if (
+                format.audioFormat != 1 ||
+                format.numChannels < 1 || format.numChannels > 2 ||
+                (format.bitsPerSample != 8 && format.bitsPerSample != 16) ||
+                format.sampleRate == 0
+            ) {
+                return SCPI_ERROR_INVALID_WAV_FILE;
+            }
+            isFormatRead = true;
+            chunkHeader.size -= sizeof(WavFormat);
+        } else if (memcmp(chunkHeader.id, "data", 4) == 0) {
+            break;
+        }
+
+        // chunks are word aligned
+        if (!file.seek(file.tell() + chunkHeader.size + (chunkHeader.size & 1))) {
+            return SCPI_ERROR_INVALID_WAV_FILE;
+        }
+    }
+
+    if (!isFormatRead) {
+        return SCPI_ERROR_INVALID_WAV_FILE;
+    }
+
+    dataSize = chunkHeader.size;
+
+    return 0;
+}
+
+// Samples are converted to mono and resampled to SAMPLE_RATE by repeating or skipping the frames,
+// which is good enough for the short sounds. Returns SCPI error or 0.
+static int loadWavSamples(File &file, const WavFormat &format, uint32_t numFrames, Sample *samples, uint32_t &numSamples) {
+    uint32_t frameSize = format.numChannels * format.bitsPerSample / 8;
+
+    numSamples = 0;
+
+    uint8_t buffer[512];
+    uint32_t bufferFrames = sizeof(buffer) / frameSize;
+    for (uint32_t frameIndex = 0; frameIndex < numFrames; ) {
+        uint32_t n = MIN(bufferFrames, numFrames - frameIndex);
+        if (file.read(buffer, n * frameSize) != n * frameSize) {
+            return SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+
+        for (uint32_t i = 0; i < n; i++, frameIndex++) {
+            uint8_t *frame = buffer + i * frameSize;
+
+            int32_t value = 0;
+            for (uint32_t channel = 0; channel < format.numChannels; channel++) {
+                if (format.bitsPerSample == 8) {
+                    value += ((int32_t)frame[channel] - 128) << 8;
+                } else {
+                    value += (int16_t)(frame[2 * channel] | (frame[2 * channel + 1] << 8));
+                }
+            }
+            value /= (int32_t)format.numChannels;
+
+            uint64_t frameEnd = (uint64_t)(frameIndex + 1) * SAMPLE_RATE;
+            while ((uint64_t)numSamples * format.sampleRate < frameEnd) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+                samples[numSamples++] = (Sample)value;
+#elif defined(EEZ_PLATFORM_STM32)
+                samples[numSamples++] = (Sample)((value >> 8) + 128);
+#endif
+            }
+        }
     }
+
+    return 0;
+}
+
+#endif
+
+bool playWav(const char *filePath, int *err) {
+#if !defined(__EMSCRIPTEN__)
+    if (!psu::sd_card::isMounted(err)) {
+        return false;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (err) {
+            *err = SCPI_ERROR_FILE_NAME_NOT_FOUND;
+        }
+        return false;
+    }
+
+    WavFormat format;
+    uint32_t dataSize;
+    int result = readWavHeader(file, format, dataSize);
+
+    uint32_t numFrames = 0;
+    if (!result) {
+        numFrames = dataSize / (format.numChannels * format.bitsPerSample / 8);
+        // number of samples after resampling, see loadWavSamples
+        uint64_t numSamples = ((uint64_t)numFrames * SAMPLE_RATE + format.sampleRate - 1) / format.sampleRate;
+        if (numSamples > SOUND_TUNES_MEMORY_SIZE / sizeof(Sample)) {
+            result = SCPI_ERROR_WAV_FILE_TOO_LONG;
+        }
+    }
+
+    if (!result) {
+        // samples are overwritten, so the user sound must be stopped first
+        if (!stopSound(USER_SOUND)) {
+            result = SCPI_ERROR_HARDWARE_ERROR;
+        }
+    }
+
+    if (!result) {
+        Sound &sound = g_sounds[USER_SOUND];
+        uint32_t numSamples;
+        result = loadWavSamples(file, format, numFrames, (Sample *)SOUND_TUNES_MEMORY, numSamples);
+        // sound is not played if loading failed, but numSamples is still valid
+        sound.numSamples = numSamples;
+    }
+
+    file.close();
+
+    if (result) {
+        if (err) {
+            *err = result;
+        }
+        return false;
+    }
+
+    playSound(USER_SOUND);
+
+    return true;
+#else
+    if (err) {
+        *err = SCPI_ERROR_HARDWARE_MISSING;
+    }
+    return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void getStatistics(Statistics &statistics) {
+    memcpy(&statistics, &g_statistics, sizeof(Statistics));
+}
+
+void resetStatistics() {
+    uint32_t initTime = g_statistics.initTime;
+    memset(&g_statistics, 0, sizeof(Statistics));
+    g_statistics.initTime = initTime;
 }
 
 } // namespace sound
 } // namespace eez
+
+#if defined(EEZ_PLATFORM_STM32)
+
+void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
+    using namespace eez::sound;
+    // first half is played, DMA continues with the second half
+    mix(g_dmaBuffer, NUM_BUFFER_SAMPLES);
+}
+
+void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
+    using namespace eez::sound;
+    mix(g_dmaBuffer + NUM_BUFFER_SAMPLES, NUM_BUFFER_SAMPLES);
+}
+
+#endif
@@ -24,7 +24,6 @@ namespace eez {
 namespace sound {
 
 void init();
-void tick();
 
 /// Play power up tune.
 enum PlayPowerUpCondition {
@@ -47,5 +46,22 @@ void playClick();
 /// Play shutter sound
 void playShutter();
 
+/// Play PCM WAV file, 8 or 16 bits, mono or stereo.
+/// Sound is played together with the other sounds.
+bool playWav(const char *filePath, int *err);
+
+struct Statistics {
+    uint32_t initTime; // us
+    uint32_t numPlays;
+    uint32_t numStolenVoices;
+    // time from the play request to the first mixed sample, us
+    uint32_t lastLatency;
+    uint32_t maxLatency;
+    uint32_t totalLatency;
+};
+
+void getStatistics(Statistics &statistics);
+void resetStatistics();
+
 } // namespace sound
 } // namespace eez
@@ -23,6 +23,7 @@
 #include <eez/sound.h>
 #include <eez/hmi.h>
 #include <eez/usb.h>
+#include <eez/profiler.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/datetime.h>
@@ -43,13 +44,19 @@
 #include <eez/modules/psu/gui/page_ch_settings.h>
 #include <eez/modules/psu/gui/page_user_profiles.h>
 
+#include <eez/modules/bp3c/comm.h>
 #include <eez/modules/bp3c/flash_slave.h>
 
 #include <eez/modules/mcu/battery.h>
+#include <eez/modules/mcu/eeprom.h>
 
 #include <eez/libs/sd_fat/sd_fat.h>
 #include <eez/libs/image/jpeg.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+#include <eez/platform/simulator/headless.h>
+#endif
+
 namespace eez {
 
 #define CONF_SCREENSHOT_TIMEOUT_MS 2000
@@ -112,6 +119,7 @@ static bool g_shutingDown;
 static bool g_isLowPriorityThreadAlive;
 
 char g_listFilePath[CH_MAX][MAX_PATH_LENGTH];
+char g_exportLogFilePath[MAX_PATH_LENGTH + 1];
 bool g_screenshotGenerating;
 
 static uint32_t g_timer1LastTickCount;
@@ -142,6 +150,10 @@ void highPriorityThreadMainLoop(const void *) {
 
 void highPriorityThreadOneIter() {
     osEvent event = osMessageGet(g_highPriorityMessageQueueId, 1);
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    platform::simulator::headless::ThreadIterationScope iterationScope(platform::simulator::headless::THREAD_PSU, osMessageWaiting(g_highPriorityMessageQueueId));
+#endif
+    PROFILER_ZONE(PSU_ITER);
     if (event.status == osEventMessage) {
     	uint32_t message = event.value.v;
     	uint8_t type = QUEUE_MESSAGE_TYPE(message);
@@ -149,11 +161,16 @@ void highPriorityThreadOneIter() {
         psu::onThreadMessage(type, param);
     } else {
         WATCHDOG_RESET();
+
+        bp3c::comm::tick();
+
         for (int i = 0; i < NUM_SLOTS; i++) {
             g_slots[i]->tick();
         }
 
         psu::tick();
+
+        bp3c::comm::tick();
     }
 }
 
@@ -201,6 +218,10 @@ void lowPriorityThreadOneIter() {
     using namespace psu;
 
     osEvent event = osMessageGet(g_lowPriorityMessageQueueId, 25);
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    platform::simulator::headless::ThreadIterationScope iterationScope(platform::simulator::headless::THREAD_LOW_PRIORITY, osMessageWaiting(g_lowPriorityMessageQueueId));
+#endif
+    PROFILER_ZONE(LOW_PRIORITY_ITER);
     if (event.status == osEventMessage) {
     	uint32_t message = event.value.v;
 
@@ -223,6 +244,13 @@ void lowPriorityThreadOneIter() {
                 if (!list::saveList(param, &g_listFilePath[param][0], &err)) {
                     generateError(err);
                 }
+            } else if (type == THREAD_MESSAGE_EVENT_QUEUE_EXPORT_LOG) {
+                int err;
+                if (!event_queue::exportLog(g_exportLogFilePath, &err)) {
+                    generateError(err);
+                }
+            } else if (type == THREAD_MESSAGE_LIST_STREAM_FILL) {
+                list::fillListStream(param);
             } else if (type == THREAD_MESSAGE_SHUTDOWN) {
                 g_shutingDown = true;
             }
@@ -249,11 +277,13 @@ void lowPriorityThreadOneIter() {
                 sound::playShutter();
 
                 const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
+                int width = mcu::display::getDisplayWidth();
+                int height = mcu::display::getDisplayHeight();
 
                 unsigned char* imageData;
                 size_t imageDataSize;
 
-                if (jpegEncode(screenshotPixels, &imageData, &imageDataSize)) {
+                if (jpegEncode(screenshotPixels, width, height, 3 * width, JpegEncodeParams(), &imageData, &imageDataSize)) {
                     event_queue::pushEvent(SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
                     g_screenshotGenerating = false;
                     return;
@@ -347,8 +377,6 @@ void lowPriorityThreadOneIter() {
                 psu::gui::UserProfilesPage::doDeleteProfile();
             } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_EDIT_REMARK) {
                 psu::gui::UserProfilesPage::doEditRemark();
-            } else if (type == THREAD_MESSAGE_SOUND_TICK) {
-                sound::tick();
             } else if (type == THREAD_MESSAGE_SELECT_USB_MODE) {
                 usb::selectUsbMode(param, usb::g_otgMode);
             } else if (type == THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS) {
@@ -365,8 +393,6 @@ void lowPriorityThreadOneIter() {
 
         event_queue::tick();
 
-        sound::tick();
-
     	if (diff >= 1000000L) { // 1 sec
             g_timer1LastTickCount = tickCount;
 
@@ -384,6 +410,10 @@ void lowPriorityThreadOneIter() {
 
         persist_conf::tick();
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+        mcu::eeprom::tick();
+#endif
+
         sd_card::tick();
 
         eez::psu::dlog_record::fileWrite();
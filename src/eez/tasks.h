@@ -47,7 +47,8 @@ enum HighPriorityThreadMessage {
     PSU_MESSAGE_CALIBRATION_START,
     PSU_MESSAGE_CALIBRATION_STOP,
     PSU_MESSAGE_FLASH_SLAVE_START,
-    PSU_MESSAGE_FLASH_SLAVE_LEAVE_BOOTLOADER_MODE
+    PSU_MESSAGE_FLASH_SLAVE_LEAVE_BOOTLOADER_MODE,
+    PSU_MESSAGE_BP3C_COMM_BENCHMARK
 };
 
 enum LowPriorityThreadMessage {
@@ -65,10 +66,12 @@ enum LowPriorityThreadMessage {
 
     MP_LOAD_SCRIPT,
     MP_EXECUTE_SCPI,
+    MP_SAVE_SCRIPT_CACHE,
 
     MP_LAST_MESSAGE_TYPE,
 
     THREAD_MESSAGE_SAVE_LIST,
+    THREAD_MESSAGE_LIST_STREAM_FILL,
     THREAD_MESSAGE_SD_DETECT_IRQ,
     THREAD_MESSAGE_DLOG_STATE_TRANSITION,
     THREAD_MESSAGE_DLOG_SHOW_FILE,
@@ -94,7 +97,7 @@ enum LowPriorityThreadMessage {
     THREAD_MESSAGE_USER_PROFILES_PAGE_DELETE,
     THREAD_MESSAGE_USER_PROFILES_PAGE_EDIT_REMARK,
     THREAD_MESSAGE_EVENT_QUEUE_REFRESH,
-    THREAD_MESSAGE_SOUND_TICK,
+    THREAD_MESSAGE_EVENT_QUEUE_EXPORT_LOG,
     THREAD_MESSAGE_SELECT_USB_MODE,
     THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS
 };
@@ -26,6 +26,7 @@
 #include <eez/usb.h>
 
 #include <eez/gui/gui.h>
+#include <eez/gui/input.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/persist_conf.h>
@@ -267,20 +268,15 @@ extern "C" void USBH_HID_EventCallback(USBH_HandleTypeDef *phost) {
         using namespace eez::gui;
 
         if (g_keyboardInfo.keys[0] == 0 && info->keys[0] != 0) {
-            sendMessageToGuiThread(GUI_QUEUE_MESSAGE_KEY_DOWN, 
-                (
-                    (
-                        (info->lctrl << 7) |
-                        (info->lshift << 6) |
-                        (info->lalt << 5) |
-                        (info->lgui << 4) |
-                        (info->rctrl << 3) |
-                        (info->rshift << 2) |
-                        (info->ralt << 1) |
-                        (info->rgui << 0)
-                    ) << 8
-                ) | 
-                info->keys[0]
+            input::push(input::SOURCE_KEYBOARD, 0, info->keys[0],
+                (info->lctrl << 7) |
+                (info->lshift << 6) |
+                (info->lalt << 5) |
+                (info->lgui << 4) |
+                (info->rctrl << 3) |
+                (info->rshift << 2) |
+                (info->ralt << 1) |
+                (info->rgui << 0)
             );
         }
 
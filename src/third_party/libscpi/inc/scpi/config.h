@@ -114,6 +114,17 @@ extern "C" {
 #define USE_DEPRECATED_FUNCTIONS 1
 #endif
 
+/* Command index (trie of command mnemonics) used to speed up command header lookup */
+#ifndef USE_COMMAND_INDEX
+#define USE_COMMAND_INDEX 1
+#endif
+
+/* Check every indexed lookup against the linear search, mismatch is
+ * pushed to the error queue as System error */
+#ifndef USE_COMMAND_INDEX_VERIFY
+#define USE_COMMAND_INDEX_VERIFY 0
+#endif
+
 #ifndef USE_CUSTOM_DTOSTRE
 #define USE_CUSTOM_DTOSTRE 0
 #endif
@@ -55,7 +55,20 @@ extern "C" {
     void SCPI_InitHeap(scpi_t * context, char * error_info_heap, size_t error_info_heap_length);
 #endif
 
+#if USE_COMMAND_INDEX
+    scpi_bool_t SCPI_CommandIndexBuild(scpi_command_index_t * index, const scpi_command_t * commands,
+            scpi_command_index_node_t * nodes, uint16_t max_nodes,
+            scpi_command_index_candidate_t * candidates, uint16_t max_candidates);
+    void SCPI_SetCommandIndex(scpi_t * context, const scpi_command_index_t * index);
+    scpi_bool_t SCPI_CommandIndexFind(const scpi_command_index_t * index, const char * header, size_t len, const scpi_command_t ** cmd);
+#if USE_COMMAND_INDEX_VERIFY
+    uint32_t SCPI_CommandIndexGetNumMismatches(void);
+#endif
+#endif
+    const scpi_command_t * SCPI_CommandListFind(const scpi_command_t * commands, const char * header, size_t len);
+
     scpi_bool_t SCPI_Input(scpi_t * context, const char * data, int len);
+    scpi_bool_t SCPI_InputInPlace(scpi_t * context, char * data, int len);
     scpi_bool_t SCPI_Parse(scpi_t * context, char * data, int len);
 
     size_t SCPI_ResultCharacters(scpi_t * context, const char * data, size_t len);
@@ -356,6 +356,41 @@ extern "C" {
 #endif /* USE_COMMAND_TAGS */
     };
 
+#if USE_COMMAND_INDEX
+#define SCPI_COMMAND_INDEX_NONE 0xFFFF
+
+    struct _scpi_command_index_node_t {
+        const char * keyword; /* points into the command pattern */
+        uint8_t long_len; /* without numeric suffix */
+        uint8_t short_len; /* without numeric suffix */
+        uint16_t first_child;
+        uint16_t next_sibling;
+        uint16_t first_candidate;
+    };
+    typedef struct _scpi_command_index_node_t scpi_command_index_node_t;
+
+    struct _scpi_command_index_candidate_t {
+        uint16_t command;
+        uint16_t next;
+    };
+    typedef struct _scpi_command_index_candidate_t scpi_command_index_candidate_t;
+
+    /* Trie of command mnemonics, every pattern is added for each combination
+     * of its optional nodes. Node 0 is the root. Node and candidate
+     * storage is provided by the caller of SCPI_CommandIndexBuild. */
+    struct _scpi_command_index_t {
+        const scpi_command_t * cmdlist;
+        scpi_bool_t valid;
+        scpi_command_index_node_t * nodes;
+        uint16_t max_nodes;
+        uint16_t num_nodes;
+        scpi_command_index_candidate_t * candidates;
+        uint16_t max_candidates;
+        uint16_t num_candidates;
+    };
+    typedef struct _scpi_command_index_t scpi_command_index_t;
+#endif /* USE_COMMAND_INDEX */
+
     struct _scpi_interface_t {
         scpi_error_callback_t error;
         scpi_write_t write;
@@ -382,6 +417,9 @@ extern "C" {
         scpi_parser_state_t parser_state;
         const char * idn[4];
         size_t arbitrary_reminding;
+#if USE_COMMAND_INDEX
+        const scpi_command_index_t * cmd_index;
+#endif
     };
 
     enum _scpi_array_format_t {
@@ -160,20 +160,384 @@ static scpi_bool_t processCommand(scpi_t * context) {
 }
 
 /**
- * Cycle all patterns and search matching pattern. Execute command callback.
+ * Cycle all patterns and search the first matching pattern
+ * @param commands - command list
+ * @param header - command header
+ * @param len - command header length
+ * @return matching command or NULL
+ */
+const scpi_command_t * SCPI_CommandListFind(const scpi_command_t * commands, const char * header, size_t len) {
+    int32_t i;
+
+    for (i = 0; commands[i].pattern != NULL; i++) {
+        if (matchCommand(commands[i].pattern, header, len, NULL, 0, 0)) {
+            return &commands[i];
+        }
+    }
+    return NULL;
+}
+
+#if USE_COMMAND_INDEX
+
+#define MAX_OPTIONAL_NODES 8
+
+/**
+ * Length of the pattern keyword used as a trie key: numeric suffix
+ * (both "#" and digits) is not part of the key.
+ * @param keyword
+ * @param len
+ * @return key length
+ */
+static size_t keyLength(const char * keyword, size_t len) {
+    if (len > 0 && keyword[len - 1] == '#') {
+        len--;
+    }
+    while (len > 0 && isdigit((unsigned char) keyword[len - 1])) {
+        len--;
+    }
+    return len;
+}
+
+/**
+ * Find child node of the parent which matches given key
+ * @param index
+ * @param parent
+ * @param key
+ * @param len
+ * @return node index or SCPI_COMMAND_INDEX_NONE
+ */
+static uint16_t findChild(const scpi_command_index_t * index, uint16_t parent, const char * key, size_t len) {
+    uint16_t i;
+    for (i = index->nodes[parent].first_child; i != SCPI_COMMAND_INDEX_NONE; i = index->nodes[i].next_sibling) {
+        const scpi_command_index_node_t * node = &index->nodes[i];
+        if ((len == node->long_len || len == node->short_len) && SCPIDEFINE_strncasecmp(node->keyword, key, len) == 0) {
+            return i;
+        }
+    }
+    return SCPI_COMMAND_INDEX_NONE;
+}
+
+/**
+ * Find or add child node for the pattern keyword
+ * @param index
+ * @param parent
+ * @param keyword
+ * @param len - keyword length including numeric suffix
+ * @return node index or SCPI_COMMAND_INDEX_NONE if index is full
+ */
+static uint16_t addChild(scpi_command_index_t * index, uint16_t parent, const char * keyword, size_t len) {
+    size_t long_len = keyLength(keyword, len);
+    size_t short_len;
+    uint16_t i;
+    scpi_command_index_node_t * node;
+
+    for (short_len = 0; short_len < long_len && !islower((unsigned char) keyword[short_len]); short_len++);
+    short_len = keyLength(keyword, short_len);
+
+    for (i = index->nodes[parent].first_child; i != SCPI_COMMAND_INDEX_NONE; i = index->nodes[i].next_sibling) {
+        node = &index->nodes[i];
+        if (node->long_len == long_len && node->short_len == short_len && SCPIDEFINE_strncasecmp(node->keyword, keyword, long_len) == 0) {
+            return i;
+        }
+    }
+
+    if (index->num_nodes >= index->max_nodes || long_len > 255) {
+        return SCPI_COMMAND_INDEX_NONE;
+    }
+
+    i = index->num_nodes++;
+    node = &index->nodes[i];
+    node->keyword = keyword;
+    node->long_len = (uint8_t) long_len;
+    node->short_len = (uint8_t) short_len;
+    node->first_child = SCPI_COMMAND_INDEX_NONE;
+    node->next_sibling = index->nodes[parent].first_child;
+    node->first_candidate = SCPI_COMMAND_INDEX_NONE;
+    index->nodes[parent].first_child = i;
+
+    return i;
+}
+
+/**
+ * Add command to the end of the node candidate list (list is ordered as the command list)
+ * @param index
+ * @param node
+ * @param command - command index
+ * @return FALSE if index is full
+ */
+static scpi_bool_t addCandidate(scpi_command_index_t * index, uint16_t node, uint16_t command) {
+    uint16_t * next = &index->nodes[node].first_candidate;
+    uint16_t last = SCPI_COMMAND_INDEX_NONE;
+    uint16_t i;
+
+    /* lists are short, walk to the end instead of keeping the last candidate in every node */
+    while (*next != SCPI_COMMAND_INDEX_NONE) {
+        last = *next;
+        next = &index->candidates[last].next;
+    }
+
+    if (last != SCPI_COMMAND_INDEX_NONE && index->candidates[last].command == command) {
+        /* already added by the other combination of optional nodes */
+        return TRUE;
+    }
+
+    if (index->num_candidates >= index->max_candidates) {
+        return FALSE;
+    }
+
+    i = index->num_candidates++;
+    index->candidates[i].command = command;
+    index->candidates[i].next = SCPI_COMMAND_INDEX_NONE;
+    *next = i;
+
+    return TRUE;
+}
+
+/**
+ * Add pattern to the index, once for each combination of optional nodes
+ * @param index
+ * @param pattern - eg. [:MEASure]:VOLTage:DC?
+ * @param command - command index
+ * @return FALSE if pattern can't be indexed
+ */
+static scpi_bool_t addPattern(scpi_command_index_t * index, const char * pattern, uint16_t command) {
+    int num_optional = 0;
+    uint32_t combination;
+    const char * p;
+
+    for (p = pattern; *p; p++) {
+        if (*p == '[') {
+            num_optional++;
+        }
+    }
+
+    if (num_optional > MAX_OPTIONAL_NODES) {
+        return FALSE;
+    }
+
+    for (combination = 0; combination < (1UL << num_optional); combination++) {
+        uint16_t node = 0;
+        int optional = 0;
+        int depth = 0;
+        int skip_depth = 0; /* > 0 while inside of not selected optional node */
+
+        for (p = pattern; *p && *p != '?';) {
+            if (*p == '[') {
+                depth++;
+                if (!skip_depth && !(combination & (1UL << optional))) {
+                    skip_depth = depth;
+                }
+                optional++;
+                p++;
+            } else if (*p == ']') {
+                if (depth == skip_depth) {
+                    skip_depth = 0;
+                }
+                depth--;
+                p++;
+            } else if (*p == ':') {
+                p++;
+            } else {
+                const char * keyword = p;
+                while (*p && !strchr("[]:?", *p)) {
+                    p++;
+                }
+                if (!skip_depth) {
+                    node = addChild(index, node, keyword, p - keyword);
+                    if (node == SCPI_COMMAND_INDEX_NONE) {
+                        return FALSE;
+                    }
+                }
+            }
+        }
+
+        if (depth != 0 || node == 0) {
+            return FALSE;
+        }
+
+        if (!addCandidate(index, node, command)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Build command index for the command list. If it fails (command list is
+ * too big or it contains pattern which is not supported), linear search is used.
+ * @param index
+ * @param commands
+ * @param nodes - node storage, at least one node for the root
+ * @param max_nodes
+ * @param candidates - candidate storage
+ * @param max_candidates
+ * @return TRUE if index is built
+ */
+scpi_bool_t SCPI_CommandIndexBuild(scpi_command_index_t * index, const scpi_command_t * commands,
+        scpi_command_index_node_t * nodes, uint16_t max_nodes,
+        scpi_command_index_candidate_t * candidates, uint16_t max_candidates) {
+    int32_t i;
+
+    index->cmdlist = commands;
+    index->valid = FALSE;
+    index->nodes = nodes;
+    index->max_nodes = max_nodes;
+    index->num_nodes = 1;
+    index->candidates = candidates;
+    index->max_candidates = max_candidates;
+    index->num_candidates = 0;
+
+    if (max_nodes < 1) {
+        return FALSE;
+    }
+
+    index->nodes[0].keyword = "";
+    index->nodes[0].long_len = 0;
+    index->nodes[0].short_len = 0;
+    index->nodes[0].first_child = SCPI_COMMAND_INDEX_NONE;
+    index->nodes[0].next_sibling = SCPI_COMMAND_INDEX_NONE;
+    index->nodes[0].first_candidate = SCPI_COMMAND_INDEX_NONE;
+
+    for (i = 0; commands[i].pattern != NULL; i++) {
+        if (i >= SCPI_COMMAND_INDEX_NONE || !addPattern(index, commands[i].pattern, (uint16_t) i)) {
+            return FALSE;
+        }
+    }
+
+    index->valid = TRUE;
+    return TRUE;
+}
+
+/**
+ * Use command index for the command header lookup in this context
  * @param context
+ * @param index - built with the same command list as the context
+ */
+void SCPI_SetCommandIndex(scpi_t * context, const scpi_command_index_t * index) {
+    context->cmd_index = index;
+}
+
+/**
+ * Search matching pattern using command index. Candidates found in the index
+ * are checked with the same matcher as the linear search, in the command list order,
+ * so the result is always the same as with SCPI_CommandListFind.
+ * @param index
+ * @param header - command header
+ * @param len - command header length
+ * @param cmd - matching command or NULL
+ * @return FALSE if index can't be used for this header
+ */
+scpi_bool_t SCPI_CommandIndexFind(const scpi_command_index_t * index, const char * header, size_t len, const scpi_command_t ** cmd) {
+    uint16_t node = 0;
+    uint16_t i;
+    const char * p;
+    const char * end;
+
+    if (!index->valid) {
+        return FALSE;
+    }
+
+    *cmd = NULL;
+
+    len = SCPIDEFINE_strnlen(header, len);
+    end = header + len;
+    if (header < end && end[-1] == '?') {
+        end--;
+    }
+
+    p = header;
+    if (p < end && *p == ':') {
+        p++;
+    }
+
+    while (1) {
+        const char * keyword = p;
+        size_t key_len;
+
+        while (p < end && *p != ':') {
+            if (*p == '?') {
+                return FALSE;
+            }
+            p++;
+        }
+
+        key_len = keyLength(keyword, p - keyword);
+        if (key_len == 0 || (size_t)(p - keyword) == 0) {
+            return FALSE;
+        }
+
+        node = findChild(index, node, keyword, key_len);
+        if (node == SCPI_COMMAND_INDEX_NONE) {
+            /* no pattern can match */
+            return TRUE;
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        p++; /* skip ':' */
+    }
+
+    for (i = index->nodes[node].first_candidate; i != SCPI_COMMAND_INDEX_NONE; i = index->candidates[i].next) {
+        const scpi_command_t * candidate = &index->cmdlist[index->candidates[i].command];
+        if (matchCommand(candidate->pattern, header, len, NULL, 0, 0)) {
+            *cmd = candidate;
+            break;
+        }
+    }
+
+    return TRUE;
+}
+
+#endif /* USE_COMMAND_INDEX */
+
+#if USE_COMMAND_INDEX && USE_COMMAND_INDEX_VERIFY
+static uint32_t commandIndexNumMismatches = 0;
+
+/**
+ * Number of lookups where the command index didn't agree with the linear search
+ * @return number of mismatches since the start
+ */
+uint32_t SCPI_CommandIndexGetNumMismatches(void) {
+    return commandIndexNumMismatches;
+}
+#endif
+
+/**
+ * Search matching pattern, using command index if available
+ * @param context
+ * @param header
+ * @param len
  * @result TRUE if context->paramlist is filled with correct values
  */
 static scpi_bool_t findCommandHeader(scpi_t * context, const char * header, int len) {
-    int32_t i;
     const scpi_command_t * cmd;
 
-    for (i = 0; context->cmdlist[i].pattern != NULL; i++) {
-        cmd = &context->cmdlist[i];
-        if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
-            context->param_list.cmd = cmd;
-            return TRUE;
+#if USE_COMMAND_INDEX
+    if (context->cmd_index && context->cmd_index->cmdlist == context->cmdlist &&
+            SCPI_CommandIndexFind(context->cmd_index, header, len, &cmd)) {
+#if USE_COMMAND_INDEX_VERIFY
+        /* linear search is the reference, mismatch is counted and reported
+         * as System error with the header, then the reference is used */
+        const scpi_command_t * reference = SCPI_CommandListFind(context->cmdlist, header, len);
+        if (cmd != reference) {
+            commandIndexNumMismatches++;
+            SCPI_ErrorPushEx(context, SCPI_ERROR_SYSTEM_ERROR, (char *) header, len);
+            cmd = reference;
         }
+#endif
+    } else {
+        cmd = SCPI_CommandListFind(context->cmdlist, header, len);
+    }
+#else
+    cmd = SCPI_CommandListFind(context->cmdlist, header, len);
+#endif
+
+    if (cmd) {
+        context->param_list.cmd = cmd;
+        return TRUE;
     }
     return FALSE;
 }
@@ -350,6 +714,49 @@ scpi_bool_t SCPI_Input(scpi_t * context, const char * data, int len) {
     return result;
 }
 
+/**
+ * Same as SCPI_Input, but complete messages are parsed directly from the
+ * given data, without copying them to the system buffer. Data is modified
+ * by the parser. Only incomplete message at the end of data is copied.
+ *
+ * @param context
+ * @param data - data to process
+ * @param len - length of data
+ * @return
+ */
+scpi_bool_t SCPI_InputInPlace(scpi_t * context, char * data, int len) {
+    scpi_bool_t result = TRUE;
+    int totcmdlen = 0;
+    int cmdlen = 0;
+
+    if (len == 0 || context->buffer.position > 0) {
+        /* previous incomplete message must be completed in the system buffer */
+        return SCPI_Input(context, data, len);
+    }
+
+    while (1) {
+        cmdlen = scpiParser_detectProgramMessageUnit(&context->parser_state, data + totcmdlen, len - totcmdlen);
+        totcmdlen += cmdlen;
+
+        if (context->parser_state.termination == SCPI_MESSAGE_TERMINATION_NL) {
+            result = SCPI_Parse(context, data, totcmdlen);
+            data += totcmdlen;
+            len -= totcmdlen;
+            totcmdlen = 0;
+        } else {
+            if (context->parser_state.programHeader.type == SCPI_TOKEN_UNKNOWN
+                    && context->parser_state.termination == SCPI_MESSAGE_TERMINATION_NONE) break;
+            if (totcmdlen >= len) break;
+        }
+    }
+
+    if (len > 0 && !SCPI_Input(context, data, len)) {
+        result = FALSE;
+    }
+
+    return result;
+}
+
 /* writing results */
 
 /**
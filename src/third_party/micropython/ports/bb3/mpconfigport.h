@@ -17,6 +17,9 @@
 #define MICROPY_HELPER_REPL         (0)
 #define MICROPY_HELPER_LEXER_UNIX   (0)
 #define MICROPY_ENABLE_SOURCE_LINE  (1)
+#define MICROPY_PERSISTENT_CODE_LOAD (1) // load compiled script from the cache (.mpy file)
+#define MICROPY_PERSISTENT_CODE_SAVE (1) // save compiled script to the cache
+#define MICROPY_PERSISTENT_CODE_SAVE_FILE (0) // cache is saved with mp_raw_code_save, POSIX file saver is not available
 #define MICROPY_ENABLE_DOC_STRING   (0)
 #define MICROPY_ERROR_REPORTING     (MICROPY_ERROR_REPORTING_TERSE)
 #define MICROPY_BUILTIN_METHOD_CHECK_SELF_ARG (0)
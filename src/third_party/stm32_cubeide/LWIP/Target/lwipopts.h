@@ -129,6 +129,8 @@ void sntpSetSystemTimeUs(uint32_t t, uint32_t us);
 #define CHECKSUM_CHECK_ICMP6 0
 /*-----------------------------------------------------------------------------*/
 /* USER CODE BEGIN 1 */
+/* MQTT telemetry publishes the state of all channels in one message */
+#define MQTT_OUTPUT_RINGBUF_SIZE 1024
 
 /* USER CODE END 1 */
 
@@ -0,0 +1,276 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Converts the main assets array in document_simulator.cpp / document_stm32.cpp,
+as generated by EEZ Studio (single LZ4 block), to the sectioned format
+described in src/eez/gui/assets.cpp. Tables are stored as one LZ4 block and
+every font and bitmap as a separate LZ4 block. LZ4 HC from liblz4 is used
+if ASSETS_CONVERTER_LZ4HC is defined, otherwise the default LZ4 compressor
+from src/eez/libs/lz4 (it doesn't include the HC compressor), which gives
+a somewhat bigger output.
+
+It is built and run by the simulator CMake build (convert-assets target), so
+the documents regenerated by EEZ Studio are converted before they are compiled.
+Commit the converted documents, STM32 firmware is not built with CMake.
+
+Manual build and usage:
+    g++ -O2 -DASSETS_CONVERTER_LZ4HC -o assets-converter tools/assets-converter.cpp -llz4
+    assets-converter src/eez/gui/document_simulator.cpp
+    assets-converter src/eez/gui/document_stm32.cpp
+
+Input file is rewritten in place. Already converted file is left unchanged.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#if defined(ASSETS_CONVERTER_LZ4HC)
+#include <lz4.h>
+#include <lz4hc.h>
+#else
+#include <eez/libs/lz4/lz4.h>
+#endif
+
+static const uint32_t SECTIONED_ASSETS_MAGIC = 0x43455341;
+static const uint32_t SECTIONED_ASSETS_VERSION = 1;
+
+// offsets in the header of the single block format, see assets.h
+static const int FONTS_OFFSET_INDEX = 2;
+static const int BITMAPS_OFFSET_INDEX = 3;
+static const int STYLES_OFFSET_INDEX = 4;
+
+static const char *ASSETS_DEFINITION = "// ASSETS DEFINITION";
+
+static void fail(const char *message) {
+    fprintf(stderr, "assets-converter: %s\n", message);
+    exit(1);
+}
+
+static uint32_t getU32(const std::vector<uint8_t> &data, size_t offset) {
+    uint32_t value;
+    memcpy(&value, data.data() + offset, 4);
+    return value;
+}
+
+static void setU32(std::vector<uint8_t> &data, size_t offset, uint32_t value) {
+    memcpy(data.data() + offset, &value, 4);
+}
+
+static void putU32(std::vector<uint8_t> &out, uint32_t value) {
+    out.resize(out.size() + 4);
+    setU32(out, out.size() - 4, value);
+}
+
+static void align4(std::vector<uint8_t> &out) {
+    while (out.size() % 4) {
+        out.push_back(0);
+    }
+}
+
+static uint32_t compressBlock(std::vector<uint8_t> &out, const uint8_t *src, uint32_t size) {
+    size_t offset = out.size();
+    out.resize(offset + LZ4_compressBound(size));
+#if defined(ASSETS_CONVERTER_LZ4HC)
+    int result = LZ4_compress_HC((const char *)src, (char *)out.data() + offset, size, LZ4_compressBound(size), LZ4HC_CLEVEL_MAX);
+#else
+    int result = LZ4_compress_default((const char *)src, (char *)out.data() + offset, size, LZ4_compressBound(size));
+#endif
+    if (result <= 0) {
+        fail("compression failed");
+    }
+    out.resize(offset + result);
+    return result;
+}
+
+// Section table in the single block format is a list of U32 offsets of the items,
+// relative to the section start, so the number of items is the first offset / 4.
+static void writeSection(std::vector<uint8_t> &out, const uint8_t *section, uint32_t sectionSize) {
+    uint32_t count;
+    memcpy(&count, section, 4);
+    count /= 4;
+
+    size_t sectionStart = out.size();
+    putU32(out, count);
+    size_t itemsStart = out.size();
+    out.resize(out.size() + count * 12);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t begin;
+        uint32_t end;
+        memcpy(&begin, section + i * 4, 4);
+        if (i + 1 < count) {
+            memcpy(&end, section + (i + 1) * 4, 4);
+        } else {
+            end = sectionSize;
+        }
+        if (begin > end || end > sectionSize) {
+            fail("invalid section table");
+        }
+
+        align4(out);
+        uint32_t offset = (uint32_t)(out.size() - sectionStart);
+        uint32_t compressedSize = compressBlock(out, section + begin, end - begin);
+
+        setU32(out, itemsStart + i * 12, offset);
+        setU32(out, itemsStart + i * 12 + 4, compressedSize);
+        setU32(out, itemsStart + i * 12 + 8, end - begin);
+    }
+
+    align4(out);
+}
+
+static std::vector<uint8_t> convert(const std::vector<uint8_t> &assets) {
+    if (assets.size() < 4) {
+        fail("assets too small");
+    }
+
+    uint32_t decompressedSize = getU32(assets, 0);
+    std::vector<uint8_t> decompressed(decompressedSize);
+    int result = LZ4_decompress_safe((const char *)assets.data() + 4, (char *)decompressed.data(),
+                                     (int)assets.size() - 4, (int)decompressedSize);
+    if (result != (int)decompressedSize) {
+        fail("decompression failed");
+    }
+
+    if (getU32(decompressed, 0) / 4 <= STYLES_OFFSET_INDEX) {
+        fail("unexpected assets header");
+    }
+    uint32_t numOffsets = getU32(decompressed, 0) / 4;
+    uint32_t fontsOffset = getU32(decompressed, FONTS_OFFSET_INDEX * 4);
+    uint32_t bitmapsOffset = getU32(decompressed, BITMAPS_OFFSET_INDEX * 4);
+    uint32_t stylesOffset = getU32(decompressed, STYLES_OFFSET_INDEX * 4);
+    if (!(fontsOffset <= bitmapsOffset && bitmapsOffset <= stylesOffset && stylesOffset <= decompressedSize)) {
+        fail("unexpected assets header");
+    }
+
+    // tables: the single block layout without the fonts and bitmaps data
+    std::vector<uint8_t> tables(decompressed.begin(), decompressed.begin() + fontsOffset);
+    tables.insert(tables.end(), decompressed.begin() + stylesOffset, decompressed.end());
+    setU32(tables, FONTS_OFFSET_INDEX * 4, 0);
+    setU32(tables, BITMAPS_OFFSET_INDEX * 4, 0);
+    uint32_t removed = stylesOffset - fontsOffset;
+    for (uint32_t i = STYLES_OFFSET_INDEX; i < numOffsets; i++) {
+        setU32(tables, i * 4, getU32(tables, i * 4) - removed);
+    }
+
+    std::vector<uint8_t> out;
+    putU32(out, SECTIONED_ASSETS_MAGIC);
+    putU32(out, SECTIONED_ASSETS_VERSION);
+    putU32(out, (uint32_t)tables.size());
+    putU32(out, 0); // tables compressed size
+    putU32(out, 0); // fonts section offset
+    putU32(out, 0); // bitmaps section offset
+
+    setU32(out, 12, compressBlock(out, tables.data(), (uint32_t)tables.size()));
+    align4(out);
+
+    setU32(out, 16, (uint32_t)out.size());
+    writeSection(out, decompressed.data() + fontsOffset, bitmapsOffset - fontsOffset);
+
+    setU32(out, 20, (uint32_t)out.size());
+    writeSection(out, decompressed.data() + bitmapsOffset, stylesOffset - bitmapsOffset);
+
+    fprintf(stderr, "assets %u bytes (%u decompressed) -> %u bytes (%u decompressed at boot)\n",
+            (unsigned)assets.size(), (unsigned)decompressedSize, (unsigned)out.size(), (unsigned)tables.size());
+
+    return out;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: assets-converter <document.cpp>\n");
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        fail("can't open input file");
+    }
+    std::string source;
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        source.append(buffer, n);
+    }
+    fclose(fp);
+
+    const char *eol = source.find("\r\n") != std::string::npos ? "\r\n" : "\n";
+
+    size_t definition = source.find(ASSETS_DEFINITION);
+    if (definition == std::string::npos) {
+        fail("assets definition not found");
+    }
+    size_t arrayBegin = source.find('{', definition);
+    size_t arrayEnd = source.find("};", definition);
+    if (arrayBegin == std::string::npos || arrayEnd == std::string::npos || arrayEnd < arrayBegin) {
+        fail("assets array not found");
+    }
+
+    std::vector<uint8_t> assets;
+    for (size_t i = arrayBegin + 1; i < arrayEnd;) {
+        if (source[i] == '0' && (source[i + 1] == 'x' || source[i + 1] == 'X')) {
+            char *end;
+            assets.push_back((uint8_t)strtoul(source.c_str() + i, &end, 16));
+            i = end - source.c_str();
+        } else {
+            i++;
+        }
+    }
+
+    if (assets.size() >= 4 && getU32(assets, 0) == SECTIONED_ASSETS_MAGIC) {
+        fprintf(stderr, "assets-converter: already in the sectioned format\n");
+        return 0;
+    }
+
+    std::vector<uint8_t> sectioned = convert(assets);
+
+    std::string array = "const uint8_t assets[" + std::to_string(sectioned.size()) + "] = {" + eol;
+    for (size_t i = 0; i < sectioned.size(); i++) {
+        if (i % 16 == 0) {
+            array += "    ";
+        }
+        char hex[8];
+        snprintf(hex, sizeof(hex), "0x%02X", sectioned[i]);
+        array += hex;
+        if (i + 1 < sectioned.size()) {
+            array += (i % 16 == 15) ? std::string(",") + eol : std::string(", ");
+        }
+    }
+    array += eol;
+
+    size_t lineBegin = source.find("const uint8_t assets[", definition);
+    if (lineBegin == std::string::npos || lineBegin > arrayBegin) {
+        fail("assets array not found");
+    }
+    source.replace(lineBegin, arrayEnd - lineBegin, array);
+
+    fp = fopen(argv[1], "wb");
+    if (!fp) {
+        fail("can't write output file");
+    }
+    fwrite(source.data(), 1, source.size(), fp);
+    fclose(fp);
+
+    return 0;
+}